@@ -31,6 +31,10 @@
 //      now uses unsigned integers rather than signed integes.
 
 #include "D3D11Image.h"
+#include "../DX11Native/FrameRateGovernor.h"
+#include "../DX11Native/FramePacer.h"
+#include <dwmapi.h>
+#include <stdexcept>
 
 namespace System {
     namespace Windows {
@@ -51,16 +55,43 @@ namespace System {
                 }
 
                 D3D11Image::D3D11Image()
+                    :
+                    governor(nullptr),
+                    governorEnabled(false),
+                    onBattery(false),
+                    lastPowerPoll(0),
+                    frameRateCap(0.0),
+                    pacer(nullptr),
+                    frameStatistics(nullptr),
+                    pacerRunning(false),
+                    framesDropped(0),
+                    disposed(false)
                 {
                 }
 
                 D3D11Image::~D3D11Image()
                 {
+                    // A frame that was posted before the pacer stopped might
+                    // still be dispatched; 'disposed' makes it return.
+                    this->disposed = true;
+                    StopPacer();
+                    this->frameRateCap = 0.0;
                     if (this->manager != nullptr)
                     {
                         this->manager->~DXManager();
                         this->manager = nullptr;
                     }
+                    this->!D3D11Image();
+                }
+
+                D3D11Image::!D3D11Image()
+                {
+                    delete this->governor;
+                    this->governor = nullptr;
+                    delete this->pacer;
+                    this->pacer = nullptr;
+                    delete this->frameStatistics;
+                    this->frameStatistics = nullptr;
                 }
 
                 Freezable^ D3D11Image::CreateInstanceCore()
@@ -94,32 +125,300 @@ namespace System {
                     }
                 }
 
-                void D3D11Image::RequestRender()
+                void D3D11Image::EnsureManager()
+                {
+                    if (this->manager == nullptr)
+                    {
+                        this->manager = gcnew DXManager();
+                        this->manager->HWND = this->WindowOwner;
+                        this->manager->D3DImage = this;
+                        this->manager->OnRender = this->OnRender;
+                        this->manager->SetNativeRender(this->nativeRenderFunction,
+                            this->nativeRenderContext);
+                        this->manager->RenderOutsideLock = this->renderOutsideLock;
+                    }
+                }
+
+                void D3D11Image::SetNativeRender(IntPtr function, IntPtr context)
+                {
+                    this->nativeRenderFunction = function;
+                    this->nativeRenderContext = context;
+                    if (this->manager != nullptr)
+                    {
+                        this->manager->SetNativeRender(function, context);
+                    }
+                }
+
+                bool D3D11Image::GovernorEnabled::get()
+                {
+                    return this->governorEnabled;
+                }
+
+                void D3D11Image::GovernorEnabled::set(bool value)
+                {
+                    if (value && this->governor == nullptr)
+                    {
+                        this->governor = new dxm::FrameRateGovernor();
+                    }
+                    else if (value && !this->governorEnabled)
+                    {
+                        this->governor->ResetStatistics();
+                    }
+                    this->governorEnabled = value;
+                }
+
+                void D3D11Image::SetGovernorPolicy(double displayRate, double unfocusedRate,
+                    double batteryRate, double idleRate, double idleSeconds,
+                    double occludedRate, double rampSeconds)
+                {
+                    if (this->governor == nullptr)
+                    {
+                        this->governor = new dxm::FrameRateGovernor();
+                    }
+
+                    dxm::FrameRateGovernor::Policy policy{};
+                    policy.displayRate = displayRate;
+                    policy.unfocusedRate = unfocusedRate;
+                    policy.batteryRate = batteryRate;
+                    policy.idleRate = idleRate;
+                    policy.idleSeconds = idleSeconds;
+                    policy.occludedRate = occludedRate;
+                    policy.rampSeconds = rampSeconds;
+                    try
+                    {
+                        this->governor->SetPolicy(policy);
+                    }
+                    catch (std::invalid_argument const& exception)
+                    {
+                        throw gcnew ArgumentException(gcnew String(exception.what()));
+                    }
+                }
+
+                double D3D11Image::GovernorRate::get()
+                {
+                    return (this->governor != nullptr ? this->governor->GetCurrentRate() : 0.0);
+                }
+
+                UInt64 D3D11Image::FramesRendered::get()
+                {
+                    return (this->governor != nullptr ? this->governor->GetStatistics().numRendered : 0);
+                }
+
+                UInt64 D3D11Image::FramesSaved::get()
+                {
+                    return (this->governor != nullptr ? this->governor->GetNumSaved() : 0);
+                }
+
+                double D3D11Image::FrameRateCap::get()
+                {
+                    return this->frameRateCap;
+                }
+
+                void D3D11Image::FrameRateCap::set(double value)
+                {
+                    value = (value > 0.0 ? value : 0.0);
+                    if (this->disposed || value == this->frameRateCap)
+                    {
+                        return;
+                    }
+
+                    StopPacer();
+                    this->frameRateCap = value;
+                    if (value > 0.0)
+                    {
+                        StartPacer();
+                    }
+                }
+
+                double D3D11Image::FrameIntervalMilliseconds::get()
+                {
+                    return (this->frameStatistics != nullptr ?
+                        1000.0 * this->frameStatistics->GetMeanInterval() : 0.0);
+                }
+
+                double D3D11Image::FrameJitterMilliseconds::get()
+                {
+                    return (this->frameStatistics != nullptr ?
+                        1000.0 * this->frameStatistics->GetJitter() : 0.0);
+                }
+
+                double D3D11Image::MaxFrameDeviationMilliseconds::get()
+                {
+                    return (this->frameStatistics != nullptr ?
+                        1000.0 * this->frameStatistics->GetMaxDeviation() : 0.0);
+                }
+
+                Int64 D3D11Image::FramesDropped::get()
+                {
+                    return System::Threading::Interlocked::Read(this->framesDropped);
+                }
+
+                void D3D11Image::ResetFrameStatistics()
+                {
+                    if (this->frameStatistics != nullptr)
+                    {
+                        this->frameStatistics->Reset(this->frameStatistics->GetTargetInterval());
+                    }
+                    System::Threading::Interlocked::Exchange(this->framesDropped, 0);
+                }
+
+                void D3D11Image::StartPacer()
+                {
+                    if (this->pacer == nullptr)
+                    {
+                        this->pacer = new dxm::FramePacer();
+                        this->frameStatistics = new dxm::FrameIntervalStatistics();
+                    }
+                    this->pacer->SetRate(this->frameRateCap);
+                    this->frameStatistics->Reset(1.0 / this->frameRateCap);
+                    System::Threading::Interlocked::Exchange(this->framesDropped, 0);
+
+                    this->pacerRunning = true;
+                    this->pacerThread = gcnew System::Threading::Thread(
+                        gcnew System::Threading::ThreadStart(this, &D3D11Image::PacerLoop));
+                    this->pacerThread->Name = "D3D11Image pacer";
+                    this->pacerThread->IsBackground = true;
+                    this->pacerThread->Priority = System::Threading::ThreadPriority::AboveNormal;
+                    this->pacerThread->Start();
+                }
+
+                void D3D11Image::StopPacer()
+                {
+                    // The pacer thread does not wait for the dispatcher, so
+                    // the join returns within one cap interval.
+                    if (this->pacerThread != nullptr)
+                    {
+                        this->pacerRunning = false;
+                        this->pacerThread->Join();
+                        this->pacerThread = nullptr;
+                    }
+
+                    // The last frame posted by the pacer is not rendered.
+                    if (this->pendingFrame != nullptr)
+                    {
+                        this->pendingFrame->Abort();
+                        this->pendingFrame = nullptr;
+                    }
+                }
+
+                void D3D11Image::PacerLoop()
+                {
+                    Action^ render = gcnew Action(this, &D3D11Image::RenderPacedFrame);
+                    while (this->pacerRunning)
+                    {
+                        this->pacer->Wait();
+                        if (!this->pacerRunning)
+                        {
+                            break;
+                        }
+
+                        System::Windows::Threading::DispatcherOperation^ pending = this->pendingFrame;
+                        if (pending != nullptr &&
+                            pending->Status == System::Windows::Threading::DispatcherOperationStatus::Pending)
+                        {
+                            System::Threading::Interlocked::Increment(this->framesDropped);
+                            continue;
+                        }
+
+                        this->pendingFrame = this->Dispatcher->BeginInvoke(
+                            System::Windows::Threading::DispatcherPriority::Render, render);
+                    }
+                }
+
+                void D3D11Image::RenderPacedFrame()
                 {
-                    if (nullptr != this->OnRender)
+                    if (this->disposed)
+                    {
+                        return;
+                    }
+
+                    if (this->frameRateCap > 0.0 && this->IsFrontBufferAvailable)
                     {
-                        if (this->manager == nullptr)
+                        double seconds = dxm::FramePacer::GetSeconds();
+                        if (RenderFrame())
                         {
-                            this->manager = gcnew DXManager();
-                            this->manager->HWND = this->WindowOwner;
-                            this->manager->D3DImage = this;
-                            this->manager->OnRender = this->OnRender;
+                            this->frameStatistics->Record(seconds);
                         }
+                    }
+                }
+
+                bool D3D11Image::GovernorAllowsFrame()
+                {
+                    ::HWND hwnd = (::HWND)(void*)this->WindowOwner;
+                    if (hwnd == nullptr)
+                    {
+                        return true;
+                    }
+
+                    dxm::FrameRateGovernor::WindowState state{};
+                    state.focused = (GetForegroundWindow() == hwnd);
+                    state.minimized = (IsIconic(hwnd) != FALSE);
+
+                    // A window on another virtual desktop is cloaked by DWM.
+                    BOOL cloaked = FALSE;
+                    if (FAILED(DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))))
+                    {
+                        cloaked = FALSE;
+                    }
+                    state.occluded = (cloaked != FALSE || IsWindowVisible(hwnd) == FALSE ||
+                        !this->IsFrontBufferAvailable);
+
+                    LASTINPUTINFO inputInfo{};
+                    inputInfo.cbSize = sizeof(inputInfo);
+                    if (GetLastInputInfo(&inputInfo))
+                    {
+                        state.idleSeconds = static_cast<double>(GetTickCount() - inputInfo.dwTime) / 1000.0;
+                    }
+
+                    Int64 now = System::Diagnostics::Stopwatch::GetTimestamp();
+                    Int64 frequency = System::Diagnostics::Stopwatch::Frequency;
+                    if (this->lastPowerPoll == 0 || now - this->lastPowerPoll >= frequency)
+                    {
+                        SYSTEM_POWER_STATUS powerStatus{};
+                        this->onBattery = (GetSystemPowerStatus(&powerStatus) &&
+                            powerStatus.ACLineStatus == 0);
+                        this->lastPowerPoll = now;
+                    }
+                    state.onBattery = this->onBattery;
+
+                    double seconds = static_cast<double>(now) / static_cast<double>(frequency);
+                    return this->governor->OnRequest(state, seconds);
+                }
 
+                bool D3D11Image::RequestRender()
+                {
+                    return (this->frameRateCap > 0.0 ? false : RenderFrame());
+                }
+
+                bool D3D11Image::RenderFrame()
+                {
+                    if (this->disposed)
+                    {
+                        return false;
+                    }
+
+                    if (nullptr != this->OnRender || IntPtr::Zero != this->nativeRenderFunction)
+                    {
+                        if (this->governorEnabled && !GovernorAllowsFrame())
+                        {
+                            return false;
+                        }
+
+                        EnsureManager();
                         this->manager->OnRequestRender();
+                        return true;
                     }
+                    return false;
                 }
 
                 void D3D11Image::Resize(unsigned int width, unsigned int height)
                 {
-                    if (this->manager == nullptr)
+                    if (this->disposed)
                     {
-                        this->manager = gcnew DXManager();
-                        this->manager->HWND = this->WindowOwner;
-                        this->manager->D3DImage = this;
-                        this->manager->OnRender = this->OnRender;
+                        return;
                     }
 
+                    EnsureManager();
                     this->manager->OnResize(width, height);
                 }
             }
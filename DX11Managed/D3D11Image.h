@@ -36,6 +36,13 @@
 
 #include "DXManager.h"
 
+namespace dxm
+{
+    class FrameRateGovernor;
+    class FramePacer;
+    class FrameIntervalStatistics;
+}
+
 using namespace System;
 using namespace System::Windows;
 using namespace System::Windows::Interop;
@@ -53,8 +60,43 @@ namespace System {
                     static void HWNDOwnerChanged(DependencyObject^ sender, DependencyPropertyChangedEventArgs args);
                     static D3D11Image();
 
+                    void EnsureManager();
+                    bool GovernorAllowsFrame();
+                    bool RenderFrame();
+                    void StartPacer();
+                    void StopPacer();
+                    void PacerLoop();
+                    void RenderPacedFrame();
+
                 internal:
                     DXManager^ manager;
+                    IntPtr nativeRenderFunction;
+                    IntPtr nativeRenderContext;
+                    bool renderOutsideLock;
+
+                    // The frame-rate governor, created when first enabled. The
+                    // power status is polled once per second.
+                    dxm::FrameRateGovernor* governor;
+                    bool governorEnabled;
+                    bool onBattery;
+                    Int64 lastPowerPoll;
+
+                    // The frame-rate cap. The pacer thread waits for the
+                    // deadlines and posts a frame to the dispatcher, unless
+                    // the previous one is still pending. The pacer is used
+                    // only by that thread while it runs; the frame intervals
+                    // are recorded on the dispatcher thread.
+                    double frameRateCap;
+                    dxm::FramePacer* pacer;
+                    dxm::FrameIntervalStatistics* frameStatistics;
+                    System::Threading::Thread^ pacerThread;
+                    volatile bool pacerRunning;
+                    System::Windows::Threading::DispatcherOperation^ pendingFrame;
+                    Int64 framesDropped;
+
+                    // Set by Dispose. Frames that are requested or dispatched
+                    // afterwards are ignored rather than creating a manager.
+                    bool disposed;
 
                 protected:
                     Freezable^ CreateInstanceCore() override;
@@ -62,6 +104,7 @@ namespace System {
                 public:
                     D3D11Image();
                     ~D3D11Image();
+                    !D3D11Image();
 
                     static DependencyProperty^ OnRenderProperty;
                     static DependencyProperty^ WindowOwnerProperty;
@@ -92,7 +135,157 @@ namespace System {
                         }
                     }
 
-                    void RequestRender();
+                    // The time from the loss of the front buffer or the
+                    // devices to the first frame rendered afterwards.
+                    property double LastRecoveryMilliseconds
+                    {
+                        double get()
+                        {
+                            return (manager != nullptr ? manager->LastRecoveryMilliseconds : 0.0);
+                        }
+                    }
+
+                    // See DXManager::AdapterLuid and DXManager::NumAdapterChanges.
+                    property UInt64 AdapterLuid
+                    {
+                        UInt64 get()
+                        {
+                            return (manager != nullptr ? manager->AdapterLuid : 0);
+                        }
+                    }
+
+                    property unsigned int NumAdapterChanges
+                    {
+                        unsigned int get()
+                        {
+                            return (manager != nullptr ? manager->NumAdapterChanges : 0);
+                        }
+                    }
+
+                    // See DXManager::RenderOutsideLock.
+                    property bool RenderOutsideLock
+                    {
+                        bool get()
+                        {
+                            return renderOutsideLock;
+                        }
+
+                        void set(bool value)
+                        {
+                            renderOutsideLock = value;
+                            if (manager != nullptr)
+                            {
+                                manager->RenderOutsideLock = value;
+                            }
+                        }
+                    }
+
+                    // The time the D3DImage lock was held by the last frame and
+                    // its moving average, in microseconds.
+                    property double LastLockMicroseconds
+                    {
+                        double get()
+                        {
+                            return (manager != nullptr ? manager->LastLockMicroseconds : 0.0);
+                        }
+                    }
+
+                    property double AverageLockMicroseconds
+                    {
+                        double get()
+                        {
+                            return (manager != nullptr ? manager->AverageLockMicroseconds : 0.0);
+                        }
+                    }
+
+                    // When enabled, RequestRender skips frames according to the
+                    // state of the WindowOwner window: focus, occlusion (hidden,
+                    // cloaked or front buffer unavailable), minimization, power
+                    // source and the time since the last user input. See
+                    // dxm::FrameRateGovernor for the policy. Resize always
+                    // renders.
+                    property bool GovernorEnabled
+                    {
+                        bool get();
+                        void set(bool value);
+                    }
+
+                    // Set the governor rates in frames per second. The display
+                    // rate is the rate of RequestRender calls and must be
+                    // positive; the other rates and times must be nonnegative.
+                    // An invalid policy throws ArgumentException and leaves
+                    // the previous policy in place.
+                    void SetGovernorPolicy(double displayRate, double unfocusedRate,
+                        double batteryRate, double idleRate, double idleSeconds,
+                        double occludedRate, double rampSeconds);
+
+                    // The governed frame rate of the last request and the
+                    // number of requests that rendered or were skipped since
+                    // the governor was enabled.
+                    property double GovernorRate
+                    {
+                        double get();
+                    }
+
+                    property UInt64 FramesRendered
+                    {
+                        UInt64 get();
+                    }
+
+                    property UInt64 FramesSaved
+                    {
+                        UInt64 get();
+                    }
+
+                    // The frame rate in frames per second at which the image
+                    // renders itself, independently of the WPF Rendering
+                    // event; 0 (the default) turns the cap off. While a cap is
+                    // set, RequestRender does not render. The deadlines are
+                    // kept by dxm::FramePacer on a background thread, and the
+                    // frames are rendered on the dispatcher thread at Render
+                    // priority. The governor, when enabled, still applies.
+                    property double FrameRateCap
+                    {
+                        double get();
+                        void set(double value);
+                    }
+
+                    // The achieved intervals between the capped frames, in
+                    // milliseconds: the mean, the jitter (root-mean-square
+                    // deviation from the cap interval) and the largest
+                    // deviation. The statistics restart when the cap changes.
+                    property double FrameIntervalMilliseconds
+                    {
+                        double get();
+                    }
+
+                    property double FrameJitterMilliseconds
+                    {
+                        double get();
+                    }
+
+                    property double MaxFrameDeviationMilliseconds
+                    {
+                        double get();
+                    }
+
+                    // The capped frames not rendered because the dispatcher
+                    // had not yet rendered the previous one.
+                    property Int64 FramesDropped
+                    {
+                        Int64 get();
+                    }
+
+                    void ResetFrameStatistics();
+
+                    // Render by calling a native function directly rather than
+                    // the OnRender delegate. See DXManager::SetNativeRender.
+                    void SetNativeRender(IntPtr function, IntPtr context);
+
+                    // Returns 'true' when a frame was rendered, 'false' when no
+                    // render callback is set, a frame-rate cap is set or the
+                    // governor skipped the frame.
+                    bool RequestRender();
                     void Resize(unsigned int width, unsigned int height);
                 };
             }
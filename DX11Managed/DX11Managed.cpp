@@ -7,6 +7,8 @@
 
 #include <msclr/marshal_cppstd.h>
 #include "DX11Managed.h"
+#include "../DX11Native/ComAccounting.h"
+#include "../DX11Native/Trace.h"
 using namespace System::Runtime::InteropServices;
 
 namespace System {
@@ -66,6 +68,196 @@ namespace System {
                         return false;
                     }
                 }
+
+                void DX11Managed::EnableTrace(bool enable)
+                {
+                    dxm::Trace::Enable(enable);
+                }
+
+                bool DX11Managed::WriteTrace(String^ filename)
+                {
+                    if (filename == nullptr)
+                    {
+                        return false;
+                    }
+                    return dxm::Trace::Write(msclr::interop::marshal_as<std::string>(filename));
+                }
+
+                void DX11Managed::EnableComAccounting(bool enable)
+                {
+                    dxm::ComAccounting::Enable(enable);
+                }
+
+                bool DX11Managed::WriteComAccounting(String^ filename)
+                {
+                    if (filename == nullptr)
+                    {
+                        return false;
+                    }
+                    return dxm::ComAccounting::Write(msclr::interop::marshal_as<std::string>(filename));
+                }
+
+                String^ DX11Managed::NativeRenderExceptionMessage::get()
+                {
+                    return msclr::interop::marshal_as<String^>(
+                        dxm::Application::GetRenderExceptionMessage(mInstance));
+                }
+
+                bool DX11Managed::UploadPixels(IntPtr pixels, CpuPixelFormat format,
+                    unsigned int rowPitch, unsigned int x, unsigned int y,
+                    unsigned int width, unsigned int height)
+                {
+                    // The size of native memory is not known; the caller is
+                    // responsible for its validity.
+                    return UploadPixels((void*)pixels, SIZE_MAX, format,
+                        rowPitch, x, y, width, height);
+                }
+
+                bool DX11Managed::UploadPixels(array<Byte>^ pixels, CpuPixelFormat format,
+                    unsigned int rowPitch, unsigned int x, unsigned int y,
+                    unsigned int width, unsigned int height)
+                {
+                    if (pixels == nullptr || pixels->Length == 0)
+                    {
+                        exceptionMessage = "Expecting a nonempty pixel array in UploadPixels.";
+                        return false;
+                    }
+
+                    pin_ptr<Byte const> pinned = &pixels[0];
+                    return UploadPixels(pinned, static_cast<size_t>(pixels->Length),
+                        format, rowPitch, x, y, width, height);
+                }
+
+                bool DX11Managed::UploadPixels(array<UInt16>^ pixels, CpuPixelFormat format,
+                    unsigned int rowPitch, unsigned int x, unsigned int y,
+                    unsigned int width, unsigned int height)
+                {
+                    if (pixels == nullptr || pixels->Length == 0)
+                    {
+                        exceptionMessage = "Expecting a nonempty pixel array in UploadPixels.";
+                        return false;
+                    }
+
+                    pin_ptr<UInt16 const> pinned = &pixels[0];
+                    return UploadPixels(pinned, 2 * static_cast<size_t>(pixels->Length),
+                        format, rowPitch, x, y, width, height);
+                }
+
+                bool DX11Managed::SetPostProcessPass(String^ name, bool enabled,
+                    array<float>^ parameters)
+                {
+                    if (!mInstance)
+                    {
+                        exceptionMessage = "Expecting an instance in SetPostProcessPass.";
+                        return false;
+                    }
+
+                    if (parameters != nullptr && parameters->Length !=
+                        static_cast<int>(dxm::PostProcessChain::numParameters))
+                    {
+                        exceptionMessage = "Expecting eight parameters in SetPostProcessPass.";
+                        return false;
+                    }
+
+                    std::string nativeName = msclr::interop::marshal_as<std::string>(name);
+                    std::string nativeExceptionMessage;
+                    if (parameters != nullptr)
+                    {
+                        pin_ptr<float const> pinned = &parameters[0];
+                        nativeExceptionMessage = dxm::Application::SetPostProcessPass(
+                            mInstance, nativeName, enabled, pinned);
+                    }
+                    else
+                    {
+                        nativeExceptionMessage = dxm::Application::SetPostProcessPass(
+                            mInstance, nativeName, enabled, nullptr);
+                    }
+                    exceptionMessage = msclr::interop::marshal_as<String^>(nativeExceptionMessage);
+                    return (nativeExceptionMessage == "");
+                }
+
+                bool DX11Managed::SetOverlayVisible(bool visible)
+                {
+                    if (!mInstance)
+                    {
+                        exceptionMessage = "Expecting an instance in SetOverlayVisible.";
+                        return false;
+                    }
+
+                    std::string nativeExceptionMessage =
+                        dxm::Application::SetOverlayVisible(mInstance, visible);
+                    exceptionMessage = msclr::interop::marshal_as<String^>(nativeExceptionMessage);
+                    return (nativeExceptionMessage == "");
+                }
+
+                bool DX11Managed::SetTileCacheEnabled(bool enabled)
+                {
+                    if (!mInstance)
+                    {
+                        exceptionMessage = "Expecting an instance in SetTileCacheEnabled.";
+                        return false;
+                    }
+
+                    std::string nativeExceptionMessage =
+                        dxm::Application::SetTileCacheEnabled(mInstance, enabled);
+                    exceptionMessage = msclr::interop::marshal_as<String^>(nativeExceptionMessage);
+                    return (nativeExceptionMessage == "");
+                }
+
+                bool DX11Managed::InvalidateRegion(unsigned int x, unsigned int y,
+                    unsigned int width, unsigned int height)
+                {
+                    if (!mInstance)
+                    {
+                        exceptionMessage = "Expecting an instance in InvalidateRegion.";
+                        return false;
+                    }
+
+                    std::string nativeExceptionMessage =
+                        dxm::Application::InvalidateRegion(mInstance, x, y, width, height);
+                    exceptionMessage = msclr::interop::marshal_as<String^>(nativeExceptionMessage);
+                    return (nativeExceptionMessage == "");
+                }
+
+                bool DX11Managed::SetFrameLoopPreset(FrameLoopPreset preset)
+                {
+                    if (!mInstance)
+                    {
+                        exceptionMessage = "Expecting an instance in SetFrameLoopPreset.";
+                        return false;
+                    }
+
+                    std::string nativeExceptionMessage = dxm::Application::SetFrameLoopPreset(
+                        mInstance, static_cast<dxm::FrameLoopPreset>(preset));
+                    exceptionMessage = msclr::interop::marshal_as<String^>(nativeExceptionMessage);
+                    return (nativeExceptionMessage == "");
+                }
+
+                bool DX11Managed::UploadPixels(void const* pixels, size_t numBytes,
+                    CpuPixelFormat format, unsigned int rowPitch, unsigned int x,
+                    unsigned int y, unsigned int width, unsigned int height)
+                {
+                    if (!mInstance)
+                    {
+                        exceptionMessage = "Expecting an instance in UploadPixels.";
+                        return false;
+                    }
+
+                    auto nativeFormat = static_cast<dxm::PixelConversion::Format>(format);
+                    size_t rowBytes = static_cast<size_t>(width) *
+                        dxm::PixelConversion::GetBytesPerPixel(nativeFormat);
+                    if (height > 0 && (rowPitch < rowBytes ||
+                        static_cast<size_t>(rowPitch) * (height - 1) + rowBytes > numBytes))
+                    {
+                        exceptionMessage = "The pixel rectangle exceeds the source in UploadPixels.";
+                        return false;
+                    }
+
+                    std::string nativeExceptionMessage = dxm::Application::UploadPixels(
+                        mInstance, nativeFormat, pixels, rowPitch, x, y, width, height);
+                    exceptionMessage = msclr::interop::marshal_as<String^>(nativeExceptionMessage);
+                    return (nativeExceptionMessage == "");
+                }
             }
         }
     }
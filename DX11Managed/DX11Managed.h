@@ -16,6 +16,38 @@ namespace System {
         namespace Interop {
             namespace DirectX {
 
+                // The CPU pixel formats accepted by DX11Managed::UploadPixels.
+                // The values match dxm::PixelConversion::Format.
+                public enum class CpuPixelFormat
+                {
+                    BGRA8,
+                    RGBA8,
+                    RGB8,
+                    Gray16,
+                    RGBA16
+                };
+
+                // The frame loops selected by DX11Managed::SetFrameLoopPreset.
+                // The values match dxm::FrameLoopPreset.
+                public enum class FrameLoopPreset
+                {
+                    // Every feature: overlay, post-processing, tile caching
+                    // and tracing, with a reused GPU wait query. The initial
+                    // preset. COM accounting records the calls of every
+                    // preset.
+                    Standard,
+
+                    // No instrumentation, post-processing or tile caching.
+                    Fast,
+
+                    // Post-processing and tile caching, no instrumentation.
+                    Composed,
+
+                    // Standard with a GPU wait query created in each frame,
+                    // the sync before the presets.
+                    PerFrameQuery
+                };
+
                 public ref class DX11Managed
                 {
                 public:
@@ -35,9 +67,150 @@ namespace System {
                         IntPtr wpfBackBuffer,
                         bool recreateRenderTarget);
 
+                    // The native render entry point and its context, to be passed
+                    // to D3D11Image::SetNativeRender. Frames rendered this way
+                    // do not pass through managed code, so RenderFrame and
+                    // exceptionMessage are not involved; the exception message
+                    // of the last such frame is NativeRenderExceptionMessage.
+                    property IntPtr NativeRenderFunction
+                    {
+                        IntPtr get()
+                        {
+                            return IntPtr(reinterpret_cast<void*>(
+                                &dxm::Application::RenderFrameCallback));
+                        }
+                    }
+
+                    property IntPtr NativeRenderContext
+                    {
+                        IntPtr get()
+                        {
+                            return IntPtr(mInstance);
+                        }
+                    }
+
+                    property String^ NativeRenderExceptionMessage
+                    {
+                        String^ get();
+                    }
+
+                    // Copy a width-by-height rectangle of CPU pixels to (x,y) of
+                    // the render target. The rectangle appears in the next
+                    // RenderFrame, after the clear. The pixels are converted to
+                    // B8G8R8A8 while being written to a dynamic texture, so they
+                    // are copied only once on the CPU. The rowPitch is the
+                    // number of bytes between rows of the source. The IntPtr
+                    // overload accepts native memory or memory the caller has
+                    // pinned; the array overloads pin the array for the call.
+                    // The return value and exceptionMessage are as described
+                    // for RenderFrame.
+                    bool UploadPixels(IntPtr pixels, CpuPixelFormat format,
+                        unsigned int rowPitch, unsigned int x, unsigned int y,
+                        unsigned int width, unsigned int height);
+
+                    bool UploadPixels(array<Byte>^ pixels, CpuPixelFormat format,
+                        unsigned int rowPitch, unsigned int x, unsigned int y,
+                        unsigned int width, unsigned int height);
+
+                    bool UploadPixels(array<UInt16>^ pixels, CpuPixelFormat format,
+                        unsigned int rowPitch, unsigned int x, unsigned int y,
+                        unsigned int width, unsigned int height);
+
+                    // Enable or disable a native post-process pass ("ToneMap",
+                    // "ColorGrade" or "Sharpen"). The parameters array has eight
+                    // elements or is null to keep the current parameters. The
+                    // return value and exceptionMessage are as described for
+                    // RenderFrame.
+                    bool SetPostProcessPass(String^ name, bool enabled,
+                        array<float>^ parameters);
+
+                    // Show or hide the native statistics overlay (frame rate,
+                    // CPU and GPU milliseconds and a frame-interval graph),
+                    // which is drawn into the render target by RenderFrame.
+                    // The return value and exceptionMessage are as described
+                    // for RenderFrame.
+                    bool SetOverlayVisible(bool visible);
+
+                    // Retain the native scene between frames in a tile cache
+                    // and render only the tiles invalidated by
+                    // InvalidateRegion (in pixels of the render target),
+                    // which is ignored while the cache is disabled. Every
+                    // tile is rendered after a resize or a device recovery.
+                    // The return values and exceptionMessage are as
+                    // described for RenderFrame.
+                    bool SetTileCacheEnabled(bool enabled);
+                    bool InvalidateRegion(unsigned int x, unsigned int y,
+                        unsigned int width, unsigned int height);
+
+                    // Select the native frame loop. The features that a preset
+                    // does not have are compiled out of its loop, and their
+                    // settings are ignored while it is selected. The return
+                    // value and exceptionMessage are as described for
+                    // RenderFrame.
+                    bool SetFrameLoopPreset(FrameLoopPreset preset);
+
+                    // Timeline tracing of the native code and of DXManager. While
+                    // tracing is enabled, the begin and end events of the frame
+                    // stages are recorded per thread. WriteTrace writes the
+                    // events recorded since the previous write to a Chrome
+                    // trace-event JSON file, which chrome://tracing and
+                    // ui.perfetto.dev load, and returns 'false' when the file
+                    // cannot be written.
+                    static void EnableTrace(bool enable);
+                    static bool WriteTrace(String^ filename);
+
+                    // COM object accounting of the native code and of
+                    // DXManager. While it is enabled, the creations, releases
+                    // and QueryInterface calls are counted and timed per call
+                    // site, and the frames that create objects without a
+                    // resize or device recovery are flagged. WriteComAccounting
+                    // writes a text report of the statistics recorded since
+                    // accounting was first enabled, including the devices that
+                    // were still referenced after their final release, and
+                    // returns 'false' when the file cannot be written.
+                    static void EnableComAccounting(bool enable);
+                    static bool WriteComAccounting(String^ filename);
+
+                    // Native device-loss recovery statistics. The recovery
+                    // time is measured from the detection of the loss to
+                    // the first completed frame.
+                    property unsigned int NumRecoveries
+                    {
+                        unsigned int get()
+                        {
+                            return static_cast<unsigned int>(
+                                dxm::Application::GetNumRecoveries(mInstance));
+                        }
+                    }
+
+                    property double LastRecoveryMilliseconds
+                    {
+                        double get()
+                        {
+                            return dxm::Application::GetLastRecoveryMilliseconds(mInstance);
+                        }
+                    }
+
+                    // The LUID of the adapter of the native device, which
+                    // follows the adapter of the shared surface. It matches
+                    // D3D11Image.AdapterLuid unless no hardware adapter was
+                    // selected.
+                    property UInt64 AdapterLuid
+                    {
+                        UInt64 get()
+                        {
+                            return dxm::Application::GetAdapterLuid(mInstance);
+                        }
+                    }
+
                     String^ exceptionMessage;
 
                 private:
+                    bool UploadPixels(void const* pixels, size_t numBytes,
+                        CpuPixelFormat format, unsigned int rowPitch,
+                        unsigned int x, unsigned int y, unsigned int width,
+                        unsigned int height);
+
                     dxm::Application* mInstance;
                     bool exceptionMessageUnassigned;
                 };
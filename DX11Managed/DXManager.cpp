@@ -48,12 +48,20 @@
 //   4. The member names were modified to be consistent with GTE conventions.
 
 #include "DXManager.h"
+#include "../DX11Native/AdapterSelection.h"
+#include "../DX11Native/ComAccounting.h"
+#include "../DX11Native/Trace.h"
+#include <dxgi.h>
 
 using namespace System;
 using namespace System::Windows;
 using namespace System::Windows::Interop;
 
-#define ReleaseInterface(object) { if (object != nullptr) { object->Release(); object = nullptr; } }
+#define ReleaseInterface(object) { if (object != nullptr) { DXM_COM_CALL(RELEASE, "DXManager Release " #object, object->Release()); object = nullptr; } }
+
+// The final release of a device or factory, which should return 0. See
+// ComAccounting::RecordLiveReferences.
+#define ReleaseDevice(object) { if (object != nullptr) { dxm::ComAccounting::RecordLiveReferences(#object, DXM_COM_CALL(RELEASE, "DXManager Release " #object, object->Release())); object = nullptr; } }
 
 namespace System {
     namespace Windows {
@@ -63,6 +71,8 @@ namespace System {
                 DXManager::DXManager()
                     :
                     mOnRender(nullptr),
+                    mNativeRender(nullptr),
+                    mNativeRenderContext(nullptr),
                     mD3DImage(),
                     mWidth(0),
                     mHeight(0),
@@ -72,7 +82,22 @@ namespace System {
                     mD3D10Device(nullptr),
                     mD3D9Surface(nullptr),
                     mDXGISurface(nullptr),
-                    mInitialized(false)
+                    mInitialized(false),
+                    mMonitor(nullptr),
+                    mD3D9Ordinal(D3DADAPTER_DEFAULT),
+                    mAdapterLuid(0),
+                    mNumAdapterChanges(0),
+                    mRecoveryPending(false),
+                    mRecoveryStart(0),
+                    mLastRecoveryMilliseconds(0.0),
+                    mNumRecoveries(0),
+                    mRenderOutsideLock(false),
+                    mD3D9BackBuffer(nullptr),
+                    mCopyQuery(nullptr),
+                    mLastLockMicroseconds(0.0),
+                    mAverageLockMicroseconds(0.0),
+                    mMaxLockMicroseconds(0.0),
+                    mNumLockSamples(0)
                 {
                 }
 
@@ -83,7 +108,29 @@ namespace System {
 
                 DXManager::~DXManager()
                 {
-                    Terminate();
+                    // Detach from the D3DImage and drop the callbacks, so a
+                    // front buffer event or a queued frame that arrives
+                    // after Dispose neither recreates the devices nor calls
+                    // into a native context that the caller has deleted.
+                    // The finalizer must not touch the managed image.
+                    if (mD3DImage != nullptr)
+                    {
+                        mD3DImage->IsFrontBufferAvailableChanged -=
+                            gcnew DependencyPropertyChangedEventHandler(
+                                this, &DXManager::OnIsFrontBufferAvailableChanged);
+                        mD3DImage = nullptr;
+                    }
+                    mOnRender = nullptr;
+                    mNativeRender = nullptr;
+                    mNativeRenderContext = nullptr;
+
+                    this->!DXManager();
+                }
+
+                void DXManager::SetNativeRender(IntPtr function, IntPtr context)
+                {
+                    mNativeRender = reinterpret_cast<NativeRenderFunction>((void*)function);
+                    mNativeRenderContext = (void*)context;
                 }
 
                 void DXManager::OnResize(unsigned int width, unsigned int height)
@@ -123,12 +170,15 @@ namespace System {
                 bool DXManager::InitializeD3D9Ex()
                 {
                     pin_ptr<IDirect3D9Ex*> pinD3D9Ex = &mD3D9;
-                    HRESULT hr = Direct3DCreate9Ex(D3D_SDK_VERSION, pinD3D9Ex);
+                    HRESULT hr = DXM_COM_CALL(CREATE, "DXManager::InitializeD3D9Ex Direct3DCreate9Ex",
+                        Direct3DCreate9Ex(D3D_SDK_VERSION, pinD3D9Ex));
                     if (FAILED(hr))
                     {
                         return false;
                     }
 
+                    SelectAdapter(MonitorFromWindow(mHWnd, MONITOR_DEFAULTTONEAREST));
+
                     D3DPRESENT_PARAMETERS presentParameters{};
                     ZeroMemory(&presentParameters, sizeof(presentParameters));
                     presentParameters.Windowed = TRUE;
@@ -142,14 +192,15 @@ namespace System {
                         D3DCREATE_FPU_PRESERVE;
 
                     pin_ptr<IDirect3DDevice9Ex*> pinD3D9ExDevice = &mD3D9Device;
-                    hr = mD3D9->CreateDeviceEx(
-                        D3DADAPTER_DEFAULT,
-                        D3DDEVTYPE_HAL,
-                        mHWnd,
-                        behaviorFlags,
-                        &presentParameters,
-                        NULL,
-                        pinD3D9ExDevice);
+                    hr = DXM_COM_CALL(CREATE, "DXManager::InitializeD3D9Ex CreateDeviceEx",
+                        mD3D9->CreateDeviceEx(
+                            mD3D9Ordinal,
+                            D3DDEVTYPE_HAL,
+                            mHWnd,
+                            behaviorFlags,
+                            &presentParameters,
+                            NULL,
+                            pinD3D9ExDevice));
                     if (FAILED(hr))
                     {
                         ReleaseInterface(mD3D9);
@@ -159,17 +210,61 @@ namespace System {
                     return true;
                 }
 
+                void DXManager::SelectAdapter(HMONITOR monitor)
+                {
+                    mMonitor = monitor;
+                    mD3D9Ordinal = D3DADAPTER_DEFAULT;
+                    mAdapterLuid = 0;
+
+                    IDXGIFactory1* factory = nullptr;
+                    HRESULT hr = DXM_COM_CALL(CREATE, "DXManager::SelectAdapter CreateDXGIFactory1",
+                        CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void**)&factory));
+                    if (FAILED(hr))
+                    {
+                        return;
+                    }
+
+                    auto adapters = dxm::AdapterSelection::Enumerate(factory);
+                    ReleaseInterface(factory);
+
+                    auto selection = dxm::AdapterSelection::Select(adapters,
+                        dxm::AdapterSelection::Enumerate(mD3D9),
+                        reinterpret_cast<uintptr_t>(monitor));
+                    if (selection.reason != dxm::AdapterSelection::Reason::NONE)
+                    {
+                        mD3D9Ordinal = selection.ordinal;
+                        mAdapterLuid = selection.luid;
+                    }
+                }
+
                 bool DXManager::InitializeD3D10()
                 {
+                    // The D3D10.1 device opens the surface created by the
+                    // D3D9Ex device, so it is created on the same adapter.
+                    IDXGIAdapter1* adapter = nullptr;
+                    if (mAdapterLuid != 0)
+                    {
+                        IDXGIFactory1* factory = nullptr;
+                        HRESULT hr = DXM_COM_CALL(CREATE, "DXManager::InitializeD3D10 CreateDXGIFactory1",
+                            CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void**)&factory));
+                        if (SUCCEEDED(hr))
+                        {
+                            adapter = dxm::AdapterSelection::GetAdapter(factory, mAdapterLuid);
+                            ReleaseInterface(factory);
+                        }
+                    }
+
                     pin_ptr<ID3D10Device1*> pinD3D10Device = &mD3D10Device;
-                    HRESULT hr = D3D10CreateDevice1(
-                        nullptr,
-                        D3D10_DRIVER_TYPE_HARDWARE,
-                        nullptr,
-                        D3D10_CREATE_DEVICE_BGRA_SUPPORT,
-                        D3D10_FEATURE_LEVEL_10_0,
-                        D3D10_1_SDK_VERSION,
-                        pinD3D10Device);
+                    HRESULT hr = DXM_COM_CALL(CREATE, "DXManager::InitializeD3D10 D3D10CreateDevice1",
+                        D3D10CreateDevice1(
+                            adapter,
+                            D3D10_DRIVER_TYPE_HARDWARE,
+                            nullptr,
+                            D3D10_CREATE_DEVICE_BGRA_SUPPORT,
+                            D3D10_FEATURE_LEVEL_10_0,
+                            D3D10_1_SDK_VERSION,
+                            pinD3D10Device));
+                    ReleaseInterface(adapter);
 
                     return SUCCEEDED(hr);
                 }
@@ -177,23 +272,25 @@ namespace System {
                 void DXManager::Terminate()
                 {
                     mInitialized = false;
+                    ReleaseBackBuffer();
                     ReleaseInterface(mDXGISurface);
                     ReleaseInterface(mD3D9Surface);
-                    ReleaseInterface(mD3D10Device);
-                    ReleaseInterface(mD3D9Device);
-                    ReleaseInterface(mD3D9);
+                    ReleaseDevice(mD3D10Device);
+                    ReleaseDevice(mD3D9Device);
+                    ReleaseDevice(mD3D9);
                 }
 
                 bool DXManager::CreateSharedSurface()
                 {
                     IDirect3DTexture9* d3d9Texture = nullptr;
                     HANDLE sharedHandle = nullptr;
-                    HRESULT hr = mD3D9Device->CreateTexture(mWidth, mHeight, 1,
-                        D3DUSAGE_RENDERTARGET,
-                        D3DFMT_A8R8G8B8,
-                        D3DPOOL_DEFAULT,
-                        (IDirect3DTexture9**)&d3d9Texture,
-                        &sharedHandle);
+                    HRESULT hr = DXM_COM_CALL(CREATE, "DXManager::CreateSharedSurface CreateTexture",
+                        mD3D9Device->CreateTexture(mWidth, mHeight, 1,
+                            D3DUSAGE_RENDERTARGET,
+                            D3DFMT_A8R8G8B8,
+                            D3DPOOL_DEFAULT,
+                            (IDirect3DTexture9**)&d3d9Texture,
+                            &sharedHandle));
                     if (FAILED(hr))
                     {
                         return false;
@@ -201,8 +298,10 @@ namespace System {
 
                     ReleaseInterface(mD3D9Surface);
                     pin_ptr<IDirect3DSurface9*> pinD3D9Surface = &mD3D9Surface;
-                    hr = d3d9Texture->GetSurfaceLevel(0, pinD3D9Surface);
-                    d3d9Texture->Release();
+                    hr = DXM_COM_CALL(QUERY_INTERFACE, "DXManager::CreateSharedSurface GetSurfaceLevel",
+                        d3d9Texture->GetSurfaceLevel(0, pinD3D9Surface));
+                    DXM_COM_CALL(RELEASE, "DXManager::CreateSharedSurface Release d3d9Texture",
+                        d3d9Texture->Release());
                     if (FAILED(hr))
                     {
                         ReleaseInterface(d3d9Texture);
@@ -210,8 +309,9 @@ namespace System {
                     }
 
                     ID3D10Texture2D* d3d10Texture = nullptr;
-                    hr = mD3D10Device->OpenSharedResource(sharedHandle,
-                        __uuidof(ID3D10Texture2D), (void**)&d3d10Texture);
+                    hr = DXM_COM_CALL(CREATE, "DXManager::CreateSharedSurface OpenSharedResource",
+                        mD3D10Device->OpenSharedResource(sharedHandle,
+                            __uuidof(ID3D10Texture2D), (void**)&d3d10Texture));
                     if (FAILED(hr))
                     {
                         ReleaseInterface(mD3D9Surface);
@@ -221,9 +321,11 @@ namespace System {
 
                     ReleaseInterface(mDXGISurface);
                     pin_ptr<IDXGISurface*> pinDXGISurface = &mDXGISurface;
-                    hr = d3d10Texture->QueryInterface(__uuidof(IDXGISurface),
-                        (void**)pinDXGISurface);
-                    d3d10Texture->Release();
+                    hr = DXM_COM_CALL(QUERY_INTERFACE, "DXManager::CreateSharedSurface QueryInterface",
+                        d3d10Texture->QueryInterface(__uuidof(IDXGISurface),
+                            (void**)pinDXGISurface));
+                    DXM_COM_CALL(RELEASE, "DXManager::CreateSharedSurface Release d3d10Texture",
+                        d3d10Texture->Release());
                     if (FAILED(hr))
                     {
                         ReleaseInterface(d3d10Texture);
@@ -235,8 +337,207 @@ namespace System {
                     return true;
                 }
 
+                bool DXManager::CreateBackBuffer()
+                {
+                    // The back buffer of the D3DImage must be shareable for
+                    // WPF to open it on its own D3D9Ex device.
+                    ReleaseBackBuffer();
+
+                    IDirect3DTexture9* d3d9Texture = nullptr;
+                    HANDLE sharedHandle = nullptr;
+                    HRESULT hr = DXM_COM_CALL(CREATE, "DXManager::CreateBackBuffer CreateTexture",
+                        mD3D9Device->CreateTexture(mWidth, mHeight, 1,
+                            D3DUSAGE_RENDERTARGET,
+                            D3DFMT_A8R8G8B8,
+                            D3DPOOL_DEFAULT,
+                            (IDirect3DTexture9**)&d3d9Texture,
+                            &sharedHandle));
+                    if (FAILED(hr))
+                    {
+                        return false;
+                    }
+
+                    pin_ptr<IDirect3DSurface9*> pinD3D9BackBuffer = &mD3D9BackBuffer;
+                    hr = DXM_COM_CALL(QUERY_INTERFACE, "DXManager::CreateBackBuffer GetSurfaceLevel",
+                        d3d9Texture->GetSurfaceLevel(0, pinD3D9BackBuffer));
+                    DXM_COM_CALL(RELEASE, "DXManager::CreateBackBuffer Release d3d9Texture",
+                        d3d9Texture->Release());
+                    if (FAILED(hr))
+                    {
+                        return false;
+                    }
+
+                    pin_ptr<IDirect3DQuery9*> pinCopyQuery = &mCopyQuery;
+                    hr = DXM_COM_CALL(CREATE, "DXManager::CreateBackBuffer CreateQuery",
+                        mD3D9Device->CreateQuery(D3DQUERYTYPE_EVENT, pinCopyQuery));
+                    if (FAILED(hr))
+                    {
+                        ReleaseBackBuffer();
+                        return false;
+                    }
+
+                    return true;
+                }
+
+                void DXManager::ReleaseBackBuffer()
+                {
+                    ReleaseInterface(mCopyQuery);
+                    ReleaseInterface(mD3D9BackBuffer);
+                }
+
+                bool DXManager::CopyToBackBuffer()
+                {
+                    // The native code waited for its device to finish the
+                    // frame, so mD3D9Surface is complete. WPF reads the back
+                    // buffer after Unlock, so the copy must be finished too.
+                    HRESULT hr = mD3D9Device->StretchRect(mD3D9Surface, nullptr,
+                        mD3D9BackBuffer, nullptr, D3DTEXF_NONE);
+                    if (FAILED(hr))
+                    {
+                        return false;
+                    }
+
+                    hr = mCopyQuery->Issue(D3DISSUE_END);
+                    if (FAILED(hr))
+                    {
+                        return false;
+                    }
+                    while (S_FALSE == (hr = mCopyQuery->GetData(nullptr, 0, D3DGETDATA_FLUSH)))
+                    {
+                    }
+                    return SUCCEEDED(hr);
+                }
+
+                bool DXManager::DevicesAreValid()
+                {
+                    // S_PRESENT_OCCLUDED and S_PRESENT_MODE_CHANGED do not
+                    // affect the offscreen shared surface, so only the
+                    // device-lost codes require the devices to be recreated.
+                    HRESULT hr = mD3D9Device->CheckDeviceState(nullptr);
+                    if (hr == D3DERR_DEVICELOST ||
+                        hr == D3DERR_DEVICEHUNG ||
+                        hr == D3DERR_DEVICEREMOVED ||
+                        hr == D3DERR_OUTOFVIDEOMEMORY)
+                    {
+                        return false;
+                    }
+
+                    return mD3D10Device->GetDeviceRemovedReason() == S_OK;
+                }
+
+                void DXManager::BeginRecovery()
+                {
+                    if (!mRecoveryPending)
+                    {
+                        mRecoveryPending = true;
+                        mRecoveryStart = System::Diagnostics::Stopwatch::GetTimestamp();
+                    }
+                }
+
+                void DXManager::OnIsFrontBufferAvailableChanged(Object^ sender,
+                    DependencyPropertyChangedEventArgs args)
+                {
+                    (void)sender;
+
+                    if (static_cast<bool>(args.NewValue))
+                    {
+                        // WPF dropped its reference to the back buffer while
+                        // the front buffer was unavailable (lock screen, RDP
+                        // reconnect, display mode change). Repaint now rather
+                        // than waiting for the application to request the
+                        // next frame. The surface is recreated because the
+                        // devices might have been lost in the meantime.
+                        if (mD3DImage != nullptr && mHWnd != nullptr)
+                        {
+                            Render(true);
+                        }
+                    }
+                    else
+                    {
+                        BeginRecovery();
+                    }
+                }
+
+                void DXManager::InvokeRender(bool resize)
+                {
+                    if (mNativeRender != nullptr)
+                    {
+                        mNativeRender(mNativeRenderContext, mDXGISurface, resize);
+                    }
+                    else if (mOnRender != nullptr)
+                    {
+                        DXM_TRACE_SCOPE("DXManager::OnRender");
+                        mOnRender((IntPtr)(void*)mDXGISurface, resize);
+                    }
+                }
+
+                void DXManager::UpdateLockStatistics(Int64 ticks)
+                {
+                    double microseconds = 1.0e6 * static_cast<double>(ticks) /
+                        static_cast<double>(System::Diagnostics::Stopwatch::Frequency);
+
+                    mLastLockMicroseconds = microseconds;
+                    if (microseconds > mMaxLockMicroseconds)
+                    {
+                        mMaxLockMicroseconds = microseconds;
+                    }
+
+                    // An exponential moving average over roughly the last
+                    // 32 frames, initialized by the first measurement.
+                    if (mNumLockSamples++ == 0)
+                    {
+                        mAverageLockMicroseconds = microseconds;
+                    }
+                    else
+                    {
+                        mAverageLockMicroseconds += (microseconds - mAverageLockMicroseconds) / 32.0;
+                    }
+                }
+
+                void DXManager::ResetLockStatistics()
+                {
+                    mLastLockMicroseconds = 0.0;
+                    mAverageLockMicroseconds = 0.0;
+                    mMaxLockMicroseconds = 0.0;
+                    mNumLockSamples = 0;
+                }
+
                 void DXManager::Render(bool resize)
                 {
+                    DXM_TRACE_SCOPE("DXManager::Render");
+
+                    // A lost or removed device invalidates the shared
+                    // surface. Both devices and the surface are recreated,
+                    // and 'resize' tells the native code to reopen its
+                    // render target on the new surface.
+                    if (mInitialized && !DevicesAreValid())
+                    {
+                        BeginRecovery();
+                        Terminate();
+                        resize = true;
+                    }
+
+                    // When the window moves to a monitor of another adapter,
+                    // the devices and the surface are recreated on that
+                    // adapter so that WPF does not copy every frame between
+                    // the adapters. The native code recreates its device
+                    // when it sees the surface on the new adapter.
+                    if (mInitialized)
+                    {
+                        HMONITOR monitor = MonitorFromWindow(mHWnd, MONITOR_DEFAULTTONEAREST);
+                        if (monitor != mMonitor)
+                        {
+                            UInt64 adapterLuid = mAdapterLuid;
+                            SelectAdapter(monitor);
+                            if (mAdapterLuid != adapterLuid)
+                            {
+                                Terminate();
+                                resize = true;
+                                ++mNumAdapterChanges;
+                            }
+                        }
+                    }
+
                     if (!Initialize())
                     {
                         return;
@@ -244,25 +545,96 @@ namespace System {
 
                     if (mD3D9Surface == nullptr || resize)
                     {
+                        DXM_TRACE_SCOPE("DXManager::CreateSharedSurface");
                         if (!CreateSharedSurface())
                         {
                             return;
                         }
                     }
 
-                    mD3DImage->Lock();
+                    // In the render-outside-lock mode, the frame is drawn and
+                    // the GPU has finished it before the lock is taken. WPF
+                    // copies its back buffer on the render thread after
+                    // Unlock, and Lock waits for that copy, so the frame is
+                    // drawn into mD3D9Surface, which WPF does not hold, and
+                    // copied to mD3D9BackBuffer under the lock. Otherwise the
+                    // frame is drawn into mD3D9Surface under the lock and
+                    // mD3D9Surface is the back buffer.
+                    IDirect3DSurface9* backBuffer = mD3D9Surface;
+                    if (mRenderOutsideLock)
                     {
-                        mOnRender((IntPtr)(void*)mDXGISurface, resize);
+                        if (mD3D9BackBuffer == nullptr || resize)
+                        {
+                            DXM_TRACE_SCOPE("DXManager::CreateBackBuffer");
+                            if (!CreateBackBuffer())
+                            {
+                                return;
+                            }
+                        }
+                        backBuffer = mD3D9BackBuffer;
+                        InvokeRender(resize);
+                    }
+
+                    Int64 lockStart = System::Diagnostics::Stopwatch::GetTimestamp();
+                    {
+                        DXM_TRACE_SCOPE("DXManager::Lock");
+                        mD3DImage->Lock();
+                    }
+                    {
+                        DXM_TRACE_SCOPE("DXManager::LockHeld");
+
+                        if (mRenderOutsideLock)
+                        {
+                            DXM_TRACE_SCOPE("DXManager::CopyToBackBuffer");
+                            if (!CopyToBackBuffer())
+                            {
+                                // The device was lost during the copy. The
+                                // next Render call recreates the devices.
+                                BeginRecovery();
+                                mD3DImage->Unlock();
+                                return;
+                            }
+                        }
+                        else
+                        {
+                            InvokeRender(resize);
+                        }
+
+                        {
+                            DXM_TRACE_SCOPE("DXManager::SetBackBuffer");
+                            mD3DImage->SetBackBuffer(
+                                System::Windows::Interop::D3DResourceType::IDirect3DSurface9,
+                                (IntPtr)(void*)backBuffer,
+                                true);
+                        }
 
-                        mD3DImage->SetBackBuffer(
-                            System::Windows::Interop::D3DResourceType::IDirect3DSurface9,
-                            (IntPtr)(void*)mD3D9Surface,
-                            true);
+                        {
+                            DXM_TRACE_SCOPE("DXManager::AddDirtyRect");
+                            mD3DImage->AddDirtyRect(
+                                Int32Rect(0, 0, mD3DImage->PixelWidth, mD3DImage->PixelHeight));
+                        }
+                    }
+                    {
+                        DXM_TRACE_SCOPE("DXManager::Unlock");
+                        mD3DImage->Unlock();
+                    }
+                    UpdateLockStatistics(System::Diagnostics::Stopwatch::GetTimestamp() - lockStart);
 
-                        mD3DImage->AddDirtyRect(
-                            Int32Rect(0, 0, mD3DImage->PixelWidth, mD3DImage->PixelHeight));
+                    // After leaving the mode, WPF holds its own reference to
+                    // the last copied frame until the next SetBackBuffer.
+                    if (!mRenderOutsideLock && mD3D9BackBuffer != nullptr)
+                    {
+                        ReleaseBackBuffer();
+                    }
+
+                    if (mRecoveryPending && mD3DImage->IsFrontBufferAvailable)
+                    {
+                        Int64 elapsed = System::Diagnostics::Stopwatch::GetTimestamp() - mRecoveryStart;
+                        mLastRecoveryMilliseconds = 1000.0 * static_cast<double>(elapsed) /
+                            static_cast<double>(System::Diagnostics::Stopwatch::Frequency);
+                        ++mNumRecoveries;
+                        mRecoveryPending = false;
                     }
-                    mD3DImage->Unlock();
                 }
 
             }
@@ -61,10 +61,18 @@ namespace System {
         namespace Interop {
             namespace DirectX {
 
+                // A native render callback. It receives the context passed to
+                // DXManager::SetNativeRender, the IDXGISurface shared with WPF
+                // and the 'resize' flag of DXManager::Render.
+                typedef void (*NativeRenderFunction)(void* context,
+                    void* wpfBackBuffer, bool resize);
+
                 public ref class DXManager : IDisposable
                 {
                 private:
                     Action<IntPtr, bool>^ mOnRender;
+                    NativeRenderFunction mNativeRender;
+                    void* mNativeRenderContext;
                     D3DImage^ mD3DImage;
                     UINT mWidth, mHeight;
                     HWND mHWnd;
@@ -75,6 +83,37 @@ namespace System {
                     IDXGISurface* mDXGISurface;
                     bool mInitialized;
 
+                    // The devices are created on the adapter of the monitor
+                    // of the window, which is the adapter on which WPF
+                    // composes the surface. See dxm::AdapterSelection. The
+                    // LUID is 0 when the runtime defaults are used.
+                    HMONITOR mMonitor;
+                    UINT mD3D9Ordinal;
+                    UInt64 mAdapterLuid;
+                    unsigned int mNumAdapterChanges;
+
+                    // Device-loss and front-buffer-loss recovery. The time is
+                    // measured from the detection of the loss to the end of
+                    // the first Render call that hands a new frame to WPF.
+                    bool mRecoveryPending;
+                    Int64 mRecoveryStart;
+                    double mLastRecoveryMilliseconds;
+                    unsigned int mNumRecoveries;
+
+                    // When 'true', the frame is rendered before the D3DImage is
+                    // locked, into mD3D9Surface, which WPF never holds. Under
+                    // the lock the finished frame is copied to mD3D9BackBuffer,
+                    // the surface given to WPF, and mCopyQuery waits for the
+                    // copy. The time the lock is held is measured for both
+                    // modes.
+                    bool mRenderOutsideLock;
+                    IDirect3DSurface9* mD3D9BackBuffer;
+                    IDirect3DQuery9* mCopyQuery;
+                    double mLastLockMicroseconds;
+                    double mAverageLockMicroseconds;
+                    double mMaxLockMicroseconds;
+                    unsigned int mNumLockSamples;
+
                 public:
                     DXManager();
                     !DXManager();
@@ -98,12 +137,23 @@ namespace System {
                             {
                                 if (nullptr != mD3DImage)
                                 {
+                                    mD3DImage->IsFrontBufferAvailableChanged -=
+                                        gcnew DependencyPropertyChangedEventHandler(
+                                            this, &DXManager::OnIsFrontBufferAvailableChanged);
+
                                     mD3DImage->SetBackBuffer(
                                         System::Windows::Interop::D3DResourceType::IDirect3DSurface9,
                                         (IntPtr)nullptr);
                                 }
 
                                 mD3DImage = d3dImage;
+
+                                if (nullptr != mD3DImage)
+                                {
+                                    mD3DImage->IsFrontBufferAvailableChanged +=
+                                        gcnew DependencyPropertyChangedEventHandler(
+                                            this, &DXManager::OnIsFrontBufferAvailableChanged);
+                                }
                             }
                         }
                     }
@@ -124,21 +174,120 @@ namespace System {
                         }
                     }
 
+                    property double DXManager::LastRecoveryMilliseconds
+                    {
+                        double get()
+                        {
+                            return mLastRecoveryMilliseconds;
+                        }
+                    }
+
+                    property unsigned int DXManager::NumRecoveries
+                    {
+                        unsigned int get()
+                        {
+                            return mNumRecoveries;
+                        }
+                    }
+
+                    // The LUID of the adapter of the devices and the number
+                    // of times the devices were recreated on another adapter
+                    // because the window moved to a monitor of that adapter.
+                    // These are not counted as recoveries.
+                    property UInt64 DXManager::AdapterLuid
+                    {
+                        UInt64 get()
+                        {
+                            return mAdapterLuid;
+                        }
+                    }
+
+                    property unsigned int DXManager::NumAdapterChanges
+                    {
+                        unsigned int get()
+                        {
+                            return mNumAdapterChanges;
+                        }
+                    }
+
+                    // Render the frame, including the wait for the GPU, before
+                    // locking the D3DImage, into a surface that WPF does not
+                    // hold, so that WPF never reads a partly drawn frame. The
+                    // lock covers the copy of the finished frame to the back
+                    // buffer of the D3DImage, SetBackBuffer and AddDirtyRect.
+                    // The mode costs a second surface and a copy per frame.
+                    // Changing the mode resets the lock statistics.
+                    property bool DXManager::RenderOutsideLock
+                    {
+                        bool get() { return mRenderOutsideLock; }
+
+                        void set(bool value)
+                        {
+                            if (value != mRenderOutsideLock)
+                            {
+                                mRenderOutsideLock = value;
+                                ResetLockStatistics();
+                            }
+                        }
+                    }
+
+                    // The time from the Lock call to the return of Unlock.
+                    property double DXManager::LastLockMicroseconds
+                    {
+                        double get() { return mLastLockMicroseconds; }
+                    }
+
+                    property double DXManager::AverageLockMicroseconds
+                    {
+                        double get() { return mAverageLockMicroseconds; }
+                    }
+
+                    property double DXManager::MaxLockMicroseconds
+                    {
+                        double get() { return mMaxLockMicroseconds; }
+                    }
+
+                    void ResetLockStatistics();
+
                     property IntPtr DXManager::HWND
                     {
                         IntPtr get() { return (IntPtr)(void*)mHWnd; }
                         void set(IntPtr hwnd) { mHWnd = (::HWND)(void*)hwnd; }
                     }
 
+                    // When 'function' is not zero, Render calls it directly with
+                    // 'context' instead of invoking OnRender, so a frame has no
+                    // managed-to-managed hops and allocates nothing. Passing a
+                    // zero 'function' restores the OnRender delegate.
+                    void SetNativeRender(IntPtr function, IntPtr context);
+
+                    property bool DXManager::HasRenderCallback
+                    {
+                        bool get()
+                        {
+                            return mNativeRender != nullptr || mOnRender != nullptr;
+                        }
+                    }
+
                     void OnResize(unsigned int width, unsigned int height);
                     void OnRequestRender();
 
                 private:
                     bool Initialize();
                     bool InitializeD3D9Ex();
+                    void SelectAdapter(HMONITOR monitor);
                     bool InitializeD3D10();
                     void Terminate();
                     bool CreateSharedSurface();
+                    bool CreateBackBuffer();
+                    void ReleaseBackBuffer();
+                    bool CopyToBackBuffer();
+                    bool DevicesAreValid();
+                    void BeginRecovery();
+                    void OnIsFrontBufferAvailableChanged(Object^ sender,
+                        DependencyPropertyChangedEventArgs args);
+                    void InvokeRender(bool resize);
+                    void UpdateLockStatistics(Int64 ticks);
                     void Render(bool resize);
                 };
 
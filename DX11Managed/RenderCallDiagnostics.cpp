@@ -0,0 +1,93 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include <msclr/marshal_cppstd.h>
+#include "RenderCallDiagnostics.h"
+#include "DXManager.h"
+#include <string>
+
+#pragma managed(push, off)
+namespace
+{
+    void NativeProbeFunction(void* context, void* wpfBackBuffer, bool recreateRenderTarget)
+    {
+        (void)context;
+        (void)wpfBackBuffer;
+        (void)recreateRenderTarget;
+    }
+
+    std::string ManagedProbeFunction(void* wpfBackBuffer, bool recreateRenderTarget)
+    {
+        (void)wpfBackBuffer;
+        (void)recreateRenderTarget;
+        return "";
+    }
+}
+#pragma managed(pop)
+
+namespace System {
+    namespace Windows {
+        namespace Interop {
+            namespace DirectX {
+
+                IntPtr RenderCallDiagnostics::NativeProbe::get()
+                {
+                    return IntPtr(reinterpret_cast<void*>(&NativeProbeFunction));
+                }
+
+                bool RenderCallDiagnostics::ManagedProbe(IntPtr wpfBackBuffer,
+                    bool recreateRenderTarget)
+                {
+                    std::string nativeExceptionMessage = ManagedProbeFunction(
+                        (void*)wpfBackBuffer, recreateRenderTarget);
+                    String^ exceptionMessage = msclr::interop::marshal_as<String^>(nativeExceptionMessage);
+                    return (exceptionMessage->Length == 0);
+                }
+
+                double RenderCallDiagnostics::Measure(IntPtr function, IntPtr context,
+                    unsigned int numCalls)
+                {
+                    NativeRenderFunction nativeFunction =
+                        reinterpret_cast<NativeRenderFunction>((void*)function);
+                    if (numCalls == 0 || nativeFunction == nullptr)
+                    {
+                        return 0.0;
+                    }
+
+                    Int64 start = System::Diagnostics::Stopwatch::GetTimestamp();
+                    for (unsigned int i = 0; i < numCalls; ++i)
+                    {
+                        nativeFunction((void*)context, nullptr, false);
+                    }
+                    Int64 elapsed = System::Diagnostics::Stopwatch::GetTimestamp() - start;
+
+                    return 1.0e9 * static_cast<double>(elapsed) /
+                        (static_cast<double>(System::Diagnostics::Stopwatch::Frequency) * numCalls);
+                }
+
+                double RenderCallDiagnostics::Measure(Action<IntPtr, bool>^ callback,
+                    unsigned int numCalls)
+                {
+                    if (numCalls == 0 || callback == nullptr)
+                    {
+                        return 0.0;
+                    }
+
+                    Int64 start = System::Diagnostics::Stopwatch::GetTimestamp();
+                    for (unsigned int i = 0; i < numCalls; ++i)
+                    {
+                        callback(IntPtr::Zero, false);
+                    }
+                    Int64 elapsed = System::Diagnostics::Stopwatch::GetTimestamp() - start;
+
+                    return 1.0e9 * static_cast<double>(elapsed) /
+                        (static_cast<double>(System::Diagnostics::Stopwatch::Frequency) * numCalls);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,50 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#pragma once
+
+using namespace System;
+
+namespace System {
+    namespace Windows {
+        namespace Interop {
+            namespace DirectX {
+
+                // Diagnostics for measuring the cost of reaching native code
+                // through the two render paths, kept apart from the render
+                // API. The probes do not render; each crosses the same
+                // transitions as the entry point it stands in for.
+                public ref class RenderCallDiagnostics abstract sealed
+                {
+                public:
+                    // A native function with the NativeRenderFunction
+                    // signature that returns at once, the stand-in for
+                    // DX11Managed::NativeRenderFunction. Its context is unused.
+                    static property IntPtr NativeProbe
+                    {
+                        IntPtr get();
+                    }
+
+                    // Calls a native function that returns an empty message and
+                    // marshals the message, as DX11Managed::RenderFrame does.
+                    // The stand-in for RenderFrame in a managed OnRender
+                    // callback. The return value is 'true'.
+                    static bool ManagedProbe(IntPtr wpfBackBuffer, bool recreateRenderTarget);
+
+                    // Call a native function with the NativeRenderFunction
+                    // signature, or a delegate with the OnRender signature,
+                    // 'numCalls' times with a null back buffer and return the
+                    // average time per call in nanoseconds.
+                    static double Measure(IntPtr function, IntPtr context,
+                        unsigned int numCalls);
+                    static double Measure(Action<IntPtr, bool>^ callback,
+                        unsigned int numCalls);
+                };
+            }
+        }
+    }
+}
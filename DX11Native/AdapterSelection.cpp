@@ -0,0 +1,235 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "AdapterSelection.h"
+#include "ComAccounting.h"
+#include <d3d9.h>
+#include <dxgi.h>
+#include <algorithm>
+#include <array>
+using namespace dxm;
+
+namespace
+{
+    uint64_t ToKey(LUID const& luid)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(luid.HighPart)) << 32) |
+            static_cast<uint64_t>(luid.LowPart);
+    }
+
+    // The first D3D9 ordinal with the LUID, preferring the one on the
+    // monitor. The return value is 'false' when the LUID has no ordinal.
+    bool FindOrdinal(std::vector<AdapterSelection::D3D9Adapter> const& d3d9Adapters,
+        uint64_t luid, uintptr_t monitor, uint32_t& ordinal)
+    {
+        bool found = false;
+        for (auto const& d3d9Adapter : d3d9Adapters)
+        {
+            if (d3d9Adapter.luid == luid)
+            {
+                if (d3d9Adapter.monitor == monitor)
+                {
+                    ordinal = d3d9Adapter.ordinal;
+                    return true;
+                }
+                if (!found)
+                {
+                    ordinal = d3d9Adapter.ordinal;
+                    found = true;
+                }
+            }
+        }
+        return found;
+    }
+}
+
+AdapterSelection::Selection AdapterSelection::Select(std::vector<Adapter> const& adapters,
+    std::vector<D3D9Adapter> const& d3d9Adapters, uintptr_t monitor)
+{
+    // The candidates in the order of the rules, each with the first
+    // matching adapter in DXGI order, which lists the adapter of the
+    // primary display first.
+    Selection const none{ Reason::NONE, 0, 0, 0 };
+    std::array<Selection, 3> selections = { none, none, none };
+
+    uint32_t primaryOrdinal = 0xFFFFFFFFu;
+    uint64_t primaryLuid = 0;
+    for (auto const& d3d9Adapter : d3d9Adapters)
+    {
+        if (d3d9Adapter.ordinal < primaryOrdinal)
+        {
+            primaryOrdinal = d3d9Adapter.ordinal;
+            primaryLuid = d3d9Adapter.luid;
+        }
+    }
+
+    for (size_t i = 0; i < adapters.size(); ++i)
+    {
+        Adapter const& adapter = adapters[i];
+        uint32_t ordinal = 0;
+        if (adapter.software ||
+            !FindOrdinal(d3d9Adapters, adapter.luid, monitor, ordinal))
+        {
+            continue;
+        }
+
+        Selection const candidate{ Reason::NONE, adapter.luid, i, ordinal };
+        if (selections[0].reason == Reason::NONE &&
+            std::find(adapter.monitors.begin(), adapter.monitors.end(), monitor) !=
+            adapter.monitors.end())
+        {
+            selections[0] = candidate;
+            selections[0].reason = Reason::MONITOR;
+        }
+
+        if (selections[1].reason == Reason::NONE)
+        {
+            for (auto const& d3d9Adapter : d3d9Adapters)
+            {
+                if (d3d9Adapter.luid == adapter.luid && d3d9Adapter.monitor == monitor)
+                {
+                    selections[1] = candidate;
+                    selections[1].reason = Reason::D3D9_MONITOR;
+                    break;
+                }
+            }
+        }
+
+        if (selections[2].reason == Reason::NONE && adapter.luid == primaryLuid)
+        {
+            selections[2] = candidate;
+            selections[2].reason = Reason::PRIMARY;
+        }
+    }
+
+    for (auto const& selection : selections)
+    {
+        if (selection.reason != Reason::NONE)
+        {
+            return selection;
+        }
+    }
+    return selections[0];
+}
+
+std::vector<AdapterSelection::Adapter> AdapterSelection::Enumerate(IDXGIFactory1* factory)
+{
+    std::vector<Adapter> adapters;
+    IDXGIAdapter1* dxgiAdapter = nullptr;
+    for (UINT i = 0; factory->EnumAdapters1(i, &dxgiAdapter) != DXGI_ERROR_NOT_FOUND; ++i)
+    {
+        DXGI_ADAPTER_DESC1 desc{};
+        if (SUCCEEDED(dxgiAdapter->GetDesc1(&desc)))
+        {
+            Adapter adapter{};
+            adapter.luid = ToKey(desc.AdapterLuid);
+            for (size_t j = 0; j < 128 && desc.Description[j] != 0; ++j)
+            {
+                // The descriptions are for diagnostics; non-ASCII
+                // characters are replaced.
+                wchar_t const c = desc.Description[j];
+                adapter.description.push_back(c < 128 ? static_cast<char>(c) : '?');
+            }
+            adapter.software = ((desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) != 0);
+            adapter.dedicatedVideoMemory = static_cast<uint64_t>(desc.DedicatedVideoMemory);
+
+            IDXGIOutput* output = nullptr;
+            for (UINT j = 0; dxgiAdapter->EnumOutputs(j, &output) != DXGI_ERROR_NOT_FOUND; ++j)
+            {
+                DXGI_OUTPUT_DESC outputDesc{};
+                if (SUCCEEDED(output->GetDesc(&outputDesc)))
+                {
+                    adapter.monitors.push_back(reinterpret_cast<uintptr_t>(outputDesc.Monitor));
+                }
+                DXM_COM_CALL(RELEASE, "AdapterSelection::Enumerate Release output",
+                    output->Release());
+            }
+            adapters.push_back(adapter);
+        }
+        DXM_COM_CALL(RELEASE, "AdapterSelection::Enumerate Release adapter",
+            dxgiAdapter->Release());
+    }
+    return adapters;
+}
+
+std::vector<AdapterSelection::D3D9Adapter> AdapterSelection::Enumerate(IDirect3D9Ex* d3d9)
+{
+    std::vector<D3D9Adapter> d3d9Adapters;
+    UINT const numOrdinals = d3d9->GetAdapterCount();
+    for (UINT ordinal = 0; ordinal < numOrdinals; ++ordinal)
+    {
+        LUID luid{};
+        if (SUCCEEDED(d3d9->GetAdapterLUID(ordinal, &luid)))
+        {
+            d3d9Adapters.push_back(D3D9Adapter{ ordinal, ToKey(luid),
+                reinterpret_cast<uintptr_t>(d3d9->GetAdapterMonitor(ordinal)) });
+        }
+    }
+    return d3d9Adapters;
+}
+
+IDXGIAdapter1* AdapterSelection::GetAdapter(IDXGIFactory1* factory, uint64_t luid)
+{
+    IDXGIAdapter1* dxgiAdapter = nullptr;
+    for (UINT i = 0; factory->EnumAdapters1(i, &dxgiAdapter) != DXGI_ERROR_NOT_FOUND; ++i)
+    {
+        DXGI_ADAPTER_DESC1 desc{};
+        if (SUCCEEDED(dxgiAdapter->GetDesc1(&desc)) && ToKey(desc.AdapterLuid) == luid)
+        {
+            return dxgiAdapter;
+        }
+        DXM_COM_CALL(RELEASE, "AdapterSelection::GetAdapter Release adapter",
+            dxgiAdapter->Release());
+    }
+    return nullptr;
+}
+
+uint64_t AdapterSelection::GetAdapterLuid(IUnknown* object)
+{
+    IDXGIDevice* device = nullptr;
+    HRESULT hr = DXM_COM_CALL(QUERY_INTERFACE,
+        "AdapterSelection::GetAdapterLuid QueryInterface IDXGIDevice",
+        object->QueryInterface(__uuidof(IDXGIDevice), (void**)&device));
+    if (FAILED(hr))
+    {
+        IDXGIDeviceSubObject* subObject = nullptr;
+        hr = DXM_COM_CALL(QUERY_INTERFACE,
+            "AdapterSelection::GetAdapterLuid QueryInterface IDXGIDeviceSubObject",
+            object->QueryInterface(__uuidof(IDXGIDeviceSubObject), (void**)&subObject));
+        if (FAILED(hr))
+        {
+            return 0;
+        }
+
+        hr = DXM_COM_CALL(QUERY_INTERFACE, "AdapterSelection::GetAdapterLuid GetDevice",
+            subObject->GetDevice(__uuidof(IDXGIDevice), (void**)&device));
+        DXM_COM_CALL(RELEASE, "AdapterSelection::GetAdapterLuid Release sub-object",
+            subObject->Release());
+        if (FAILED(hr))
+        {
+            return 0;
+        }
+    }
+
+    uint64_t luid = 0;
+    IDXGIAdapter* dxgiAdapter = nullptr;
+    hr = DXM_COM_CALL(QUERY_INTERFACE, "AdapterSelection::GetAdapterLuid GetAdapter",
+        device->GetAdapter(&dxgiAdapter));
+    if (SUCCEEDED(hr))
+    {
+        DXGI_ADAPTER_DESC desc{};
+        if (SUCCEEDED(dxgiAdapter->GetDesc(&desc)))
+        {
+            luid = ToKey(desc.AdapterLuid);
+        }
+        DXM_COM_CALL(RELEASE, "AdapterSelection::GetAdapterLuid Release adapter",
+            dxgiAdapter->Release());
+    }
+    DXM_COM_CALL(RELEASE, "AdapterSelection::GetAdapterLuid Release device",
+        device->Release());
+    return luid;
+}
@@ -0,0 +1,101 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// AdapterSelection chooses the GPU on which the D3D9Ex device of DXManager,
+// its D3D10.1 device and the D3D11 device of Application are created. The
+// shared surface is opened by all three devices and composed by WPF on the
+// adapter of the window's monitor; when the devices are on different
+// adapters, for example on a hybrid-GPU laptop or a multi-GPU workstation,
+// every frame is copied between adapters. The adapters are identified by
+// their LUIDs, which D3D9Ex (GetAdapterLUID) and DXGI (the adapter
+// description) both report. A LUID is stored as a 64-bit value with the
+// HighPart in the upper 32 bits.
+//
+// Select depends only on the adapter lists, so the policy can be tested
+// with fake adapters. The Enumerate and Get functions fill the lists and
+// look up adapters on Windows.
+
+struct IUnknown;
+struct IDirect3D9Ex;
+struct IDXGIAdapter1;
+struct IDXGIFactory1;
+
+namespace dxm
+{
+    class AdapterSelection
+    {
+    public:
+        // A DXGI adapter and the monitors (HMONITOR values) of its outputs.
+        struct Adapter
+        {
+            uint64_t luid;
+            std::string description;
+            bool software;
+            uint64_t dedicatedVideoMemory;
+            std::vector<uintptr_t> monitors;
+        };
+
+        // A D3D9 adapter ordinal. An adapter with several outputs has an
+        // ordinal per output, all with the same LUID.
+        struct D3D9Adapter
+        {
+            uint32_t ordinal;
+            uint64_t luid;
+            uintptr_t monitor;
+        };
+
+        enum class Reason
+        {
+            // A DXGI output of the adapter is on the monitor.
+            MONITOR,
+            // The D3D9 ordinal of the monitor has the adapter's LUID (the
+            // DXGI adapter has no outputs or they were not reported).
+            D3D9_MONITOR,
+            // No adapter is on the monitor; the adapter of D3D9 ordinal 0,
+            // the primary display, is used.
+            PRIMARY,
+            // No hardware adapter is known to both D3D9 and DXGI. The
+            // devices are created on the defaults of the runtimes.
+            NONE
+        };
+
+        struct Selection
+        {
+            Reason reason;
+            uint64_t luid;
+            size_t adapter;
+            uint32_t ordinal;
+        };
+
+        // Select the adapter for a window on 'monitor'. Only hardware DXGI
+        // adapters that have a D3D9 ordinal with the same LUID are
+        // candidates. The D3D9 ordinal is the one on the monitor when the
+        // adapter has one there, otherwise its first ordinal. For Reason
+        // NONE, 'adapter' and 'ordinal' are 0 and 'luid' is 0.
+        static Selection Select(std::vector<Adapter> const& adapters,
+            std::vector<D3D9Adapter> const& d3d9Adapters, uintptr_t monitor);
+
+        // The DXGI adapters of a factory and the D3D9 adapter ordinals.
+        static std::vector<Adapter> Enumerate(IDXGIFactory1* factory);
+        static std::vector<D3D9Adapter> Enumerate(IDirect3D9Ex* d3d9);
+
+        // The adapter of a factory with the LUID, with a reference the
+        // caller releases, or null.
+        static IDXGIAdapter1* GetAdapter(IDXGIFactory1* factory, uint64_t luid);
+
+        // The LUID of the adapter of a DXGI device, or of the device that
+        // owns a DXGI resource (a D3D10 or D3D11 device and its textures
+        // are both). The return value is 0 when the object is neither.
+        static uint64_t GetAdapterLuid(IUnknown* object);
+    };
+}
@@ -6,9 +6,101 @@
 // Version: 1.0.2022.07.01
 
 #include "Application.h"
+#include "AdapterSelection.h"
+#include "CullingKernels.h"
+#include "FramePacer.h"
+#include "Trace.h"
+#include <dxgi.h>
+#include <cstdio>
 #include <stdexcept>
 using namespace dxm;
 
+namespace
+{
+    // Ends the ComAccounting frame on every return path of RenderFrame.
+    // The frame is in steady state unless the device or render target is
+    // recreated in it. DXM_COM_CALL records the calls of every loop, so
+    // every loop ends its frames, also those without instrumentation;
+    // otherwise their calls would accumulate in the frame that the next
+    // instrumented loop ends. EndFrame returns at once while accounting
+    // is disabled.
+    class AccountingFrame
+    {
+    public:
+        AccountingFrame()
+            :
+            mSteadyState(true)
+        {
+        }
+
+        ~AccountingFrame()
+        {
+            ComAccounting::EndFrame(mSteadyState);
+        }
+
+        AccountingFrame(AccountingFrame const&) = delete;
+        AccountingFrame& operator=(AccountingFrame const&) = delete;
+
+        inline void MarkTransient()
+        {
+            mSteadyState = false;
+        }
+
+    private:
+        bool mSteadyState;
+    };
+
+    // Brackets the GPU work of an overlay frame with the disjoint and
+    // timestamp queries. If the frame throws after Begin, the destructor
+    // ends the disjoint query, so that it is not left open when the next
+    // frame begins it.
+    class TimestampFrame
+    {
+    public:
+        TimestampFrame()
+            :
+            mContext(nullptr),
+            mDisjointQuery(nullptr)
+        {
+        }
+
+        ~TimestampFrame()
+        {
+            End(nullptr);
+        }
+
+        TimestampFrame(TimestampFrame const&) = delete;
+        TimestampFrame& operator=(TimestampFrame const&) = delete;
+
+        void Begin(ID3D11DeviceContext* context, ID3D11Query* disjointQuery,
+            ID3D11Query* beginQuery)
+        {
+            mContext = context;
+            mDisjointQuery = disjointQuery;
+            mContext->Begin(mDisjointQuery);
+            mContext->End(beginQuery);
+        }
+
+        // The end timestamp is not written on the exception path.
+        void End(ID3D11Query* endQuery)
+        {
+            if (mContext)
+            {
+                if (endQuery)
+                {
+                    mContext->End(endQuery);
+                }
+                mContext->End(mDisjointQuery);
+                mContext = nullptr;
+            }
+        }
+
+    private:
+        ID3D11DeviceContext* mContext;
+        ID3D11Query* mDisjointQuery;
+    };
+}
+
 Application* Application::Create(std::string& exceptionMessage)
 {
     Application* application = nullptr;
@@ -58,7 +150,7 @@ std::string Application::RenderFrame(Application* application,
     {
         try
         {
-            application->RenderFrame(wpfBackBuffer, recreateRenderTarget);
+            (application->*application->mRenderFrame)(wpfBackBuffer, recreateRenderTarget);
         }
         catch (std::exception& e)
         {
@@ -73,16 +165,419 @@ std::string Application::RenderFrame(Application* application,
     return exceptionMessage;
 }
 
+void Application::RenderFrameCallback(void* application,
+    void* wpfBackBuffer, bool recreateRenderTarget)
+{
+    Application* instance = static_cast<Application*>(application);
+    if (instance == nullptr)
+    {
+        return;
+    }
+
+    // The message is cleared without releasing its storage so that the
+    // callback does not allocate in the common case.
+    instance->mRenderExceptionMessage.clear();
+    try
+    {
+        (instance->*instance->mRenderFrame)(wpfBackBuffer, recreateRenderTarget);
+    }
+    catch (std::exception& e)
+    {
+        instance->mRenderExceptionMessage = e.what();
+    }
+}
+
+std::string Application::GetRenderExceptionMessage(Application* application)
+{
+    return (application ? application->mRenderExceptionMessage : std::string());
+}
+
+std::string Application::UploadPixels(Application* application,
+    PixelConversion::Format format, void const* pixels, size_t rowPitch,
+    uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    std::string exceptionMessage = "";
+
+    if (application)
+    {
+        try
+        {
+            application->UploadPixels(format, pixels, rowPitch, x, y, width,
+                height);
+        }
+        catch (std::exception& e)
+        {
+            exceptionMessage = e.what();
+        }
+    }
+    else
+    {
+        exceptionMessage = "Expecting null pointer to Application::UploadPixels";
+    }
+
+    return exceptionMessage;
+}
+
+std::string Application::SetPostProcessPass(Application* application,
+    std::string const& name, bool enabled, float const* parameters)
+{
+    std::string exceptionMessage = "";
+
+    if (application)
+    {
+        try
+        {
+            application->mPostProcess.SetPass(name, enabled, parameters);
+        }
+        catch (std::exception& e)
+        {
+            exceptionMessage = e.what();
+        }
+    }
+    else
+    {
+        exceptionMessage = "Expecting null pointer to Application::SetPostProcessPass";
+    }
+
+    return exceptionMessage;
+}
+
+size_t Application::GetNumRecoveries(Application* application)
+{
+    return (application ? application->mRecovery.GetNumRecoveries() : 0);
+}
+
+double Application::GetLastRecoveryMilliseconds(Application* application)
+{
+    return (application ? application->mRecovery.GetLastRecoveryMilliseconds() : 0.0);
+}
+
+uint64_t Application::GetAdapterLuid(Application* application)
+{
+    return (application ? application->mDeviceLuid : 0);
+}
+
+std::string Application::SetOverlayVisible(Application* application, bool visible)
+{
+    std::string exceptionMessage = "";
+
+    if (application)
+    {
+        // The averages restart so that the interval in which the overlay
+        // was hidden is not part of them.
+        application->mOverlayVisible = visible;
+        application->mLastFrameStart = 0.0;
+        application->mWindowStart = 0.0;
+    }
+    else
+    {
+        exceptionMessage = "Expecting null pointer to Application::SetOverlayVisible";
+    }
+
+    return exceptionMessage;
+}
+
+std::string Application::SetTileCacheEnabled(Application* application, bool enabled)
+{
+    std::string exceptionMessage = "";
+
+    if (application)
+    {
+        // The cache is not maintained while it is disabled, so every tile
+        // is rendered when it is enabled again.
+        application->mTileCacheEnabled = enabled;
+        application->mTileUploads.clear();
+        if (application->mTileCache)
+        {
+            application->mTileCache->Discard();
+        }
+    }
+    else
+    {
+        exceptionMessage = "Expecting null pointer to Application::SetTileCacheEnabled";
+    }
+
+    return exceptionMessage;
+}
+
+std::string Application::SetFrameLoopPreset(Application* application,
+    FrameLoopPreset preset)
+{
+    std::string exceptionMessage = "";
+
+    if (application)
+    {
+        switch (preset)
+        {
+        case FrameLoopPreset::STANDARD:
+            application->mRenderFrame = &Application::RenderFrame<FramePolicy::Standard>;
+            break;
+        case FrameLoopPreset::FAST:
+            application->mRenderFrame = &Application::RenderFrame<FramePolicy::Fast>;
+            break;
+        case FrameLoopPreset::COMPOSED:
+            application->mRenderFrame = &Application::RenderFrame<FramePolicy::Composed>;
+            break;
+        case FrameLoopPreset::PER_FRAME_QUERY:
+            application->mRenderFrame = &Application::RenderFrame<FramePolicy::PerFrameQuery>;
+            break;
+        default:
+            return "Invalid preset in Application::SetFrameLoopPreset";
+        }
+        application->mFrameLoopPreset = preset;
+
+        // A direct loop does not maintain the tile cache, and the overlay
+        // statistics of a loop without instrumentation are stale, so both
+        // restart with the next loop that has them.
+        application->mTileUploads.clear();
+        if (application->mTileCache)
+        {
+            application->mTileCache->Discard();
+        }
+        application->mLastFrameStart = 0.0;
+        application->mWindowStart = 0.0;
+    }
+    else
+    {
+        exceptionMessage = "Expecting null pointer to Application::SetFrameLoopPreset";
+    }
+
+    return exceptionMessage;
+}
+
+FrameLoopPreset Application::GetFrameLoopPreset(Application* application)
+{
+    return (application ? application->mFrameLoopPreset : FrameLoopPreset::STANDARD);
+}
+
+std::string Application::InvalidateRegion(Application* application,
+    uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    std::string exceptionMessage = "";
+
+    if (application)
+    {
+        if (application->mTileCacheEnabled && application->mTileCache)
+        {
+            application->mTileCache->Invalidate(x, y, width, height);
+        }
+    }
+    else
+    {
+        exceptionMessage = "Expecting null pointer to Application::InvalidateRegion";
+    }
+
+    return exceptionMessage;
+}
+
 Application::Application()
     :
     mDevice(nullptr),
     mContext(nullptr),
+    mFeatureLevel(D3D_FEATURE_LEVEL_1_0_CORE),
+    mAdapterLuid(0),
+    mDeviceLuid(0),
+    mFailedLuid(0),
     mXSize(0),
     mYSize(0),
+    mRenderTarget(nullptr),
     mRenderTargetView(nullptr),
+    mFrameArena(frameArenaBytes, numFramesInFlight),
+    mConstantBuffers{},
+    mConstantBufferPool{},
+    mGeometryHeap{},
+    mPixelUploader{},
+    mTileUploads{},
+    mRenderTargetPool{},
+    mPostProcess{},
+    mTileCache{},
+    mTileCacheEnabled(false),
+    mRenderFrame(&Application::RenderFrame<FramePolicy::Standard>),
+    mFrameLoopPreset(FrameLoopPreset::STANDARD),
+    mSyncQuery(nullptr),
+    mRenderQueue{},
+    mInstances{},
+    mScene{},
+    mFrustum{},
+    mVisibleIndices(nullptr),
+    mNumVisible(0),
+    mThreadPool(std::make_unique<ThreadPool>()),
+    mOverlay{},
+    mOverlayVisible(false),
+    mFpsField(0),
+    mCpuField(0),
+    mGpuField(0),
+    mDisjointQuery(nullptr),
+    mTimestampQueries{ nullptr, nullptr },
+    mLastFrameStart(0.0),
+    mWindowStart(0.0),
+    mWindowFrames(0),
+    mWindowCpuSeconds(0.0),
+    mWindowGpuSeconds(0.0),
+    mWindowGpuFrames(0),
+    mRecovery{},
+    mRenderExceptionMessage{},
     mDRE{},
     mURD(0.0f, 1.0f),
     mClearColor{ 0.0f, 0.0f, 1.0f, 1.0f }
+{
+    // The device-dependent objects are listed in dependency order. When
+    // the device is lost, they are released in reverse order and created
+    // again in this order. See DeviceRecovery.h.
+    mRecovery.AddStage("device",
+        [this]() { return CreateDevice(); },
+        [this]()
+        {
+            ReleaseInterface(mContext, "Application device Release context");
+            ULONG refs = ReleaseInterface(mDevice, "Application device Release device");
+            ComAccounting::RecordLiveReferences("ID3D11Device", refs);  // This should be 0.
+        });
+
+    mRecovery.AddStage("constant buffers",
+        [this]()
+        {
+            // Recreate the pooled buffers that the previous device had
+            // accumulated so that no frame after a recovery has to create
+            // them one at a time.
+            mConstantBuffers = std::make_unique<ConstantBufferRing>(mDevice,
+                mContext, constantBufferRingBytes);
+            mConstantBuffers->Prewarm(mConstantBufferPool);
+            return true;
+        },
+        [this]()
+        {
+            if (mConstantBuffers)
+            {
+                mConstantBufferPool = mConstantBuffers->GetPoolSizes();
+                mConstantBuffers = nullptr;
+            }
+        });
+
+    // The meshes do not survive a device loss. The application adds them
+    // again when GetNumMeshes() is 0, for example at the first frame after
+    // a recovery.
+    mRecovery.AddStage("geometry heap",
+        [this]()
+        {
+            mGeometryHeap = std::make_unique<GeometryHeap>(mDevice, mContext,
+                geometryVertexStride, DXGI_FORMAT_R16_UINT,
+                geometryVerticesPerPage, geometryIndicesPerPage);
+            return true;
+        },
+        [this]()
+        {
+            mGeometryHeap = nullptr;
+        });
+
+    mRecovery.AddStage("pixel uploader",
+        [this]()
+        {
+            mPixelUploader = std::make_unique<PixelUploader>(mDevice, mContext);
+            return true;
+        },
+        [this]()
+        {
+            mPixelUploader = nullptr;
+        });
+
+    // The passes are applied in this order when enabled.
+    mPostProcess.AddPass(PostProcessChain::ToneMap());
+    mPostProcess.AddPass(PostProcessChain::ColorGrade());
+    mPostProcess.AddPass(PostProcessChain::Sharpen());
+
+    mRecovery.AddStage("post-process",
+        [this]()
+        {
+            mRenderTargetPool = std::make_unique<RenderTargetPool>(mDevice);
+            mPostProcess.CreateShaders(mDevice);
+            return true;
+        },
+        [this]()
+        {
+            mPostProcess.ReleaseShaders();
+            mRenderTargetPool = nullptr;
+        });
+
+    // A new cache has no texture, so the first frame after a recovery
+    // renders every tile.
+    mRecovery.AddStage("tile cache",
+        [this]()
+        {
+            mTileCache = std::make_unique<TileCache>(mDevice, mContext);
+            return true;
+        },
+        [this]()
+        {
+            mTileCache = nullptr;
+        });
+
+    mFpsField = mOverlay.AddField(0, 0, 14);
+    mCpuField = mOverlay.AddField(0, 1, 14, 0xFF80FF80u);
+    mGpuField = mOverlay.AddField(0, 2, 14, 0xFF80E0FFu);
+    mOverlay.SetField(mFpsField, "FPS");
+    mOverlay.SetField(mCpuField, "CPU");
+    mOverlay.SetField(mGpuField, "GPU");
+
+    mRecovery.AddStage("overlay",
+        [this]()
+        {
+            mOverlay.CreateResources(mDevice);
+            return CreateTimestampQueries();
+        },
+        [this]()
+        {
+            for (auto& query : mTimestampQueries)
+            {
+                ReleaseInterface(query, "Application overlay Release timestamp query");
+            }
+            ReleaseInterface(mDisjointQuery, "Application overlay Release disjoint query");
+            mOverlay.ReleaseResources();
+        });
+
+    // The event query of the loops with the ReusedEventQuery policy.
+    mRecovery.AddStage("frame sync",
+        [this]()
+        {
+            D3D11_QUERY_DESC desc{};
+            desc.Query = D3D11_QUERY_EVENT;
+            desc.MiscFlags = 0u;
+            HRESULT hr = DXM_COM_CALL(CREATE, "Application frame sync CreateQuery",
+                mDevice->CreateQuery(&desc, &mSyncQuery));
+            return SUCCEEDED(hr);
+        },
+        [this]()
+        {
+            ReleaseInterface(mSyncQuery, "Application frame sync Release query");
+        });
+
+    mRecovery.AddStage("render target",
+        [this]()
+        {
+            // The view is reopened from the WPF back buffer by the next
+            // RenderFrame call. No GPU frames are in flight, so the
+            // per-frame CPU data can be reset.
+            mFrameArena.Reset();
+            mRenderQueue.Clear();
+            return true;
+        },
+        [this]()
+        {
+            ReleaseInterface(mRenderTargetView, "Application render target Release view");
+            ReleaseInterface(mRenderTarget, "Application render target Release texture");
+        });
+
+    if (!mRecovery.Create())
+    {
+        throw std::runtime_error("Failed to create " + mRecovery.GetFailedStage() + ".");
+    }
+}
+
+Application::~Application()
+{
+    mRecovery.Release();
+}
+
+bool Application::CreateDevice()
 {
     // To enable the DirectX Debug Layer, OR in D3D11_CREATE_DEVICE_DEBUG.
     // You then need to run the DirectX Control Panel and add the executable
@@ -95,21 +590,38 @@ Application::Application()
         D3D_FEATURE_LEVEL_10_0
     };
 
+    // The device is created on the adapter of the shared surface when it
+    // is known. If that adapter is no longer present, the default adapter
+    // is used, and RenderFrame detects the mismatch with the surface.
+    IDXGIAdapter1* adapter = nullptr;
+    if (mAdapterLuid != 0)
+    {
+        IDXGIFactory1* factory = nullptr;
+        HRESULT hr = DXM_COM_CALL(CREATE, "Application::CreateDevice CreateDXGIFactory1",
+            CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void**)&factory));
+        if (SUCCEEDED(hr))
+        {
+            adapter = AdapterSelection::GetAdapter(factory, mAdapterLuid);
+            ReleaseInterface(factory, "Application::CreateDevice Release factory");
+        }
+    }
+
     UINT flags = D3D11_CREATE_DEVICE_BGRA_SUPPORT;
     D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_1_0_CORE;
     bool success = false;
     for (size_t i = 0; i < featureLevels.size(); ++i)
     {
-        HRESULT hr = D3D11CreateDevice(
-            nullptr,
-            D3D_DRIVER_TYPE_HARDWARE,
-            nullptr,
-            flags,
-            &featureLevels[i],
-            1, D3D11_SDK_VERSION,
-            &mDevice,
-            &featureLevel,
-            &mContext);
+        HRESULT hr = DXM_COM_CALL(CREATE, "Application::CreateDevice D3D11CreateDevice",
+            D3D11CreateDevice(
+                adapter,
+                (adapter ? D3D_DRIVER_TYPE_UNKNOWN : D3D_DRIVER_TYPE_HARDWARE),
+                nullptr,
+                flags,
+                &featureLevels[i],
+                1, D3D11_SDK_VERSION,
+                &mDevice,
+                &featureLevel,
+                &mContext));
 
         if (SUCCEEDED(hr))
         {
@@ -136,35 +648,234 @@ Application::Application()
         }
     }
 
-    if (!success)
+    ReleaseInterface(adapter, "Application::CreateDevice Release adapter");
+
+    if (success)
     {
-        throw std::runtime_error("Failed to create device.");
+        mFeatureLevel = featureLevel;
+        mDeviceLuid = AdapterSelection::GetAdapterLuid(mDevice);
+        mFailedLuid = (mAdapterLuid != 0 && mAdapterLuid != mDeviceLuid ? mAdapterLuid : 0);
     }
+    return success;
 }
 
-Application::~Application()
-{
-    ReleaseInterface(mRenderTargetView);
-    ReleaseInterface(mContext);
-    ULONG refs = ReleaseInterface(mDevice);
-    (void)refs;  // This should be 0.
-}
-
+template <typename Loop>
 void Application::RenderFrame(void* wpfBackBuffer, bool recreateRenderTarget)
 {
+    DXM_LOOP_TRACE_SCOPE(Loop, "Application::RenderFrame");
+    AccountingFrame accountingFrame;
+
+    // A removed device is detected here or by a failing call during the
+    // previous frame. The device-dependent objects are rebuilt in this
+    // frame so that WPF gets a repaint as soon as possible. If rebuilding
+    // fails (for example, while the session is locked), it is attempted
+    // again on the next frame.
+    if (mRecovery.GetState() == DeviceRecovery::State::OPERATIONAL &&
+        mDevice->GetDeviceRemovedReason() != S_OK)
+    {
+        mRecovery.NotifyLost();
+    }
+
+    // A new shared surface can be on another adapter than the device, in
+    // which case every frame would be copied between the adapters. The
+    // device is recreated on the adapter of the surface instead, unless
+    // the last attempt to create it there did not find the adapter.
+    if (recreateRenderTarget && wpfBackBuffer)
+    {
+        uint64_t const luid = AdapterSelection::GetAdapterLuid(
+            reinterpret_cast<IUnknown*>(wpfBackBuffer));
+        if (luid != 0 && luid != mDeviceLuid && luid != mFailedLuid)
+        {
+            mAdapterLuid = luid;
+            if (mRecovery.GetState() == DeviceRecovery::State::OPERATIONAL)
+            {
+                mRecovery.NotifyLost();
+            }
+        }
+    }
+
+    if (mRecovery.GetState() == DeviceRecovery::State::LOST)
+    {
+        DXM_LOOP_TRACE_SCOPE(Loop, "Application::Recover");
+        accountingFrame.MarkTransient();
+        if (!mRecovery.TryRecover())
+        {
+            return;
+        }
+        recreateRenderTarget = true;
+    }
+
+    // The region being reset was last used two frames ago, and the GPU
+    // finished that frame before the previous RenderFrame call returned.
+    // Nothing has been allocated in this frame, so the arena can grow to
+    // hold the culling results of all instances.
+    mFrameArena.NextFrame();
+    mFrameArena.Reserve(frameArenaBytes + mInstances.GetNumInstances() *
+        (sizeof(uint8_t) + sizeof(uint32_t)) + 2 * FrameArena::defaultAlignment);
+    mConstantBuffers->NextFrame();
+    mRenderQueue.Clear();
+
+    bool const overlay = (Loop::Instrumentation::enabled && mOverlayVisible);
+    double const frameStart = (overlay ? FramePacer::GetSeconds() : 0.0);
+
     if (recreateRenderTarget || mRenderTargetView == nullptr)
     {
+        DXM_LOOP_TRACE_SCOPE(Loop, "Application::RecreateRenderTarget");
+        accountingFrame.MarkTransient();
         RecreateRenderTarget(wpfBackBuffer);
         for (size_t i = 0; i < 3; ++i)
         {
             mClearColor[i] = mURD(mDRE);
         }
+
+        // The new render target has no valid contents, and the clear
+        // color has changed.
+        if (mTileCache)
+        {
+            mTileCache->InvalidateAll();
+        }
+    }
+
+    // The GPU time is measured from here, after RecreateRenderTarget,
+    // which can throw.
+    TimestampFrame timestampFrame;
+    if (overlay)
+    {
+        timestampFrame.Begin(mContext, mDisjointQuery, mTimestampQueries[0]);
+    }
+
+    {
+        DXM_LOOP_TRACE_SCOPE(Loop, "Application::UpdateScene");
+        mScene.Update(*mThreadPool);
+        mScene.WriteInstances(mInstances);
+    }
+
+    {
+        DXM_LOOP_TRACE_SCOPE(Loop, "Application::Cull");
+        CullInstances();
+    }
+
+    // With post-processing, the scene is drawn to a pooled target that the
+    // post-process chain reads. The chain releases the target to the pool;
+    // until then 'scene' holds it, so an exception does not lose it.
+    // With tile caching, the scene is drawn to the cache, only in the
+    // regions of the invalid tiles, which Begin clears.
+    bool const postProcess = (Loop::Present::composed && mPostProcess.IsActive());
+    bool const tiles = (Loop::Present::composed && mTileCacheEnabled);
+    ScopedTarget scene(*mRenderTargetPool);
+    ID3D11RenderTargetView* sceneView = mRenderTargetView;
+    ID3D11Texture2D* sceneTexture = mRenderTarget;
+    size_t numRegions = 1;
+    if (tiles)
+    {
+        DXM_LOOP_TRACE_SCOPE(Loop, "Application::TileCache");
+        numRegions = mTileCache->Begin(mXSize, mYSize, postProcess ?
+            PostProcessChain::intermediateFormat : DXGI_FORMAT_B8G8R8A8_UNORM,
+            mClearColor.data());
+        sceneView = mTileCache->GetView();
+        sceneTexture = mTileCache->GetTexture();
+
+        // The uploads shown in this frame are cleared in the next one.
+        for (auto const& upload : mTileUploads)
+        {
+            mTileCache->Invalidate(upload.x, upload.y, upload.width, upload.height);
+        }
+        mTileUploads.clear();
+    }
+    else if (postProcess)
+    {
+        scene.Reset(mRenderTargetPool->Acquire(mXSize, mYSize,
+            PostProcessChain::intermediateFormat));
+        sceneView = scene.Get()->rtv;
     }
 
-    mContext->OMSetRenderTargets(1, &mRenderTargetView, nullptr);
-    mContext->ClearRenderTargetView(mRenderTargetView, mClearColor.data());
+    mContext->OMSetRenderTargets(1, &sceneView, nullptr);
+    if (!tiles)
+    {
+        mContext->ClearRenderTargetView(sceneView, mClearColor.data());
+    }
+    if (!postProcess && mPixelUploader->HasPending())
+    {
+        mPixelUploader->Resolve(sceneTexture, mXSize, mYSize);
+    }
     {
+        DXM_LOOP_TRACE_SCOPE(Loop, "Application::Draw");
+
+        // The copies are recorded before the draws, so the draw
+        // parameters of the meshes must be read after this call.
+        {
+            DXM_LOOP_TRACE_SCOPE(Loop, "Application::Defragment");
+            mGeometryHeap->Defragment(geometryDefragmentBytes);
+        }
+
         // DO YOUR RENDERING HERE
+        //
+        // Per-draw constants are uploaded with mConstantBuffers->Upload.
+        // Add the draws to mRenderQueue with RenderQueue::MakeKey keys;
+        // the queue binds the state and constants when submitted. Meshes
+        // in mGeometryHeap are drawn with the count, first index and base
+        // vertex of GetDraw and a draw state per page (SetBuffers), and
+        // the page should be part of the material key so that the draws
+        // of a page are adjacent.
+
+        mRenderQueue.Sort();
+        if (tiles)
+        {
+            for (size_t region = 0; region < numRegions; ++region)
+            {
+                mTileCache->SetScissor(region);
+                mRenderQueue.Submit(mContext, *mConstantBuffers);
+            }
+        }
+        else
+        {
+            mRenderQueue.Submit(mContext, *mConstantBuffers);
+        }
+    }
+    if (tiles)
+    {
+        // The post-process chain takes a pool target, so the cached scene
+        // is copied to one. Without post-processing, only the regions that
+        // changed are copied to the render target.
+        DXM_LOOP_TRACE_SCOPE(Loop, "Application::Composite");
+        mContext->OMSetRenderTargets(0, nullptr, nullptr);
+        if (postProcess)
+        {
+            scene.Reset(mRenderTargetPool->Acquire(mXSize, mYSize,
+                PostProcessChain::intermediateFormat));
+            mContext->CopyResource(scene.Get()->texture, sceneTexture);
+        }
+        else
+        {
+            mTileCache->Composite(mRenderTarget);
+        }
+    }
+    if (scene.Get())
+    {
+        DXM_LOOP_TRACE_SCOPE(Loop, "Application::PostProcess");
+        mPostProcess.Execute(mContext, *mConstantBuffers, *mRenderTargetPool,
+            scene.Detach(), mRenderTargetView);
+        if (mPixelUploader->HasPending())
+        {
+            mPixelUploader->Resolve(mRenderTarget, mXSize, mYSize);
+        }
+    }
+
+    // The overlay is drawn last so that it is not post-processed. The
+    // statistics it shows are those of the previous frames.
+    double cpuSeconds = 0.0;
+    if (overlay)
+    {
+        DXM_LOOP_TRACE_SCOPE(Loop, "Application::Overlay");
+        mContext->OMSetRenderTargets(1, &mRenderTargetView, nullptr);
+        mOverlay.Draw(mContext, *mConstantBuffers, mXSize, mYSize);
+        if (tiles && !postProcess)
+        {
+            std::array<uint32_t, 4> const rect = mOverlay.GetRect();
+            mTileCache->AddTargetDamage(rect[0], rect[1], rect[2], rect[3]);
+        }
+        timestampFrame.End(mTimestampQueries[1]);
+        cpuSeconds = FramePacer::GetSeconds() - frameStart;
     }
     mContext->OMSetRenderTargets(0, nullptr, nullptr);
 
@@ -176,24 +887,60 @@ void Application::RenderFrame(void* wpfBackBuffer, bool recreateRenderTarget)
     // shared back buffer. But if the GPU is not yet finished, this leads
     // to concurrent writing by two threads. Instead, you have to wait
     // for the GPU to finish to be sure that WPF can draw safely.
-    D3D11_QUERY_DESC desc{};
-    desc.Query = D3D11_QUERY_EVENT;
-    desc.MiscFlags = 0u;
     ID3D11Query* waitQuery = nullptr;
-    HRESULT hr = mDevice->CreateQuery(&desc, &waitQuery);
-    if (FAILED(hr))
+    HRESULT hr = S_OK;
+    if constexpr (Loop::Sync::reuseQuery)
+    {
+        waitQuery = mSyncQuery;
+    }
+    else
     {
-        throw std::runtime_error("CreateQuery failed.");
+        D3D11_QUERY_DESC desc{};
+        desc.Query = D3D11_QUERY_EVENT;
+        desc.MiscFlags = 0u;
+        hr = DXM_COM_CALL(CREATE, "Application::RenderFrame CreateQuery",
+            mDevice->CreateQuery(&desc, &waitQuery));
+        if (FAILED(hr))
+        {
+            if (mDevice->GetDeviceRemovedReason() != S_OK)
+            {
+                mRecovery.NotifyLost();
+                return;
+            }
+            throw std::runtime_error("CreateQuery failed.");
+        }
     }
 
+    DXM_LOOP_TRACE_SCOPE(Loop, "Application::GpuWait");
     mContext->End(waitQuery);
     BOOL data = 0;
     UINT size = sizeof(BOOL);
-    while (S_OK != mContext->GetData(waitQuery, &data, size, 0))
+    while (S_OK != (hr = mContext->GetData(waitQuery, &data, size, 0)))
+    {
+        // Wait for the GPU to finish computing its current commands. When
+        // the device is removed, GetData returns DXGI_ERROR_DEVICE_REMOVED
+        // instead of S_FALSE and the query never completes.
+        if (FAILED(hr))
+        {
+            if constexpr (!Loop::Sync::reuseQuery)
+            {
+                ReleaseInterface(waitQuery, "Application::RenderFrame Release query");
+            }
+            mRecovery.NotifyLost();
+            return;
+        }
+    }
+    if constexpr (!Loop::Sync::reuseQuery)
+    {
+        ReleaseInterface(waitQuery, "Application::RenderFrame Release query");
+    }
+    if (overlay)
     {
-        // Wait for the GPU to finish computing its current commands.
+        UpdateOverlay(frameStart, cpuSeconds, ReadTimestampQueries());
     }
-    ReleaseInterface(waitQuery);
+    mPixelUploader->NextFrame();
+    mRenderTargetPool->NextFrame();
+    mRecovery.NotifyFrameCompleted();
 }
 
 void Application::RecreateRenderTarget(void* wpfBackBuffer)
@@ -202,8 +949,9 @@ void Application::RecreateRenderTarget(void* wpfBackBuffer)
 
     IUnknown* unknown = reinterpret_cast<IUnknown*>(wpfBackBuffer);
     IDXGIResource* dxgiResource = nullptr;
-    HRESULT hr = unknown->QueryInterface(__uuidof(IDXGIResource),
-        (void**)&dxgiResource);
+    HRESULT hr = DXM_COM_CALL(QUERY_INTERFACE,
+        "Application::RecreateRenderTarget QueryInterface IDXGIResource",
+        unknown->QueryInterface(__uuidof(IDXGIResource), (void**)&dxgiResource));
     if (FAILED(hr))
     {
         throw std::runtime_error("dxgiResource QueryInterface failed");
@@ -215,32 +963,35 @@ void Application::RecreateRenderTarget(void* wpfBackBuffer)
     {
         throw std::runtime_error("GetSharedHandle failed");
     }
-    ReleaseInterface(dxgiResource);
+    ReleaseInterface(dxgiResource, "Application::RecreateRenderTarget Release IDXGIResource");
 
     IUnknown* sharedResource = nullptr;
-    hr = mDevice->OpenSharedResource(sharedHandle,
-        __uuidof(ID3D11Resource), (void**)(&sharedResource));
+    hr = DXM_COM_CALL(CREATE, "Application::RecreateRenderTarget OpenSharedResource",
+        mDevice->OpenSharedResource(sharedHandle, __uuidof(ID3D11Resource),
+            (void**)(&sharedResource)));
     if (FAILED(hr))
     {
         throw std::runtime_error("OpenSharedResource failed");
     }
 
     ID3D11Texture2D* texture = nullptr;
-    hr = sharedResource->QueryInterface(__uuidof(ID3D11Texture2D),
-        (void**)(&texture));
+    hr = DXM_COM_CALL(QUERY_INTERFACE,
+        "Application::RecreateRenderTarget QueryInterface ID3D11Texture2D",
+        sharedResource->QueryInterface(__uuidof(ID3D11Texture2D), (void**)(&texture)));
     if (FAILED(hr))
     {
         throw std::runtime_error("sharedResource QueryInterface failed");
     }
-    ReleaseInterface(sharedResource);
+    ReleaseInterface(sharedResource, "Application::RecreateRenderTarget Release resource");
 
     D3D11_RENDER_TARGET_VIEW_DESC rtDesc{};
     rtDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
     rtDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
     rtDesc.Texture2D.MipSlice = 0;
 
-    ReleaseInterface(mRenderTargetView);
-    hr = mDevice->CreateRenderTargetView(texture, &rtDesc, &mRenderTargetView);
+    ReleaseInterface(mRenderTargetView, "Application::RecreateRenderTarget Release view");
+    hr = DXM_COM_CALL(CREATE, "Application::RecreateRenderTarget CreateRenderTargetView",
+        mDevice->CreateRenderTargetView(texture, &rtDesc, &mRenderTargetView));
     if (FAILED(hr))
     {
         throw std::runtime_error("CreateRenderTargetView failed");
@@ -250,7 +1001,10 @@ void Application::RecreateRenderTarget(void* wpfBackBuffer)
     texture->GetDesc(&desc);
     mXSize = desc.Width;
     mYSize = desc.Height;
-    ReleaseInterface(texture);
+
+    // The texture is kept for copying uploaded CPU pixels into it.
+    ReleaseInterface(mRenderTarget, "Application::RecreateRenderTarget Release texture");
+    mRenderTarget = texture;
 
     D3D11_VIEWPORT viewport{};
     viewport.Width = static_cast<float>(mXSize);
@@ -261,3 +1015,141 @@ void Application::RecreateRenderTarget(void* wpfBackBuffer)
     viewport.TopLeftY = 0.0f;
     mContext->RSSetViewports(1, &viewport);
 }
+
+void Application::UploadPixels(PixelConversion::Format format,
+    void const* pixels, size_t rowPitch, uint32_t x, uint32_t y,
+    uint32_t width, uint32_t height)
+{
+    // While the device is lost, the uploads are dropped. The next frame
+    // after the recovery shows the next upload.
+    if (mRecovery.GetState() == DeviceRecovery::State::OPERATIONAL)
+    {
+        mPixelUploader->Upload(format, pixels, rowPitch, x, y, width, height);
+        // The FAST loop does not maintain the tile cache; it is discarded
+        // when another loop is selected.
+        if (mTileCacheEnabled && mFrameLoopPreset != FrameLoopPreset::FAST)
+        {
+            mTileCache->Invalidate(x, y, width, height);
+            mTileUploads.push_back(TileGrid::Region{ x, y, width, height });
+        }
+    }
+}
+
+void Application::CullInstances()
+{
+    size_t const numInstances = mInstances.GetNumInstances();
+    mNumVisible = 0;
+    mVisibleIndices = nullptr;
+    if (numInstances == 0)
+    {
+        return;
+    }
+
+    // The arena was reserved for both arrays at the start of the frame.
+    uint8_t* visible = mFrameArena.Allocate<uint8_t>(numInstances);
+    mVisibleIndices = mFrameArena.Allocate<uint32_t>(numInstances);
+
+    CullingKernels::Path const path = CullingKernels::GetBestPath();
+    CullingKernels::TransformBounds(*mThreadPool, path, mInstances);
+    CullingKernels::CullBoxes(*mThreadPool, path, mFrustum, mInstances,
+        visible);
+    mNumVisible = CullingKernels::Compact(visible, numInstances,
+        mVisibleIndices);
+}
+
+bool Application::CreateTimestampQueries()
+{
+    D3D11_QUERY_DESC desc{};
+    desc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+    desc.MiscFlags = 0u;
+    if (FAILED(DXM_COM_CALL(CREATE, "Application::CreateTimestampQueries CreateQuery",
+        mDevice->CreateQuery(&desc, &mDisjointQuery))))
+    {
+        return false;
+    }
+
+    desc.Query = D3D11_QUERY_TIMESTAMP;
+    for (auto& query : mTimestampQueries)
+    {
+        if (FAILED(DXM_COM_CALL(CREATE, "Application::CreateTimestampQueries CreateQuery",
+            mDevice->CreateQuery(&desc, &query))))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+double Application::ReadTimestampQueries()
+{
+    // The GPU is idle, so the data is available. A disjoint interval (for
+    // example, a clock change from power management) has no valid time.
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint{};
+    UINT64 begin = 0, end = 0;
+    if (mContext->GetData(mDisjointQuery, &disjoint, sizeof(disjoint), 0) == S_OK &&
+        mContext->GetData(mTimestampQueries[0], &begin, sizeof(begin), 0) == S_OK &&
+        mContext->GetData(mTimestampQueries[1], &end, sizeof(end), 0) == S_OK &&
+        !disjoint.Disjoint && disjoint.Frequency > 0 && end >= begin)
+    {
+        return static_cast<double>(end - begin) / static_cast<double>(disjoint.Frequency);
+    }
+    return -1.0;
+}
+
+void Application::UpdateOverlay(double frameStart, double cpuSeconds,
+    double gpuSeconds)
+{
+    if (mLastFrameStart > 0.0)
+    {
+        mOverlay.AddGraphSample(static_cast<float>(1000.0 * (frameStart - mLastFrameStart)));
+    }
+    mLastFrameStart = frameStart;
+
+    if (mWindowStart == 0.0)
+    {
+        mWindowStart = frameStart;
+        mWindowFrames = 0;
+        mWindowCpuSeconds = 0.0;
+        mWindowGpuSeconds = 0.0;
+        mWindowGpuFrames = 0;
+    }
+
+    double const elapsed = frameStart - mWindowStart;
+    if (elapsed < overlayUpdateSeconds)
+    {
+        ++mWindowFrames;
+        mWindowCpuSeconds += cpuSeconds;
+        if (gpuSeconds >= 0.0)
+        {
+            mWindowGpuSeconds += gpuSeconds;
+            ++mWindowGpuFrames;
+        }
+        return;
+    }
+
+    // The window is the frames that started in [mWindowStart,frameStart),
+    // so the current frame belongs to the next window.
+    std::array<char, 32> text{};
+    std::snprintf(text.data(), text.size(), "FPS %7.1f",
+        static_cast<double>(mWindowFrames) / elapsed);
+    mOverlay.SetField(mFpsField, text.data());
+    std::snprintf(text.data(), text.size(), "CPU %7.2f MS",
+        1000.0 * mWindowCpuSeconds / static_cast<double>(mWindowFrames));
+    mOverlay.SetField(mCpuField, text.data());
+    if (mWindowGpuFrames > 0)
+    {
+        std::snprintf(text.data(), text.size(), "GPU %7.2f MS",
+            1000.0 * mWindowGpuSeconds / static_cast<double>(mWindowGpuFrames));
+    }
+    else
+    {
+        std::snprintf(text.data(), text.size(), "GPU      -- MS");
+    }
+    mOverlay.SetField(mGpuField, text.data());
+
+    mWindowStart = frameStart;
+    mWindowFrames = 1;
+    mWindowCpuSeconds = cpuSeconds;
+    mWindowGpuSeconds = (gpuSeconds >= 0.0 ? gpuSeconds : 0.0);
+    mWindowGpuFrames = (gpuSeconds >= 0.0 ? 1 : 0);
+}
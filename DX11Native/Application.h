@@ -6,9 +6,27 @@
 // Version: 1.0.2022.07.01
 #pragma once
 
+#include "ComAccounting.h"
+#include "ConstantBufferRing.h"
+#include "DeviceRecovery.h"
+#include "FrameArena.h"
+#include "FrameLoopPolicy.h"
+#include "Frustum.h"
+#include "GeometryHeap.h"
+#include "InstanceStore.h"
+#include "PixelUploader.h"
+#include "PostProcessChain.h"
+#include "RenderQueue.h"
+#include "RenderTargetPool.h"
+#include "SceneStore.h"
+#include "StatsOverlay.h"
+#include "TileCache.h"
 #include <d3d11.h>
 #include <array>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 // The random number generator is used to set the clear color during a
 // resize, acting as a visual confirmation that the render target is
@@ -17,6 +35,10 @@
 
 namespace dxm
 {
+    // ThreadPool.h includes <thread> and <mutex>, which cannot be included
+    // by the C++/CLI code that includes this header.
+    class ThreadPool;
+
     class Application
     {
     public:
@@ -28,21 +50,122 @@ namespace dxm
         static std::string RenderFrame(Application* application,
             void* wpfBackBuffer, bool recreateRenderTarget);
 
+        // RenderFrame with the signature of the native render callback of
+        // DXManager, where 'application' is the Application pointer. The
+        // call involves no managed code. An exception is not propagated;
+        // its message is available from GetRenderExceptionMessage until
+        // the next call.
+        static void RenderFrameCallback(void* application,
+            void* wpfBackBuffer, bool recreateRenderTarget);
+
+        static std::string GetRenderExceptionMessage(Application* application);
+
+        // Convert a CPU pixel rectangle into the render target at (x,y).
+        // The pixels are read before the function returns, so the caller
+        // can release or reuse the memory (or unpin a managed array). The
+        // rectangle appears in the next frame rendered by RenderFrame,
+        // after the clear and before any other drawing. When post-processing
+        // is active, the rectangle is copied after the post-process passes,
+        // because the pixels are already display ready.
+        static std::string UploadPixels(Application* application,
+            PixelConversion::Format format, void const* pixels,
+            size_t rowPitch, uint32_t x, uint32_t y, uint32_t width,
+            uint32_t height);
+
+        // Enable or disable a post-process pass ("ToneMap", "ColorGrade" or
+        // "Sharpen") and set its eight parameters. When 'parameters' is
+        // null, the parameters are unchanged. See PostProcessChain.h for
+        // the meaning of the parameters.
+        static std::string SetPostProcessPass(Application* application,
+            std::string const& name, bool enabled, float const* parameters);
+
+        // Device-loss recovery statistics. The recovery time is measured
+        // from the detection of the loss to the first completed frame.
+        static size_t GetNumRecoveries(Application* application);
+        static double GetLastRecoveryMilliseconds(Application* application);
+
+        // The LUID of the adapter of the device (see AdapterSelection.h), or
+        // 0 before the device is created. The device is created on the
+        // adapter of the shared surface passed to RenderFrame. When the
+        // surface moves to another adapter, for example after DXManager
+        // follows the window to a monitor of another GPU, the device and
+        // its objects are recreated on that adapter as for a device loss.
+        static uint64_t GetAdapterLuid(Application* application);
+
+        // Show or hide the statistics overlay, which is drawn by
+        // RenderFrame into the shared render target: the frame rate, the
+        // CPU and GPU milliseconds per frame and a graph of the frame
+        // intervals. The overlay is hidden initially.
+        static std::string SetOverlayVisible(Application* application, bool visible);
+
+        // Enable or disable tile caching of the scene. While it is enabled,
+        // the scene is retained between frames in a cache of the render
+        // target size, and a frame renders only the tiles invalidated by
+        // InvalidateRegion since the previous frame, or every tile after a
+        // resize, a device recovery or a change of the post-process format.
+        // The scene is drawn once per region of invalid tiles with the
+        // region as the scissor rectangle, so the rasterizer states of the
+        // draws must enable the scissor test. Tile caching is disabled
+        // initially. See TileCache.h.
+        static std::string SetTileCacheEnabled(Application* application, bool enabled);
+
+        // Invalidate the tiles that overlap a rectangle of pixels, for
+        // example the bounding rectangles of an object before and after it
+        // moves. The call is ignored while tile caching is disabled.
+        static std::string InvalidateRegion(Application* application,
+            uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
+        // Select the frame loop used by RenderFrame. The features that the
+        // policies of a preset disable are not compiled into its loop, and
+        // their settings are ignored while it is selected; for example, the
+        // FAST loop draws no overlay, post-processing or tile caching. See
+        // FrameLoopPolicy.h. The preset is STANDARD initially.
+        static std::string SetFrameLoopPreset(Application* application,
+            FrameLoopPreset preset);
+        static FrameLoopPreset GetFrameLoopPreset(Application* application);
+
     private:
         Application();
         ~Application();
 
+        bool CreateDevice();
+
+        // The frame loop, instantiated for the presets of FrameLoopPolicy.h.
+        // The static RenderFrame functions call the loop of the selected
+        // preset through mRenderFrame.
+        template <typename Loop>
         void RenderFrame(void* wpfBackBuffer, bool recreateRenderTarget);
 
         void RecreateRenderTarget(void* wpfBackBuffer);
 
+        void UploadPixels(PixelConversion::Format format, void const* pixels,
+            size_t rowPitch, uint32_t x, uint32_t y, uint32_t width,
+            uint32_t height);
+
+        // Compute the world bounds of the instances and the indices of
+        // those that intersect the view frustum.
+        void CullInstances();
+
+        // Timestamp queries bracketing the GPU work of a frame. They are
+        // read after the GPU wait at the end of RenderFrame, so no query
+        // is ever pending across frames.
+        // ReadTimestampQueries returns the GPU seconds of the frame, or a
+        // negative number when the timestamps are not valid.
+        bool CreateTimestampQueries();
+        double ReadTimestampQueries();
+
+        // Accumulate the timings of a frame and, every overlayUpdateSeconds,
+        // write the averages to the overlay fields.
+        void UpdateOverlay(double frameStart, double cpuSeconds, double gpuSeconds);
+
+        // The site names the call for ComAccounting.
         template <typename T>
-        ULONG ReleaseInterface(T*& object)
+        ULONG ReleaseInterface(T*& object, char const* site)
         {
             ULONG refs;
             if (object)
             {
-                refs = object->Release();
+                refs = DXM_COM_CALL(RELEASE, site, object->Release());
                 object = nullptr;
             }
             else
@@ -54,9 +177,122 @@ namespace dxm
 
         ID3D11Device* mDevice;
         ID3D11DeviceContext* mContext;
+        D3D_FEATURE_LEVEL mFeatureLevel;
+
+        // The adapter on which CreateDevice creates the device (0 for the
+        // default adapter) and that of the created device. mFailedLuid is
+        // the adapter of the last CreateDevice when the device was created
+        // on another adapter (it was not found), so that the surfaces on
+        // that adapter do not rebuild the device every frame; it is 0
+        // otherwise.
+        uint64_t mAdapterLuid;
+        uint64_t mDeviceLuid;
+        uint64_t mFailedLuid;
         uint32_t mXSize, mYSize;
+        ID3D11Texture2D* mRenderTarget;
         ID3D11RenderTargetView* mRenderTargetView;
 
+        // Transient per-frame allocations (the culling results, and draw
+        // lists, constant data or sort keys of the application). The GPU
+        // is drained at the end of each RenderFrame call, but the arena is
+        // double buffered so that RenderFrame can later be modified to
+        // keep a frame in flight without further changes. The regions have
+        // frameArenaBytes bytes in addition to the culling results.
+        static size_t constexpr frameArenaBytes = 1024 * 1024;
+        static size_t constexpr numFramesInFlight = 2;
+        FrameArena mFrameArena;
+
+        // Per-draw constant data. On D3D11.1 devices this is a single ring
+        // buffer bound with offsets; otherwise it is a pool of discrete
+        // dynamic buffers.
+        static UINT constexpr constantBufferRingBytes = 4 * 1024 * 1024;
+        std::unique_ptr<ConstantBufferRing> mConstantBuffers;
+        std::map<UINT, size_t> mConstantBufferPool;
+
+        // The meshes, suballocated from shared vertex and index buffers so
+        // that the draws of many meshes share a buffer binding. The vertex
+        // layout is application specific; the stride here is that of a
+        // position, normal and texture coordinate. Meshes with 16-bit
+        // indices relative to their first vertex can have up to 65536
+        // vertices. Each frame moves at most geometryDefragmentBytes bytes
+        // to compact the buffers.
+        static UINT constexpr geometryVertexStride = 32;
+        static size_t constexpr geometryVerticesPerPage = 1024 * 1024;
+        static size_t constexpr geometryIndicesPerPage = 3 * 1024 * 1024;
+        static size_t constexpr geometryDefragmentBytes = 1024 * 1024;
+        std::unique_ptr<GeometryHeap> mGeometryHeap;
+
+        // CPU pixel rectangles waiting to be copied to the render target.
+        // With tile caching, an upload invalidates its tiles when it is
+        // made and again in the frame that shows it, so that it is visible
+        // for one frame as without the cache.
+        std::unique_ptr<PixelUploader> mPixelUploader;
+        std::vector<TileGrid::Region> mTileUploads;
+
+        // When a post-process pass is enabled, the scene is drawn to a pooled
+        // floating-point target, and the passes write the shared target.
+        std::unique_ptr<RenderTargetPool> mRenderTargetPool;
+        PostProcessChain mPostProcess;
+
+        // The scene retained between frames when tile caching is enabled.
+        // The cache has the format of the scene: that of the render target
+        // without post-processing and the intermediate format with it.
+        std::unique_ptr<TileCache> mTileCache;
+        bool mTileCacheEnabled;
+
+        // The loop of the selected preset and, for the loops with the
+        // ReusedEventQuery policy, the query that each frame waits on.
+        void (Application::*mRenderFrame)(void*, bool);
+        FrameLoopPreset mFrameLoopPreset;
+        ID3D11Query* mSyncQuery;
+
+        // Draws are added to the queue during the frame, then sorted and
+        // submitted with redundant state changes filtered out.
+        RenderQueue mRenderQueue;
+
+        // Instance bounds and transforms in structure-of-arrays layout. The
+        // view-projection matrix is application specific; the default
+        // frustum is the clip-space volume. After CullInstances, the first
+        // mNumVisible elements of mVisibleIndices are the instances to draw.
+        // The indices are allocated from mFrameArena and are valid until
+        // the end of the frame.
+        InstanceStore mInstances;
+
+        // The transform hierarchy. Each frame, the world transforms of the
+        // nodes whose local transforms changed, and of their descendants,
+        // are recomputed and copied to the instances of the nodes before
+        // culling. Instances that are not in the scene keep the transforms
+        // set by InstanceStore::SetWorld.
+        SceneStore mScene;
+        Frustum mFrustum;
+        uint32_t* mVisibleIndices;
+        size_t mNumVisible;
+        std::unique_ptr<ThreadPool> mThreadPool;
+
+        // The statistics overlay. The text fields change only when their
+        // averages are written, every overlayUpdateSeconds, so most frames
+        // upload a single graph bar. The GPU time is that between the
+        // first and last timestamps of the frame.
+        static double constexpr overlayUpdateSeconds = 0.5;
+        StatsOverlay mOverlay;
+        bool mOverlayVisible;
+        size_t mFpsField, mCpuField, mGpuField;
+        ID3D11Query* mDisjointQuery;
+        std::array<ID3D11Query*, 2> mTimestampQueries;
+        double mLastFrameStart;
+        double mWindowStart;
+        size_t mWindowFrames;
+        double mWindowCpuSeconds;
+        double mWindowGpuSeconds;
+        size_t mWindowGpuFrames;
+
+        // The device-dependent objects are registered as recovery stages
+        // in the constructor.
+        DeviceRecovery mRecovery;
+
+        // The exception message of the last RenderFrameCallback call.
+        std::string mRenderExceptionMessage;
+
         // See the comments before the #include <random>.
         std::default_random_engine mDRE;
         std::uniform_real_distribution<float> mURD;
@@ -0,0 +1,275 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "ComAccounting.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+using namespace dxm;
+
+std::atomic<bool> ComAccountingDetail::enabled(false);
+
+namespace
+{
+    struct SiteKey
+    {
+        char const* name;
+        ComAccounting::Operation operation;
+    };
+
+    // Sites are compared by name so that equal literals in different
+    // translation units are one site.
+    struct SiteKeyLess
+    {
+        bool operator()(SiteKey const& key0, SiteKey const& key1) const
+        {
+            int const order = std::strcmp(key0.name, key1.name);
+            return order < 0 || (order == 0 && key0.operation < key1.operation);
+        }
+    };
+
+    struct SiteData
+    {
+        uint64_t count;
+        uint64_t nanoseconds;
+    };
+
+    struct State
+    {
+        std::mutex mutex;
+        std::map<SiteKey, SiteData, SiteKeyLess> sites;
+        ComAccounting::Frame current;
+        ComAccounting::Frame last;
+        char const* firstCreate;
+        uint64_t numFrames;
+        uint64_t numFlagged;
+        std::vector<ComAccounting::FlaggedFrame> flagged;
+        std::vector<ComAccounting::LiveReferences> live;
+    };
+
+    State& GetState()
+    {
+        static State state{};
+        return state;
+    }
+
+    uint64_t GetNanoseconds()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    thread_local uint64_t startNanoseconds = 0;
+
+    char const* GetOperationName(ComAccounting::Operation operation)
+    {
+        switch (operation)
+        {
+        case ComAccounting::Operation::CREATE:
+            return "create";
+        case ComAccounting::Operation::RELEASE:
+            return "release";
+        default:
+            return "query";
+        }
+    }
+}
+
+void ComAccounting::Enable(bool enable)
+{
+    ComAccountingDetail::enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool ComAccounting::IsEnabled()
+{
+    return ComAccountingDetail::IsEnabled();
+}
+
+void ComAccounting::Reset()
+{
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.sites.clear();
+    state.current = Frame{};
+    state.last = Frame{};
+    state.firstCreate = nullptr;
+    state.numFrames = 0;
+    state.numFlagged = 0;
+    state.flagged.clear();
+    state.live.clear();
+}
+
+void ComAccounting::Start()
+{
+    startNanoseconds = GetNanoseconds();
+}
+
+void ComAccounting::Record(Operation operation, char const* site)
+{
+    uint64_t const nanoseconds = GetNanoseconds() - startNanoseconds;
+
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    SiteData& data = state.sites[SiteKey{ site, operation }];
+    ++data.count;
+    data.nanoseconds += nanoseconds;
+
+    switch (operation)
+    {
+    case Operation::CREATE:
+        if (state.current.numCreates++ == 0)
+        {
+            state.firstCreate = site;
+        }
+        break;
+    case Operation::RELEASE:
+        ++state.current.numReleases;
+        break;
+    default:
+        ++state.current.numQueryInterfaces;
+        break;
+    }
+    state.current.milliseconds += 1e-6 * static_cast<double>(nanoseconds);
+}
+
+void ComAccounting::EndFrame(bool steadyState)
+{
+    if (!ComAccountingDetail::IsEnabled())
+    {
+        return;
+    }
+
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (steadyState && state.current.numCreates > 0)
+    {
+        ++state.numFlagged;
+        if (state.flagged.size() < maxFlaggedFrames)
+        {
+            state.flagged.push_back(FlaggedFrame{ state.numFrames,
+                state.current.numCreates, state.firstCreate });
+        }
+    }
+
+    state.last = state.current;
+    state.current = Frame{};
+    state.firstCreate = nullptr;
+    ++state.numFrames;
+}
+
+void ComAccounting::RecordLiveReferences(char const* name, unsigned long references)
+{
+    if (!ComAccountingDetail::IsEnabled() || references == 0)
+    {
+        return;
+    }
+
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.live.push_back(LiveReferences{ name, references });
+}
+
+std::vector<ComAccounting::Site> ComAccounting::GetSites()
+{
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    std::vector<Site> sites;
+    sites.reserve(state.sites.size());
+    for (auto const& element : state.sites)
+    {
+        sites.push_back(Site{ element.first.name, element.first.operation,
+            element.second.count, 1e-6 * static_cast<double>(element.second.nanoseconds) });
+    }
+    return sites;
+}
+
+uint64_t ComAccounting::GetNumFrames()
+{
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.numFrames;
+}
+
+ComAccounting::Frame ComAccounting::GetLastFrame()
+{
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.last;
+}
+
+uint64_t ComAccounting::GetNumFlaggedFrames()
+{
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.numFlagged;
+}
+
+std::vector<ComAccounting::FlaggedFrame> ComAccounting::GetFlaggedFrames()
+{
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.flagged;
+}
+
+std::vector<ComAccounting::LiveReferences> ComAccounting::GetLiveReferences()
+{
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.live;
+}
+
+void ComAccounting::Write(std::ostream& output)
+{
+    std::vector<Site> sites = GetSites();
+    std::sort(sites.begin(), sites.end(),
+        [](Site const& site0, Site const& site1)
+        {
+            return site0.milliseconds > site1.milliseconds;
+        });
+
+    std::array<char, 64> line{};
+    output << "operation  count       total ms    mean us     site\n";
+    for (auto const& site : sites)
+    {
+        double const mean = 1000.0 * site.milliseconds / static_cast<double>(site.count);
+        std::snprintf(line.data(), line.size(), "%-10s %-11llu %-11.3f %-11.2f ",
+            GetOperationName(site.operation), static_cast<unsigned long long>(site.count),
+            site.milliseconds, mean);
+        output << line.data() << site.name << "\n";
+    }
+
+    output << "\nframes: " << GetNumFrames()
+        << ", steady-state frames that created objects: " << GetNumFlaggedFrames() << "\n";
+    for (auto const& frame : GetFlaggedFrames())
+    {
+        output << "  frame " << frame.frame << ": " << frame.numCreates
+            << " created, first at " << frame.firstSite << "\n";
+    }
+
+    std::vector<LiveReferences> live = GetLiveReferences();
+    output << "\nobjects referenced after their final release: " << live.size() << "\n";
+    for (auto const& object : live)
+    {
+        output << "  " << object.name << ": " << object.references << " references\n";
+    }
+}
+
+bool ComAccounting::Write(std::string const& filename)
+{
+    std::ofstream output(filename);
+    if (!output)
+    {
+        return false;
+    }
+    Write(output);
+    return static_cast<bool>(output);
+}
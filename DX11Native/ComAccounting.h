@@ -0,0 +1,156 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if !defined(_M_CEE)
+#include <atomic>
+#endif
+
+// ComAccounting is a diagnostics mode that counts and times the calls that
+// create, release or query COM objects, per call site and per frame. A call
+// is instrumented by wrapping it in DXM_COM_CALL, which evaluates to the
+// result of the call:
+//
+//   hr = DXM_COM_CALL(CREATE, "Application::RenderFrame CreateQuery",
+//       mDevice->CreateQuery(&desc, &query));
+//
+// The site names must have static storage duration (string literals),
+// because only the pointers are recorded until the statistics are read;
+// sites with equal names are merged.
+//
+// The render loop ends each frame with EndFrame. A frame in steady state
+// (one that has no resize, device recovery or other reason to create
+// objects) that creates an object is flagged, and the first flagged frames
+// are listed with the site of their first creation. The final Release of a
+// device should return 0; RecordLiveReferences records a nonzero count,
+// and the report lists the objects that were still referenced.
+//
+// When accounting is off, the cost of an instrumented call is one relaxed
+// atomic load. Defining DXM_DISABLE_COM_ACCOUNTING removes the accounting
+// at compile time. C++/CLI code cannot include <atomic>, so there the check
+// is a call to ComAccounting::IsEnabled(). DXM_COM_CALL uses no lambda, so
+// it can be used in the member functions of ref classes.
+//
+// The code uses only the C++ standard library, not COM, so the accounting
+// can be tested with mock objects on any platform.
+
+namespace dxm
+{
+    class ComAccounting
+    {
+    public:
+        enum class Operation
+        {
+            CREATE,
+            RELEASE,
+            QUERY_INTERFACE
+        };
+
+        static size_t constexpr maxFlaggedFrames = 64;
+
+        struct Site
+        {
+            std::string name;
+            Operation operation;
+            uint64_t count;
+            double milliseconds;
+        };
+
+        struct Frame
+        {
+            uint64_t numCreates;
+            uint64_t numReleases;
+            uint64_t numQueryInterfaces;
+            double milliseconds;
+        };
+
+        struct FlaggedFrame
+        {
+            uint64_t frame;
+            uint64_t numCreates;
+            std::string firstSite;
+        };
+
+        struct LiveReferences
+        {
+            std::string name;
+            unsigned long references;
+        };
+
+        // Accounting is off initially. Enabling it does not clear the
+        // statistics; Reset does.
+        static void Enable(bool enable);
+        static bool IsEnabled();
+        static void Reset();
+
+        // DXM_COM_CALL calls Start before the call and Finish with its
+        // result. The start time is per thread.
+        static void Start();
+
+        template <typename Result>
+        static Result Finish(Operation operation, char const* site, Result result)
+        {
+            Record(operation, site);
+            return result;
+        }
+
+        static void Record(Operation operation, char const* site);
+
+        // End the current frame. The operations recorded since the previous
+        // EndFrame, on any thread, belong to the frame.
+        static void EndFrame(bool steadyState);
+
+        // Record the reference count returned by the final Release of an
+        // object when it is not 0. The name is copied.
+        static void RecordLiveReferences(char const* name, unsigned long references);
+
+        static std::vector<Site> GetSites();
+        static uint64_t GetNumFrames();
+        static Frame GetLastFrame();
+        static uint64_t GetNumFlaggedFrames();
+        static std::vector<FlaggedFrame> GetFlaggedFrames();
+        static std::vector<LiveReferences> GetLiveReferences();
+
+        // Write a text report: the sites sorted by total time, the frame
+        // counts, the flagged frames and the live references. The filename
+        // version returns 'false' when the file cannot be opened.
+        static void Write(std::ostream& output);
+        static bool Write(std::string const& filename);
+    };
+
+#if !defined(_M_CEE)
+    namespace ComAccountingDetail
+    {
+        extern std::atomic<bool> enabled;
+
+        inline bool IsEnabled()
+        {
+            return enabled.load(std::memory_order_relaxed);
+        }
+    }
+#endif
+}
+
+#if defined(DXM_DISABLE_COM_ACCOUNTING)
+#define DXM_COM_CALL(operation, site, call) (call)
+#else
+#if !defined(_M_CEE)
+#define DXM_COM_ACCOUNTING_ENABLED() dxm::ComAccountingDetail::IsEnabled()
+#else
+#define DXM_COM_ACCOUNTING_ENABLED() dxm::ComAccounting::IsEnabled()
+#endif
+#define DXM_COM_CALL(operation, site, call) \
+    (DXM_COM_ACCOUNTING_ENABLED() ? \
+        (dxm::ComAccounting::Start(), dxm::ComAccounting::Finish( \
+            dxm::ComAccounting::Operation::operation, (site), (call))) : \
+        (call))
+#endif
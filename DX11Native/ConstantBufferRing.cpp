@@ -0,0 +1,230 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "ConstantBufferRing.h"
+#include "ComAccounting.h"
+#include <cstring>
+#include <stdexcept>
+using namespace dxm;
+
+ConstantBufferRing::ConstantBufferRing(ID3D11Device* device,
+    ID3D11DeviceContext* context, UINT ringBytes)
+    :
+    mDevice(device),
+    mContext(context),
+    mContext1(nullptr),
+    mRingBuffer(nullptr),
+    mRing((ringBytes + sliceBytes - 1) / sliceBytes * sliceBytes, sliceBytes),
+    mPool{}
+{
+    // Constant buffer offsetting requires a D3D11.1 runtime and driver
+    // support. Writing a slice of a buffer that is bound to the pipeline
+    // with D3D11_MAP_WRITE_NO_OVERWRITE additionally requires support for
+    // MapNoOverwriteOnDynamicConstantBuffer. Without both, the pooled
+    // fallback is used.
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+    HRESULT hr = mDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS,
+        &options, sizeof(options));
+    if (SUCCEEDED(hr) &&
+        options.ConstantBufferOffsetting &&
+        options.MapNoOverwriteOnDynamicConstantBuffer)
+    {
+        hr = DXM_COM_CALL(QUERY_INTERFACE,
+            "ConstantBufferRing QueryInterface ID3D11DeviceContext1",
+            mContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&mContext1));
+        if (FAILED(hr))
+        {
+            mContext1 = nullptr;
+        }
+    }
+
+    if (mContext1)
+    {
+        mRingBuffer = CreateDynamicBuffer(static_cast<UINT>(mRing.GetCapacity()));
+    }
+}
+
+ConstantBufferRing::~ConstantBufferRing()
+{
+    for (auto& element : mPool)
+    {
+        for (auto buffer : element.second.buffers)
+        {
+            DXM_COM_CALL(RELEASE, "ConstantBufferRing Release pooled buffer",
+                buffer->Release());
+        }
+    }
+
+    if (mRingBuffer)
+    {
+        DXM_COM_CALL(RELEASE, "ConstantBufferRing Release ring buffer",
+            mRingBuffer->Release());
+    }
+
+    if (mContext1)
+    {
+        DXM_COM_CALL(RELEASE, "ConstantBufferRing Release context",
+            mContext1->Release());
+    }
+}
+
+ConstantBufferRing::Allocation ConstantBufferRing::Upload(void const* data,
+    UINT numBytes)
+{
+    if (numBytes == 0 || numBytes > maxBytes)
+    {
+        throw std::runtime_error("Invalid constant buffer size.");
+    }
+
+    return mContext1 ? UploadRing(data, numBytes) : UploadPool(data, numBytes);
+}
+
+void ConstantBufferRing::BindVS(UINT slot, Allocation const& allocation)
+{
+    if (mContext1)
+    {
+        mContext1->VSSetConstantBuffers1(slot, 1, &allocation.buffer,
+            &allocation.firstConstant, &allocation.numConstants);
+    }
+    else
+    {
+        mContext->VSSetConstantBuffers(slot, 1, &allocation.buffer);
+    }
+}
+
+void ConstantBufferRing::BindPS(UINT slot, Allocation const& allocation)
+{
+    if (mContext1)
+    {
+        mContext1->PSSetConstantBuffers1(slot, 1, &allocation.buffer,
+            &allocation.firstConstant, &allocation.numConstants);
+    }
+    else
+    {
+        mContext->PSSetConstantBuffers(slot, 1, &allocation.buffer);
+    }
+}
+
+void ConstantBufferRing::NextFrame()
+{
+    // The caller guarantees the GPU has finished the previous frame, so
+    // every closed frame can be retired.
+    mRing.EndFrame();
+    while (mRing.RetireFrame())
+    {
+        continue;
+    }
+
+    for (auto& element : mPool)
+    {
+        element.second.next = 0;
+    }
+}
+
+std::map<UINT, size_t> ConstantBufferRing::GetPoolSizes() const
+{
+    std::map<UINT, size_t> poolSizes;
+    for (auto const& element : mPool)
+    {
+        poolSizes[element.first] = element.second.buffers.size();
+    }
+    return poolSizes;
+}
+
+void ConstantBufferRing::Prewarm(std::map<UINT, size_t> const& poolSizes)
+{
+    if (mContext1)
+    {
+        return;
+    }
+
+    for (auto const& element : poolSizes)
+    {
+        Bucket& bucket = mPool[element.first];
+        while (bucket.buffers.size() < element.second)
+        {
+            bucket.buffers.push_back(CreateDynamicBuffer(element.first * sliceBytes));
+        }
+    }
+}
+
+ID3D11Buffer* ConstantBufferRing::CreateDynamicBuffer(UINT numBytes)
+{
+    D3D11_BUFFER_DESC desc{};
+    desc.ByteWidth = numBytes;
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    desc.MiscFlags = 0;
+    desc.StructureByteStride = 0;
+
+    ID3D11Buffer* buffer = nullptr;
+    HRESULT hr = DXM_COM_CALL(CREATE, "ConstantBufferRing::CreateDynamicBuffer CreateBuffer",
+        mDevice->CreateBuffer(&desc, nullptr, &buffer));
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("CreateBuffer failed for constant buffer.");
+    }
+    return buffer;
+}
+
+ConstantBufferRing::Allocation ConstantBufferRing::UploadRing(
+    void const* data, UINT numBytes)
+{
+    bool wrapped = false;
+    size_t offset = mRing.Allocate(numBytes, wrapped);
+    if (offset == RingAllocator::invalidOffset)
+    {
+        throw std::runtime_error("Constant buffer ring is full.");
+    }
+
+    // Discard when the ring wraps; the driver renames the buffer so that
+    // draws already submitted keep reading the previous contents. All
+    // other writes go to bytes the GPU is not reading.
+    D3D11_MAP mapType = (wrapped ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE);
+    D3D11_MAPPED_SUBRESOURCE sub{};
+    HRESULT hr = mContext->Map(mRingBuffer, 0, mapType, 0, &sub);
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Map failed for constant buffer ring.");
+    }
+    std::memcpy(static_cast<char*>(sub.pData) + offset, data, numBytes);
+    mContext->Unmap(mRingBuffer, 0);
+
+    Allocation allocation{};
+    allocation.buffer = mRingBuffer;
+    allocation.firstConstant = static_cast<UINT>(offset / 16);
+    allocation.numConstants = (numBytes + sliceBytes - 1) / sliceBytes * (sliceBytes / 16);
+    return allocation;
+}
+
+ConstantBufferRing::Allocation ConstantBufferRing::UploadPool(
+    void const* data, UINT numBytes)
+{
+    UINT const numSlices = (numBytes + sliceBytes - 1) / sliceBytes;
+    Bucket& bucket = mPool[numSlices];
+    if (bucket.next == bucket.buffers.size())
+    {
+        bucket.buffers.push_back(CreateDynamicBuffer(numSlices * sliceBytes));
+    }
+    ID3D11Buffer* buffer = bucket.buffers[bucket.next++];
+
+    D3D11_MAPPED_SUBRESOURCE sub{};
+    HRESULT hr = mContext->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &sub);
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Map failed for pooled constant buffer.");
+    }
+    std::memcpy(sub.pData, data, numBytes);
+    mContext->Unmap(buffer, 0);
+
+    Allocation allocation{};
+    allocation.buffer = buffer;
+    allocation.firstConstant = 0;
+    allocation.numConstants = numSlices * (sliceBytes / 16);
+    return allocation;
+}
@@ -0,0 +1,103 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include "RingAllocator.h"
+#include <d3d11_1.h>
+#include <map>
+#include <vector>
+
+// ConstantBufferRing supplies per-draw constant data without creating a
+// constant buffer per draw. On devices that support D3D11.1 constant
+// buffer offsetting, a single large dynamic buffer is suballocated in
+// 256-byte slices (16 constants of 16 bytes) and each slice is bound with
+// VSSetConstantBuffers1/PSSetConstantBuffers1. On older devices, the data
+// is uploaded to discrete dynamic buffers taken from a pool keyed by size.
+// The pooled buffers are recycled each frame.
+
+namespace dxm
+{
+    class ConstantBufferRing
+    {
+    public:
+        // The byte alignment and granularity of a slice. Offsets passed to
+        // *SetConstantBuffers1 are measured in 16-byte constants and must
+        // be multiples of 16 constants.
+        static UINT constexpr sliceBytes = 256;
+
+        // The largest constant buffer allowed by D3D11.
+        static UINT constexpr maxBytes =
+            D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT * 16;
+
+        struct Allocation
+        {
+            ID3D11Buffer* buffer;
+            UINT firstConstant;
+            UINT numConstants;
+        };
+
+        // The ring capacity is rounded up to a multiple of sliceBytes. The
+        // device and context are not reference counted by this class.
+        ConstantBufferRing(ID3D11Device* device, ID3D11DeviceContext* context,
+            UINT ringBytes);
+        ~ConstantBufferRing();
+
+        // Disallow copying; the class owns COM interfaces.
+        ConstantBufferRing(ConstantBufferRing const&) = delete;
+        ConstantBufferRing& operator=(ConstantBufferRing const&) = delete;
+
+        // Returns 'true' when the D3D11.1 ring is used, 'false' when the
+        // pooled fallback is used.
+        inline bool UsesOffsetBinding() const
+        {
+            return mContext1 != nullptr;
+        }
+
+        // Copy 'numBytes' of 'data' into GPU-visible memory. A
+        // std::runtime_error is thrown when the data is larger than
+        // maxBytes or when the ring is full.
+        Allocation Upload(void const* data, UINT numBytes);
+
+        // Bind an allocation to a shader slot.
+        void BindVS(UINT slot, Allocation const& allocation);
+        void BindPS(UINT slot, Allocation const& allocation);
+
+        // Call once per frame after the GPU has finished the previous
+        // frame. The ring space and pooled buffers of that frame are
+        // recycled.
+        void NextFrame();
+
+        // The number of pooled buffers for each size in slices. After a
+        // device loss, the sizes of the pool for the old device are passed
+        // to Prewarm for the new device so that the steady-state frames do
+        // not create buffers. The ring (offset binding) needs no prewarm.
+        std::map<UINT, size_t> GetPoolSizes() const;
+        void Prewarm(std::map<UINT, size_t> const& poolSizes);
+
+    private:
+        struct Bucket
+        {
+            std::vector<ID3D11Buffer*> buffers;
+            size_t next;
+        };
+
+        ID3D11Buffer* CreateDynamicBuffer(UINT numBytes);
+        Allocation UploadRing(void const* data, UINT numBytes);
+        Allocation UploadPool(void const* data, UINT numBytes);
+
+        ID3D11Device* mDevice;
+        ID3D11DeviceContext* mContext;
+        ID3D11DeviceContext1* mContext1;
+
+        // Offset binding.
+        ID3D11Buffer* mRingBuffer;
+        RingAllocator mRing;
+
+        // Pooled fallback, keyed by the size in slices.
+        std::map<UINT, Bucket> mPool;
+    };
+}
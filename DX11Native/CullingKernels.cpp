@@ -0,0 +1,224 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "CullingKernels.h"
+#include "CullingKernelsImpl.h"
+#include <cmath>
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+using namespace dxm;
+
+namespace dxm
+{
+    // Implemented in CullingKernelsAVX2.cpp.
+    size_t TransformBoundsAVX2(CullingBoundsArrays const& arrays, size_t begin, size_t end);
+    size_t CullSpheresAVX2(CullingCullArrays const& arrays, size_t begin, size_t end,
+        uint8_t* visible);
+    size_t CullBoxesAVX2(CullingCullArrays const& arrays, size_t begin, size_t end,
+        uint8_t* visible);
+
+    namespace
+    {
+        struct ScalarTraits
+        {
+            using V = float;
+            using M = bool;
+            static size_t constexpr width = 1;
+
+            static inline V Load(float const* p) { return *p; }
+            static inline void Store(float* p, V v) { *p = v; }
+            static inline V Set1(float s) { return s; }
+            static inline V Add(V a, V b) { return a + b; }
+            static inline V Mul(V a, V b) { return a * b; }
+            static inline V Abs(V a) { return std::fabs(a); }
+            static inline V Sqrt(V a) { return std::sqrt(a); }
+            static inline M AllTrue() { return true; }
+            static inline M GreaterEqual(V a, V b) { return a >= b; }
+            static inline M And(M a, M b) { return a && b; }
+            static inline uint32_t MoveMask(M m) { return m ? 1u : 0u; }
+        };
+
+        struct SSETraits
+        {
+            using V = __m128;
+            using M = __m128;
+            static size_t constexpr width = 4;
+
+            static inline V Load(float const* p) { return _mm_loadu_ps(p); }
+            static inline void Store(float* p, V v) { _mm_storeu_ps(p, v); }
+            static inline V Set1(float s) { return _mm_set1_ps(s); }
+            static inline V Add(V a, V b) { return _mm_add_ps(a, b); }
+            static inline V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+            static inline V Abs(V a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+            static inline V Sqrt(V a) { return _mm_sqrt_ps(a); }
+            static inline M AllTrue() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+            static inline M GreaterEqual(V a, V b) { return _mm_cmpge_ps(a, b); }
+            static inline M And(M a, M b) { return _mm_and_ps(a, b); }
+            static inline uint32_t MoveMask(M m) { return static_cast<uint32_t>(_mm_movemask_ps(m)); }
+        };
+
+        CullingBoundsArrays GetBoundsArrays(InstanceStore& store)
+        {
+            CullingBoundsArrays arrays{};
+            for (size_t i = 0; i < 3; ++i)
+            {
+                arrays.localCenter[i] = store.GetLocalCenter(i);
+                arrays.localExtent[i] = store.GetLocalExtent(i);
+                arrays.center[i] = store.GetCenter(i);
+                arrays.extent[i] = store.GetExtent(i);
+            }
+            for (size_t i = 0; i < 12; ++i)
+            {
+                arrays.world[i] = store.GetWorld(i);
+            }
+            arrays.radius = store.GetRadius();
+            return arrays;
+        }
+
+        CullingCullArrays GetCullArrays(Frustum const& frustum, InstanceStore const& store)
+        {
+            static_assert(CullingCullArrays::numPlanes == Frustum::NUM_PLANES,
+                "The kernels require the planes of Frustum.");
+
+            CullingCullArrays arrays{};
+            for (size_t p = 0; p < Frustum::NUM_PLANES; ++p)
+            {
+                auto const& plane = frustum.GetPlane(p);
+                for (size_t k = 0; k < 4; ++k)
+                {
+                    arrays.planes[p][k] = plane[k];
+                }
+            }
+            for (size_t i = 0; i < 3; ++i)
+            {
+                arrays.center[i] = store.GetCenter(i);
+                arrays.extent[i] = store.GetExtent(i);
+            }
+            arrays.radius = store.GetRadius();
+            return arrays;
+        }
+    }
+}
+
+CullingKernels::Path CullingKernels::GetBestPath()
+{
+    static Path const best = []()
+    {
+#if defined(_MSC_VER)
+        // AVX2 requires the CPU feature bits and operating system support
+        // for saving the YMM registers (OSXSAVE and XCR0 bits 1 and 2).
+        int info[4] = { 0, 0, 0, 0 };
+        __cpuid(info, 0);
+        int const maxLeaf = info[0];
+        __cpuid(info, 1);
+        bool const osxsave = (info[2] & (1 << 27)) != 0;
+        bool const avx = (info[2] & (1 << 28)) != 0;
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+        return avx2 ? Path::AVX2 : Path::SSE;
+#else
+        return __builtin_cpu_supports("avx2") ? Path::AVX2 : Path::SSE;
+#endif
+    }();
+    return best;
+}
+
+void CullingKernels::TransformBounds(Path path, InstanceStore& store,
+    size_t begin, size_t end)
+{
+    CullingBoundsArrays const arrays = GetBoundsArrays(store);
+    switch (path)
+    {
+    case Path::AVX2:
+        begin = TransformBoundsAVX2(arrays, begin, end);
+        break;
+    case Path::SSE:
+        begin = TransformBoundsKernel<SSETraits>(arrays, begin, end);
+        break;
+    default:
+        break;
+    }
+    TransformBoundsKernel<ScalarTraits>(arrays, begin, end);
+}
+
+void CullingKernels::CullSpheres(Path path, Frustum const& frustum,
+    InstanceStore const& store, size_t begin, size_t end, uint8_t* visible)
+{
+    CullingCullArrays const arrays = GetCullArrays(frustum, store);
+    switch (path)
+    {
+    case Path::AVX2:
+        begin = CullSpheresAVX2(arrays, begin, end, visible);
+        break;
+    case Path::SSE:
+        begin = CullKernel<SSETraits, false>(arrays, begin, end, visible);
+        break;
+    default:
+        break;
+    }
+    CullKernel<ScalarTraits, false>(arrays, begin, end, visible);
+}
+
+void CullingKernels::CullBoxes(Path path, Frustum const& frustum,
+    InstanceStore const& store, size_t begin, size_t end, uint8_t* visible)
+{
+    CullingCullArrays const arrays = GetCullArrays(frustum, store);
+    switch (path)
+    {
+    case Path::AVX2:
+        begin = CullBoxesAVX2(arrays, begin, end, visible);
+        break;
+    case Path::SSE:
+        begin = CullKernel<SSETraits, true>(arrays, begin, end, visible);
+        break;
+    default:
+        break;
+    }
+    CullKernel<ScalarTraits, true>(arrays, begin, end, visible);
+}
+
+void CullingKernels::TransformBounds(ThreadPool& pool, Path path,
+    InstanceStore& store, size_t grainSize)
+{
+    pool.ParallelFor(store.GetNumInstances(), grainSize,
+        [path, &store](size_t begin, size_t end)
+        {
+            TransformBounds(path, store, begin, end);
+        });
+}
+
+void CullingKernels::CullBoxes(ThreadPool& pool, Path path,
+    Frustum const& frustum, InstanceStore const& store, uint8_t* visible,
+    size_t grainSize)
+{
+    pool.ParallelFor(store.GetNumInstances(), grainSize,
+        [path, &frustum, &store, visible](size_t begin, size_t end)
+        {
+            CullBoxes(path, frustum, store, begin, end, visible);
+        });
+}
+
+size_t CullingKernels::Compact(uint8_t const* visible, size_t numInstances,
+    uint32_t* indices)
+{
+    size_t numVisible = 0;
+    for (size_t i = 0; i < numInstances; ++i)
+    {
+        // Write unconditionally and advance by the flag, which avoids a
+        // mispredicted branch per instance when visibility is mixed.
+        indices[numVisible] = static_cast<uint32_t>(i);
+        numVisible += visible[i];
+    }
+    return numVisible;
+}
@@ -0,0 +1,72 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include "Frustum.h"
+#include "InstanceStore.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+
+// Batch kernels that run before anything is submitted to the device. The
+// kernels process the instances [begin,end) of an InstanceStore. Each has a
+// scalar reference implementation and SSE (4-wide) and AVX2 (8-wide)
+// implementations that produce the same results up to floating-point
+// rounding. The scalar path is the reference for validating the others.
+//
+// The culling kernels write one byte per instance to 'visible' (1 when the
+// bound intersects the frustum, 0 otherwise), indexed by instance, so that
+// disjoint ranges can be processed concurrently. Compact converts the bytes
+// to a list of visible instance indices.
+
+namespace dxm
+{
+    class CullingKernels
+    {
+    public:
+        enum class Path
+        {
+            SCALAR,
+            SSE,
+            AVX2
+        };
+
+        // The fastest path supported by the processor and operating system.
+        static Path GetBestPath();
+
+        // Compute the world-space box and bounding sphere of each instance
+        // from its model-space box and world transform. The box is the
+        // bound of the transformed model box; the sphere encloses the box.
+        static void TransformBounds(Path path, InstanceStore& store,
+            size_t begin, size_t end);
+
+        static void CullSpheres(Path path, Frustum const& frustum,
+            InstanceStore const& store, size_t begin, size_t end,
+            uint8_t* visible);
+
+        static void CullBoxes(Path path, Frustum const& frustum,
+            InstanceStore const& store, size_t begin, size_t end,
+            uint8_t* visible);
+
+        // Parallel versions over all instances of the store. The instances
+        // are split into chunks of 'grainSize' instances.
+        static size_t constexpr defaultGrainSize = 4096;
+
+        static void TransformBounds(ThreadPool& pool, Path path,
+            InstanceStore& store, size_t grainSize = defaultGrainSize);
+
+        static void CullBoxes(ThreadPool& pool, Path path,
+            Frustum const& frustum, InstanceStore const& store,
+            uint8_t* visible, size_t grainSize = defaultGrainSize);
+
+        // Write the indices of the visible instances to 'indices', which
+        // must have room for 'numInstances' elements, and return the number
+        // of visible instances.
+        static size_t Compact(uint8_t const* visible, size_t numInstances,
+            uint32_t* indices);
+    };
+}
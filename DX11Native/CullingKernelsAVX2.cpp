@@ -0,0 +1,60 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+// This file is compiled with AVX2 code generation (/arch:AVX2 in the
+// project file, or the target pragma for GCC and Clang). Its functions
+// are called only when CullingKernels::GetBestPath() reports AVX2. It
+// must not include headers with inline functions of external linkage;
+// see CullingKernelsImpl.h.
+#if defined(__GNUC__) && !defined(__AVX2__)
+#pragma GCC target("avx2")
+#endif
+
+#include "CullingKernelsImpl.h"
+#include <immintrin.h>
+
+namespace dxm
+{
+    namespace
+    {
+        struct AVX2Traits
+        {
+            using V = __m256;
+            using M = __m256;
+            static size_t constexpr width = 8;
+
+            static inline V Load(float const* p) { return _mm256_loadu_ps(p); }
+            static inline void Store(float* p, V v) { _mm256_storeu_ps(p, v); }
+            static inline V Set1(float s) { return _mm256_set1_ps(s); }
+            static inline V Add(V a, V b) { return _mm256_add_ps(a, b); }
+            static inline V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+            static inline V Abs(V a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+            static inline V Sqrt(V a) { return _mm256_sqrt_ps(a); }
+            static inline M AllTrue() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+            static inline M GreaterEqual(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+            static inline M And(M a, M b) { return _mm256_and_ps(a, b); }
+            static inline uint32_t MoveMask(M m) { return static_cast<uint32_t>(_mm256_movemask_ps(m)); }
+        };
+    }
+
+    size_t TransformBoundsAVX2(CullingBoundsArrays const& arrays, size_t begin, size_t end)
+    {
+        return TransformBoundsKernel<AVX2Traits>(arrays, begin, end);
+    }
+
+    size_t CullSpheresAVX2(CullingCullArrays const& arrays, size_t begin, size_t end,
+        uint8_t* visible)
+    {
+        return CullKernel<AVX2Traits, false>(arrays, begin, end, visible);
+    }
+
+    size_t CullBoxesAVX2(CullingCullArrays const& arrays, size_t begin, size_t end,
+        uint8_t* visible)
+    {
+        return CullKernel<AVX2Traits, true>(arrays, begin, end, visible);
+    }
+}
@@ -0,0 +1,162 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+// This file is included only by CullingKernels.cpp and CullingKernelsAVX2.cpp.
+// The kernels are written once as templates on a SIMD traits class. The
+// traits provide a vector type V, a mask type M and the operations used by
+// the kernels. The AVX2 translation unit is compiled with AVX2 code
+// generation enabled. An inline function with external linkage that it
+// calls, such as an accessor of InstanceStore or Frustum or a <cmath>
+// function, could be emitted there with AVX2 instructions, and the linker
+// could select that copy for the callers on the scalar and SSE paths. So
+// the kernels see only the raw arrays below and the traits, everything
+// here has internal linkage, and the AVX2 traits use only intrinsics.
+//
+// A kernel processes the full vectors of [begin,end) and returns the index
+// of the first element it did not process. The caller, in CullingKernels.cpp,
+// processes the remaining elements with the scalar traits.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dxm
+{
+    // The arrays of an InstanceStore that TransformBounds reads and writes.
+    struct CullingBoundsArrays
+    {
+        float const* localCenter[3];
+        float const* localExtent[3];
+        float const* world[12];
+        float* center[3];
+        float* extent[3];
+        float* radius;
+    };
+
+    // The frustum planes (N,d) and the arrays of an InstanceStore that the
+    // culling kernels read.
+    struct CullingCullArrays
+    {
+        static size_t constexpr numPlanes = 6;
+        float planes[numPlanes][4];
+        float const* center[3];
+        float const* extent[3];
+        float const* radius;
+    };
+
+    namespace
+    {
+        template <typename T>
+        size_t TransformBoundsKernel(CullingBoundsArrays const& a, size_t begin, size_t end)
+        {
+            using V = typename T::V;
+            size_t constexpr W = T::width;
+
+            size_t const last = begin + (end - begin) / W * W;
+            size_t j = begin;
+            for (; j < last; j += W)
+            {
+                V x = T::Load(a.localCenter[0] + j);
+                V y = T::Load(a.localCenter[1] + j);
+                V z = T::Load(a.localCenter[2] + j);
+                V ex = T::Load(a.localExtent[0] + j);
+                V ey = T::Load(a.localExtent[1] + j);
+                V ez = T::Load(a.localExtent[2] + j);
+                V sqrLength = T::Set1(0.0f);
+                for (size_t r = 0; r < 3; ++r)
+                {
+                    V m0 = T::Load(a.world[4 * r] + j);
+                    V m1 = T::Load(a.world[4 * r + 1] + j);
+                    V m2 = T::Load(a.world[4 * r + 2] + j);
+                    V m3 = T::Load(a.world[4 * r + 3] + j);
+
+                    // The transformed box center is M*C. Its extent in
+                    // direction r is the sum of |M(r,k)|*E[k].
+                    V center = T::Add(T::Add(T::Mul(m0, x), T::Mul(m1, y)),
+                        T::Add(T::Mul(m2, z), m3));
+                    V extent = T::Add(T::Add(T::Mul(T::Abs(m0), ex),
+                        T::Mul(T::Abs(m1), ey)), T::Mul(T::Abs(m2), ez));
+                    T::Store(a.center[r] + j, center);
+                    T::Store(a.extent[r] + j, extent);
+                    sqrLength = T::Add(sqrLength, T::Mul(extent, extent));
+                }
+                T::Store(a.radius + j, T::Sqrt(sqrLength));
+            }
+            return j;
+        }
+
+        // A sphere is visible when its signed distance to every plane is
+        // at least -radius. A box is visible when, for every plane, the
+        // signed distance of its center is at least -Sum(|N[k]|*E[k]), the
+        // projected radius of the box onto the plane normal. Both tests
+        // are conservative: a bound near a frustum corner can be reported
+        // visible although it is outside.
+        template <typename T, bool IsBox>
+        size_t CullKernel(CullingCullArrays const& a, size_t begin, size_t end,
+            uint8_t* visible)
+        {
+            using V = typename T::V;
+            using M = typename T::M;
+            size_t constexpr W = T::width;
+            size_t constexpr numPlanes = CullingCullArrays::numPlanes;
+
+            V n[numPlanes][3], absN[numPlanes][3];
+            V d[numPlanes];
+            for (size_t p = 0; p < numPlanes; ++p)
+            {
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    n[p][k] = T::Set1(a.planes[p][k]);
+                    absN[p][k] = T::Abs(n[p][k]);
+                }
+                d[p] = T::Set1(a.planes[p][3]);
+            }
+
+            V const minusOne = T::Set1(-1.0f);
+            size_t const last = begin + (end - begin) / W * W;
+            size_t j = begin;
+            for (; j < last; j += W)
+            {
+                V x = T::Load(a.center[0] + j);
+                V y = T::Load(a.center[1] + j);
+                V z = T::Load(a.center[2] + j);
+                V ex{}, ey{}, ez{}, negRadius{};
+                if constexpr (IsBox)
+                {
+                    ex = T::Load(a.extent[0] + j);
+                    ey = T::Load(a.extent[1] + j);
+                    ez = T::Load(a.extent[2] + j);
+                }
+                else
+                {
+                    negRadius = T::Mul(minusOne, T::Load(a.radius + j));
+                }
+
+                M inside = T::AllTrue();
+                for (size_t p = 0; p < numPlanes; ++p)
+                {
+                    V distance = T::Add(T::Add(T::Mul(n[p][0], x), T::Mul(n[p][1], y)),
+                        T::Add(T::Mul(n[p][2], z), d[p]));
+                    if constexpr (IsBox)
+                    {
+                        V projected = T::Add(T::Add(T::Mul(absN[p][0], ex),
+                            T::Mul(absN[p][1], ey)), T::Mul(absN[p][2], ez));
+                        negRadius = T::Mul(minusOne, projected);
+                    }
+                    inside = T::And(inside, T::GreaterEqual(distance, negRadius));
+                }
+
+                uint32_t bits = T::MoveMask(inside);
+                for (size_t k = 0; k < W; ++k, bits >>= 1)
+                {
+                    visible[j + k] = static_cast<uint8_t>(bits & 1u);
+                }
+            }
+            return j;
+        }
+    }
+}
@@ -0,0 +1,124 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "DeviceRecovery.h"
+#include <stdexcept>
+using namespace dxm;
+
+DeviceRecovery::DeviceRecovery()
+    :
+    mStages{},
+    mState(State::UNINITIALIZED),
+    mFailedStage{},
+    mNumRecoveries(0),
+    mNumFailedAttempts(0),
+    mAwaitingFrame(false),
+    mLostTime{},
+    mLastRecoveryMilliseconds(0.0),
+    mLastRebuildMilliseconds(0.0)
+{
+}
+
+void DeviceRecovery::AddStage(std::string const& name,
+    std::function<bool()> const& create,
+    std::function<void()> const& release)
+{
+    mStages.push_back({ name, create, release });
+}
+
+bool DeviceRecovery::Create()
+{
+    if (CreateStages())
+    {
+        mState = State::OPERATIONAL;
+        return true;
+    }
+
+    mState = State::UNINITIALIZED;
+    return false;
+}
+
+void DeviceRecovery::Release()
+{
+    for (auto stage = mStages.rbegin(); stage != mStages.rend(); ++stage)
+    {
+        stage->release();
+    }
+}
+
+void DeviceRecovery::NotifyLost()
+{
+    if (mState == State::OPERATIONAL)
+    {
+        mState = State::LOST;
+        mLostTime = Clock::now();
+        mAwaitingFrame = false;
+    }
+}
+
+bool DeviceRecovery::TryRecover()
+{
+    if (mState != State::LOST)
+    {
+        return mState == State::OPERATIONAL;
+    }
+
+    Clock::time_point const start = Clock::now();
+    if (CreateStages())
+    {
+        auto const elapsed = Clock::now() - start;
+        mLastRebuildMilliseconds =
+            std::chrono::duration<double, std::milli>(elapsed).count();
+        mState = State::OPERATIONAL;
+        mAwaitingFrame = true;
+        ++mNumRecoveries;
+        return true;
+    }
+
+    ++mNumFailedAttempts;
+    return false;
+}
+
+void DeviceRecovery::NotifyFrameCompleted()
+{
+    if (mAwaitingFrame)
+    {
+        auto const elapsed = Clock::now() - mLostTime;
+        mLastRecoveryMilliseconds =
+            std::chrono::duration<double, std::milli>(elapsed).count();
+        mAwaitingFrame = false;
+    }
+}
+
+bool DeviceRecovery::CreateStages()
+{
+    // Release everything first. The release functions must tolerate
+    // objects that were never created or were already released.
+    Release();
+    mFailedStage.clear();
+
+    for (auto const& stage : mStages)
+    {
+        bool created = false;
+        try
+        {
+            created = stage.create();
+        }
+        catch (std::exception const&)
+        {
+            created = false;
+        }
+
+        if (!created)
+        {
+            mFailedStage = stage.name;
+            Release();
+            return false;
+        }
+    }
+    return true;
+}
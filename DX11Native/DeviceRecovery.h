@@ -0,0 +1,125 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// DeviceRecovery is the state machine for rebuilding device objects after
+// the device is removed, reset or hung (for example, after a driver update,
+// a TDR, or a session change such as a lock screen or RDP reconnect). The
+// device-dependent objects are registered as stages in dependency order,
+// each with a create and a release function. Recovery releases all stages
+// in reverse order and then creates them in order. A create function that
+// returns 'false' or throws a std::exception stops the attempt; the state
+// remains LOST and the next TryRecover call starts over.
+//
+// The class has no dependency on Direct3D, so the transitions can be
+// exercised by stages that fail on demand.
+//
+// The time from NotifyLost to the first NotifyFrameCompleted after a
+// successful recovery is the time to a recovered frame, which is what the
+// user sees as the repaint delay.
+
+namespace dxm
+{
+    class DeviceRecovery
+    {
+    public:
+        enum class State
+        {
+            UNINITIALIZED,
+            OPERATIONAL,
+            LOST
+        };
+
+        using Clock = std::chrono::steady_clock;
+
+        DeviceRecovery();
+        ~DeviceRecovery() = default;
+
+        // Stages are created in the order they are added.
+        void AddStage(std::string const& name,
+            std::function<bool()> const& create,
+            std::function<void()> const& release);
+
+        // Create all stages for the first time. On failure, the stages
+        // already created are released, the state is UNINITIALIZED and the
+        // name of the failing stage is returned by GetFailedStage().
+        bool Create();
+
+        // Release all stages in reverse order.
+        void Release();
+
+        // Report that a device call returned a device-lost error. The
+        // first report after OPERATIONAL starts the recovery timer.
+        void NotifyLost();
+
+        // Release and recreate all stages. Returns 'true' when the state
+        // is OPERATIONAL on return.
+        bool TryRecover();
+
+        // Report that a frame was rendered and handed to the compositor.
+        void NotifyFrameCompleted();
+
+        inline State GetState() const
+        {
+            return mState;
+        }
+
+        inline std::string const& GetFailedStage() const
+        {
+            return mFailedStage;
+        }
+
+        inline size_t GetNumRecoveries() const
+        {
+            return mNumRecoveries;
+        }
+
+        inline size_t GetNumFailedAttempts() const
+        {
+            return mNumFailedAttempts;
+        }
+
+        // The time from the loss to the first completed frame for the most
+        // recent recovery, and the part of it spent in the stage create
+        // functions. Both are zero before the first recovery.
+        inline double GetLastRecoveryMilliseconds() const
+        {
+            return mLastRecoveryMilliseconds;
+        }
+
+        inline double GetLastRebuildMilliseconds() const
+        {
+            return mLastRebuildMilliseconds;
+        }
+
+    private:
+        struct Stage
+        {
+            std::string name;
+            std::function<bool()> create;
+            std::function<void()> release;
+        };
+
+        bool CreateStages();
+
+        std::vector<Stage> mStages;
+        State mState;
+        std::string mFailedStage;
+        size_t mNumRecoveries;
+        size_t mNumFailedAttempts;
+        bool mAwaitingFrame;
+        Clock::time_point mLostTime;
+        double mLastRecoveryMilliseconds;
+        double mLastRebuildMilliseconds;
+    };
+}
@@ -0,0 +1,129 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+using namespace dxm;
+
+FrameArena::FrameArena(size_t bytesPerFrame, size_t numFramesInFlight)
+    :
+    mBytesPerFrame(bytesPerFrame),
+    mNumFramesInFlight(numFramesInFlight),
+    mRegionStride(0),
+    mStorage{},
+    mRegion(nullptr),
+    mCurrentFrame(0),
+    mOffset(0),
+    mHighWaterMark(0)
+{
+    if (mBytesPerFrame == 0 || mNumFramesInFlight == 0)
+    {
+        throw std::invalid_argument("FrameArena requires nonzero sizes.");
+    }
+
+    CreateRegions();
+}
+
+void* FrameArena::Allocate(size_t numBytes, size_t alignment)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+    {
+        throw std::invalid_argument("FrameArena alignment must be a power of two.");
+    }
+
+    uintptr_t const base = reinterpret_cast<uintptr_t>(mRegion);
+    uintptr_t const current = base + mOffset;
+    uintptr_t const aligned = (current + alignment - 1) & ~(alignment - 1);
+    size_t const newOffset = static_cast<size_t>(aligned - base) + numBytes;
+    if (newOffset > mBytesPerFrame || newOffset < mOffset)
+    {
+        ThrowOverflow();
+    }
+
+    mOffset = newOffset;
+    mHighWaterMark = std::max(mHighWaterMark, mOffset);
+    return reinterpret_cast<void*>(aligned);
+}
+
+void FrameArena::NextFrame()
+{
+    mCurrentFrame = (mCurrentFrame + 1) % mNumFramesInFlight;
+    ResetRegion(mCurrentFrame, true);
+}
+
+void FrameArena::Reset()
+{
+    for (size_t frame = mNumFramesInFlight; frame > 0; --frame)
+    {
+        ResetRegion(frame - 1, true);
+    }
+    mCurrentFrame = 0;
+}
+
+void FrameArena::Reserve(size_t bytesPerFrame)
+{
+    if (bytesPerFrame > mBytesPerFrame)
+    {
+        mBytesPerFrame = bytesPerFrame;
+        mStorage = std::vector<uint8_t>{};
+        CreateRegions();
+        mCurrentFrame = 0;
+    }
+}
+
+void FrameArena::CreateRegions()
+{
+    // Each region starts on a defaultAlignment boundary relative to the
+    // start of the storage. The storage itself is aligned by rounding up
+    // the first region pointer.
+    size_t const mask = defaultAlignment - 1;
+    mRegionStride = (mBytesPerFrame + guardSize + mask) & ~mask;
+    mStorage.resize(mRegionStride * mNumFramesInFlight + mask);
+    for (size_t frame = mNumFramesInFlight; frame > 0; --frame)
+    {
+        ResetRegion(frame - 1, false);
+    }
+}
+
+void FrameArena::ThrowOverflow()
+{
+    throw std::runtime_error("FrameArena overflow.");
+}
+
+void FrameArena::ResetRegion(size_t frame, bool checkGuard)
+{
+    size_t const mask = defaultAlignment - 1;
+    uintptr_t const storage = reinterpret_cast<uintptr_t>(mStorage.data());
+    uint8_t* region = reinterpret_cast<uint8_t*>((storage + mask) & ~mask) +
+        frame * mRegionStride;
+
+#if defined(_DEBUG)
+    // The guard bytes are written at construction. On later resets they
+    // must still be intact; otherwise, a client wrote past the end of an
+    // allocation at the end of the region.
+    uint8_t* guard = region + mBytesPerFrame;
+    if (checkGuard)
+    {
+        for (size_t i = 0; i < guardSize; ++i)
+        {
+            if (guard[i] != guardByte)
+            {
+                throw std::runtime_error("FrameArena guard bytes overwritten.");
+            }
+        }
+    }
+    std::memset(region, poisonByte, mBytesPerFrame);
+    std::memset(guard, guardByte, guardSize);
+#else
+    (void)checkGuard;
+#endif
+
+    mRegion = region;
+    mOffset = 0;
+}
@@ -0,0 +1,185 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// FrameArena is a linear allocator for transient per-frame data such as
+// draw lists, constant data and sort keys. The arena is partitioned into
+// one region per GPU frame in flight. Allocation is a pointer bump in the
+// region of the current frame. NextFrame() advances to the next region and
+// resets it, so the caller must guarantee that the GPU has retired the
+// frame that last used that region. In Application::RenderFrame, the GPU
+// is drained at the end of each frame, so this is always true.
+//
+// Objects allocated from the arena are never destroyed individually. Only
+// place trivially destructible data in the arena, or use the STL adapter
+// FrameArenaAllocator<T> for containers whose lifetime is a single frame.
+//
+// In debug builds (_DEBUG defined), each region is followed by guard bytes
+// that are verified when the region is reset, and the bytes of a reset
+// region are filled with a poison pattern so that stale pointers into a
+// retired frame produce recognizable garbage.
+
+namespace dxm
+{
+    class FrameArena
+    {
+    public:
+        // The default alignment is sufficient for SIMD data (16 bytes) and
+        // for the 16-byte constant buffer packing rules of HLSL.
+        static size_t constexpr defaultAlignment = 16;
+
+        FrameArena(size_t bytesPerFrame, size_t numFramesInFlight);
+        ~FrameArena() = default;
+
+        // Disallow copying; the allocator adapters hold pointers to the
+        // arena.
+        FrameArena(FrameArena const&) = delete;
+        FrameArena& operator=(FrameArena const&) = delete;
+
+        // Allocate 'numBytes' bytes from the current frame region. The
+        // alignment must be a power of two. A std::runtime_error is thrown
+        // when the region does not have enough space.
+        void* Allocate(size_t numBytes, size_t alignment = defaultAlignment);
+
+        // A std::runtime_error is also thrown when numElements * sizeof(T)
+        // overflows.
+        template <typename T>
+        T* Allocate(size_t numElements)
+        {
+            if (numElements > SIZE_MAX / sizeof(T))
+            {
+                ThrowOverflow();
+            }
+
+            return static_cast<T*>(Allocate(numElements * sizeof(T),
+                alignof(T) > defaultAlignment ? alignof(T) : defaultAlignment));
+        }
+
+        // Advance to the region of the next frame and reset it. In debug
+        // builds, a std::runtime_error is thrown when the guard bytes of
+        // the region were overwritten.
+        void NextFrame();
+
+        // Reset all regions. This is used when the device is recreated and
+        // no frames are in flight.
+        void Reset();
+
+        // Grow the regions to at least 'bytesPerFrame' bytes. When they
+        // grow, the storage is reallocated and all regions are reset, so
+        // the call is allowed only when no frames are in flight and nothing
+        // allocated in the current frame is still in use. In RenderFrame,
+        // this is the start of the frame.
+        void Reserve(size_t bytesPerFrame);
+
+        inline size_t GetBytesPerFrame() const
+        {
+            return mBytesPerFrame;
+        }
+
+        inline size_t GetNumFramesInFlight() const
+        {
+            return mNumFramesInFlight;
+        }
+
+        inline size_t GetCurrentFrame() const
+        {
+            return mCurrentFrame;
+        }
+
+        inline size_t GetBytesUsed() const
+        {
+            return mOffset;
+        }
+
+        // The maximum number of bytes used by any single frame since
+        // construction, useful for tuning 'bytesPerFrame'.
+        inline size_t GetHighWaterMark() const
+        {
+            return mHighWaterMark;
+        }
+
+    private:
+        void CreateRegions();
+        void ResetRegion(size_t frame, bool checkGuard);
+        [[noreturn]] static void ThrowOverflow();
+
+#if defined(_DEBUG)
+        static size_t constexpr guardSize = 64;
+        static uint8_t constexpr guardByte = 0xFD;
+        static uint8_t constexpr poisonByte = 0xCD;
+#else
+        static size_t constexpr guardSize = 0;
+#endif
+
+        size_t mBytesPerFrame;
+        size_t mNumFramesInFlight;
+        size_t mRegionStride;
+        std::vector<uint8_t> mStorage;
+        uint8_t* mRegion;
+        size_t mCurrentFrame;
+        size_t mOffset;
+        size_t mHighWaterMark;
+    };
+
+    // An STL-compatible allocator that allocates from the current frame
+    // of a FrameArena. Deallocation is a no-op; memory is reclaimed when
+    // the arena region is reset. For example,
+    //   std::vector<uint64_t, FrameArenaAllocator<uint64_t>> keys(
+    //       FrameArenaAllocator<uint64_t>(arena));
+    template <typename T>
+    class FrameArenaAllocator
+    {
+    public:
+        using value_type = T;
+
+        FrameArenaAllocator(FrameArena& arena) noexcept
+            :
+            mArena(&arena)
+        {
+        }
+
+        template <typename U>
+        FrameArenaAllocator(FrameArenaAllocator<U> const& other) noexcept
+            :
+            mArena(other.GetArena())
+        {
+        }
+
+        T* allocate(size_t numElements)
+        {
+            return mArena->Allocate<T>(numElements);
+        }
+
+        void deallocate(T*, size_t) noexcept
+        {
+        }
+
+        inline FrameArena* GetArena() const noexcept
+        {
+            return mArena;
+        }
+
+        template <typename U>
+        bool operator==(FrameArenaAllocator<U> const& other) const noexcept
+        {
+            return mArena == other.GetArena();
+        }
+
+        template <typename U>
+        bool operator!=(FrameArenaAllocator<U> const& other) const noexcept
+        {
+            return mArena != other.GetArena();
+        }
+
+    private:
+        FrameArena* mArena;
+    };
+}
@@ -0,0 +1,133 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include "Trace.h"
+
+// The frame loop of Application::RenderFrame is a template over three
+// policies. A feature that a policy disables is removed from the loop at
+// compile time instead of being tested every frame; a feature that a
+// policy enables is still switched on and off at run time by its own
+// setting (SetOverlayVisible, SetPostProcessPass, SetTileCacheEnabled,
+// Trace::Enable).
+//
+// Sync. WPF reads the shared surface after RenderFrame returns, so every
+// policy waits for the GPU to finish the frame. EventQueryPerFrame creates
+// and releases an event query in each frame. ReusedEventQuery ends the
+// same query, which is created with the device, in each frame.
+//
+// Instrumentation. RuntimeInstrumentation has the statistics overlay and
+// the trace scopes of the loop. NoInstrumentation has neither of them.
+// The COM calls are recorded by ComAccounting in every loop, so every loop
+// ends a ComAccounting frame.
+//
+// Present. DirectPresent draws the scene into the shared render target;
+// post-process passes and tile caching are ignored. ComposedPresent
+// applies them when they are enabled.
+//
+// The presets are the loops for which RenderFrame is instantiated.
+// STANDARD is the loop with every feature, which is the initial preset.
+// PER_FRAME_QUERY is STANDARD with the sync that RenderFrame had before
+// the presets, for comparing the sync policies.
+
+namespace dxm
+{
+    enum class FrameLoopPreset
+    {
+        // ReusedEventQuery, RuntimeInstrumentation, ComposedPresent.
+        STANDARD,
+
+        // ReusedEventQuery, NoInstrumentation, DirectPresent.
+        FAST,
+
+        // ReusedEventQuery, NoInstrumentation, ComposedPresent.
+        COMPOSED,
+
+        // EventQueryPerFrame, RuntimeInstrumentation, ComposedPresent.
+        PER_FRAME_QUERY
+    };
+
+    namespace FramePolicy
+    {
+        struct EventQueryPerFrame
+        {
+            static bool constexpr reuseQuery = false;
+        };
+
+        struct ReusedEventQuery
+        {
+            static bool constexpr reuseQuery = true;
+        };
+
+        struct NoInstrumentation
+        {
+            static bool constexpr enabled = false;
+        };
+
+        struct RuntimeInstrumentation
+        {
+            static bool constexpr enabled = true;
+        };
+
+        struct DirectPresent
+        {
+            static bool constexpr composed = false;
+        };
+
+        struct ComposedPresent
+        {
+            static bool constexpr composed = true;
+        };
+
+        template <typename SyncPolicy, typename InstrumentationPolicy, typename PresentPolicy>
+        struct FrameLoop
+        {
+            using Sync = SyncPolicy;
+            using Instrumentation = InstrumentationPolicy;
+            using Present = PresentPolicy;
+        };
+
+        using Standard = FrameLoop<ReusedEventQuery, RuntimeInstrumentation, ComposedPresent>;
+        using Fast = FrameLoop<ReusedEventQuery, NoInstrumentation, DirectPresent>;
+        using Composed = FrameLoop<ReusedEventQuery, NoInstrumentation, ComposedPresent>;
+        using PerFrameQuery = FrameLoop<EventQueryPerFrame, RuntimeInstrumentation, ComposedPresent>;
+
+#if !defined(_M_CEE)
+        // A TraceScope of the loop when 'Enabled' is true, otherwise an
+        // empty object.
+        template <bool Enabled>
+        class TraceScope : public dxm::TraceScope
+        {
+        public:
+            inline TraceScope(char const* name)
+                :
+                dxm::TraceScope(TraceDetail::IsEnabled() ? name : nullptr)
+            {
+            }
+        };
+
+        template <>
+        class TraceScope<false>
+        {
+        public:
+            inline TraceScope(char const*)
+            {
+            }
+        };
+#endif
+    }
+}
+
+// DXM_LOOP_TRACE_SCOPE(Loop, "name") is DXM_TRACE_SCOPE("name") when the
+// instrumentation policy of Loop is enabled and nothing otherwise.
+#if defined(DXM_DISABLE_TRACE)
+#define DXM_LOOP_TRACE_SCOPE(Loop, name)
+#else
+#define DXM_LOOP_TRACE_SCOPE(Loop, name) \
+    dxm::FramePolicy::TraceScope<Loop::Instrumentation::enabled> \
+        DXM_TRACE_CONCATENATE(loopTraceScope, __LINE__)(name)
+#endif
@@ -0,0 +1,200 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "FramePacer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#if !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+using namespace dxm;
+
+FrameIntervalStatistics::FrameIntervalStatistics(double targetInterval)
+{
+    Reset(targetInterval);
+}
+
+void FrameIntervalStatistics::Record(double seconds)
+{
+    if (mHasLastTime)
+    {
+        double const interval = seconds - mLastTime;
+        double const deviation = interval - mTargetInterval;
+        mLastInterval = interval;
+        mSumInterval += interval;
+        mSumSqrDeviation += deviation * deviation;
+        mMaxDeviation = std::max(mMaxDeviation, std::fabs(deviation));
+        ++mNumIntervals;
+    }
+    mLastTime = seconds;
+    mHasLastTime = true;
+}
+
+void FrameIntervalStatistics::Reset(double targetInterval)
+{
+    mTargetInterval = targetInterval;
+    mLastTime = 0.0;
+    mLastInterval = 0.0;
+    mSumInterval = 0.0;
+    mSumSqrDeviation = 0.0;
+    mMaxDeviation = 0.0;
+    mNumIntervals = 0;
+    mHasLastTime = false;
+}
+
+double FrameIntervalStatistics::GetMeanInterval() const
+{
+    return (mNumIntervals > 0 ? mSumInterval / static_cast<double>(mNumIntervals) : 0.0);
+}
+
+double FrameIntervalStatistics::GetJitter() const
+{
+    return (mNumIntervals > 0 ?
+        std::sqrt(mSumSqrDeviation / static_cast<double>(mNumIntervals)) : 0.0);
+}
+
+FramePacer::FramePacer(double framesPerSecond)
+    :
+    mRate(0.0),
+    mInterval(0.0),
+    mStart(0.0),
+    mFrame(0),
+    mSpinSeconds(defaultSpinSeconds),
+    mHighResolution(false),
+    mTimer(nullptr),
+    mStatistics{},
+    mNumMissed(0)
+{
+#if defined(_WIN32)
+    mTimer = CreateWaitableTimerExW(nullptr, nullptr,
+        CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (mTimer)
+    {
+        mHighResolution = true;
+    }
+    else
+    {
+        mTimer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        mSpinSeconds = lowResolutionSpinSeconds;
+    }
+#else
+    mHighResolution = true;
+#endif
+
+    SetRate(framesPerSecond);
+}
+
+FramePacer::~FramePacer()
+{
+#if defined(_WIN32)
+    if (mTimer)
+    {
+        CloseHandle(static_cast<HANDLE>(mTimer));
+    }
+#endif
+}
+
+void FramePacer::SetRate(double framesPerSecond)
+{
+    mRate = (framesPerSecond > 0.0 ? framesPerSecond : 0.0);
+    mInterval = (mRate > 0.0 ? 1.0 / mRate : 0.0);
+    mFrame = 0;
+    ResetStatistics();
+}
+
+double FramePacer::Wait()
+{
+    if (mRate <= 0.0)
+    {
+        return GetSeconds();
+    }
+
+    double now;
+    if (mFrame == 0)
+    {
+        now = GetSeconds();
+        mStart = now;
+    }
+    else
+    {
+        double deadline = mStart + static_cast<double>(mFrame) * mInterval;
+        now = GetSeconds();
+        if (now - deadline >= mInterval)
+        {
+            // Skip the deadlines that have passed and wait for the next one.
+            uint64_t const frame = static_cast<uint64_t>(
+                std::floor((now - mStart) / mInterval)) + 1;
+            mNumMissed += frame - mFrame;
+            mFrame = frame;
+            deadline = mStart + static_cast<double>(mFrame) * mInterval;
+        }
+
+        if (now < deadline - mSpinSeconds)
+        {
+            SleepUntil(deadline - mSpinSeconds);
+        }
+
+        do
+        {
+            now = GetSeconds();
+        }
+        while (now < deadline);
+    }
+
+    ++mFrame;
+    mStatistics.Record(now);
+    return now;
+}
+
+double FramePacer::GetSeconds()
+{
+    auto const elapsed = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double>(elapsed).count();
+}
+
+void FramePacer::ResetStatistics()
+{
+    mStatistics.Reset(mInterval);
+    mNumMissed = 0;
+}
+
+void FramePacer::SleepUntil(double seconds)
+{
+    double const duration = seconds - GetSeconds();
+    if (duration <= 0.0)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    if (mTimer)
+    {
+        // A negative due time is relative, in units of 100 nanoseconds.
+        LARGE_INTEGER dueTime{};
+        dueTime.QuadPart = -static_cast<LONGLONG>(duration * 1e7);
+        if (SetWaitableTimerEx(static_cast<HANDLE>(mTimer), &dueTime, 0,
+            nullptr, nullptr, nullptr, 0))
+        {
+            (void)WaitForSingleObject(static_cast<HANDLE>(mTimer), INFINITE);
+            return;
+        }
+    }
+    Sleep(static_cast<DWORD>(duration * 1e3));
+#else
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point const wakeTime(std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(seconds)));
+    std::this_thread::sleep_until(wakeTime);
+#endif
+}
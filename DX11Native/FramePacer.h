@@ -0,0 +1,152 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <cstdint>
+
+// FramePacer blocks the calling thread until the next frame deadline of a
+// fixed rate. The deadlines are start + n * interval, computed from the
+// frame index rather than accumulated from the previous wake-up, so the
+// errors of the individual waits do not drift the rate. A deadline missed
+// by a full interval or more is skipped, not caught up, and counted.
+//
+// The wait sleeps until spinSeconds before the deadline and spins for the
+// remainder. On Windows the sleep is a high-resolution waitable timer
+// (CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, Windows 10 1803 and later),
+// falling back to a standard waitable timer, whose resolution is that of
+// the system timer, with a longer spin. Elsewhere the sleep is
+// std::this_thread::sleep_until, which allows the scheduler accuracy to be
+// measured on Linux.
+//
+// The header does not include <thread> or <chrono> so that C++/CLI code
+// can include it.
+
+namespace dxm
+{
+    // Running statistics of the intervals between successive events,
+    // relative to a target interval. The jitter is the root-mean-square
+    // deviation of the intervals from the target.
+    class FrameIntervalStatistics
+    {
+    public:
+        FrameIntervalStatistics(double targetInterval = 0.0);
+
+        // Record an event at time 'seconds' (monotonic). The first event
+        // after a reset starts the first interval.
+        void Record(double seconds);
+
+        // Reset the statistics and set the target interval in seconds.
+        void Reset(double targetInterval);
+
+        inline double GetTargetInterval() const
+        {
+            return mTargetInterval;
+        }
+
+        inline uint64_t GetNumIntervals() const
+        {
+            return mNumIntervals;
+        }
+
+        inline double GetLastInterval() const
+        {
+            return mLastInterval;
+        }
+
+        double GetMeanInterval() const;
+        double GetJitter() const;
+
+        // The largest absolute deviation of an interval from the target.
+        inline double GetMaxDeviation() const
+        {
+            return mMaxDeviation;
+        }
+
+    private:
+        double mTargetInterval;
+        double mLastTime;
+        double mLastInterval;
+        double mSumInterval;
+        double mSumSqrDeviation;
+        double mMaxDeviation;
+        uint64_t mNumIntervals;
+        bool mHasLastTime;
+    };
+
+    class FramePacer
+    {
+    public:
+        // The spin durations with a high-resolution timer (and on platforms
+        // other than Windows) and with a standard waitable timer.
+        static double constexpr defaultSpinSeconds = 0.0005;
+        static double constexpr lowResolutionSpinSeconds = 0.002;
+
+        // A rate of 0 makes Wait return at once.
+        FramePacer(double framesPerSecond = 0.0);
+        ~FramePacer();
+
+        // Set the rate and restart the schedule; the first Wait afterwards
+        // returns at once.
+        void SetRate(double framesPerSecond);
+
+        inline double GetRate() const
+        {
+            return mRate;
+        }
+
+        // The duration of the final spin. Setting it to 0 relies on the
+        // sleep alone, which shows the accuracy of the timer.
+        inline void SetSpinSeconds(double spinSeconds)
+        {
+            mSpinSeconds = (spinSeconds > 0.0 ? spinSeconds : 0.0);
+        }
+
+        inline double GetSpinSeconds() const
+        {
+            return mSpinSeconds;
+        }
+
+        // Returns 'true' when the platform has a high-resolution timer.
+        inline bool IsHighResolution() const
+        {
+            return mHighResolution;
+        }
+
+        // Block until the next deadline and return the time of the wake-up.
+        double Wait();
+
+        // The monotonic time in seconds used for the deadlines.
+        static double GetSeconds();
+
+        // The intervals between the wake-ups of Wait.
+        inline FrameIntervalStatistics const& GetStatistics() const
+        {
+            return mStatistics;
+        }
+
+        // The deadlines skipped because Wait was called too late.
+        inline uint64_t GetNumMissed() const
+        {
+            return mNumMissed;
+        }
+
+        void ResetStatistics();
+
+    private:
+        void SleepUntil(double seconds);
+
+        double mRate;
+        double mInterval;
+        double mStart;
+        uint64_t mFrame;
+        double mSpinSeconds;
+        bool mHighResolution;
+        void* mTimer;
+        FrameIntervalStatistics mStatistics;
+        uint64_t mNumMissed;
+    };
+}
@@ -0,0 +1,176 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "FrameRateGovernor.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+using namespace dxm;
+
+FrameRateGovernor::Policy FrameRateGovernor::DefaultPolicy()
+{
+    Policy policy{};
+    policy.displayRate = 60.0;
+    policy.unfocusedRate = 30.0;
+    policy.batteryRate = 30.0;
+    policy.idleRate = 10.0;
+    policy.idleSeconds = 30.0;
+    policy.occludedRate = 1.0;
+    policy.rampSeconds = 0.5;
+    return policy;
+}
+
+FrameRateGovernor::FrameRateGovernor(Policy const& policy)
+    :
+    mPolicy(policy),
+    mCurrentRate(0.0),
+    mLastRequestTime(0.0),
+    mLastFrameTime(0.0),
+    mLastIdleSeconds(0.0),
+    mFirstRequest(true),
+    mWake(true),
+    mStatistics{}
+{
+    Validate(policy);
+}
+
+void FrameRateGovernor::SetPolicy(Policy const& policy)
+{
+    Validate(policy);
+    mPolicy = policy;
+    mWake = true;
+}
+
+void FrameRateGovernor::Validate(Policy const& policy)
+{
+    // The comparisons are written so that NaN fails them. The display rate
+    // divides the slack of the deadlines in OnRequest.
+    if (!(policy.displayRate > 0.0))
+    {
+        throw std::invalid_argument("FrameRateGovernor display rate must be positive.");
+    }
+    if (!(policy.unfocusedRate >= 0.0) || !(policy.batteryRate >= 0.0) ||
+        !(policy.idleRate >= 0.0) || !(policy.occludedRate >= 0.0))
+    {
+        throw std::invalid_argument("FrameRateGovernor rates must be nonnegative.");
+    }
+    if (!(policy.idleSeconds >= 0.0) || !(policy.rampSeconds >= 0.0))
+    {
+        throw std::invalid_argument("FrameRateGovernor times must be nonnegative.");
+    }
+}
+
+double FrameRateGovernor::GetTargetRate(WindowState const& state) const
+{
+    if (state.minimized)
+    {
+        return 0.0;
+    }
+
+    double rate = mPolicy.displayRate;
+    if (state.occluded)
+    {
+        rate = std::min(rate, mPolicy.occludedRate);
+    }
+    if (state.idleSeconds >= mPolicy.idleSeconds)
+    {
+        rate = std::min(rate, mPolicy.idleRate);
+    }
+    if (!state.focused)
+    {
+        rate = std::min(rate, mPolicy.unfocusedRate);
+    }
+    if (state.onBattery)
+    {
+        rate = std::min(rate, mPolicy.batteryRate);
+    }
+    return std::max(rate, 0.0);
+}
+
+bool FrameRateGovernor::OnRequest(WindowState const& state, double seconds)
+{
+    ++mStatistics.numRequests;
+
+    double const target = GetTargetRate(state);
+    bool const input = (!mFirstRequest && state.idleSeconds < mLastIdleSeconds);
+    mLastIdleSeconds = state.idleSeconds;
+
+    if (mFirstRequest || target >= mCurrentRate)
+    {
+        if (target > mCurrentRate)
+        {
+            mWake = true;
+        }
+        mCurrentRate = target;
+        mFirstRequest = false;
+    }
+    else
+    {
+        // Decay toward the lower target. The rate snaps to the target when
+        // the difference is no longer noticeable.
+        double const dt = std::max(seconds - mLastRequestTime, 0.0);
+        if (mPolicy.rampSeconds > 0.0)
+        {
+            mCurrentRate = target + (mCurrentRate - target) *
+                std::exp(-dt / mPolicy.rampSeconds);
+        }
+        else
+        {
+            mCurrentRate = target;
+        }
+
+        if (mCurrentRate - target < 0.5)
+        {
+            mCurrentRate = target;
+        }
+    }
+    mLastRequestTime = seconds;
+
+    if (input)
+    {
+        mWake = true;
+    }
+
+    bool render;
+    if (mCurrentRate <= 0.0)
+    {
+        render = false;
+    }
+    else if (mWake || mCurrentRate >= mPolicy.displayRate)
+    {
+        render = true;
+        mLastFrameTime = seconds;
+    }
+    else
+    {
+        // The frames follow deadlines spaced by the interval rather than
+        // the request times, so a rate that is not a divisor of the request
+        // rate is met on average. Half a request interval of slack accepts
+        // a request that arrives slightly before its deadline. A deadline
+        // missed by more than an interval is not caught up.
+        double const interval = 1.0 / mCurrentRate;
+        double const slack = 0.5 / mPolicy.displayRate;
+        double const deadline = mLastFrameTime + interval;
+        render = (seconds >= deadline - slack);
+        if (render)
+        {
+            mLastFrameTime = (seconds - deadline > interval ? seconds : deadline);
+        }
+    }
+
+    if (render)
+    {
+        ++mStatistics.numRendered;
+        mWake = false;
+    }
+    return render;
+}
+
+void FrameRateGovernor::ResetStatistics()
+{
+    mStatistics = Statistics{};
+}
@@ -0,0 +1,114 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <cstdint>
+
+// FrameRateGovernor decides, for each render request (a WPF Rendering
+// event), whether a frame is rendered. The target rate is the smallest of
+// the caps that apply to the window state:
+//   minimized            0 (no frames)
+//   occluded             occludedRate
+//   idle (no input for idleSeconds)  idleRate
+//   not focused          unfocusedRate
+//   on battery           batteryRate
+//   otherwise            displayRate (every request)
+// A lower target is approached gradually, with time constant rampSeconds,
+// so an animation does not visibly stutter when the window loses focus.
+// A higher target takes effect at once and the next request renders, so
+// input or focus wakes the window without delay.
+//
+// The class has no platform dependencies; the caller supplies the window
+// state and the time. This allows the policy to be simulated.
+
+namespace dxm
+{
+    class FrameRateGovernor
+    {
+    public:
+        struct WindowState
+        {
+            bool focused;
+            bool occluded;
+            bool minimized;
+            bool onBattery;
+            double idleSeconds;
+        };
+
+        struct Policy
+        {
+            // The rate of the render requests. A target at or above this
+            // rate renders every request.
+            double displayRate;
+            double unfocusedRate;
+            double batteryRate;
+            double idleRate;
+            double idleSeconds;
+            double occludedRate;
+            double rampSeconds;
+        };
+
+        struct Statistics
+        {
+            uint64_t numRequests;
+            uint64_t numRendered;
+        };
+
+        static Policy DefaultPolicy();
+
+        // The display rate must be positive. The other rates and the times
+        // must be nonnegative; a rate of 0 renders no frames in its state.
+        // An invalid policy throws std::invalid_argument.
+        FrameRateGovernor(Policy const& policy = DefaultPolicy());
+        ~FrameRateGovernor() = default;
+
+        void SetPolicy(Policy const& policy);
+
+        inline Policy const& GetPolicy() const
+        {
+            return mPolicy;
+        }
+
+        // The target rate for a window state, before ramping.
+        double GetTargetRate(WindowState const& state) const;
+
+        // Update the rate for the state at time 'seconds' (monotonic) and
+        // return 'true' when a frame should be rendered for this request.
+        bool OnRequest(WindowState const& state, double seconds);
+
+        // The ramped rate used by the last OnRequest call.
+        inline double GetCurrentRate() const
+        {
+            return mCurrentRate;
+        }
+
+        inline Statistics const& GetStatistics() const
+        {
+            return mStatistics;
+        }
+
+        // The requests that did not render.
+        inline uint64_t GetNumSaved() const
+        {
+            return mStatistics.numRequests - mStatistics.numRendered;
+        }
+
+        void ResetStatistics();
+
+    private:
+        static void Validate(Policy const& policy);
+
+        Policy mPolicy;
+        double mCurrentRate;
+        double mLastRequestTime;
+        double mLastFrameTime;
+        double mLastIdleSeconds;
+        bool mFirstRequest;
+        bool mWake;
+        Statistics mStatistics;
+    };
+}
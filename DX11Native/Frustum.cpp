@@ -0,0 +1,56 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "Frustum.h"
+#include <cmath>
+using namespace dxm;
+
+Frustum::Frustum()
+    :
+    mPlanes{}
+{
+    // The default is the clip-space box -1 <= x,y <= 1 and 0 <= z <= 1.
+    std::array<float, 16> const identity =
+    {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+    FromViewProjection(identity);
+}
+
+void Frustum::FromViewProjection(std::array<float, 16> const& H)
+{
+    // Let R[i] be row i of H. A point is inside the clip volume when
+    // -w <= x <= w, -w <= y <= w and 0 <= z <= w, where (x,y,z,w) =
+    // (Dot(R[0],P), Dot(R[1],P), Dot(R[2],P), Dot(R[3],P)) for P =
+    // (X,1). Each inequality is a plane in the coordinates of X.
+    for (size_t c = 0; c < 4; ++c)
+    {
+        float const r0 = H[c], r1 = H[4 + c], r2 = H[8 + c], r3 = H[12 + c];
+        mPlanes[LEFT][c] = r3 + r0;
+        mPlanes[RIGHT][c] = r3 - r0;
+        mPlanes[BOTTOM][c] = r3 + r1;
+        mPlanes[TOP][c] = r3 - r1;
+        mPlanes[NEAR_PLANE][c] = r2;
+        mPlanes[FAR_PLANE][c] = r3 - r2;
+    }
+
+    for (auto& plane : mPlanes)
+    {
+        float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] +
+            plane[2] * plane[2]);
+        if (length > 0.0f)
+        {
+            for (auto& value : plane)
+            {
+                value /= length;
+            }
+        }
+    }
+}
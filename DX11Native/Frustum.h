@@ -0,0 +1,43 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+// A view frustum represented by 6 planes Dot(N,X) + d = 0. The normals
+// point to the inside of the frustum, so a point X is inside when
+// Dot(N,X) + d >= 0 for all planes. The planes are stored as (N,d).
+
+namespace dxm
+{
+    class Frustum
+    {
+    public:
+        enum Plane
+        {
+            LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, NUM_PLANES
+        };
+
+        Frustum();
+
+        // Extract the planes from a view-projection matrix H stored in
+        // row-major order and applied as clip = H * (x,y,z,1). The clip
+        // space depth is in [0,1], which is the Direct3D convention. The
+        // planes are normalized so that the plane function is a signed
+        // distance.
+        void FromViewProjection(std::array<float, 16> const& H);
+
+        inline std::array<float, 4> const& GetPlane(size_t i) const
+        {
+            return mPlanes[i];
+        }
+
+    private:
+        std::array<std::array<float, 4>, NUM_PLANES> mPlanes;
+    };
+}
@@ -0,0 +1,347 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "GeometryHeap.h"
+#include "ComAccounting.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+using namespace dxm;
+
+GeometryHeap::GeometryHeap(ID3D11Device* device, ID3D11DeviceContext* context,
+    UINT vertexStride, DXGI_FORMAT indexFormat, size_t verticesPerPage,
+    size_t indicesPerPage)
+    :
+    mDevice(device),
+    mContext(context),
+    mVertexStride(vertexStride),
+    mIndexFormat(indexFormat),
+    mIndexSize(indexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4),
+    mVerticesPerPage(verticesPerPage),
+    mIndicesPerPage(indicesPerPage),
+    mPages{},
+    mScratch(nullptr),
+    mMeshes{},
+    mFreeMeshes{},
+    mNumMeshes(0),
+    mDefragmentPage(0),
+    mNumMoves(0),
+    mBytesMoved(0)
+{
+    if (indexFormat != DXGI_FORMAT_R16_UINT && indexFormat != DXGI_FORMAT_R32_UINT)
+    {
+        throw std::invalid_argument("GeometryHeap index format must be R16_UINT or R32_UINT.");
+    }
+
+    if (vertexStride == 0 || verticesPerPage == 0 || indicesPerPage == 0)
+    {
+        throw std::invalid_argument("GeometryHeap stride and page sizes must be positive.");
+    }
+
+    // The scratch buffer is the intermediate of the copies made by
+    // Defragment. A buffer has a single subresource, and a copy within
+    // one subresource is not allowed.
+    mScratch = CreateBuffer(static_cast<UINT>(scratchBytes), D3D11_BIND_VERTEX_BUFFER);
+}
+
+GeometryHeap::~GeometryHeap()
+{
+    for (auto& page : mPages)
+    {
+        DXM_COM_CALL(RELEASE, "GeometryHeap Release vertex buffer",
+            page->vertices.buffer->Release());
+        DXM_COM_CALL(RELEASE, "GeometryHeap Release index buffer",
+            page->indices.buffer->Release());
+    }
+
+    if (mScratch)
+    {
+        DXM_COM_CALL(RELEASE, "GeometryHeap Release scratch buffer", mScratch->Release());
+    }
+}
+
+uint32_t GeometryHeap::AddMesh(void const* vertices, size_t numVertices,
+    void const* indices, size_t numIndices)
+{
+    if (numVertices == 0 || numIndices == 0)
+    {
+        throw std::invalid_argument("GeometryHeap meshes must have vertices and indices.");
+    }
+
+    uint32_t mesh;
+    if (!mFreeMeshes.empty())
+    {
+        mesh = mFreeMeshes.back();
+        mFreeMeshes.pop_back();
+    }
+    else
+    {
+        mesh = static_cast<uint32_t>(mMeshes.size());
+        mMeshes.push_back(Mesh{ invalidMesh, TLSFAllocator::invalidBlock,
+            TLSFAllocator::invalidBlock });
+    }
+
+    // Use the first page with room for both the vertices and the indices,
+    // so that the meshes added together tend to share a page.
+    TLSFAllocator::Allocation vertexAllocation{};
+    TLSFAllocator::Allocation indexAllocation{};
+    size_t page = 0;
+    for (; page < mPages.size(); ++page)
+    {
+        vertexAllocation = mPages[page]->vertices.allocator.Allocate(numVertices, mesh);
+        if (vertexAllocation.block == TLSFAllocator::invalidBlock)
+        {
+            continue;
+        }
+
+        indexAllocation = mPages[page]->indices.allocator.Allocate(numIndices, mesh);
+        if (indexAllocation.block != TLSFAllocator::invalidBlock)
+        {
+            break;
+        }
+        mPages[page]->vertices.allocator.Free(vertexAllocation.block);
+    }
+
+    if (page == mPages.size())
+    {
+        try
+        {
+            mPages.push_back(CreatePage(std::max(numVertices, mVerticesPerPage),
+                std::max(numIndices, mIndicesPerPage)));
+        }
+        catch (std::exception const&)
+        {
+            mFreeMeshes.push_back(mesh);
+            throw;
+        }
+        vertexAllocation = mPages[page]->vertices.allocator.Allocate(numVertices, mesh);
+        indexAllocation = mPages[page]->indices.allocator.Allocate(numIndices, mesh);
+        if (vertexAllocation.block == TLSFAllocator::invalidBlock ||
+            indexAllocation.block == TLSFAllocator::invalidBlock)
+        {
+            // The page is sized for the mesh, so this is not expected; the
+            // empty page is kept for later meshes.
+            if (vertexAllocation.block != TLSFAllocator::invalidBlock)
+            {
+                mPages[page]->vertices.allocator.Free(vertexAllocation.block);
+            }
+            if (indexAllocation.block != TLSFAllocator::invalidBlock)
+            {
+                mPages[page]->indices.allocator.Free(indexAllocation.block);
+            }
+            mFreeMeshes.push_back(mesh);
+            throw std::runtime_error("GeometryHeap page cannot hold the mesh.");
+        }
+    }
+
+    Page& target = *mPages[page];
+    Upload(target.vertices.buffer, vertexAllocation.offset * mVertexStride,
+        vertices, numVertices * mVertexStride);
+    Upload(target.indices.buffer, indexAllocation.offset * mIndexSize,
+        indices, numIndices * mIndexSize);
+
+    mMeshes[mesh] = Mesh{ static_cast<uint32_t>(page), vertexAllocation.block,
+        indexAllocation.block };
+    ++mNumMeshes;
+    return mesh;
+}
+
+void GeometryHeap::RemoveMesh(uint32_t mesh)
+{
+    if (mesh >= mMeshes.size() || mMeshes[mesh].page == invalidMesh)
+    {
+        throw std::invalid_argument("GeometryHeap::RemoveMesh of an unknown mesh.");
+    }
+
+    Mesh& record = mMeshes[mesh];
+    Page& page = *mPages[record.page];
+    page.vertices.allocator.Free(record.vertexBlock);
+    page.indices.allocator.Free(record.indexBlock);
+    record = Mesh{ invalidMesh, TLSFAllocator::invalidBlock, TLSFAllocator::invalidBlock };
+    mFreeMeshes.push_back(mesh);
+    --mNumMeshes;
+}
+
+GeometryHeap::MeshDraw GeometryHeap::GetDraw(uint32_t mesh) const
+{
+    Mesh const& record = mMeshes[mesh];
+    Page const& page = *mPages[record.page];
+
+    MeshDraw draw{};
+    draw.page = record.page;
+    draw.indexCount = static_cast<UINT>(page.indices.allocator.GetSize(record.indexBlock));
+    draw.firstIndex = static_cast<UINT>(page.indices.allocator.GetOffset(record.indexBlock));
+    draw.baseVertex = static_cast<INT>(page.vertices.allocator.GetOffset(record.vertexBlock));
+    return draw;
+}
+
+void GeometryHeap::SetBuffers(uint32_t page, RenderQueue::DrawState& state) const
+{
+    state.vertexBuffer = mPages[page]->vertices.buffer;
+    state.vertexStride = mVertexStride;
+    state.vertexOffset = 0;
+    state.indexBuffer = mPages[page]->indices.buffer;
+    state.indexFormat = mIndexFormat;
+    state.indexOffset = 0;
+}
+
+size_t GeometryHeap::Defragment(size_t maxBytes)
+{
+    size_t copied = 0;
+    for (size_t i = 0; i < mPages.size() && copied < maxBytes; ++i)
+    {
+        // Continue with the page where the previous call stopped so that
+        // every page makes progress under the byte budget.
+        Page& page = *mPages[mDefragmentPage];
+        copied += Compact(page.vertices, mVertexStride, maxBytes - copied);
+        if (copied < maxBytes)
+        {
+            copied += Compact(page.indices, mIndexSize, maxBytes - copied);
+        }
+
+        if (copied < maxBytes)
+        {
+            mDefragmentPage = (mDefragmentPage + 1) % mPages.size();
+        }
+    }
+    return copied;
+}
+
+GeometryHeap::Statistics GeometryHeap::GetStatistics() const
+{
+    Statistics statistics{};
+    statistics.numPages = mPages.size();
+    statistics.numMeshes = mNumMeshes;
+    for (auto const& page : mPages)
+    {
+        statistics.vertexBytesUsed += page->vertices.allocator.GetUsed() * mVertexStride;
+        statistics.indexBytesUsed += page->indices.allocator.GetUsed() * mIndexSize;
+        statistics.bytesCapacity +=
+            page->vertices.allocator.GetCapacity() * mVertexStride +
+            page->indices.allocator.GetCapacity() * mIndexSize;
+    }
+    statistics.numMoves = mNumMoves;
+    statistics.bytesMoved = mBytesMoved;
+    return statistics;
+}
+
+std::unique_ptr<GeometryHeap::Page> GeometryHeap::CreatePage(size_t numVertices,
+    size_t numIndices)
+{
+    // The base vertex of a draw is an INT and the byte sizes are UINTs.
+    size_t const maxBytes = std::numeric_limits<UINT>::max();
+    if (numVertices > static_cast<size_t>(std::numeric_limits<INT>::max()) ||
+        numVertices * mVertexStride > maxBytes || numIndices * mIndexSize > maxBytes)
+    {
+        throw std::runtime_error("GeometryHeap page is too large.");
+    }
+
+    auto page = std::make_unique<Page>(numVertices, numIndices);
+    page->vertices.buffer = CreateBuffer(static_cast<UINT>(numVertices * mVertexStride),
+        D3D11_BIND_VERTEX_BUFFER);
+    try
+    {
+        page->indices.buffer = CreateBuffer(static_cast<UINT>(numIndices * mIndexSize),
+            D3D11_BIND_INDEX_BUFFER);
+    }
+    catch (std::exception const&)
+    {
+        DXM_COM_CALL(RELEASE, "GeometryHeap Release vertex buffer",
+            page->vertices.buffer->Release());
+        throw;
+    }
+    return page;
+}
+
+ID3D11Buffer* GeometryHeap::CreateBuffer(UINT numBytes, UINT bindFlags)
+{
+    D3D11_BUFFER_DESC desc{};
+    desc.ByteWidth = numBytes;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = bindFlags;
+    desc.CPUAccessFlags = 0;
+    desc.MiscFlags = 0;
+    desc.StructureByteStride = 0;
+
+    ID3D11Buffer* buffer = nullptr;
+    HRESULT hr = DXM_COM_CALL(CREATE, "GeometryHeap::CreateBuffer CreateBuffer",
+        mDevice->CreateBuffer(&desc, nullptr, &buffer));
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("CreateBuffer failed for geometry heap.");
+    }
+    return buffer;
+}
+
+void GeometryHeap::Upload(ID3D11Buffer* buffer, size_t offset, void const* data,
+    size_t numBytes)
+{
+    D3D11_BOX box{};
+    box.left = static_cast<UINT>(offset);
+    box.right = static_cast<UINT>(offset + numBytes);
+    box.top = 0;
+    box.bottom = 1;
+    box.front = 0;
+    box.back = 1;
+    mContext->UpdateSubresource(buffer, 0, &box, data, 0, 0);
+}
+
+void GeometryHeap::MoveBytes(ID3D11Buffer* buffer, size_t source, size_t target,
+    size_t numBytes)
+{
+    // The target is below the source, so copying the chunks front to back
+    // never overwrites source bytes that are still to be copied.
+    for (size_t done = 0; done < numBytes; done += scratchBytes)
+    {
+        UINT const size = static_cast<UINT>(std::min(scratchBytes, numBytes - done));
+
+        D3D11_BOX box{};
+        box.left = static_cast<UINT>(source + done);
+        box.right = box.left + size;
+        box.top = 0;
+        box.bottom = 1;
+        box.front = 0;
+        box.back = 1;
+        mContext->CopySubresourceRegion(mScratch, 0, 0, 0, 0, buffer, 0, &box);
+
+        box.left = 0;
+        box.right = size;
+        mContext->CopySubresourceRegion(buffer, 0, static_cast<UINT>(target + done),
+            0, 0, mScratch, 0, &box);
+    }
+}
+
+size_t GeometryHeap::Compact(Range& range, size_t unitBytes, size_t maxBytes)
+{
+    if (!range.compacting)
+    {
+        if (range.allocator.GetFragmentation() <= minFragmentation)
+        {
+            return 0;
+        }
+        range.compacting = true;
+    }
+
+    size_t copied = 0;
+    TLSFAllocator::Move move{};
+    while (copied < maxBytes)
+    {
+        if (!range.allocator.Compact(move))
+        {
+            range.compacting = false;
+            break;
+        }
+
+        size_t const numBytes = move.size * unitBytes;
+        MoveBytes(range.buffer, move.oldOffset * unitBytes,
+            move.newOffset * unitBytes, numBytes);
+        copied += numBytes;
+        ++mNumMoves;
+        mBytesMoved += numBytes;
+    }
+    return copied;
+}
@@ -0,0 +1,183 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include "RenderQueue.h"
+#include "TLSFAllocator.h"
+#include <d3d11.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// GeometryHeap stores many meshes in a few large vertex and index buffers
+// instead of a pair of buffers per mesh. The buffers are grouped in pages;
+// each page has a vertex buffer and an index buffer that are suballocated
+// by TLSFAllocator in units of vertices and indices. A mesh lives in one
+// page and is drawn with DrawIndexed(indexCount, firstIndex, baseVertex),
+// so the indices of a mesh are relative to its first vertex and all the
+// meshes of a page share one vertex and index buffer binding. A page is
+// added when a mesh does not fit in the existing pages; a mesh larger than
+// a page gets a page of its own size.
+//
+// Defragment moves meshes toward the start of their buffers with GPU
+// copies through a scratch buffer, a bounded number of bytes per call, so
+// that it can run every frame without a visible cost. Compaction of a
+// buffer starts when its fragmentation exceeds minFragmentation and runs
+// until the buffer is contiguous. The draw parameters of a mesh change
+// when it is moved, so GetDraw must be called for each frame rather than
+// cached. The copies are recorded on the immediate context before the
+// draws that follow them, so no synchronization is needed.
+//
+// All the meshes of a heap have the same vertex stride and index format.
+// The buffers are created with D3D11_USAGE_DEFAULT and filled with
+// UpdateSubresource.
+
+namespace dxm
+{
+    class GeometryHeap
+    {
+    public:
+        static uint32_t constexpr invalidMesh = 0xFFFFFFFFu;
+        static size_t constexpr scratchBytes = 256 * 1024;
+        static double constexpr minFragmentation = 0.25;
+
+        struct MeshDraw
+        {
+            uint32_t page;
+            UINT indexCount;
+            UINT firstIndex;
+            INT baseVertex;
+        };
+
+        struct Statistics
+        {
+            size_t numPages;
+            size_t numMeshes;
+            size_t vertexBytesUsed;
+            size_t indexBytesUsed;
+            size_t bytesCapacity;
+            size_t numMoves;
+            size_t bytesMoved;
+        };
+
+        // The device and context are not reference counted by this class.
+        // The index format is DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT.
+        // The page capacities are in vertices and indices.
+        GeometryHeap(ID3D11Device* device, ID3D11DeviceContext* context,
+            UINT vertexStride, DXGI_FORMAT indexFormat,
+            size_t verticesPerPage, size_t indicesPerPage);
+        ~GeometryHeap();
+
+        // Disallow copying; the class owns COM interfaces.
+        GeometryHeap(GeometryHeap const&) = delete;
+        GeometryHeap& operator=(GeometryHeap const&) = delete;
+
+        // Copy a mesh into the heap. The vertices have the heap stride and
+        // the indices have the heap format. A std::runtime_error is thrown
+        // when a page cannot be created or cannot hold the mesh.
+        uint32_t AddMesh(void const* vertices, size_t numVertices,
+            void const* indices, size_t numIndices);
+
+        void RemoveMesh(uint32_t mesh);
+
+        // The draw parameters of a mesh for RenderQueue::DrawItem, valid
+        // until the next Defragment call.
+        MeshDraw GetDraw(uint32_t mesh) const;
+
+        // Set the vertex and index buffer members of a draw state to those
+        // of a page. The other members are not modified.
+        void SetBuffers(uint32_t page, RenderQueue::DrawState& state) const;
+
+        // Move meshes until at least 'maxBytes' bytes have been copied or
+        // no buffer needs compaction. The return value is the number of
+        // bytes copied.
+        size_t Defragment(size_t maxBytes);
+
+        inline size_t GetNumPages() const
+        {
+            return mPages.size();
+        }
+
+        inline size_t GetNumMeshes() const
+        {
+            return mNumMeshes;
+        }
+
+        Statistics GetStatistics() const;
+
+    private:
+        struct Range
+        {
+            Range(size_t capacity)
+                :
+                buffer(nullptr),
+                allocator(capacity),
+                compacting(false)
+            {
+            }
+
+            ID3D11Buffer* buffer;
+            TLSFAllocator allocator;
+            bool compacting;
+        };
+
+        struct Page
+        {
+            Page(size_t numVertices, size_t numIndices)
+                :
+                vertices(numVertices),
+                indices(numIndices)
+            {
+            }
+
+            Range vertices;
+            Range indices;
+        };
+
+        struct Mesh
+        {
+            uint32_t page;
+            uint32_t vertexBlock;
+            uint32_t indexBlock;
+        };
+
+        std::unique_ptr<Page> CreatePage(size_t numVertices, size_t numIndices);
+        ID3D11Buffer* CreateBuffer(UINT numBytes, UINT bindFlags);
+        void Upload(ID3D11Buffer* buffer, size_t offset, void const* data, size_t numBytes);
+
+        // Copy bytes to a lower offset of the same buffer; the ranges can
+        // overlap.
+        void MoveBytes(ID3D11Buffer* buffer, size_t source, size_t target, size_t numBytes);
+
+        // Compact a range until 'maxBytes' bytes have been copied or it is
+        // contiguous. The return value is the number of bytes copied. The
+        // block of a mesh keeps its index when moved, and GetDraw reads
+        // the offsets from the allocators, so no mesh record changes.
+        size_t Compact(Range& range, size_t unitBytes, size_t maxBytes);
+
+        ID3D11Device* mDevice;
+        ID3D11DeviceContext* mContext;
+        UINT mVertexStride;
+        DXGI_FORMAT mIndexFormat;
+        UINT mIndexSize;
+        size_t mVerticesPerPage;
+        size_t mIndicesPerPage;
+        std::vector<std::unique_ptr<Page>> mPages;
+        ID3D11Buffer* mScratch;
+
+        // The mesh records are indexed by the mesh identifiers; the records
+        // of removed meshes are reused.
+        std::vector<Mesh> mMeshes;
+        std::vector<uint32_t> mFreeMeshes;
+        size_t mNumMeshes;
+
+        // Defragment resumes with this page.
+        size_t mDefragmentPage;
+        size_t mNumMoves;
+        size_t mBytesMoved;
+    };
+}
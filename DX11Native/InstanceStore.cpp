@@ -0,0 +1,75 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "InstanceStore.h"
+using namespace dxm;
+
+void InstanceStore::Clear()
+{
+    for (size_t i = 0; i < 3; ++i)
+    {
+        mLocalCenter[i].clear();
+        mLocalExtent[i].clear();
+        mCenter[i].clear();
+        mExtent[i].clear();
+    }
+
+    for (auto& element : mWorld)
+    {
+        element.clear();
+    }
+
+    mRadius.clear();
+}
+
+void InstanceStore::Reserve(size_t numInstances)
+{
+    for (size_t i = 0; i < 3; ++i)
+    {
+        mLocalCenter[i].reserve(numInstances);
+        mLocalExtent[i].reserve(numInstances);
+        mCenter[i].reserve(numInstances);
+        mExtent[i].reserve(numInstances);
+    }
+
+    for (auto& element : mWorld)
+    {
+        element.reserve(numInstances);
+    }
+
+    mRadius.reserve(numInstances);
+}
+
+uint32_t InstanceStore::Add(std::array<float, 3> const& localCenter,
+    std::array<float, 3> const& localExtent,
+    std::array<float, 12> const& world)
+{
+    uint32_t const instance = static_cast<uint32_t>(mRadius.size());
+    for (size_t i = 0; i < 3; ++i)
+    {
+        mLocalCenter[i].push_back(localCenter[i]);
+        mLocalExtent[i].push_back(localExtent[i]);
+        mCenter[i].push_back(0.0f);
+        mExtent[i].push_back(0.0f);
+    }
+
+    for (size_t i = 0; i < 12; ++i)
+    {
+        mWorld[i].push_back(world[i]);
+    }
+
+    mRadius.push_back(0.0f);
+    return instance;
+}
+
+void InstanceStore::SetWorld(uint32_t instance, std::array<float, 12> const& world)
+{
+    for (size_t i = 0; i < 12; ++i)
+    {
+        mWorld[i][instance] = world[i];
+    }
+}
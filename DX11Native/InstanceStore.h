@@ -0,0 +1,100 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// InstanceStore holds per-instance bounds and transforms as a structure of
+// arrays so that the culling kernels can load 4 or 8 instances per SIMD
+// register. Each instance has a model-space axis-aligned box (center and
+// extents) and an affine world transform stored as the upper 3 rows of a
+// row-major 4x4 matrix, applied as world = M * (x,y,z,1). The world-space
+// box and bounding sphere are derived by CullingKernels::TransformBounds.
+
+namespace dxm
+{
+    class InstanceStore
+    {
+    public:
+        InstanceStore() = default;
+        ~InstanceStore() = default;
+
+        void Clear();
+        void Reserve(size_t numInstances);
+
+        // Append an instance and return its index. The world matrix has
+        // 12 elements: the upper 3 rows of the 4x4 matrix.
+        uint32_t Add(std::array<float, 3> const& localCenter,
+            std::array<float, 3> const& localExtent,
+            std::array<float, 12> const& world);
+
+        void SetWorld(uint32_t instance, std::array<float, 12> const& world);
+
+        inline size_t GetNumInstances() const
+        {
+            return mRadius.size();
+        }
+
+        // Model-space bounds, i in {0,1,2}.
+        inline float const* GetLocalCenter(size_t i) const
+        {
+            return mLocalCenter[i].data();
+        }
+
+        inline float const* GetLocalExtent(size_t i) const
+        {
+            return mLocalExtent[i].data();
+        }
+
+        // World transform element (r,c) for r in {0,1,2}, c in {0,1,2,3}
+        // is GetWorld(4 * r + c).
+        inline float const* GetWorld(size_t i) const
+        {
+            return mWorld[i].data();
+        }
+
+        // World-space bounds, written by the transform kernels.
+        inline float* GetCenter(size_t i)
+        {
+            return mCenter[i].data();
+        }
+
+        inline float const* GetCenter(size_t i) const
+        {
+            return mCenter[i].data();
+        }
+
+        inline float* GetExtent(size_t i)
+        {
+            return mExtent[i].data();
+        }
+
+        inline float const* GetExtent(size_t i) const
+        {
+            return mExtent[i].data();
+        }
+
+        inline float* GetRadius()
+        {
+            return mRadius.data();
+        }
+
+        inline float const* GetRadius() const
+        {
+            return mRadius.data();
+        }
+
+    private:
+        std::array<std::vector<float>, 3> mLocalCenter, mLocalExtent;
+        std::array<std::vector<float>, 12> mWorld;
+        std::array<std::vector<float>, 3> mCenter, mExtent;
+        std::vector<float> mRadius;
+    };
+}
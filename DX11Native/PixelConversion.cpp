@@ -0,0 +1,128 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "PixelConversion.h"
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+using namespace dxm;
+
+size_t PixelConversion::GetBytesPerPixel(Format format)
+{
+    switch (format)
+    {
+    case Format::RGB8:
+        return 3;
+    case Format::GRAY16:
+        return 2;
+    case Format::RGBA16:
+        return 8;
+    default:
+        return 4;
+    }
+}
+
+PixelConversion::Path PixelConversion::GetBestPath()
+{
+    static Path const best = []()
+    {
+#if defined(_MSC_VER)
+        int info[4] = { 0, 0, 0, 0 };
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0 ? Path::SSSE3 : Path::SCALAR;
+#else
+        return __builtin_cpu_supports("ssse3") ? Path::SSSE3 : Path::SCALAR;
+#endif
+    }();
+    return best;
+}
+
+void PixelConversion::ConvertToBGRA8(Path path, Format format,
+    void const* source, size_t sourcePitch, void* target, size_t targetPitch,
+    uint32_t width, uint32_t height)
+{
+    uint8_t const* sourceRow = static_cast<uint8_t const*>(source);
+    uint8_t* targetRow = static_cast<uint8_t*>(target);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        if (format == Format::BGRA8)
+        {
+            std::memcpy(targetRow, sourceRow, static_cast<size_t>(width) * 4);
+        }
+        else
+        {
+            uint32_t begin = 0;
+            if (path == Path::SSSE3)
+            {
+                begin = ConvertRowSSSE3(format, sourceRow, targetRow, width);
+            }
+            ConvertRowScalar(format, sourceRow, targetRow, begin, width);
+        }
+
+        sourceRow += sourcePitch;
+        targetRow += targetPitch;
+    }
+}
+
+void PixelConversion::ConvertRowScalar(Format format, uint8_t const* source,
+    uint8_t* target, uint32_t begin, uint32_t end)
+{
+    uint8_t* t = target + 4 * static_cast<size_t>(begin);
+    switch (format)
+    {
+    case Format::RGBA8:
+        for (uint32_t x = begin; x < end; ++x, t += 4)
+        {
+            uint8_t const* s = source + 4 * static_cast<size_t>(x);
+            t[0] = s[2];
+            t[1] = s[1];
+            t[2] = s[0];
+            t[3] = s[3];
+        }
+        break;
+
+    case Format::RGB8:
+        for (uint32_t x = begin; x < end; ++x, t += 4)
+        {
+            uint8_t const* s = source + 3 * static_cast<size_t>(x);
+            t[0] = s[2];
+            t[1] = s[1];
+            t[2] = s[0];
+            t[3] = 0xFF;
+        }
+        break;
+
+    case Format::GRAY16:
+        for (uint32_t x = begin; x < end; ++x, t += 4)
+        {
+            // The high byte of the little-endian 16-bit value.
+            uint8_t const value = source[2 * static_cast<size_t>(x) + 1];
+            t[0] = value;
+            t[1] = value;
+            t[2] = value;
+            t[3] = 0xFF;
+        }
+        break;
+
+    case Format::RGBA16:
+        for (uint32_t x = begin; x < end; ++x, t += 4)
+        {
+            uint8_t const* s = source + 8 * static_cast<size_t>(x);
+            t[0] = s[5];
+            t[1] = s[3];
+            t[2] = s[1];
+            t[3] = s[7];
+        }
+        break;
+
+    default:
+        std::memcpy(t, source + 4 * static_cast<size_t>(begin),
+            4 * static_cast<size_t>(end - begin));
+        break;
+    }
+}
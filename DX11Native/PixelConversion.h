@@ -0,0 +1,66 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Conversion of CPU pixel rectangles to the B8G8R8A8 format of the shared
+// WPF surface. The conversion writes directly to the destination (for
+// example, a mapped dynamic texture), so converting and copying are a
+// single pass over the pixels. Each conversion has a scalar reference
+// implementation and an SSSE3 implementation that produces identical
+// results.
+//
+// The 16-bit formats are assumed to use the full 16-bit range; they are
+// converted to 8 bits by keeping the most significant byte. The formats
+// without alpha get alpha 255.
+
+namespace dxm
+{
+    class PixelConversion
+    {
+    public:
+        enum class Format
+        {
+            BGRA8,      // copied unchanged
+            RGBA8,      // red and blue swapped
+            RGB8,       // 3 bytes per pixel, expanded to 4
+            GRAY16,     // 1 channel, replicated to red, green and blue
+            RGBA16      // 8 bytes per pixel
+        };
+
+        enum class Path
+        {
+            SCALAR,
+            SSSE3
+        };
+
+        static size_t GetBytesPerPixel(Format format);
+
+        // The fastest path supported by the processor.
+        static Path GetBestPath();
+
+        // Convert a width-by-height rectangle. The pitches are the number
+        // of bytes between the starts of consecutive rows.
+        static void ConvertToBGRA8(Path path, Format format,
+            void const* source, size_t sourcePitch,
+            void* target, size_t targetPitch,
+            uint32_t width, uint32_t height);
+
+    private:
+        // Convert the pixels [begin,end) of a row.
+        static void ConvertRowScalar(Format format, uint8_t const* source,
+            uint8_t* target, uint32_t begin, uint32_t end);
+    };
+
+    // Implemented in PixelConversionSSSE3.cpp. The return value is the
+    // number of pixels converted; the remaining pixels of the row are
+    // converted by the scalar path.
+    uint32_t ConvertRowSSSE3(PixelConversion::Format format,
+        uint8_t const* source, uint8_t* target, uint32_t width);
+}
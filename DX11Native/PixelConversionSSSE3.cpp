@@ -0,0 +1,102 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+// The functions in this file are called only when
+// PixelConversion::GetBestPath() reports SSSE3.
+#if defined(__GNUC__) && !defined(__SSSE3__)
+#pragma GCC target("ssse3")
+#endif
+
+#include "PixelConversion.h"
+#include <tmmintrin.h>
+
+namespace dxm
+{
+    uint32_t ConvertRowSSSE3(PixelConversion::Format format,
+        uint8_t const* source, uint8_t* target, uint32_t width)
+    {
+        // The shuffle masks select source bytes for each target byte; an
+        // index with the high bit set produces 0, which is then ORed with
+        // the opaque alpha.
+        __m128i const alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+        uint32_t x = 0;
+
+        switch (format)
+        {
+        case PixelConversion::Format::RGBA8:
+        {
+            __m128i const mask = _mm_setr_epi8(
+                2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+            for (; x + 4 <= width; x += 4)
+            {
+                __m128i pixels = _mm_loadu_si128(
+                    reinterpret_cast<__m128i const*>(source + 4 * static_cast<size_t>(x)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(target + 4 * static_cast<size_t>(x)),
+                    _mm_shuffle_epi8(pixels, mask));
+            }
+            break;
+        }
+
+        case PixelConversion::Format::RGB8:
+        {
+            // Each 16-byte load covers 4 pixels (12 bytes) plus 4 bytes
+            // of the next pixels, so the loop stops while at least 16
+            // source bytes remain to avoid reading past the end of a row.
+            __m128i const mask = _mm_setr_epi8(
+                2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+            for (; x + 6 <= width; x += 4)
+            {
+                __m128i pixels = _mm_loadu_si128(
+                    reinterpret_cast<__m128i const*>(source + 3 * static_cast<size_t>(x)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(target + 4 * static_cast<size_t>(x)),
+                    _mm_or_si128(_mm_shuffle_epi8(pixels, mask), alpha));
+            }
+            break;
+        }
+
+        case PixelConversion::Format::GRAY16:
+        {
+            __m128i const maskLo = _mm_setr_epi8(
+                1, 1, 1, -1, 3, 3, 3, -1, 5, 5, 5, -1, 7, 7, 7, -1);
+            __m128i const maskHi = _mm_setr_epi8(
+                9, 9, 9, -1, 11, 11, 11, -1, 13, 13, 13, -1, 15, 15, 15, -1);
+            for (; x + 8 <= width; x += 8)
+            {
+                __m128i pixels = _mm_loadu_si128(
+                    reinterpret_cast<__m128i const*>(source + 2 * static_cast<size_t>(x)));
+                __m128i* t = reinterpret_cast<__m128i*>(target + 4 * static_cast<size_t>(x));
+                _mm_storeu_si128(t, _mm_or_si128(_mm_shuffle_epi8(pixels, maskLo), alpha));
+                _mm_storeu_si128(t + 1, _mm_or_si128(_mm_shuffle_epi8(pixels, maskHi), alpha));
+            }
+            break;
+        }
+
+        case PixelConversion::Format::RGBA16:
+        {
+            __m128i const mask0 = _mm_setr_epi8(
+                5, 3, 1, 7, 13, 11, 9, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+            __m128i const mask1 = _mm_setr_epi8(
+                -1, -1, -1, -1, -1, -1, -1, -1, 5, 3, 1, 7, 13, 11, 9, 15);
+            for (; x + 4 <= width; x += 4)
+            {
+                __m128i const* s = reinterpret_cast<__m128i const*>(
+                    source + 8 * static_cast<size_t>(x));
+                __m128i pixels0 = _mm_loadu_si128(s);
+                __m128i pixels1 = _mm_loadu_si128(s + 1);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(target + 4 * static_cast<size_t>(x)),
+                    _mm_or_si128(_mm_shuffle_epi8(pixels0, mask0), _mm_shuffle_epi8(pixels1, mask1)));
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        return x;
+    }
+}
@@ -0,0 +1,133 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "PixelUploader.h"
+#include "ComAccounting.h"
+#include <algorithm>
+#include <stdexcept>
+using namespace dxm;
+
+PixelUploader::PixelUploader(ID3D11Device* device, ID3D11DeviceContext* context)
+    :
+    mDevice(device),
+    mContext(context),
+    mSlots{},
+    mNumSlotsUsed(0),
+    mPending{},
+    mPath(PixelConversion::GetBestPath())
+{
+}
+
+PixelUploader::~PixelUploader()
+{
+    // A slot whose first texture could not be created has none.
+    for (auto& slot : mSlots)
+    {
+        if (slot.texture)
+        {
+            DXM_COM_CALL(RELEASE, "PixelUploader Release texture", slot.texture->Release());
+        }
+    }
+}
+
+void PixelUploader::Upload(PixelConversion::Format format, void const* pixels,
+    size_t rowPitch, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    if (pixels == nullptr || width == 0 || height == 0)
+    {
+        return;
+    }
+
+    if (mNumSlotsUsed == mSlots.size())
+    {
+        mSlots.push_back({ nullptr, 0, 0 });
+    }
+    size_t const index = mNumSlotsUsed++;
+    Slot& slot = mSlots[index];
+
+    // The textures only grow so that a ring sized for the largest upload
+    // is not recreated when smaller rectangles follow.
+    if (slot.width < width || slot.height < height)
+    {
+        D3D11_TEXTURE2D_DESC desc{};
+        desc.Width = std::max(slot.width, width);
+        desc.Height = std::max(slot.height, height);
+        desc.MipLevels = 1;
+        desc.ArraySize = 1;
+        desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+        desc.SampleDesc.Count = 1;
+        desc.SampleDesc.Quality = 0;
+        desc.Usage = D3D11_USAGE_DYNAMIC;
+        desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        desc.MiscFlags = 0;
+
+        ID3D11Texture2D* texture = nullptr;
+        HRESULT hr = DXM_COM_CALL(CREATE, "PixelUploader::Upload CreateTexture2D",
+            mDevice->CreateTexture2D(&desc, nullptr, &texture));
+        if (FAILED(hr))
+        {
+            --mNumSlotsUsed;
+            throw std::runtime_error("CreateTexture2D failed for upload texture.");
+        }
+
+        if (slot.texture)
+        {
+            DXM_COM_CALL(RELEASE, "PixelUploader::Upload Release texture",
+                slot.texture->Release());
+        }
+        slot.texture = texture;
+        slot.width = desc.Width;
+        slot.height = desc.Height;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE sub{};
+    HRESULT hr = mContext->Map(slot.texture, 0, D3D11_MAP_WRITE_DISCARD, 0, &sub);
+    if (FAILED(hr))
+    {
+        --mNumSlotsUsed;
+        throw std::runtime_error("Map failed for upload texture.");
+    }
+    PixelConversion::ConvertToBGRA8(mPath, format, pixels, rowPitch,
+        sub.pData, sub.RowPitch, width, height);
+    mContext->Unmap(slot.texture, 0);
+
+    mPending.push_back({ index, x, y, width, height });
+}
+
+void PixelUploader::Resolve(ID3D11Texture2D* target, uint32_t targetWidth,
+    uint32_t targetHeight)
+{
+    for (auto const& pending : mPending)
+    {
+        if (pending.x >= targetWidth || pending.y >= targetHeight)
+        {
+            continue;
+        }
+
+        D3D11_BOX box{};
+        box.left = 0;
+        box.top = 0;
+        box.front = 0;
+        box.right = std::min(pending.width, targetWidth - pending.x);
+        box.bottom = std::min(pending.height, targetHeight - pending.y);
+        box.back = 1;
+        mContext->CopySubresourceRegion(target, 0, pending.x, pending.y, 0,
+            mSlots[pending.slot].texture, 0, &box);
+    }
+    mPending.clear();
+}
+
+void PixelUploader::NextFrame()
+{
+    // Uploads that were never resolved keep their textures until they
+    // are; only the textures of resolved uploads are recycled.
+    if (mPending.empty())
+    {
+        mNumSlotsUsed = 0;
+    }
+}
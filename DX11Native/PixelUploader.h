@@ -0,0 +1,78 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include "PixelConversion.h"
+#include <d3d11.h>
+#include <vector>
+
+// PixelUploader streams CPU pixel rectangles (camera frames, rasters) into
+// the shared render target. Upload converts the pixels directly into a
+// dynamic B8G8R8A8 texture mapped with D3D11_MAP_WRITE_DISCARD, which is
+// the only CPU copy of the data, and records a GPU copy to the target.
+// Resolve issues the recorded copies with CopySubresourceRegion.
+//
+// The dynamic textures form a ring. Each upload of a frame uses its own
+// texture, so the ring grows to the largest number of uploads in a frame.
+// A texture is reused in the next frame, after the GPU has executed the
+// copy; the discard lets the driver rename the texture should the copy
+// still be pending.
+
+namespace dxm
+{
+    class PixelUploader
+    {
+    public:
+        // The device and context are not reference counted by this class.
+        PixelUploader(ID3D11Device* device, ID3D11DeviceContext* context);
+        ~PixelUploader();
+
+        // Disallow copying; the class owns COM interfaces.
+        PixelUploader(PixelUploader const&) = delete;
+        PixelUploader& operator=(PixelUploader const&) = delete;
+
+        // Convert the width-by-height rectangle of 'pixels' and record a
+        // copy to the target rectangle with upper-left corner (x,y). A
+        // std::runtime_error is thrown when a texture cannot be created or
+        // mapped.
+        void Upload(PixelConversion::Format format, void const* pixels,
+            size_t rowPitch, uint32_t x, uint32_t y, uint32_t width,
+            uint32_t height);
+
+        // Copy the pending uploads to the target, clipped to its size.
+        void Resolve(ID3D11Texture2D* target, uint32_t targetWidth,
+            uint32_t targetHeight);
+
+        // Make all textures of the ring available for the next frame.
+        void NextFrame();
+
+        inline bool HasPending() const
+        {
+            return !mPending.empty();
+        }
+
+    private:
+        struct Slot
+        {
+            ID3D11Texture2D* texture;
+            uint32_t width, height;
+        };
+
+        struct Pending
+        {
+            size_t slot;
+            uint32_t x, y, width, height;
+        };
+
+        ID3D11Device* mDevice;
+        ID3D11DeviceContext* mContext;
+        std::vector<Slot> mSlots;
+        size_t mNumSlotsUsed;
+        std::vector<Pending> mPending;
+        PixelConversion::Path mPath;
+    };
+}
@@ -0,0 +1,392 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "PostProcessChain.h"
+#include "ComAccounting.h"
+#include <d3dcompiler.h>
+#include <algorithm>
+#include <stdexcept>
+using namespace dxm;
+
+namespace
+{
+    // A triangle that covers the viewport, generated from SV_VertexID so
+    // that no vertex buffer or input layout is needed.
+    char const* const vertexShaderSource = R"(
+float4 VSMain(uint id : SV_VertexID) : SV_POSITION
+{
+    float2 uv = float2((id << 1) & 2, id & 2);
+    return float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+}
+)";
+
+    ID3DBlob* Compile(std::string const& source, char const* entry,
+        char const* target)
+    {
+        ID3DBlob* code = nullptr;
+        ID3DBlob* errors = nullptr;
+        HRESULT hr = DXM_COM_CALL(CREATE, "PostProcessChain Compile D3DCompile",
+            D3DCompile(source.c_str(), source.size(), nullptr, nullptr, nullptr,
+                entry, target, D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &code, &errors));
+        if (FAILED(hr))
+        {
+            std::string message = "Post-process shader compilation failed";
+            if (errors)
+            {
+                message += ": ";
+                message += static_cast<char const*>(errors->GetBufferPointer());
+                DXM_COM_CALL(RELEASE, "PostProcessChain Compile Release blob", errors->Release());
+            }
+            if (code)
+            {
+                DXM_COM_CALL(RELEASE, "PostProcessChain Compile Release blob", code->Release());
+            }
+            throw std::runtime_error(message);
+        }
+        if (errors)
+        {
+            DXM_COM_CALL(RELEASE, "PostProcessChain Compile Release blob", errors->Release());
+        }
+        return code;
+    }
+}
+
+PostProcessChain::Pass PostProcessChain::ToneMap()
+{
+    Pass pass{};
+    pass.name = "ToneMap";
+    pass.kind = Kind::POINTWISE;
+    pass.function = R"(
+float4 ToneMap(float4 color, float4 p0, float4 p1)
+{
+    float3 x = max(color.rgb * p0.x, 0.0f);
+    x = saturate((x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f));
+    return float4(x, color.a);
+}
+)";
+    pass.parameters = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    pass.enabled = false;
+    return pass;
+}
+
+PostProcessChain::Pass PostProcessChain::ColorGrade()
+{
+    Pass pass{};
+    pass.name = "ColorGrade";
+    pass.kind = Kind::POINTWISE;
+    pass.function = R"(
+float4 ColorGrade(float4 color, float4 p0, float4 p1)
+{
+    float3 c = pow(max(color.rgb * p0.rgb + p1.rgb, 0.0f), p1.a);
+    float luma = dot(c, float3(0.2126f, 0.7152f, 0.0722f));
+    return float4(lerp(luma.xxx, c, p0.a), color.a);
+}
+)";
+    pass.parameters = { 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+    pass.enabled = false;
+    return pass;
+}
+
+PostProcessChain::Pass PostProcessChain::Sharpen()
+{
+    Pass pass{};
+    pass.name = "Sharpen";
+    pass.kind = Kind::NEIGHBORHOOD;
+    pass.function = R"(
+float4 Sharpen(Texture2D<float4> source, int2 pixel, float4 p0, float4 p1)
+{
+    uint width, height;
+    source.GetDimensions(width, height);
+    int2 maxPixel = int2(width, height) - 1;
+    float4 center = source.Load(int3(pixel, 0));
+    float3 sum =
+        source.Load(int3(clamp(pixel + int2(-1, 0), 0, maxPixel), 0)).rgb +
+        source.Load(int3(clamp(pixel + int2(+1, 0), 0, maxPixel), 0)).rgb +
+        source.Load(int3(clamp(pixel + int2(0, -1), 0, maxPixel), 0)).rgb +
+        source.Load(int3(clamp(pixel + int2(0, +1), 0, maxPixel), 0)).rgb;
+    float3 c = center.rgb + p0.x * (4.0f * center.rgb - sum);
+    return float4(max(c, 0.0f), center.a);
+}
+)";
+    pass.parameters = { 0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    pass.enabled = false;
+    return pass;
+}
+
+std::vector<PostProcessChain::Segment> PostProcessChain::Plan(
+    std::vector<Pass> const& passes)
+{
+    std::vector<Segment> plan;
+    for (size_t i = 0; i < passes.size(); ++i)
+    {
+        if (!passes[i].enabled)
+        {
+            continue;
+        }
+
+        if (plan.empty() || passes[i].kind == Kind::NEIGHBORHOOD)
+        {
+            plan.push_back(Segment{});
+        }
+        plan.back().passes.push_back(i);
+    }
+    return plan;
+}
+
+PostProcessChain::PostProcessChain()
+    :
+    mPasses{},
+    mPlan{},
+    mPlanDirty(true),
+    mDevice(nullptr),
+    mVertexShader(nullptr),
+    mShaders{},
+    mConstants{},
+    mNumDraws(0)
+{
+}
+
+PostProcessChain::~PostProcessChain()
+{
+    ReleaseShaders();
+}
+
+void PostProcessChain::AddPass(Pass const& pass)
+{
+    for (auto const& existing : mPasses)
+    {
+        if (existing.name == pass.name)
+        {
+            throw std::runtime_error("Duplicate post-process pass " + pass.name + ".");
+        }
+    }
+    mPasses.push_back(pass);
+    mPlanDirty = true;
+}
+
+void PostProcessChain::SetPass(std::string const& name, bool enabled,
+    float const* parameters)
+{
+    for (auto& pass : mPasses)
+    {
+        if (pass.name == name)
+        {
+            if (pass.enabled != enabled)
+            {
+                pass.enabled = enabled;
+                mPlanDirty = true;
+            }
+            if (parameters)
+            {
+                std::copy(parameters, parameters + numParameters,
+                    pass.parameters.begin());
+            }
+            return;
+        }
+    }
+    throw std::runtime_error("Unknown post-process pass " + name + ".");
+}
+
+bool PostProcessChain::IsActive() const
+{
+    for (auto const& pass : mPasses)
+    {
+        if (pass.enabled)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PostProcessChain::CreateShaders(ID3D11Device* device)
+{
+    ReleaseShaders();
+    mDevice = device;
+
+    ID3DBlob* code = Compile(vertexShaderSource, "VSMain", "vs_4_0");
+    HRESULT hr = DXM_COM_CALL(CREATE, "PostProcessChain::CreateShaders CreateVertexShader",
+        mDevice->CreateVertexShader(code->GetBufferPointer(), code->GetBufferSize(),
+            nullptr, &mVertexShader));
+    DXM_COM_CALL(RELEASE, "PostProcessChain::CreateShaders Release blob", code->Release());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("CreateVertexShader failed for post-process.");
+    }
+
+    UpdatePlan();
+    for (auto const& segment : mPlan)
+    {
+        (void)GetShader(segment);
+    }
+}
+
+void PostProcessChain::ReleaseShaders()
+{
+    for (auto& element : mShaders)
+    {
+        DXM_COM_CALL(RELEASE, "PostProcessChain::ReleaseShaders Release pixel shader",
+            element.second->Release());
+    }
+    mShaders.clear();
+
+    if (mVertexShader)
+    {
+        DXM_COM_CALL(RELEASE, "PostProcessChain::ReleaseShaders Release vertex shader",
+            mVertexShader->Release());
+        mVertexShader = nullptr;
+    }
+    mDevice = nullptr;
+}
+
+void PostProcessChain::Execute(ID3D11DeviceContext* context,
+    ConstantBufferRing& constants, RenderTargetPool& pool,
+    RenderTargetPool::Target const* source, ID3D11RenderTargetView* output)
+{
+    // The targets are released to the pool also when a shader cannot be
+    // compiled or a target cannot be created.
+    ScopedTarget input(pool, source);
+    UpdatePlan();
+    mNumDraws = 0;
+    if (mPlan.empty())
+    {
+        return;
+    }
+
+    context->IASetInputLayout(nullptr);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->VSSetShader(mVertexShader, nullptr, 0);
+    context->RSSetState(nullptr);
+    context->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFFu);
+    context->OMSetDepthStencilState(nullptr, 0);
+
+    ID3D11ShaderResourceView* const nullSRV = nullptr;
+    for (size_t s = 0; s < mPlan.size(); ++s)
+    {
+        Segment const& segment = mPlan[s];
+        bool const last = (s + 1 == mPlan.size());
+
+        ScopedTarget target(pool);
+        ID3D11RenderTargetView* targetView = output;
+        if (!last)
+        {
+            target.Reset(pool.Acquire(input.Get()->width, input.Get()->height,
+                intermediateFormat));
+            targetView = target.Get()->rtv;
+        }
+
+        // The input must be unbound from the shader stage before it can
+        // be the render target of the next segment, and the output must
+        // be unbound as a render target before it is read.
+        context->PSSetShaderResources(0, 1, &nullSRV);
+        context->OMSetRenderTargets(1, &targetView, nullptr);
+        context->PSSetShaderResources(0, 1, &input.Get()->srv);
+
+        mConstants.resize(2 * segment.passes.size());
+        for (size_t i = 0; i < segment.passes.size(); ++i)
+        {
+            auto const& parameters = mPasses[segment.passes[i]].parameters;
+            std::copy(parameters.begin(), parameters.begin() + 4,
+                mConstants[2 * i].begin());
+            std::copy(parameters.begin() + 4, parameters.end(),
+                mConstants[2 * i + 1].begin());
+        }
+        auto allocation = constants.Upload(mConstants.data(),
+            static_cast<UINT>(mConstants.size() * sizeof(mConstants[0])));
+        constants.BindPS(0, allocation);
+
+        context->PSSetShader(GetShader(segment), nullptr, 0);
+        context->Draw(3, 0);
+        ++mNumDraws;
+
+        input.Reset(target.Detach());
+    }
+
+    context->PSSetShaderResources(0, 1, &nullSRV);
+    context->OMSetRenderTargets(0, nullptr, nullptr);
+}
+
+std::string PostProcessChain::GenerateSource(Segment const& segment) const
+{
+    std::string source =
+        "Texture2D<float4> source : register(t0);\n"
+        "cbuffer PostProcessParameters : register(b0)\n"
+        "{\n"
+        "    float4 parameters[" + std::to_string(2 * segment.passes.size()) + "];\n"
+        "};\n";
+
+    for (size_t index : segment.passes)
+    {
+        source += mPasses[index].function;
+    }
+
+    source +=
+        "float4 PSMain(float4 position : SV_POSITION) : SV_TARGET\n"
+        "{\n"
+        "    int2 pixel = int2(position.xy);\n";
+
+    for (size_t i = 0; i < segment.passes.size(); ++i)
+    {
+        Pass const& pass = mPasses[segment.passes[i]];
+        std::string const p0 = "parameters[" + std::to_string(2 * i) + "]";
+        std::string const p1 = "parameters[" + std::to_string(2 * i + 1) + "]";
+        if (i == 0)
+        {
+            if (pass.kind == Kind::NEIGHBORHOOD)
+            {
+                source += "    float4 color = " + pass.name +
+                    "(source, pixel, " + p0 + ", " + p1 + ");\n";
+                continue;
+            }
+            source += "    float4 color = source.Load(int3(pixel, 0));\n";
+        }
+        source += "    color = " + pass.name + "(color, " + p0 + ", " + p1 + ");\n";
+    }
+
+    source +=
+        "    return color;\n"
+        "}\n";
+    return source;
+}
+
+ID3D11PixelShader* PostProcessChain::GetShader(Segment const& segment)
+{
+    std::string key;
+    for (size_t index : segment.passes)
+    {
+        key += mPasses[index].name;
+        key += ';';
+    }
+
+    auto iter = mShaders.find(key);
+    if (iter != mShaders.end())
+    {
+        return iter->second;
+    }
+
+    ID3DBlob* code = Compile(GenerateSource(segment), "PSMain", "ps_4_0");
+    ID3D11PixelShader* shader = nullptr;
+    HRESULT hr = DXM_COM_CALL(CREATE, "PostProcessChain::GetShader CreatePixelShader",
+        mDevice->CreatePixelShader(code->GetBufferPointer(), code->GetBufferSize(),
+            nullptr, &shader));
+    DXM_COM_CALL(RELEASE, "PostProcessChain::GetShader Release blob", code->Release());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("CreatePixelShader failed for post-process.");
+    }
+    mShaders.insert(std::make_pair(key, shader));
+    return shader;
+}
+
+void PostProcessChain::UpdatePlan()
+{
+    if (mPlanDirty)
+    {
+        mPlan = Plan(mPasses);
+        mPlanDirty = false;
+    }
+}
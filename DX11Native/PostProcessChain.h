@@ -0,0 +1,149 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include "ConstantBufferRing.h"
+#include "RenderTargetPool.h"
+#include <d3d11.h>
+#include <array>
+#include <map>
+#include <string>
+#include <vector>
+
+// PostProcessChain applies full-screen passes (tone mapping, color grading,
+// sharpening, ...) to the scene before it reaches the shared surface. Each
+// pass is an HLSL function. A POINTWISE pass maps a color to a color,
+//   float4 <name>(float4 color, float4 p0, float4 p1)
+// and a NEIGHBORHOOD pass reads texels around the pixel,
+//   float4 <name>(Texture2D<float4> source, int2 pixel, float4 p0, float4 p1)
+// where p0 and p1 are the eight parameters of the pass.
+//
+// Adjacent passes are fused into one draw when possible. A segment is an
+// optional NEIGHBORHOOD pass followed by any number of POINTWISE passes;
+// a NEIGHBORHOOD pass after a POINTWISE pass must start a new segment,
+// because it reads the results of the previous passes at other pixels.
+// Each segment is one pixel shader, generated from the pass functions and
+// compiled on first use. The segments ping-pong between two targets from
+// the RenderTargetPool, and the last segment writes the output view.
+//
+// Plan() depends only on the pass descriptions, so the fusion can be
+// verified without a device. The shaders use shader model 4.0 and run on
+// every feature level Application accepts, including the WARP device.
+
+namespace dxm
+{
+    class PostProcessChain
+    {
+    public:
+        // The format of the scene and of the intermediate targets.
+        static DXGI_FORMAT constexpr intermediateFormat = DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+        static size_t constexpr numParameters = 8;
+
+        enum class Kind
+        {
+            POINTWISE,
+            NEIGHBORHOOD
+        };
+
+        struct Pass
+        {
+            // The name is the HLSL function name and must be unique in
+            // the chain.
+            std::string name;
+            Kind kind;
+            std::string function;
+            std::array<float, numParameters> parameters;
+            bool enabled;
+        };
+
+        // The indices of the passes that are fused into one draw.
+        struct Segment
+        {
+            std::vector<size_t> passes;
+        };
+
+        // Built-in passes. The passes are created disabled.
+        //   ToneMap: p0.x is the exposure; ACES filmic curve.
+        //   ColorGrade: p0.rgb is the gain, p0.a the saturation, p1.rgb
+        //     the lift and p1.a the gamma exponent.
+        //   Sharpen: p0.x is the amount of unsharp masking.
+        static Pass ToneMap();
+        static Pass ColorGrade();
+        static Pass Sharpen();
+
+        // Partition the enabled passes into segments.
+        static std::vector<Segment> Plan(std::vector<Pass> const& passes);
+
+        PostProcessChain();
+        ~PostProcessChain();
+
+        // Disallow copying; the class owns COM interfaces.
+        PostProcessChain(PostProcessChain const&) = delete;
+        PostProcessChain& operator=(PostProcessChain const&) = delete;
+
+        // A std::runtime_error is thrown when a pass of the same name is
+        // in the chain.
+        void AddPass(Pass const& pass);
+
+        // Enable or disable a pass and set its parameters. When
+        // 'parameters' is null, the parameters are unchanged. A
+        // std::runtime_error is thrown when no pass has the name.
+        void SetPass(std::string const& name, bool enabled,
+            float const* parameters);
+
+        inline std::vector<Pass> const& GetPasses() const
+        {
+            return mPasses;
+        }
+
+        // Returns 'true' when at least one pass is enabled.
+        bool IsActive() const;
+
+        // Compile the shaders for the device. The pixel shaders for the
+        // current plan are compiled now; other plans are compiled on first
+        // use. The device is not reference counted by this class. A
+        // std::runtime_error is thrown when compilation fails.
+        void CreateShaders(ID3D11Device* device);
+
+        void ReleaseShaders();
+
+        // Apply the enabled passes to 'source' and write the result to
+        // 'output'. The source must be a pool target of the output size;
+        // it is released to the pool when no longer needed, so it takes
+        // part in the ping-pong. The source and the intermediate targets
+        // are released also when an exception is thrown. The render target and shader resource
+        // bindings of slot 0 are cleared on return.
+        void Execute(ID3D11DeviceContext* context, ConstantBufferRing& constants,
+            RenderTargetPool& pool, RenderTargetPool::Target const* source,
+            ID3D11RenderTargetView* output);
+
+        // The number of draws issued by the last Execute call.
+        inline size_t GetNumDraws() const
+        {
+            return mNumDraws;
+        }
+
+    private:
+        std::string GenerateSource(Segment const& segment) const;
+        ID3D11PixelShader* GetShader(Segment const& segment);
+        void UpdatePlan();
+
+        std::vector<Pass> mPasses;
+        std::vector<Segment> mPlan;
+        bool mPlanDirty;
+
+        ID3D11Device* mDevice;
+        ID3D11VertexShader* mVertexShader;
+
+        // The pixel shaders keyed by the pass names of their segments.
+        std::map<std::string, ID3D11PixelShader*> mShaders;
+
+        std::vector<std::array<float, 4>> mConstants;
+        size_t mNumDraws;
+    };
+}
@@ -0,0 +1,90 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "RenderQueue.h"
+#include <array>
+using namespace dxm;
+
+uint64_t RenderQueue::MakeKey(uint32_t pass, uint32_t shader,
+    uint32_t material, float depth)
+{
+    uint32_t constexpr depthMax = (1u << 24) - 1u;
+    float const clamped = (depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth));
+    uint64_t const quantized = static_cast<uint64_t>(clamped * static_cast<float>(depthMax));
+
+    return (static_cast<uint64_t>(pass & 0xFFu) << 56)
+        | (static_cast<uint64_t>(shader & 0xFFFu) << 44)
+        | (static_cast<uint64_t>(material & 0xFFFFFu) << 24)
+        | (quantized & depthMax);
+}
+
+void RenderQueue::Clear()
+{
+    mItems.clear();
+    mKeys.clear();
+}
+
+void RenderQueue::Add(uint64_t key, DrawItem const& item)
+{
+    mKeys.push_back(std::make_pair(key, static_cast<uint32_t>(mItems.size())));
+    mItems.push_back(item);
+}
+
+void RenderQueue::Sort()
+{
+    size_t const numKeys = mKeys.size();
+    if (numKeys < 2)
+    {
+        return;
+    }
+
+    // Compute the histograms for all 8 digits in a single pass over the
+    // keys.
+    std::array<std::array<uint32_t, 256>, 8> histogram{};
+    for (auto const& keyIndex : mKeys)
+    {
+        uint64_t key = keyIndex.first;
+        for (size_t digit = 0; digit < 8; ++digit, key >>= 8)
+        {
+            ++histogram[digit][key & 0xFFu];
+        }
+    }
+
+    mScratch.resize(numKeys);
+    KeyIndex* source = mKeys.data();
+    KeyIndex* target = mScratch.data();
+    for (size_t digit = 0; digit < 8; ++digit)
+    {
+        // Skip the digit when all keys have the same value for it.
+        auto& counts = histogram[digit];
+        uint64_t const firstDigit = (source[0].first >> (8 * digit)) & 0xFFu;
+        if (counts[firstDigit] == numKeys)
+        {
+            continue;
+        }
+
+        std::array<uint32_t, 256> offsets{};
+        uint32_t sum = 0;
+        for (size_t i = 0; i < 256; ++i)
+        {
+            offsets[i] = sum;
+            sum += counts[i];
+        }
+
+        for (size_t i = 0; i < numKeys; ++i)
+        {
+            size_t const bucket = (source[i].first >> (8 * digit)) & 0xFFu;
+            target[offsets[bucket]++] = source[i];
+        }
+        std::swap(source, target);
+    }
+
+    if (source != mKeys.data())
+    {
+        mKeys.swap(mScratch);
+    }
+}
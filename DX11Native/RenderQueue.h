@@ -0,0 +1,290 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include "ConstantBufferRing.h"
+#include <d3d11.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// RenderQueue collects draw submissions for a frame, sorts them by a 64-bit
+// key and submits them to a device context. The key layout, from the most
+// significant bits to the least significant bits, is
+//   pass      8 bits  (for example, opaque before transparent)
+//   shader   12 bits  (vertex/pixel shader pair identifier)
+//   material 20 bits  (textures, samplers, constants)
+//   depth    24 bits  (quantized view depth in [0,1])
+// so that draws sharing a pass and shaders are adjacent after sorting. The
+// sort is an LSD radix sort on (key, index) pairs; digits that are the same
+// for all keys are skipped, which is common for the pass and shader bytes.
+//
+// During submission, state that is unchanged from the previous draw is not
+// set again. The draw states are compared by value, so identical state
+// objects must be shared (the usual case for D3D11 state objects, which the
+// runtime already deduplicates on creation).
+//
+// Submit is a template on the context and constant-buffer binder types.
+// Application uses ID3D11DeviceContext and ConstantBufferRing, but any types
+// with the same member functions can be used, for example a context that
+// records the calls in order to count the state changes.
+
+namespace dxm
+{
+    class RenderQueue
+    {
+    public:
+        struct DrawState
+        {
+            ID3D11InputLayout* inputLayout;
+            D3D11_PRIMITIVE_TOPOLOGY topology;
+            ID3D11Buffer* vertexBuffer;
+            UINT vertexStride;
+            UINT vertexOffset;
+            ID3D11Buffer* indexBuffer;
+            DXGI_FORMAT indexFormat;
+            UINT indexOffset;
+            ID3D11VertexShader* vertexShader;
+            ID3D11PixelShader* pixelShader;
+            ID3D11ShaderResourceView* psResource;
+            ID3D11SamplerState* psSampler;
+            ID3D11RasterizerState* rasterizerState;
+            ID3D11BlendState* blendState;
+            ID3D11DepthStencilState* depthStencilState;
+            UINT stencilReference;
+        };
+
+        // When the draw state has an index buffer, DrawIndexed(count, first,
+        // baseVertex) is called. Otherwise, Draw(count, first) is called.
+        // The constants are bound to slot 0 of the vertex and pixel shaders;
+        // an allocation with a null buffer is not bound.
+        struct DrawItem
+        {
+            DrawState const* state;
+            ConstantBufferRing::Allocation vsConstants;
+            ConstantBufferRing::Allocation psConstants;
+            UINT count;
+            UINT first;
+            INT baseVertex;
+        };
+
+        struct Statistics
+        {
+            size_t numDraws;
+            size_t numStateCalls;
+            size_t numSkippedStateCalls;
+        };
+
+        RenderQueue() = default;
+        ~RenderQueue() = default;
+
+        // The depth is clamped to [0,1]. For back-to-front ordering (for
+        // example, a transparent pass), use 1 - depth.
+        static uint64_t MakeKey(uint32_t pass, uint32_t shader,
+            uint32_t material, float depth);
+
+        // Remove all items. The storage is retained for the next frame.
+        void Clear();
+
+        void Add(uint64_t key, DrawItem const& item);
+
+        // Sort the items by key. The sort is stable.
+        void Sort();
+
+        inline size_t GetNumItems() const
+        {
+            return mItems.size();
+        }
+
+        inline Statistics const& GetStatistics() const
+        {
+            return mStatistics;
+        }
+
+        // Submit the items in sorted order (or in submission order when
+        // Sort() was not called). The first draw sets all of its state.
+        template <typename Context, typename ConstantBinder>
+        void Submit(Context* context, ConstantBinder& binder);
+
+    private:
+        using KeyIndex = std::pair<uint64_t, uint32_t>;
+
+        template <typename T>
+        bool Changed(T& current, T const& value)
+        {
+            if (mForceState || current != value)
+            {
+                current = value;
+                ++mStatistics.numStateCalls;
+                return true;
+            }
+            ++mStatistics.numSkippedStateCalls;
+            return false;
+        }
+
+        static bool Equal(ConstantBufferRing::Allocation const& a0,
+            ConstantBufferRing::Allocation const& a1)
+        {
+            return a0.buffer == a1.buffer
+                && a0.firstConstant == a1.firstConstant
+                && a0.numConstants == a1.numConstants;
+        }
+
+        std::vector<DrawItem> mItems;
+        std::vector<KeyIndex> mKeys, mScratch;
+        Statistics mStatistics{};
+
+        // The state most recently set by Submit.
+        bool mForceState = true;
+        DrawState mCurrent{};
+        ConstantBufferRing::Allocation mCurrentVS{}, mCurrentPS{};
+    };
+
+    template <typename Context, typename ConstantBinder>
+    void RenderQueue::Submit(Context* context, ConstantBinder& binder)
+    {
+        mStatistics = Statistics{};
+        mForceState = true;
+        mCurrentVS = ConstantBufferRing::Allocation{};
+        mCurrentPS = ConstantBufferRing::Allocation{};
+
+        for (auto const& keyIndex : mKeys)
+        {
+            DrawItem const& item = mItems[keyIndex.second];
+            DrawState const& state = *item.state;
+
+            if (Changed(mCurrent.inputLayout, state.inputLayout))
+            {
+                context->IASetInputLayout(state.inputLayout);
+            }
+
+            if (Changed(mCurrent.topology, state.topology))
+            {
+                context->IASetPrimitiveTopology(state.topology);
+            }
+
+            if (mForceState ||
+                mCurrent.vertexBuffer != state.vertexBuffer ||
+                mCurrent.vertexStride != state.vertexStride ||
+                mCurrent.vertexOffset != state.vertexOffset)
+            {
+                mCurrent.vertexBuffer = state.vertexBuffer;
+                mCurrent.vertexStride = state.vertexStride;
+                mCurrent.vertexOffset = state.vertexOffset;
+                context->IASetVertexBuffers(0, 1, &state.vertexBuffer,
+                    &state.vertexStride, &state.vertexOffset);
+                ++mStatistics.numStateCalls;
+            }
+            else
+            {
+                ++mStatistics.numSkippedStateCalls;
+            }
+
+            if (mForceState ||
+                mCurrent.indexBuffer != state.indexBuffer ||
+                mCurrent.indexFormat != state.indexFormat ||
+                mCurrent.indexOffset != state.indexOffset)
+            {
+                mCurrent.indexBuffer = state.indexBuffer;
+                mCurrent.indexFormat = state.indexFormat;
+                mCurrent.indexOffset = state.indexOffset;
+                context->IASetIndexBuffer(state.indexBuffer,
+                    state.indexFormat, state.indexOffset);
+                ++mStatistics.numStateCalls;
+            }
+            else
+            {
+                ++mStatistics.numSkippedStateCalls;
+            }
+
+            if (Changed(mCurrent.vertexShader, state.vertexShader))
+            {
+                context->VSSetShader(state.vertexShader, nullptr, 0);
+            }
+
+            if (item.vsConstants.buffer != nullptr)
+            {
+                if (mForceState || !Equal(mCurrentVS, item.vsConstants))
+                {
+                    mCurrentVS = item.vsConstants;
+                    binder.BindVS(0, item.vsConstants);
+                    ++mStatistics.numStateCalls;
+                }
+                else
+                {
+                    ++mStatistics.numSkippedStateCalls;
+                }
+            }
+
+            if (Changed(mCurrent.pixelShader, state.pixelShader))
+            {
+                context->PSSetShader(state.pixelShader, nullptr, 0);
+            }
+
+            if (item.psConstants.buffer != nullptr)
+            {
+                if (mForceState || !Equal(mCurrentPS, item.psConstants))
+                {
+                    mCurrentPS = item.psConstants;
+                    binder.BindPS(0, item.psConstants);
+                    ++mStatistics.numStateCalls;
+                }
+                else
+                {
+                    ++mStatistics.numSkippedStateCalls;
+                }
+            }
+
+            if (Changed(mCurrent.psResource, state.psResource))
+            {
+                context->PSSetShaderResources(0, 1, &state.psResource);
+            }
+
+            if (Changed(mCurrent.psSampler, state.psSampler))
+            {
+                context->PSSetSamplers(0, 1, &state.psSampler);
+            }
+
+            if (Changed(mCurrent.rasterizerState, state.rasterizerState))
+            {
+                context->RSSetState(state.rasterizerState);
+            }
+
+            if (Changed(mCurrent.blendState, state.blendState))
+            {
+                context->OMSetBlendState(state.blendState, nullptr, 0xFFFFFFFFu);
+            }
+
+            if (mForceState ||
+                mCurrent.depthStencilState != state.depthStencilState ||
+                mCurrent.stencilReference != state.stencilReference)
+            {
+                mCurrent.depthStencilState = state.depthStencilState;
+                mCurrent.stencilReference = state.stencilReference;
+                context->OMSetDepthStencilState(state.depthStencilState,
+                    state.stencilReference);
+                ++mStatistics.numStateCalls;
+            }
+            else
+            {
+                ++mStatistics.numSkippedStateCalls;
+            }
+
+            mForceState = false;
+
+            if (state.indexBuffer != nullptr)
+            {
+                context->DrawIndexed(item.count, item.first, item.baseVertex);
+            }
+            else
+            {
+                context->Draw(item.count, item.first);
+            }
+            ++mStatistics.numDraws;
+        }
+    }
+}
@@ -0,0 +1,198 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "RenderTargetPool.h"
+#include "ComAccounting.h"
+#include <algorithm>
+#include <stdexcept>
+using namespace dxm;
+
+RenderTargetPool::RenderTargetPool(ID3D11Device* device)
+    :
+    mDevice(device),
+    mEntries{},
+    mFree{},
+    mFrame(0),
+    mNumAcquired(0),
+    mStatistics{}
+{
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+    for (auto& entry : mEntries)
+    {
+        DestroyEntry(*entry);
+    }
+}
+
+RenderTargetPool::Target const* RenderTargetPool::Acquire(uint32_t width,
+    uint32_t height, DXGI_FORMAT format)
+{
+    uint64_t const key = MakeKey(width, height, format);
+    auto iter = mFree.find(key);
+    if (iter != mFree.end() && !iter->second.empty())
+    {
+        Entry* entry = iter->second.back();
+        iter->second.pop_back();
+        entry->acquired = true;
+        entry->lastUsedFrame = mFrame;
+        ++mNumAcquired;
+        ++mStatistics.numReused;
+        return &entry->target;
+    }
+
+    mEntries.push_back(CreateEntry(width, height, format));
+    Entry* entry = mEntries.back().get();
+    entry->key = key;
+    entry->acquired = true;
+    entry->lastUsedFrame = mFrame;
+    ++mNumAcquired;
+    ++mStatistics.numCreated;
+    return &entry->target;
+}
+
+void RenderTargetPool::Release(Target const* target)
+{
+    if (target == nullptr)
+    {
+        return;
+    }
+
+    // The pool holds a handful of targets, so a linear search is cheaper
+    // than maintaining a map from targets to entries.
+    for (auto& entry : mEntries)
+    {
+        if (&entry->target == target)
+        {
+            if (entry->acquired)
+            {
+                entry->acquired = false;
+                entry->lastUsedFrame = mFrame;
+                --mNumAcquired;
+                mFree[entry->key].push_back(entry.get());
+            }
+            return;
+        }
+    }
+}
+
+void RenderTargetPool::NextFrame()
+{
+    ++mFrame;
+
+    for (auto iter = mFree.begin(); iter != mFree.end(); )
+    {
+        auto& free = iter->second;
+        auto last = std::remove_if(free.begin(), free.end(),
+            [this](Entry* entry)
+            {
+                return mFrame - entry->lastUsedFrame > maxIdleFrames;
+            });
+
+        for (auto idle = last; idle != free.end(); ++idle)
+        {
+            DestroyEntry(**idle);
+            ++mStatistics.numDestroyed;
+        }
+        free.erase(last, free.end());
+
+        if (free.empty())
+        {
+            iter = mFree.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+
+    mEntries.erase(std::remove_if(mEntries.begin(), mEntries.end(),
+        [](std::unique_ptr<Entry> const& entry)
+        {
+            return entry->target.texture == nullptr;
+        }),
+        mEntries.end());
+}
+
+uint64_t RenderTargetPool::MakeKey(uint32_t width, uint32_t height,
+    DXGI_FORMAT format)
+{
+    // D3D11 textures are at most 16384 texels on a side, and the DXGI
+    // formats are less than 2^16.
+    return (static_cast<uint64_t>(width) << 40)
+        | (static_cast<uint64_t>(height) << 16)
+        | static_cast<uint64_t>(format);
+}
+
+std::unique_ptr<RenderTargetPool::Entry> RenderTargetPool::CreateEntry(
+    uint32_t width, uint32_t height, DXGI_FORMAT format)
+{
+    auto entry = std::make_unique<Entry>();
+    Target& target = entry->target;
+    target.texture = nullptr;
+    target.rtv = nullptr;
+    target.srv = nullptr;
+    target.width = width;
+    target.height = height;
+    target.format = format;
+
+    D3D11_TEXTURE2D_DESC desc{};
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = format;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = 0;
+    desc.MiscFlags = 0;
+
+    HRESULT hr = DXM_COM_CALL(CREATE, "RenderTargetPool::CreateEntry CreateTexture2D",
+        mDevice->CreateTexture2D(&desc, nullptr, &target.texture));
+    if (SUCCEEDED(hr))
+    {
+        hr = DXM_COM_CALL(CREATE, "RenderTargetPool::CreateEntry CreateRenderTargetView",
+            mDevice->CreateRenderTargetView(target.texture, nullptr, &target.rtv));
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = DXM_COM_CALL(CREATE, "RenderTargetPool::CreateEntry CreateShaderResourceView",
+            mDevice->CreateShaderResourceView(target.texture, nullptr, &target.srv));
+    }
+    if (FAILED(hr))
+    {
+        DestroyEntry(*entry);
+        throw std::runtime_error("Failed to create pooled render target.");
+    }
+    return entry;
+}
+
+void RenderTargetPool::DestroyEntry(Entry& entry)
+{
+    Target& target = entry.target;
+    if (target.srv)
+    {
+        DXM_COM_CALL(RELEASE, "RenderTargetPool::DestroyEntry Release view",
+            target.srv->Release());
+        target.srv = nullptr;
+    }
+    if (target.rtv)
+    {
+        DXM_COM_CALL(RELEASE, "RenderTargetPool::DestroyEntry Release view",
+            target.rtv->Release());
+        target.rtv = nullptr;
+    }
+    if (target.texture)
+    {
+        DXM_COM_CALL(RELEASE, "RenderTargetPool::DestroyEntry Release texture",
+            target.texture->Release());
+        target.texture = nullptr;
+    }
+}
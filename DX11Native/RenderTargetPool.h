@@ -0,0 +1,154 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+// RenderTargetPool supplies intermediate render targets (a texture with a
+// render target view and a shader resource view) keyed by width, height
+// and format. Acquire returns a pooled target when one of the requested
+// key is free and creates a target otherwise; Release returns the target
+// to the pool. A target that has not been acquired for maxIdleFrames
+// calls to NextFrame is destroyed, so the targets for the sizes of an
+// interactive window resize do not accumulate. A ScopedTarget releases
+// the target it holds when it goes out of scope, so that a target is not
+// lost from the pool when an exception is thrown while it is acquired.
+
+namespace dxm
+{
+    class RenderTargetPool
+    {
+    public:
+        static uint32_t constexpr maxIdleFrames = 8;
+
+        struct Target
+        {
+            ID3D11Texture2D* texture;
+            ID3D11RenderTargetView* rtv;
+            ID3D11ShaderResourceView* srv;
+            uint32_t width, height;
+            DXGI_FORMAT format;
+        };
+
+        struct Statistics
+        {
+            size_t numCreated;
+            size_t numReused;
+            size_t numDestroyed;
+        };
+
+        // The device is not reference counted by this class.
+        RenderTargetPool(ID3D11Device* device);
+        ~RenderTargetPool();
+
+        // Disallow copying; the class owns COM interfaces.
+        RenderTargetPool(RenderTargetPool const&) = delete;
+        RenderTargetPool& operator=(RenderTargetPool const&) = delete;
+
+        // The returned pointer is valid until the target is released. A
+        // std::runtime_error is thrown when the target cannot be created.
+        Target const* Acquire(uint32_t width, uint32_t height, DXGI_FORMAT format);
+
+        void Release(Target const* target);
+
+        // Advance the frame counter and destroy the free targets that have
+        // been idle for more than maxIdleFrames frames.
+        void NextFrame();
+
+        // The number of targets owned by the pool, acquired or free.
+        inline size_t GetNumTargets() const
+        {
+            return mEntries.size();
+        }
+
+        // The number of targets acquired and not yet released.
+        inline size_t GetNumAcquired() const
+        {
+            return mNumAcquired;
+        }
+
+        inline Statistics const& GetStatistics() const
+        {
+            return mStatistics;
+        }
+
+    private:
+        struct Entry
+        {
+            Target target;
+            uint64_t key;
+            uint64_t lastUsedFrame;
+            bool acquired;
+        };
+
+        static uint64_t MakeKey(uint32_t width, uint32_t height, DXGI_FORMAT format);
+
+        std::unique_ptr<Entry> CreateEntry(uint32_t width, uint32_t height,
+            DXGI_FORMAT format);
+
+        static void DestroyEntry(Entry& entry);
+
+        ID3D11Device* mDevice;
+        std::vector<std::unique_ptr<Entry>> mEntries;
+
+        // The free entries for each key. The entries are owned by mEntries.
+        std::map<uint64_t, std::vector<Entry*>> mFree;
+
+        uint64_t mFrame;
+        size_t mNumAcquired;
+        Statistics mStatistics;
+    };
+
+    // Holds an acquired target of a pool and releases it on destruction.
+    // Reset releases the held target and holds another; Detach gives up
+    // the target without releasing it, for example to a function that
+    // releases it.
+    class ScopedTarget
+    {
+    public:
+        ScopedTarget(RenderTargetPool& pool, RenderTargetPool::Target const* target = nullptr)
+            :
+            mPool(pool),
+            mTarget(target)
+        {
+        }
+
+        ~ScopedTarget()
+        {
+            mPool.Release(mTarget);
+        }
+
+        ScopedTarget(ScopedTarget const&) = delete;
+        ScopedTarget& operator=(ScopedTarget const&) = delete;
+
+        inline RenderTargetPool::Target const* Get() const
+        {
+            return mTarget;
+        }
+
+        inline void Reset(RenderTargetPool::Target const* target)
+        {
+            mPool.Release(mTarget);
+            mTarget = target;
+        }
+
+        inline RenderTargetPool::Target const* Detach()
+        {
+            RenderTargetPool::Target const* target = mTarget;
+            mTarget = nullptr;
+            return target;
+        }
+
+    private:
+        RenderTargetPool& mPool;
+        RenderTargetPool::Target const* mTarget;
+    };
+}
@@ -0,0 +1,114 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "RingAllocator.h"
+#include <stdexcept>
+using namespace dxm;
+
+RingAllocator::RingAllocator(size_t capacity, size_t alignment)
+    :
+    mCapacity(capacity),
+    mAlignment(alignment),
+    mHead(0),
+    mTail(0),
+    mUsed(0),
+    mFrameUsed(0),
+    mFrames{}
+{
+    if (mAlignment == 0 || (mAlignment & (mAlignment - 1)) != 0)
+    {
+        throw std::invalid_argument("RingAllocator alignment must be a power of two.");
+    }
+
+    if (mCapacity == 0 || (mCapacity & (mAlignment - 1)) != 0)
+    {
+        throw std::invalid_argument("RingAllocator capacity must be a multiple of the alignment.");
+    }
+}
+
+size_t RingAllocator::Allocate(size_t numBytes, bool& wrapped)
+{
+    wrapped = false;
+
+    size_t const size = (numBytes + mAlignment - 1) & ~(mAlignment - 1);
+    if (size == 0 || size > mCapacity)
+    {
+        return invalidOffset;
+    }
+
+    size_t offset = invalidOffset;
+    size_t consumed = size;
+    if (mUsed == 0)
+    {
+        // The ring is empty. Restart at the beginning so that the full
+        // capacity is available.
+        mHead = 0;
+        mTail = 0;
+        offset = 0;
+    }
+    else if (mHead > mTail)
+    {
+        // The free space is [head,capacity) and [0,tail).
+        if (mCapacity - mHead >= size)
+        {
+            offset = mHead;
+        }
+        else if (mTail >= size)
+        {
+            consumed += mCapacity - mHead;
+            offset = 0;
+        }
+    }
+    else if (mTail - mHead >= size)
+    {
+        // The free space is [head,tail). When head == tail and mUsed is
+        // positive, the ring is full and this test fails.
+        offset = mHead;
+    }
+
+    if (offset != invalidOffset)
+    {
+        wrapped = (offset == 0);
+        mHead = offset + size;
+        if (mHead == mCapacity)
+        {
+            mHead = 0;
+        }
+        mUsed += consumed;
+        mFrameUsed += consumed;
+    }
+    return offset;
+}
+
+void RingAllocator::EndFrame()
+{
+    mFrames.push_back({ mHead, mFrameUsed });
+    mFrameUsed = 0;
+}
+
+bool RingAllocator::RetireFrame()
+{
+    if (mFrames.empty())
+    {
+        return false;
+    }
+
+    Frame const& frame = mFrames.front();
+    mTail = frame.end;
+    mUsed -= frame.used;
+    mFrames.pop_front();
+    return true;
+}
+
+void RingAllocator::Reset()
+{
+    mHead = 0;
+    mTail = 0;
+    mUsed = 0;
+    mFrameUsed = 0;
+    mFrames.clear();
+}
@@ -0,0 +1,89 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <cstddef>
+#include <deque>
+
+// RingAllocator manages offsets into a fixed-size buffer that is written
+// front to back and wraps around. It has no knowledge of the memory it
+// manages, so it is independent of Direct3D. Allocations are grouped into
+// frames. EndFrame() marks the end of the allocations for the current
+// frame, and RetireFrame() releases the oldest frame once the GPU has
+// finished with it. An allocation never straddles the end of the buffer;
+// when it does not fit at the end, the tail bytes are skipped and the
+// allocation starts at offset 0.
+
+namespace dxm
+{
+    class RingAllocator
+    {
+    public:
+        static size_t constexpr invalidOffset = ~static_cast<size_t>(0);
+
+        // The alignment must be a power of two, and the capacity must be a
+        // positive multiple of the alignment.
+        RingAllocator(size_t capacity, size_t alignment);
+        ~RingAllocator() = default;
+
+        // Return the offset of a block of at least 'numBytes' bytes, the
+        // size rounded up to a multiple of the alignment. The return value
+        // is invalidOffset when there is not enough free space. The output
+        // 'wrapped' is set to 'true' when the block starts at offset 0,
+        // either because the ring was empty or because of wrap-around. The
+        // caller can use this to discard (rename) the buffer contents.
+        size_t Allocate(size_t numBytes, bool& wrapped);
+
+        // Close the current frame. The frame is retired by a later call
+        // to RetireFrame().
+        void EndFrame();
+
+        // Release the allocations of the oldest closed frame. The return
+        // value is 'false' when there are no closed frames.
+        bool RetireFrame();
+
+        // Release all allocations.
+        void Reset();
+
+        inline size_t GetCapacity() const
+        {
+            return mCapacity;
+        }
+
+        inline size_t GetAlignment() const
+        {
+            return mAlignment;
+        }
+
+        // The number of bytes in use, including alignment padding and any
+        // bytes skipped at the end of the buffer by wrap-around.
+        inline size_t GetUsed() const
+        {
+            return mUsed;
+        }
+
+        inline size_t GetNumFramesInFlight() const
+        {
+            return mFrames.size();
+        }
+
+    private:
+        struct Frame
+        {
+            size_t end;
+            size_t used;
+        };
+
+        size_t mCapacity;
+        size_t mAlignment;
+        size_t mHead;
+        size_t mTail;
+        size_t mUsed;
+        size_t mFrameUsed;
+        std::deque<Frame> mFrames;
+    };
+}
@@ -0,0 +1,369 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "SceneStore.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <stdexcept>
+using namespace dxm;
+
+SceneStore::SceneStore()
+    :
+    mParent{},
+    mNumChildren{},
+    mSlot{},
+    mFreeNodes{},
+    mNumNodes(0),
+    mNode{},
+    mParentSlot{},
+    mInstance{},
+    mLocal{},
+    mWorld{},
+    mDirty{},
+    mUpdated{},
+    mLevelStart{},
+    mOrderStale(false),
+    mFirstDirty(0),
+    mUpdatedEnd(0)
+{
+}
+
+void SceneStore::Clear()
+{
+    mParent.clear();
+    mNumChildren.clear();
+    mSlot.clear();
+    mFreeNodes.clear();
+    mNumNodes = 0;
+    mNode.clear();
+    mParentSlot.clear();
+    mInstance.clear();
+    mLocal.clear();
+    mWorld.clear();
+    mDirty.clear();
+    mUpdated.clear();
+    mLevelStart.clear();
+    mOrderStale = false;
+    mFirstDirty = 0;
+    mUpdatedEnd = 0;
+}
+
+void SceneStore::Reserve(size_t numNodes)
+{
+    mParent.reserve(numNodes);
+    mNumChildren.reserve(numNodes);
+    mSlot.reserve(numNodes);
+    mNode.reserve(numNodes);
+    mParentSlot.reserve(numNodes);
+    mInstance.reserve(numNodes);
+    mLocal.reserve(numNodes);
+    mWorld.reserve(numNodes);
+    mDirty.reserve(numNodes);
+    mUpdated.reserve(numNodes);
+}
+
+uint32_t SceneStore::AddNode(uint32_t parent, std::array<float, 12> const& local,
+    uint32_t instance)
+{
+    if (parent != invalidNode &&
+        (parent >= mParent.size() || mSlot[parent] == invalidNode))
+    {
+        throw std::invalid_argument("SceneStore::AddNode with an unknown parent.");
+    }
+
+    uint32_t node;
+    if (!mFreeNodes.empty())
+    {
+        node = mFreeNodes.back();
+        mFreeNodes.pop_back();
+    }
+    else
+    {
+        node = static_cast<uint32_t>(mParent.size());
+        mParent.push_back(invalidNode);
+        mNumChildren.push_back(0);
+        mSlot.push_back(invalidNode);
+    }
+
+    // The node is appended; the next Update moves it to its level.
+    uint32_t const slot = static_cast<uint32_t>(mNode.size());
+    mParent[node] = parent;
+    mNumChildren[node] = 0;
+    mSlot[node] = slot;
+    if (parent != invalidNode)
+    {
+        ++mNumChildren[parent];
+    }
+    ++mNumNodes;
+
+    mNode.push_back(node);
+    mParentSlot.push_back(parent != invalidNode ? mSlot[parent] : invalidNode);
+    mInstance.push_back(instance);
+    mLocal.push_back(local);
+    mWorld.push_back(std::array<float, 12>{});
+    mDirty.push_back(1);
+    mUpdated.push_back(0);
+    mFirstDirty = std::min<size_t>(mFirstDirty, slot);
+    mOrderStale = true;
+    return node;
+}
+
+void SceneStore::RemoveNode(uint32_t node)
+{
+    if (node >= mParent.size() || mSlot[node] == invalidNode)
+    {
+        throw std::invalid_argument("SceneStore::RemoveNode of an unknown node.");
+    }
+
+    if (mNumChildren[node] > 0)
+    {
+        throw std::invalid_argument("SceneStore::RemoveNode of a node with children.");
+    }
+
+    // The slot stays in the arrays, unreferenced, until the order is
+    // rebuilt.
+    if (mParent[node] != invalidNode)
+    {
+        --mNumChildren[mParent[node]];
+    }
+    mNode[mSlot[node]] = invalidNode;
+    mSlot[node] = invalidNode;
+    mParent[node] = invalidNode;
+    mFreeNodes.push_back(node);
+    --mNumNodes;
+    mOrderStale = true;
+}
+
+void SceneStore::SetParent(uint32_t node, uint32_t parent)
+{
+    if (node >= mParent.size() || mSlot[node] == invalidNode ||
+        (parent != invalidNode && (parent >= mParent.size() || mSlot[parent] == invalidNode)))
+    {
+        throw std::invalid_argument("SceneStore::SetParent of an unknown node.");
+    }
+
+    for (uint32_t ancestor = parent; ancestor != invalidNode; ancestor = mParent[ancestor])
+    {
+        if (ancestor == node)
+        {
+            throw std::invalid_argument("SceneStore::SetParent would create a cycle.");
+        }
+    }
+
+    if (mParent[node] != invalidNode)
+    {
+        --mNumChildren[mParent[node]];
+    }
+    if (parent != invalidNode)
+    {
+        ++mNumChildren[parent];
+    }
+    mParent[node] = parent;
+
+    size_t const slot = mSlot[node];
+    mDirty[slot] = 1;
+    mFirstDirty = std::min(mFirstDirty, slot);
+    mOrderStale = true;
+}
+
+void SceneStore::SetLocal(uint32_t node, std::array<float, 12> const& local)
+{
+    size_t const slot = mSlot[node];
+    mLocal[slot] = local;
+    mDirty[slot] = 1;
+    mFirstDirty = std::min(mFirstDirty, slot);
+}
+
+std::array<float, 12> SceneStore::GetLocal(uint32_t node) const
+{
+    return mLocal[mSlot[node]];
+}
+
+std::array<float, 12> SceneStore::GetWorld(uint32_t node) const
+{
+    return mWorld[mSlot[node]];
+}
+
+size_t SceneStore::Update(ThreadPool& pool, size_t grainSize)
+{
+    if (mOrderStale)
+    {
+        RebuildOrder();
+    }
+
+    size_t const numSlots = mNode.size();
+    std::fill(mUpdated.begin(), mUpdated.begin() + std::min(mFirstDirty, mUpdatedEnd), 0);
+    if (mFirstDirty >= numSlots)
+    {
+        mUpdatedEnd = 0;
+        return 0;
+    }
+
+    // The slots before the first dirty one are not recomputed, so the
+    // levels are processed starting with the one that contains it. Each
+    // level reads the world transforms and flags of the previous level.
+    size_t const first = mFirstDirty;
+    size_t level = static_cast<size_t>(std::upper_bound(mLevelStart.begin(),
+        mLevelStart.end(), first) - mLevelStart.begin()) - 1;
+    for (; level + 1 < mLevelStart.size(); ++level)
+    {
+        size_t const begin = std::max(mLevelStart[level], first);
+        size_t const end = mLevelStart[level + 1];
+        pool.ParallelFor(end - begin, grainSize,
+            [this, begin](size_t chunkBegin, size_t chunkEnd)
+            {
+                UpdateSlots(begin + chunkBegin, begin + chunkEnd);
+            });
+    }
+
+    mFirstDirty = numSlots;
+    mUpdatedEnd = numSlots;
+    return static_cast<size_t>(std::count(mUpdated.begin() + first, mUpdated.end(), 1));
+}
+
+void SceneStore::WriteInstances(InstanceStore& instances) const
+{
+    for (size_t slot = 0; slot < mUpdatedEnd; ++slot)
+    {
+        if (mUpdated[slot] && mInstance[slot] != invalidInstance)
+        {
+            instances.SetWorld(mInstance[slot], mWorld[slot]);
+        }
+    }
+}
+
+void SceneStore::RebuildOrder()
+{
+    size_t const numHandles = mParent.size();
+
+    // Group the live nodes by parent handle, with the roots last, in a
+    // compressed list: the children of handle h are the entries
+    // [childStart[h],childStart[h+1]) of 'children'.
+    std::vector<uint32_t> childStart(numHandles + 2, 0);
+    for (uint32_t node = 0; node < numHandles; ++node)
+    {
+        if (mSlot[node] != invalidNode)
+        {
+            uint32_t const parent = mParent[node];
+            ++childStart[(parent != invalidNode ? parent : numHandles) + 1];
+        }
+    }
+    for (size_t h = 0; h <= numHandles; ++h)
+    {
+        childStart[h + 1] += childStart[h];
+    }
+
+    std::vector<uint32_t> children(mNumNodes);
+    std::vector<uint32_t> next(childStart.begin(), childStart.end() - 1);
+    for (uint32_t node = 0; node < numHandles; ++node)
+    {
+        if (mSlot[node] != invalidNode)
+        {
+            uint32_t const parent = mParent[node];
+            children[next[parent != invalidNode ? parent : numHandles]++] = node;
+        }
+    }
+
+    // A breadth-first traversal from the roots lists the nodes by depth,
+    // with the children of a node adjacent.
+    std::vector<uint32_t> order;
+    order.reserve(mNumNodes);
+    order.insert(order.end(), children.begin() + childStart[numHandles],
+        children.begin() + childStart[numHandles + 1]);
+    mLevelStart.clear();
+    mLevelStart.push_back(0);
+    for (size_t levelBegin = 0; levelBegin < order.size(); )
+    {
+        size_t const levelEnd = order.size();
+        mLevelStart.push_back(levelEnd);
+        for (size_t i = levelBegin; i < levelEnd; ++i)
+        {
+            uint32_t const node = order[i];
+            order.insert(order.end(), children.begin() + childStart[node],
+                children.begin() + childStart[node + 1]);
+        }
+        levelBegin = levelEnd;
+    }
+
+    // Permute the per-slot arrays.
+    std::vector<uint32_t> oldSlot(mNumNodes);
+    for (size_t slot = 0; slot < mNumNodes; ++slot)
+    {
+        oldSlot[slot] = mSlot[order[slot]];
+        mSlot[order[slot]] = static_cast<uint32_t>(slot);
+    }
+
+    std::vector<uint32_t> parentSlot(mNumNodes), instance(mNumNodes);
+    std::vector<std::array<float, 12>> local(mNumNodes), world(mNumNodes);
+    std::vector<uint8_t> dirty(mNumNodes);
+    mFirstDirty = mNumNodes;
+    for (size_t slot = 0; slot < mNumNodes; ++slot)
+    {
+        uint32_t const parent = mParent[order[slot]];
+        parentSlot[slot] = (parent != invalidNode ? mSlot[parent] : invalidNode);
+        instance[slot] = mInstance[oldSlot[slot]];
+        local[slot] = mLocal[oldSlot[slot]];
+        world[slot] = mWorld[oldSlot[slot]];
+        dirty[slot] = mDirty[oldSlot[slot]];
+        if (dirty[slot] && mFirstDirty == mNumNodes)
+        {
+            mFirstDirty = slot;
+        }
+    }
+
+    mNode = std::move(order);
+    mParentSlot = std::move(parentSlot);
+    mInstance = std::move(instance);
+    mLocal = std::move(local);
+    mWorld = std::move(world);
+    mDirty = std::move(dirty);
+    mUpdated.assign(mNumNodes, 0);
+    mUpdatedEnd = 0;
+    mOrderStale = false;
+}
+
+void SceneStore::UpdateSlots(size_t begin, size_t end)
+{
+    for (size_t slot = begin; slot < end; ++slot)
+    {
+        // A node is recomputed when it is dirty or its parent was
+        // recomputed in this Update.
+        uint32_t const parent = mParentSlot[slot];
+        uint8_t const update = mDirty[slot] |
+            (parent != invalidNode ? mUpdated[parent] : static_cast<uint8_t>(0));
+        mUpdated[slot] = update;
+        if (!update)
+        {
+            continue;
+        }
+        mDirty[slot] = 0;
+
+        if (parent == invalidNode)
+        {
+            mWorld[slot] = mLocal[slot];
+            continue;
+        }
+
+        // world = parentWorld * local, where the fourth rows of both are
+        // (0,0,0,1). The operands are copied so that the compiler can keep
+        // them in registers; the stores to mWorld could otherwise alias
+        // them.
+        std::array<float, 12> const P = mWorld[parent];
+        std::array<float, 12> const L = mLocal[slot];
+        std::array<float, 12> W;
+        for (size_t r = 0; r < 3; ++r)
+        {
+            for (size_t c = 0; c < 4; ++c)
+            {
+                W[4 * r + c] = P[4 * r] * L[c] + P[4 * r + 1] * L[4 + c] +
+                    P[4 * r + 2] * L[8 + c];
+            }
+            W[4 * r + 3] += P[4 * r + 3];
+        }
+        mWorld[slot] = W;
+    }
+}
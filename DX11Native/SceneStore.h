@@ -0,0 +1,144 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include "InstanceStore.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// SceneStore is a transform hierarchy stored as a structure of arrays:
+// parents, local transforms, world transforms, dirty flags and instances
+// are each a contiguous array indexed by the same slot. The transforms are
+// affine and stored as the upper 3 rows of a row-major 4x4 matrix (the
+// InstanceStore convention), with world = parentWorld * local. Unlike
+// InstanceStore, which splits a matrix into 12 arrays for SIMD across
+// instances, a matrix here is one 48-byte element: the propagation reads
+// the matrix of an arbitrary parent, and 24 page-aligned element arrays
+// map to the same cache sets and make it several times slower.
+//
+// The nodes are identified by handles that do not change, but the arrays
+// are indexed by slots that are sorted by depth: the roots first, then the
+// children of the roots, and so on, with the children of a node adjacent
+// and the levels in the order of their parents. A parent therefore always
+// precedes its children, and the nodes of one level are in independent
+// subtrees, so Update processes the levels in order and the nodes of a
+// level in parallel. Adding, removing or reparenting nodes only marks the
+// order as stale; it is rebuilt by the next Update in O(n) time.
+//
+// SetLocal marks a node dirty. Update recomputes the world transforms of
+// the dirty nodes and their descendants and of no other nodes; it starts
+// at the first dirty slot, and the nodes before it are not visited. A
+// node bound to an instance of an InstanceStore has its world transform
+// copied to the instance by WriteInstances when it was recomputed.
+
+namespace dxm
+{
+    // ThreadPool.h includes <thread> and <mutex>, which cannot be included
+    // by the C++/CLI code that includes Application.h.
+    class ThreadPool;
+
+    class SceneStore
+    {
+    public:
+        static uint32_t constexpr invalidNode = 0xFFFFFFFFu;
+        static uint32_t constexpr invalidInstance = 0xFFFFFFFFu;
+
+        // The nodes of a level are split into chunks of 'grainSize' nodes
+        // for the thread pool. Smaller levels are processed by the calling
+        // thread.
+        static size_t constexpr defaultGrainSize = 4096;
+
+        SceneStore();
+        ~SceneStore() = default;
+
+        void Clear();
+        void Reserve(size_t numNodes);
+
+        // Add a node and return its handle. The parent is invalidNode for a
+        // root. The instance is invalidInstance for a node that is not drawn.
+        uint32_t AddNode(uint32_t parent, std::array<float, 12> const& local,
+            uint32_t instance = invalidInstance);
+
+        // Remove a node that has no children. A std::invalid_argument is
+        // thrown for an unknown node or a node with children.
+        void RemoveNode(uint32_t node);
+
+        // Move a node and its subtree under another parent, or make it a
+        // root when 'parent' is invalidNode. A std::invalid_argument is
+        // thrown when the parent is the node or one of its descendants.
+        void SetParent(uint32_t node, uint32_t parent);
+
+        void SetLocal(uint32_t node, std::array<float, 12> const& local);
+
+        std::array<float, 12> GetLocal(uint32_t node) const;
+
+        // The world transform computed by the last Update.
+        std::array<float, 12> GetWorld(uint32_t node) const;
+
+        inline uint32_t GetParent(uint32_t node) const
+        {
+            return mParent[node];
+        }
+
+        inline size_t GetNumNodes() const
+        {
+            return mNumNodes;
+        }
+
+        // The number of levels after the last Update; the depth of the
+        // deepest node is one less.
+        inline size_t GetNumLevels() const
+        {
+            return mLevelStart.empty() ? 0 : mLevelStart.size() - 1;
+        }
+
+        // Recompute the world transforms of the dirty nodes and their
+        // descendants. The return value is the number of nodes recomputed.
+        size_t Update(ThreadPool& pool, size_t grainSize = defaultGrainSize);
+
+        // Copy the world transforms that the last Update recomputed to the
+        // instances of their nodes.
+        void WriteInstances(InstanceStore& instances) const;
+
+    private:
+        // Sort the slots by depth. The transforms, flags and instances
+        // move with their nodes.
+        void RebuildOrder();
+
+        // Compute the world transforms of the slots [begin,end), all in one
+        // level or in levels that do not depend on each other.
+        void UpdateSlots(size_t begin, size_t end);
+
+        // Per-handle data. The slot of a removed handle is invalidNode, and
+        // its handle is reused by AddNode.
+        std::vector<uint32_t> mParent;
+        std::vector<uint32_t> mNumChildren;
+        std::vector<uint32_t> mSlot;
+        std::vector<uint32_t> mFreeNodes;
+        size_t mNumNodes;
+
+        // Per-slot data. mParentSlot is invalidNode for a root. mDirty is
+        // set by SetLocal and cleared by Update; mUpdated is set by Update
+        // for the recomputed slots.
+        std::vector<uint32_t> mNode;
+        std::vector<uint32_t> mParentSlot;
+        std::vector<uint32_t> mInstance;
+        std::vector<std::array<float, 12>> mLocal, mWorld;
+        std::vector<uint8_t> mDirty, mUpdated;
+
+        // Slots [mLevelStart[d],mLevelStart[d+1]) are the nodes of depth d.
+        std::vector<size_t> mLevelStart;
+        bool mOrderStale;
+
+        // The first dirty slot, or mNode.size() when no slot is dirty. The
+        // slots [mUpdatedEnd,mNode.size()) have mUpdated clear.
+        size_t mFirstDirty;
+        size_t mUpdatedEnd;
+    };
+}
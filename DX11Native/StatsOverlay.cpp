@@ -0,0 +1,588 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "StatsOverlay.h"
+#include "ComAccounting.h"
+#include <d3dcompiler.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+using namespace dxm;
+
+namespace
+{
+    // The 5x7 glyphs, one byte per row from top to bottom, with bit 4 the
+    // leftmost pixel.
+    char const glyphCharacters[] = " 0123456789.:-%/?ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+    uint8_t const glyphRows[][7] =
+    {
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // ' '
+        { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },  // '0'
+        { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },  // '1'
+        { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },  // '2'
+        { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },  // '3'
+        { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },  // '4'
+        { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },  // '5'
+        { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },  // '6'
+        { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },  // '7'
+        { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },  // '8'
+        { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },  // '9'
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },  // '.'
+        { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },  // ':'
+        { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },  // '-'
+        { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },  // '%'
+        { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },  // '/'
+        { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 },  // '?'
+        { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },  // 'A'
+        { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E },  // 'B'
+        { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },  // 'C'
+        { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },  // 'D'
+        { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F },  // 'E'
+        { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },  // 'F'
+        { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F },  // 'G'
+        { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },  // 'H'
+        { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },  // 'I'
+        { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },  // 'J'
+        { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },  // 'K'
+        { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F },  // 'L'
+        { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 },  // 'M'
+        { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },  // 'N'
+        { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },  // 'O'
+        { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },  // 'P'
+        { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },  // 'Q'
+        { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },  // 'R'
+        { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },  // 'S'
+        { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },  // 'T'
+        { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },  // 'U'
+        { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },  // 'V'
+        { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A },  // 'W'
+        { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 },  // 'X'
+        { 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04 },  // 'Y'
+        { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F }   // 'Z'
+    };
+
+    size_t constexpr numGlyphs = sizeof(glyphCharacters) - 1;
+
+    // The atlas is a grid of 8x8 cells. The cell after the glyphs is solid
+    // and is used for the panel and the graph.
+    uint32_t constexpr cellSize = 8;
+    uint32_t constexpr atlasColumns = 16;
+    uint32_t constexpr atlasRows = (numGlyphs + 1 + atlasColumns - 1) / atlasColumns;
+    size_t constexpr solidCell = numGlyphs;
+
+    // The screen layout in pixels.
+    float constexpr margin = 8.0f;
+    float constexpr padding = 2.0f * StatsOverlay::scale;
+    float constexpr cellWidth = 6.0f * StatsOverlay::scale;
+    float constexpr cellHeight = 9.0f * StatsOverlay::scale;
+    float constexpr barWidth = 2.0f;
+
+    // RGBA8 colors; the red channel is the low byte.
+    inline uint32_t MakeColor(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+    {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    char const* const shaderSource = R"(
+cbuffer OverlayParameters : register(b0)
+{
+    float4 pixelToClip;
+};
+
+Texture2D<float> atlas : register(t0);
+
+struct VSInput
+{
+    float4 rect : RECT;
+    float4 atlasRect : ATLAS;
+    float4 color : COLOR;
+    uint id : SV_VertexID;
+};
+
+struct VSOutput
+{
+    float4 position : SV_POSITION;
+    float2 texel : TEXCOORD0;
+    float4 color : COLOR;
+};
+
+VSOutput VSMain(VSInput input)
+{
+    float2 corner = float2(input.id & 1, input.id >> 1);
+    float2 pixel = input.rect.xy + corner * input.rect.zw;
+    VSOutput output;
+    output.position = float4(pixel * pixelToClip.xy + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+    output.texel = lerp(input.atlasRect.xy, input.atlasRect.zw, corner);
+    output.color = input.color;
+    return output;
+}
+
+float4 PSMain(VSOutput input) : SV_TARGET
+{
+    float coverage = atlas.Load(int3(input.texel, 0));
+    return float4(input.color.rgb, input.color.a * coverage);
+}
+)";
+
+    ID3DBlob* Compile(char const* entry, char const* target)
+    {
+        ID3DBlob* code = nullptr;
+        ID3DBlob* errors = nullptr;
+        HRESULT hr = DXM_COM_CALL(CREATE, "StatsOverlay Compile D3DCompile",
+            D3DCompile(shaderSource, std::char_traits<char>::length(shaderSource),
+                nullptr, nullptr, nullptr, entry, target, D3DCOMPILE_OPTIMIZATION_LEVEL3,
+                0, &code, &errors));
+        if (FAILED(hr))
+        {
+            std::string message = "Overlay shader compilation failed";
+            if (errors)
+            {
+                message += ": ";
+                message += static_cast<char const*>(errors->GetBufferPointer());
+                DXM_COM_CALL(RELEASE, "StatsOverlay Compile Release blob", errors->Release());
+            }
+            if (code)
+            {
+                DXM_COM_CALL(RELEASE, "StatsOverlay Compile Release blob", code->Release());
+            }
+            throw std::runtime_error(message);
+        }
+        if (errors)
+        {
+            DXM_COM_CALL(RELEASE, "StatsOverlay Compile Release blob", errors->Release());
+        }
+        return code;
+    }
+}
+
+StatsOverlay::StatsOverlay()
+    :
+    mFields{},
+    mInstances(firstFieldInstance),
+    mNumColumns(0),
+    mNumRows(0),
+    mSamples{},
+    mNextSample(0),
+    mDirty{},
+    mDevice(nullptr),
+    mAtlas(nullptr),
+    mAtlasView(nullptr),
+    mInstanceBuffer(nullptr),
+    mInstanceCapacity(0),
+    mVertexShader(nullptr),
+    mPixelShader(nullptr),
+    mInputLayout(nullptr),
+    mBlendState(nullptr),
+    mStatistics{}
+{
+    static_assert(sizeof(Instance) == 36, "The instance layout must match the input layout.");
+    UpdateLayout();
+}
+
+StatsOverlay::~StatsOverlay()
+{
+    ReleaseResources();
+}
+
+size_t StatsOverlay::AddField(uint32_t column, uint32_t row, uint32_t numCharacters,
+    uint32_t color)
+{
+    Field field{};
+    field.column = column;
+    field.row = row;
+    field.color = color;
+    field.firstInstance = mInstances.size();
+    field.glyphs.resize(numCharacters, static_cast<uint8_t>(GetGlyph(' ')));
+    mFields.push_back(field);
+    mInstances.resize(mInstances.size() + numCharacters);
+
+    mNumColumns = std::max(mNumColumns, column + numCharacters);
+    mNumRows = std::max(mNumRows, row + 1);
+    UpdateLayout();
+    return mFields.size() - 1;
+}
+
+void StatsOverlay::SetField(size_t index, char const* text)
+{
+    Field& field = mFields[index];
+    float const x0 = margin + padding + cellWidth * field.column;
+    float const y0 = margin + padding + cellHeight * field.row;
+
+    bool ended = false;
+    for (size_t i = 0; i < field.glyphs.size(); ++i)
+    {
+        ended = ended || text[i] == 0;
+        uint8_t const glyph = static_cast<uint8_t>(GetGlyph(ended ? ' ' : text[i]));
+        if (glyph != field.glyphs[i])
+        {
+            field.glyphs[i] = glyph;
+            SetInstance(field.firstInstance + i, MakeGlyph(
+                static_cast<uint32_t>(x0 + cellWidth * i), static_cast<uint32_t>(y0),
+                glyph, field.color));
+        }
+    }
+}
+
+void StatsOverlay::AddGraphSample(float milliseconds)
+{
+    mSamples[mNextSample] = milliseconds;
+    SetBar(mNextSample);
+    mNextSample = (mNextSample + 1) % graphSamples;
+}
+
+void StatsOverlay::CreateResources(ID3D11Device* device)
+{
+    ReleaseResources();
+    mDevice = device;
+
+    // Bake the glyphs into the atlas.
+    uint32_t const width = atlasColumns * cellSize;
+    uint32_t const height = atlasRows * cellSize;
+    std::vector<uint8_t> texels(static_cast<size_t>(width) * height, 0);
+    for (size_t glyph = 0; glyph <= numGlyphs; ++glyph)
+    {
+        size_t const x0 = (glyph % atlasColumns) * cellSize;
+        size_t const y0 = (glyph / atlasColumns) * cellSize;
+        for (size_t y = 0; y < cellSize; ++y)
+        {
+            for (size_t x = 0; x < cellSize; ++x)
+            {
+                bool set;
+                if (glyph == solidCell)
+                {
+                    set = true;
+                }
+                else
+                {
+                    set = (y < 7 && x < 5 && (glyphRows[glyph][y] & (0x10 >> x)) != 0);
+                }
+                texels[(y0 + y) * width + x0 + x] = (set ? 255 : 0);
+            }
+        }
+    }
+
+    D3D11_TEXTURE2D_DESC desc{};
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = 0;
+    desc.MiscFlags = 0;
+
+    D3D11_SUBRESOURCE_DATA data{};
+    data.pSysMem = texels.data();
+    data.SysMemPitch = width;
+    HRESULT hr = DXM_COM_CALL(CREATE, "StatsOverlay::CreateResources CreateTexture2D",
+        mDevice->CreateTexture2D(&desc, &data, &mAtlas));
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("CreateTexture2D failed for overlay atlas.");
+    }
+
+    hr = DXM_COM_CALL(CREATE, "StatsOverlay::CreateResources CreateShaderResourceView",
+        mDevice->CreateShaderResourceView(mAtlas, nullptr, &mAtlasView));
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("CreateShaderResourceView failed for overlay atlas.");
+    }
+
+    ID3DBlob* code = Compile("VSMain", "vs_4_0");
+    hr = DXM_COM_CALL(CREATE, "StatsOverlay::CreateResources CreateVertexShader",
+        mDevice->CreateVertexShader(code->GetBufferPointer(), code->GetBufferSize(),
+            nullptr, &mVertexShader));
+    if (SUCCEEDED(hr))
+    {
+        D3D11_INPUT_ELEMENT_DESC const elements[] =
+        {
+            { "RECT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "ATLAS", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 }
+        };
+        hr = DXM_COM_CALL(CREATE, "StatsOverlay::CreateResources CreateInputLayout",
+            mDevice->CreateInputLayout(elements, 3, code->GetBufferPointer(),
+                code->GetBufferSize(), &mInputLayout));
+    }
+    DXM_COM_CALL(RELEASE, "StatsOverlay::CreateResources Release blob", code->Release());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("CreateVertexShader failed for overlay.");
+    }
+
+    code = Compile("PSMain", "ps_4_0");
+    hr = DXM_COM_CALL(CREATE, "StatsOverlay::CreateResources CreatePixelShader",
+        mDevice->CreatePixelShader(code->GetBufferPointer(), code->GetBufferSize(),
+            nullptr, &mPixelShader));
+    DXM_COM_CALL(RELEASE, "StatsOverlay::CreateResources Release blob", code->Release());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("CreatePixelShader failed for overlay.");
+    }
+
+    // Blend the color and keep the destination alpha, which WPF uses to
+    // compose the image.
+    D3D11_BLEND_DESC blendDesc{};
+    blendDesc.RenderTarget[0].BlendEnable = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ZERO;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    hr = DXM_COM_CALL(CREATE, "StatsOverlay::CreateResources CreateBlendState",
+        mDevice->CreateBlendState(&blendDesc, &mBlendState));
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("CreateBlendState failed for overlay.");
+    }
+
+    // The instance buffer is created by the first Draw.
+    mDirty[0] = DirtyRange{ 0, firstFieldInstance };
+    mDirty[1] = DirtyRange{ firstFieldInstance, mInstances.size() };
+}
+
+void StatsOverlay::ReleaseResources()
+{
+    ID3D11DeviceChild* children[] =
+    {
+        mAtlasView, mAtlas, mInstanceBuffer, mInputLayout, mVertexShader,
+        mPixelShader, mBlendState
+    };
+    for (auto child : children)
+    {
+        if (child)
+        {
+            DXM_COM_CALL(RELEASE, "StatsOverlay::ReleaseResources Release", child->Release());
+        }
+    }
+
+    mAtlasView = nullptr;
+    mAtlas = nullptr;
+    mInstanceBuffer = nullptr;
+    mInstanceCapacity = 0;
+    mInputLayout = nullptr;
+    mVertexShader = nullptr;
+    mPixelShader = nullptr;
+    mBlendState = nullptr;
+    mDevice = nullptr;
+}
+
+void StatsOverlay::Draw(ID3D11DeviceContext* context, ConstantBufferRing& constants,
+    uint32_t width, uint32_t height)
+{
+    if (mDevice == nullptr || width == 0 || height == 0)
+    {
+        return;
+    }
+
+    if (mInstanceCapacity < mInstances.size())
+    {
+        if (mInstanceBuffer)
+        {
+            DXM_COM_CALL(RELEASE, "StatsOverlay::Draw Release instance buffer",
+                mInstanceBuffer->Release());
+            mInstanceBuffer = nullptr;
+        }
+
+        D3D11_BUFFER_DESC desc{};
+        desc.ByteWidth = static_cast<UINT>(mInstances.size() * sizeof(Instance));
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        desc.CPUAccessFlags = 0;
+        desc.MiscFlags = 0;
+        desc.StructureByteStride = 0;
+        HRESULT hr = DXM_COM_CALL(CREATE, "StatsOverlay::Draw CreateBuffer",
+            mDevice->CreateBuffer(&desc, nullptr, &mInstanceBuffer));
+        if (FAILED(hr))
+        {
+            throw std::runtime_error("CreateBuffer failed for overlay instances.");
+        }
+        mInstanceCapacity = mInstances.size();
+        mDirty[0] = DirtyRange{ 0, firstFieldInstance };
+        mDirty[1] = DirtyRange{ firstFieldInstance, mInstances.size() };
+    }
+
+    UploadInstances(context, 0);
+    UploadInstances(context, 1);
+
+    std::array<float, 4> const pixelToClip =
+    {
+        2.0f / static_cast<float>(width), -2.0f / static_cast<float>(height), 0.0f, 0.0f
+    };
+    auto allocation = constants.Upload(pixelToClip.data(), sizeof(pixelToClip));
+    constants.BindVS(0, allocation);
+
+    UINT const stride = sizeof(Instance);
+    UINT const offset = 0;
+    ID3D11ShaderResourceView* const nullSRV = nullptr;
+    context->IASetInputLayout(mInputLayout);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+    context->IASetVertexBuffers(0, 1, &mInstanceBuffer, &stride, &offset);
+    context->VSSetShader(mVertexShader, nullptr, 0);
+    context->PSSetShader(mPixelShader, nullptr, 0);
+    context->PSSetShaderResources(0, 1, &mAtlasView);
+    context->RSSetState(nullptr);
+    context->OMSetBlendState(mBlendState, nullptr, 0xFFFFFFFFu);
+    context->OMSetDepthStencilState(nullptr, 0);
+    context->DrawInstanced(4, static_cast<UINT>(mInstances.size()), 0, 0);
+    context->PSSetShaderResources(0, 1, &nullSRV);
+    context->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFFu);
+}
+
+size_t StatsOverlay::GetGlyph(char c)
+{
+    static std::array<uint8_t, 256> const table = []()
+    {
+        std::array<uint8_t, 256> result{};
+        size_t const unknown = std::char_traits<char>::find(glyphCharacters,
+            numGlyphs, '?') - glyphCharacters;
+        result.fill(static_cast<uint8_t>(unknown));
+        for (size_t glyph = 0; glyph < numGlyphs; ++glyph)
+        {
+            unsigned char const u = static_cast<unsigned char>(glyphCharacters[glyph]);
+            result[u] = static_cast<uint8_t>(glyph);
+            if (u >= 'A' && u <= 'Z')
+            {
+                result[u - 'A' + 'a'] = static_cast<uint8_t>(glyph);
+            }
+        }
+        return result;
+    }();
+    return table[static_cast<unsigned char>(c)];
+}
+
+StatsOverlay::Instance StatsOverlay::MakeGlyph(uint32_t x, uint32_t y, size_t glyph,
+    uint32_t color) const
+{
+    // A space is an empty rectangle, which produces no pixels.
+    float const size = (glyph == GetGlyph(' ') ? 0.0f : 1.0f);
+    float const u = static_cast<float>((glyph % atlasColumns) * cellSize);
+    float const v = static_cast<float>((glyph / atlasColumns) * cellSize);
+
+    Instance instance{};
+    instance.rect = { static_cast<float>(x), static_cast<float>(y),
+        size * 5.0f * scale, size * 7.0f * scale };
+    instance.atlas = { u, v, u + 5.0f, v + 7.0f };
+    instance.color = color;
+    return instance;
+}
+
+StatsOverlay::Instance StatsOverlay::MakeSolid(float x, float y, float width,
+    float height, uint32_t color) const
+{
+    float const u = static_cast<float>((solidCell % atlasColumns) * cellSize);
+    float const v = static_cast<float>((solidCell / atlasColumns) * cellSize);
+
+    Instance instance{};
+    instance.rect = { x, y, width, height };
+    instance.atlas = { u, v, u + cellSize, v + cellSize };
+    instance.color = color;
+    return instance;
+}
+
+std::array<uint32_t, 4> StatsOverlay::GetRect() const
+{
+    float const graphWidth = barWidth * graphSamples;
+    float const contentWidth = std::max(cellWidth * mNumColumns, graphWidth);
+    float const graphY = margin + 2.0f * padding + cellHeight * mNumRows;
+    return std::array<uint32_t, 4>
+    {
+        static_cast<uint32_t>(margin),
+        static_cast<uint32_t>(margin),
+        static_cast<uint32_t>(std::ceil(contentWidth + 2.0f * padding)),
+        static_cast<uint32_t>(std::ceil(graphY + graphHeight + padding - margin))
+    };
+}
+
+void StatsOverlay::UpdateLayout()
+{
+    float const graphWidth = barWidth * graphSamples;
+    float const contentWidth = std::max(cellWidth * mNumColumns, graphWidth);
+    float const graphY = margin + 2.0f * padding + cellHeight * mNumRows;
+
+    SetInstance(panelInstance, MakeSolid(margin, margin, contentWidth + 2.0f * padding,
+        graphY + graphHeight + padding - margin, MakeColor(0, 0, 0, 176)));
+
+    float const lineY = graphY + graphHeight * (1.0f - (1000.0f / 60.0f) / graphMilliseconds);
+    SetInstance(lineInstance, MakeSolid(margin + padding, lineY, graphWidth, 1.0f,
+        MakeColor(255, 255, 255, 96)));
+
+    // The graph and the fields move when a field adds a row.
+    for (size_t i = 0; i < graphSamples; ++i)
+    {
+        SetBar(i);
+    }
+
+    for (auto& field : mFields)
+    {
+        std::string text(field.glyphs.size(), ' ');
+        for (size_t i = 0; i < field.glyphs.size(); ++i)
+        {
+            text[i] = glyphCharacters[field.glyphs[i]];
+            field.glyphs[i] = static_cast<uint8_t>(numGlyphs);
+        }
+        SetField(static_cast<size_t>(&field - mFields.data()), text.c_str());
+    }
+}
+
+void StatsOverlay::SetBar(size_t sample)
+{
+    float const milliseconds = mSamples[sample];
+    float const graphY = margin + 2.0f * padding + cellHeight * mNumRows;
+    float const height = graphHeight * std::min(std::max(milliseconds, 0.0f) /
+        graphMilliseconds, 1.0f);
+    uint32_t const color =
+        milliseconds <= 1000.0f / 60.0f ? MakeColor(64, 224, 64, 255) :
+        milliseconds <= 1000.0f / 30.0f ? MakeColor(224, 224, 64, 255) :
+        MakeColor(224, 64, 64, 255);
+    SetInstance(firstBarInstance + sample, MakeSolid(
+        margin + padding + barWidth * sample, graphY + graphHeight - height,
+        barWidth, height, color));
+}
+
+void StatsOverlay::SetInstance(size_t index, Instance const& instance)
+{
+    mInstances[index] = instance;
+    DirtyRange& dirty = mDirty[index < firstFieldInstance ? 0 : 1];
+    if (dirty.begin == dirty.end)
+    {
+        dirty.begin = index;
+        dirty.end = index + 1;
+    }
+    else
+    {
+        dirty.begin = std::min(dirty.begin, index);
+        dirty.end = std::max(dirty.end, index + 1);
+    }
+}
+
+void StatsOverlay::UploadInstances(ID3D11DeviceContext* context, size_t range)
+{
+    DirtyRange& dirty = mDirty[range];
+    if (dirty.begin < dirty.end)
+    {
+        D3D11_BOX box{};
+        box.left = static_cast<UINT>(dirty.begin * sizeof(Instance));
+        box.right = static_cast<UINT>(dirty.end * sizeof(Instance));
+        box.top = 0;
+        box.bottom = 1;
+        box.front = 0;
+        box.back = 1;
+        context->UpdateSubresource(mInstanceBuffer, 0, &box,
+            &mInstances[dirty.begin], 0, 0);
+        ++mStatistics.numUploads;
+        mStatistics.numInstancesUploaded += dirty.end - dirty.begin;
+        dirty = DirtyRange{ 0, 0 };
+    }
+}
@@ -0,0 +1,151 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include "ConstantBufferRing.h"
+#include <d3d11.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// StatsOverlay draws a heads-up display of text fields and a frame-time
+// graph in the top-left corner of a render target with one instanced draw
+// call. The glyphs are a built-in 5x7 pixel font baked into a texture
+// atlas when the resources are created; the characters are the space, the
+// digits, the uppercase letters and . : - % / (lowercase letters are drawn
+// as uppercase, other characters as ?). Each character cell, graph bar and
+// the background panel is an instance (a screen rectangle, an atlas
+// rectangle and a color) in a persistent instance buffer. SetField
+// compares the new text with the old and rewrites only the instances of
+// the characters that changed; Draw uploads the changed instances, if
+// any, so a display whose digits are unchanged uploads nothing. The graph
+// and the fields have separate ranges of changed instances, uploaded with
+// one UpdateSubresource each, so that a new bar and a changed digit do not
+// upload the bars between them. The graph is a sweep: each sample
+// replaces one bar.
+//
+// The layout is in character cells of 6x9 font pixels, scaled by 'scale'
+// screen pixels per font pixel. The graph is below the last text row.
+
+namespace dxm
+{
+    class StatsOverlay
+    {
+    public:
+        static size_t constexpr graphSamples = 120;
+        static uint32_t constexpr graphHeight = 48;
+        static uint32_t constexpr scale = 2;
+
+        // The graph spans [0,graphMilliseconds]; the reference line is at
+        // 1000/60 milliseconds.
+        static float constexpr graphMilliseconds = 50.0f;
+
+        struct Statistics
+        {
+            size_t numUploads;
+            size_t numInstancesUploaded;
+        };
+
+        StatsOverlay();
+        ~StatsOverlay();
+
+        // Disallow copying; the class owns COM interfaces.
+        StatsOverlay(StatsOverlay const&) = delete;
+        StatsOverlay& operator=(StatsOverlay const&) = delete;
+
+        // Add a field of 'numCharacters' cells at a cell position. The
+        // return value is the field index for SetField. Adding a field
+        // after the resources are created rebuilds the instance buffer.
+        size_t AddField(uint32_t column, uint32_t row, uint32_t numCharacters,
+            uint32_t color = 0xFFFFFFFFu);
+
+        // Set the text of a field. The text is truncated to the field
+        // length and padded with spaces.
+        void SetField(size_t field, char const* text);
+
+        // Replace the oldest bar of the frame-time graph.
+        void AddGraphSample(float milliseconds);
+
+        // Create or release the device-dependent objects. A
+        // std::runtime_error is thrown when creation fails.
+        void CreateResources(ID3D11Device* device);
+        void ReleaseResources();
+
+        // Draw to the render target that is bound to the output merger.
+        // The viewport size is needed to convert pixels to clip space.
+        void Draw(ID3D11DeviceContext* context, ConstantBufferRing& constants,
+            uint32_t width, uint32_t height);
+
+        inline Statistics const& GetStatistics() const
+        {
+            return mStatistics;
+        }
+
+        // The rectangle (x, y, width, height) in pixels that Draw covers.
+        std::array<uint32_t, 4> GetRect() const;
+
+    private:
+        // The data of an instance: the screen rectangle (x, y, width,
+        // height) in pixels, the atlas rectangle (u0, v0, u1, v1) in texels
+        // and an RGBA8 color.
+        struct Instance
+        {
+            std::array<float, 4> rect;
+            std::array<float, 4> atlas;
+            uint32_t color;
+        };
+
+        struct Field
+        {
+            uint32_t column, row;
+            uint32_t color;
+            size_t firstInstance;
+            std::vector<uint8_t> glyphs;
+        };
+
+        static size_t GetGlyph(char c);
+        Instance MakeGlyph(uint32_t x, uint32_t y, size_t glyph, uint32_t color) const;
+        Instance MakeSolid(float x, float y, float width, float height, uint32_t color) const;
+        void UpdateLayout();
+        void SetBar(size_t sample);
+        void SetInstance(size_t index, Instance const& instance);
+        void UploadInstances(ID3D11DeviceContext* context, size_t range);
+
+        // The instances are the panel, the graph reference line, the graph
+        // bars and the field characters, in that order.
+        static size_t constexpr panelInstance = 0;
+        static size_t constexpr lineInstance = 1;
+        static size_t constexpr firstBarInstance = 2;
+        static size_t constexpr firstFieldInstance = firstBarInstance + graphSamples;
+
+        std::vector<Field> mFields;
+        std::vector<Instance> mInstances;
+        uint32_t mNumColumns, mNumRows;
+        std::array<float, graphSamples> mSamples;
+        size_t mNextSample;
+
+        // The ranges [begin,end) of instances to upload: range 0 is the
+        // panel, the line and the bars, and range 1 is the characters.
+        struct DirtyRange
+        {
+            size_t begin, end;
+        };
+
+        std::array<DirtyRange, 2> mDirty;
+
+        ID3D11Device* mDevice;
+        ID3D11Texture2D* mAtlas;
+        ID3D11ShaderResourceView* mAtlasView;
+        ID3D11Buffer* mInstanceBuffer;
+        size_t mInstanceCapacity;
+        ID3D11VertexShader* mVertexShader;
+        ID3D11PixelShader* mPixelShader;
+        ID3D11InputLayout* mInputLayout;
+        ID3D11BlendState* mBlendState;
+        Statistics mStatistics;
+    };
+}
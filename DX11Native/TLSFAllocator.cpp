@@ -0,0 +1,428 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "TLSFAllocator.h"
+#include <stdexcept>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+using namespace dxm;
+
+namespace
+{
+    // The index of the least significant set bit; 'bits' is not zero.
+    inline size_t LowestBit(uint64_t bits)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<size_t>(index);
+#else
+        return static_cast<size_t>(__builtin_ctzll(bits));
+#endif
+    }
+
+    // floor(log2(value)); 'value' is not zero.
+    inline size_t HighestBit(uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<size_t>(index);
+#else
+        return static_cast<size_t>(63 - __builtin_clzll(value));
+#endif
+    }
+}
+
+TLSFAllocator::TLSFAllocator(size_t capacity)
+    :
+    mCapacity(capacity),
+    mUsed(0),
+    mNumAllocations(0),
+    mBlocks{},
+    mUnusedBlocks{},
+    mFirstBlock(invalidBlock),
+    mFirstLevelMap(0),
+    mSecondLevelMap{},
+    mFreeLists{},
+    mCompactCursor(invalidBlock)
+{
+    if (mCapacity == 0)
+    {
+        throw std::invalid_argument("TLSFAllocator capacity must be positive.");
+    }
+    Reset();
+}
+
+TLSFAllocator::Allocation TLSFAllocator::Allocate(size_t size, uint32_t tag)
+{
+    Allocation allocation{ 0, 0, invalidBlock };
+    if (size == 0 || size > mCapacity)
+    {
+        return allocation;
+    }
+
+    uint32_t const index = FindSuitable(size);
+    if (index == invalidBlock)
+    {
+        return allocation;
+    }
+    RemoveFree(index);
+
+    // Split off the remainder as a free block.
+    if (mBlocks[index].size > size)
+    {
+        uint32_t const remainder = NewBlock();
+        Block& block = mBlocks[index];
+        Block& rest = mBlocks[remainder];
+        rest.offset = block.offset + size;
+        rest.size = block.size - size;
+        rest.prevPhysical = index;
+        rest.nextPhysical = block.nextPhysical;
+        if (rest.nextPhysical != invalidBlock)
+        {
+            mBlocks[rest.nextPhysical].prevPhysical = remainder;
+        }
+        block.nextPhysical = remainder;
+        block.size = size;
+        InsertFree(remainder);
+    }
+
+    Block& block = mBlocks[index];
+    block.free = false;
+    block.tag = tag;
+    mUsed += size;
+    ++mNumAllocations;
+    mCompactCursor = invalidBlock;
+
+    allocation.offset = block.offset;
+    allocation.size = size;
+    allocation.block = index;
+    return allocation;
+}
+
+void TLSFAllocator::Free(uint32_t index)
+{
+    if (index >= mBlocks.size() || mBlocks[index].free || mBlocks[index].size == 0)
+    {
+        throw std::invalid_argument("TLSFAllocator::Free of a block that is not allocated.");
+    }
+
+    mUsed -= mBlocks[index].size;
+    --mNumAllocations;
+    mCompactCursor = invalidBlock;
+
+    // Merge with the previous and next blocks when they are free.
+    uint32_t const prev = mBlocks[index].prevPhysical;
+    if (prev != invalidBlock && mBlocks[prev].free)
+    {
+        RemoveFree(prev);
+        mBlocks[prev].size += mBlocks[index].size;
+        mBlocks[prev].nextPhysical = mBlocks[index].nextPhysical;
+        if (mBlocks[index].nextPhysical != invalidBlock)
+        {
+            mBlocks[mBlocks[index].nextPhysical].prevPhysical = prev;
+        }
+        DeleteBlock(index);
+        index = prev;
+    }
+
+    uint32_t const next = mBlocks[index].nextPhysical;
+    if (next != invalidBlock && mBlocks[next].free)
+    {
+        RemoveFree(next);
+        mBlocks[index].size += mBlocks[next].size;
+        mBlocks[index].nextPhysical = mBlocks[next].nextPhysical;
+        if (mBlocks[next].nextPhysical != invalidBlock)
+        {
+            mBlocks[mBlocks[next].nextPhysical].prevPhysical = index;
+        }
+        DeleteBlock(next);
+    }
+
+    InsertFree(index);
+}
+
+size_t TLSFAllocator::GetOffset(uint32_t block) const
+{
+    return mBlocks[block].offset;
+}
+
+size_t TLSFAllocator::GetSize(uint32_t block) const
+{
+    return mBlocks[block].size;
+}
+
+bool TLSFAllocator::Compact(Move& move)
+{
+    // Find the first free block, or resume at the cursor.
+    uint32_t gap = mCompactCursor;
+    if (gap == invalidBlock)
+    {
+        gap = mFirstBlock;
+        while (gap != invalidBlock && !mBlocks[gap].free)
+        {
+            gap = mBlocks[gap].nextPhysical;
+        }
+    }
+
+    if (gap == invalidBlock || mBlocks[gap].nextPhysical == invalidBlock)
+    {
+        // No free block, or the free space is a single block at the end.
+        mCompactCursor = gap;
+        return false;
+    }
+
+    // The block after a free block is allocated. Swap the two in the
+    // physical order: the allocation moves to the start of the gap and the
+    // gap follows it, merging with the next block when that is free.
+    uint32_t const index = mBlocks[gap].nextPhysical;
+    Block& block = mBlocks[index];
+    Block& free = mBlocks[gap];
+
+    move.block = index;
+    move.tag = block.tag;
+    move.oldOffset = block.offset;
+    move.newOffset = free.offset;
+    move.size = block.size;
+
+    RemoveFree(gap);
+    block.offset = free.offset;
+    free.offset = block.offset + block.size;
+
+    uint32_t const prev = free.prevPhysical;
+    uint32_t const next = block.nextPhysical;
+    block.prevPhysical = prev;
+    block.nextPhysical = gap;
+    free.prevPhysical = index;
+    free.nextPhysical = next;
+    if (prev != invalidBlock)
+    {
+        mBlocks[prev].nextPhysical = index;
+    }
+    else
+    {
+        mFirstBlock = index;
+    }
+    if (next != invalidBlock)
+    {
+        mBlocks[next].prevPhysical = gap;
+    }
+
+    if (next != invalidBlock && mBlocks[next].free)
+    {
+        RemoveFree(next);
+        mBlocks[gap].size += mBlocks[next].size;
+        mBlocks[gap].nextPhysical = mBlocks[next].nextPhysical;
+        if (mBlocks[next].nextPhysical != invalidBlock)
+        {
+            mBlocks[mBlocks[next].nextPhysical].prevPhysical = gap;
+        }
+        DeleteBlock(next);
+    }
+    InsertFree(gap);
+
+    mCompactCursor = gap;
+    return true;
+}
+
+void TLSFAllocator::Reset()
+{
+    mUsed = 0;
+    mNumAllocations = 0;
+    mBlocks.clear();
+    mUnusedBlocks.clear();
+    mFirstLevelMap = 0;
+    for (size_t fl = 0; fl < numFirstLevel; ++fl)
+    {
+        mSecondLevelMap[fl] = 0;
+        for (size_t sl = 0; sl < numSecondLevel; ++sl)
+        {
+            mFreeLists[fl][sl] = invalidBlock;
+        }
+    }
+
+    mFirstBlock = NewBlock();
+    Block& block = mBlocks[mFirstBlock];
+    block.offset = 0;
+    block.size = mCapacity;
+    InsertFree(mFirstBlock);
+    mCompactCursor = invalidBlock;
+}
+
+size_t TLSFAllocator::GetLargestFree() const
+{
+    if (mFirstLevelMap == 0)
+    {
+        return 0;
+    }
+
+    // The largest block is in the highest nonempty list, which is short
+    // in practice.
+    size_t const fl = HighestBit(mFirstLevelMap);
+    size_t const sl = HighestBit(mSecondLevelMap[fl]);
+    size_t largest = 0;
+    for (uint32_t index = mFreeLists[fl][sl]; index != invalidBlock;
+        index = mBlocks[index].nextFree)
+    {
+        if (mBlocks[index].size > largest)
+        {
+            largest = mBlocks[index].size;
+        }
+    }
+    return largest;
+}
+
+double TLSFAllocator::GetFragmentation() const
+{
+    size_t const free = mCapacity - mUsed;
+    if (free == 0)
+    {
+        return 0.0;
+    }
+    return 1.0 - static_cast<double>(GetLargestFree()) / static_cast<double>(free);
+}
+
+void TLSFAllocator::Mapping(size_t size, size_t& fl, size_t& sl)
+{
+    if (size < numSecondLevel)
+    {
+        // The small sizes each have their own list in the first level.
+        fl = 0;
+        sl = size;
+    }
+    else
+    {
+        size_t const log2 = HighestBit(size);
+        fl = log2 - secondLevelBits + 1;
+        sl = (size >> (log2 - secondLevelBits)) - numSecondLevel;
+    }
+}
+
+uint32_t TLSFAllocator::FindSuitable(size_t size) const
+{
+    // Round the size up to the next class boundary so that every block in
+    // the class is large enough.
+    size_t rounded = size;
+    if (size >= numSecondLevel)
+    {
+        rounded += (static_cast<size_t>(1) << (HighestBit(size) - secondLevelBits)) - 1;
+    }
+    size_t fl, sl;
+    Mapping(rounded, fl, sl);
+
+    uint32_t slMap = mSecondLevelMap[fl] & (~0u << sl);
+    if (slMap == 0)
+    {
+        uint64_t const flMap = (fl + 1 < 64 ? mFirstLevelMap & (~0ull << (fl + 1)) : 0);
+        if (flMap != 0)
+        {
+            fl = LowestBit(flMap);
+            slMap = mSecondLevelMap[fl];
+        }
+    }
+    if (slMap != 0)
+    {
+        return mFreeLists[fl][LowestBit(slMap)];
+    }
+
+    // The rounding skips the class of the size itself, whose blocks can be
+    // smaller than the size. One of them can still fit.
+    Mapping(size, fl, sl);
+    for (uint32_t index = mFreeLists[fl][sl]; index != invalidBlock;
+        index = mBlocks[index].nextFree)
+    {
+        if (mBlocks[index].size >= size)
+        {
+            return index;
+        }
+    }
+    return invalidBlock;
+}
+
+uint32_t TLSFAllocator::NewBlock()
+{
+    uint32_t index;
+    if (!mUnusedBlocks.empty())
+    {
+        index = mUnusedBlocks.back();
+        mUnusedBlocks.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(mBlocks.size());
+        mBlocks.push_back(Block{});
+    }
+
+    Block& block = mBlocks[index];
+    block.offset = 0;
+    block.size = 0;
+    block.prevPhysical = invalidBlock;
+    block.nextPhysical = invalidBlock;
+    block.prevFree = invalidBlock;
+    block.nextFree = invalidBlock;
+    block.tag = 0;
+    block.free = false;
+    return index;
+}
+
+void TLSFAllocator::DeleteBlock(uint32_t index)
+{
+    mBlocks[index].free = false;
+    mBlocks[index].size = 0;
+    mUnusedBlocks.push_back(index);
+}
+
+void TLSFAllocator::InsertFree(uint32_t index)
+{
+    size_t fl, sl;
+    Mapping(mBlocks[index].size, fl, sl);
+
+    Block& block = mBlocks[index];
+    block.free = true;
+    block.prevFree = invalidBlock;
+    block.nextFree = mFreeLists[fl][sl];
+    if (block.nextFree != invalidBlock)
+    {
+        mBlocks[block.nextFree].prevFree = index;
+    }
+    mFreeLists[fl][sl] = index;
+    mFirstLevelMap |= (1ull << fl);
+    mSecondLevelMap[fl] |= (1u << sl);
+}
+
+void TLSFAllocator::RemoveFree(uint32_t index)
+{
+    size_t fl, sl;
+    Mapping(mBlocks[index].size, fl, sl);
+
+    Block& block = mBlocks[index];
+    if (block.prevFree != invalidBlock)
+    {
+        mBlocks[block.prevFree].nextFree = block.nextFree;
+    }
+    else
+    {
+        mFreeLists[fl][sl] = block.nextFree;
+        if (block.nextFree == invalidBlock)
+        {
+            mSecondLevelMap[fl] &= ~(1u << sl);
+            if (mSecondLevelMap[fl] == 0)
+            {
+                mFirstLevelMap &= ~(1ull << fl);
+            }
+        }
+    }
+    if (block.nextFree != invalidBlock)
+    {
+        mBlocks[block.nextFree].prevFree = block.prevFree;
+    }
+    block.free = false;
+    block.prevFree = invalidBlock;
+    block.nextFree = invalidBlock;
+}
@@ -0,0 +1,153 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// TLSFAllocator manages offsets into a fixed-size range with the two-level
+// segregated fit algorithm (M. Masmano et al., "TLSF: a New Dynamic Memory
+// Allocator for Real-Time Systems", 2004). Like RingAllocator, it has no
+// knowledge of the memory it manages; the units are whatever the caller
+// chooses (GeometryHeap uses vertices and indices). The free blocks are
+// kept in lists by size class: the first level is the power of two of the
+// size and the second level divides each power of two into 16 classes.
+// Bitmaps of the nonempty lists make Allocate and Free O(1). A freed block
+// is merged with free neighbors, so two free blocks are never adjacent.
+//
+// The allocation for a size is taken from a class whose blocks are all
+// large enough, so a block of a smaller class that would fit is not used.
+// The waste is bounded by 1/16 of the size. When every such class is
+// empty, the list of the size's own class is searched for a block that is
+// large enough, so that an exact fit (for example, the whole range) is not
+// missed. That search is linear in the length of the list, but it runs
+// only when the allocation would otherwise fail.
+//
+// Compact moves the allocations toward offset 0 one at a time, so that the
+// free space ends up in a single block at the end of the range. The caller
+// copies the data of each move it is told about. The caller's data for an
+// allocation is identified by the tag passed to Allocate.
+
+namespace dxm
+{
+    class TLSFAllocator
+    {
+    public:
+        static uint32_t constexpr invalidBlock = 0xFFFFFFFFu;
+
+        struct Allocation
+        {
+            size_t offset;
+            size_t size;
+            uint32_t block;
+        };
+
+        // A move of an allocation by Compact. The destination range starts
+        // before the source range, but the two ranges can overlap.
+        struct Move
+        {
+            uint32_t block;
+            uint32_t tag;
+            size_t oldOffset;
+            size_t newOffset;
+            size_t size;
+        };
+
+        TLSFAllocator(size_t capacity);
+        ~TLSFAllocator() = default;
+
+        // Allocate a block of 'size' units. The returned block is
+        // invalidBlock when no free block of the size class is available.
+        Allocation Allocate(size_t size, uint32_t tag = 0);
+
+        // Free a block returned by Allocate. A std::invalid_argument is
+        // thrown for a block that is free or was merged into a neighbor.
+        // The block index can be reused by a later Allocate.
+        void Free(uint32_t block);
+
+        // The current offset and size of an allocated block. Compact can
+        // change the offset.
+        size_t GetOffset(uint32_t block) const;
+        size_t GetSize(uint32_t block) const;
+
+        // Move one allocation that follows a free block to the start of
+        // that free block. The return value is 'false' when the allocations
+        // are contiguous from offset 0. The search resumes where the
+        // previous call ended unless Allocate or Free was called since.
+        bool Compact(Move& move);
+
+        // Release all allocations.
+        void Reset();
+
+        inline size_t GetCapacity() const
+        {
+            return mCapacity;
+        }
+
+        // The units in allocated blocks.
+        inline size_t GetUsed() const
+        {
+            return mUsed;
+        }
+
+        inline size_t GetNumAllocations() const
+        {
+            return mNumAllocations;
+        }
+
+        size_t GetLargestFree() const;
+
+        // 1 - largest free block / free units; 0 when the free space is a
+        // single block or there is no free space.
+        double GetFragmentation() const;
+
+    private:
+        static size_t constexpr secondLevelBits = 4;
+        static size_t constexpr numSecondLevel = 1 << secondLevelBits;
+        static size_t constexpr numFirstLevel = 65 - secondLevelBits;
+
+        struct Block
+        {
+            size_t offset;
+            size_t size;
+            uint32_t prevPhysical, nextPhysical;
+            uint32_t prevFree, nextFree;
+            uint32_t tag;
+            bool free;
+        };
+
+        static void Mapping(size_t size, size_t& fl, size_t& sl);
+
+        // A free block of at least 'size' units, or invalidBlock.
+        uint32_t FindSuitable(size_t size) const;
+
+        uint32_t NewBlock();
+        void DeleteBlock(uint32_t index);
+        void InsertFree(uint32_t index);
+        void RemoveFree(uint32_t index);
+
+        size_t mCapacity;
+        size_t mUsed;
+        size_t mNumAllocations;
+
+        // The blocks are stored in a vector and linked by index; the
+        // records of merged blocks are reused. An unused record has size 0,
+        // which no block in use has.
+        std::vector<Block> mBlocks;
+        std::vector<uint32_t> mUnusedBlocks;
+        uint32_t mFirstBlock;
+
+        uint64_t mFirstLevelMap;
+        uint32_t mSecondLevelMap[numFirstLevel];
+        uint32_t mFreeLists[numFirstLevel][numSecondLevel];
+
+        // The free block where Compact resumes; every block before it is
+        // allocated. Allocate and Free invalidate it.
+        uint32_t mCompactCursor;
+    };
+}
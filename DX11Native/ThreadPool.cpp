@@ -0,0 +1,156 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "ThreadPool.h"
+#include "Trace.h"
+#include <algorithm>
+#include <string>
+using namespace dxm;
+
+ThreadPool::ThreadPool(size_t numThreads)
+    :
+    mWorkers{},
+    mGeneration(0),
+    mNumActive(0),
+    mStop(false),
+    mTask(nullptr),
+    mNumItems(0),
+    mGrainSize(1),
+    mNumChunks(0),
+    mNextChunk(0),
+    mException{}
+{
+    if (numThreads == 0)
+    {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    mWorkers.reserve(numThreads - 1);
+    for (size_t i = 1; i < numThreads; ++i)
+    {
+        mWorkers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mWake.notify_all();
+
+    for (auto& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t numItems, size_t grainSize, Task const& task)
+{
+    if (numItems == 0)
+    {
+        return;
+    }
+
+    grainSize = std::max<size_t>(grainSize, 1);
+    size_t const numChunks = (numItems + grainSize - 1) / grainSize;
+    if (numChunks == 1 || mWorkers.empty())
+    {
+        task(0, numItems);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTask = &task;
+        mNumItems = numItems;
+        mGrainSize = grainSize;
+        mNumChunks = numChunks;
+        mNextChunk = 0;
+        mNumActive = mWorkers.size();
+        ++mGeneration;
+    }
+    mWake.notify_all();
+
+    RunChunks();
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [this]() { return mNumActive == 0; });
+    mTask = nullptr;
+    if (mException)
+    {
+        std::exception_ptr exception = nullptr;
+        std::swap(exception, mException);
+        std::rethrow_exception(exception);
+    }
+}
+
+void ThreadPool::WorkerLoop(size_t index)
+{
+    Trace::SetThreadName(("ThreadPool worker " + std::to_string(index)).c_str());
+
+    uint64_t generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [this, generation]()
+                {
+                    return mStop || mGeneration != generation;
+                });
+
+            if (mStop)
+            {
+                return;
+            }
+            generation = mGeneration;
+        }
+
+        RunChunks();
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            --mNumActive;
+        }
+        mDone.notify_one();
+    }
+}
+
+void ThreadPool::RunChunks()
+{
+    DXM_TRACE_SCOPE("ThreadPool::RunChunks");
+
+    for (;;)
+    {
+        size_t const chunk = mNextChunk.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= mNumChunks)
+        {
+            return;
+        }
+
+        size_t const begin = chunk * mGrainSize;
+        size_t const end = std::min(begin + mGrainSize, mNumItems);
+        try
+        {
+            (*mTask)(begin, end);
+        }
+        catch (...)
+        {
+            // An exception must not leave a worker thread, which would
+            // terminate the process, or the calling thread before the
+            // workers finish with the task.
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (!mException)
+            {
+                mException = std::current_exception();
+            }
+            mNextChunk.store(mNumChunks, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
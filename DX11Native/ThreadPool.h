@@ -0,0 +1,76 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ThreadPool runs data-parallel loops on a set of persistent worker
+// threads. ParallelFor partitions [0,numItems) into chunks of 'grainSize'
+// items; the workers and the calling thread take chunks until none are
+// left, and ParallelFor returns when all chunks are finished. The threads
+// are created once, so the per-call cost is a wake-up and a wait rather
+// than thread creation. ParallelFor must not be called concurrently or
+// recursively from within a task.
+//
+// When a task throws, the chunks that have not started are skipped, and
+// ParallelFor rethrows the first exception on the calling thread after
+// all running chunks have finished. The pool remains usable.
+
+namespace dxm
+{
+    class ThreadPool
+    {
+    public:
+        using Task = std::function<void(size_t begin, size_t end)>;
+
+        // The number of threads includes the calling thread, so the pool
+        // creates numThreads-1 workers. When numThreads is 0, the number of
+        // hardware threads is used.
+        ThreadPool(size_t numThreads = 0);
+        ~ThreadPool();
+
+        // Disallow copying; the class owns threads.
+        ThreadPool(ThreadPool const&) = delete;
+        ThreadPool& operator=(ThreadPool const&) = delete;
+
+        inline size_t GetNumThreads() const
+        {
+            return mWorkers.size() + 1;
+        }
+
+        void ParallelFor(size_t numItems, size_t grainSize, Task const& task);
+
+    private:
+        void WorkerLoop(size_t index);
+        void RunChunks();
+
+        std::vector<std::thread> mWorkers;
+        std::mutex mMutex;
+        std::condition_variable mWake, mDone;
+        uint64_t mGeneration;
+        size_t mNumActive;
+        bool mStop;
+
+        // The current loop, valid while ParallelFor is executing.
+        Task const* mTask;
+        size_t mNumItems;
+        size_t mGrainSize;
+        size_t mNumChunks;
+        std::atomic<size_t> mNextChunk;
+
+        // The first exception thrown by a task of the current loop.
+        std::exception_ptr mException;
+    };
+}
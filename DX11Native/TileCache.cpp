@@ -0,0 +1,208 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "TileCache.h"
+#include "ComAccounting.h"
+#include <algorithm>
+#include <stdexcept>
+using namespace dxm;
+
+TileCache::TileCache(ID3D11Device* device, ID3D11DeviceContext* context,
+    uint32_t tileSize)
+    :
+    mDevice(device),
+    mContext(context),
+    mContext1(nullptr),
+    mTexture(nullptr),
+    mView(nullptr),
+    mWidth(0),
+    mHeight(0),
+    mFormat(DXGI_FORMAT_UNKNOWN),
+    mGrid(tileSize),
+    mRects{},
+    mDamage{}
+{
+    // ClearView requires a D3D11.1 runtime and driver support. Without
+    // both, the whole cache is cleared when any tile is invalid.
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+    HRESULT hr = mDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS,
+        &options, sizeof(options));
+    if (SUCCEEDED(hr) && options.ClearView)
+    {
+        hr = DXM_COM_CALL(QUERY_INTERFACE,
+            "TileCache QueryInterface ID3D11DeviceContext1",
+            mContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&mContext1));
+        if (FAILED(hr))
+        {
+            mContext1 = nullptr;
+        }
+    }
+}
+
+TileCache::~TileCache()
+{
+    ReleaseTexture();
+
+    if (mContext1)
+    {
+        DXM_COM_CALL(RELEASE, "TileCache Release context", mContext1->Release());
+    }
+}
+
+void TileCache::Discard()
+{
+    ReleaseTexture();
+    mDamage.clear();
+}
+
+size_t TileCache::Begin(uint32_t width, uint32_t height, DXGI_FORMAT format,
+    float const* clearColor)
+{
+    if (width == 0 || height == 0)
+    {
+        return 0;
+    }
+
+    if (mTexture == nullptr || width != mWidth || height != mHeight || format != mFormat)
+    {
+        ReleaseTexture();
+        CreateTexture(width, height, format);
+        mGrid.Resize(width, height);
+        mGrid.InvalidateAll();
+        mDamage.clear();
+    }
+
+    size_t numRegions = mGrid.CollectRegions(maxRegions);
+    if (numRegions == 0)
+    {
+        return 0;
+    }
+
+    auto const& regions = mGrid.GetRegions();
+    if (mContext1)
+    {
+        mRects.resize(numRegions);
+        for (size_t i = 0; i < numRegions; ++i)
+        {
+            auto const& region = regions[i];
+            mRects[i].left = static_cast<LONG>(region.x);
+            mRects[i].top = static_cast<LONG>(region.y);
+            mRects[i].right = static_cast<LONG>(region.x + region.width);
+            mRects[i].bottom = static_cast<LONG>(region.y + region.height);
+        }
+        mContext1->ClearView(mView, clearColor, mRects.data(),
+            static_cast<UINT>(numRegions));
+    }
+    else
+    {
+        if (numRegions > 1 || regions[0].width != width || regions[0].height != height)
+        {
+            mGrid.InvalidateAll();
+            numRegions = mGrid.CollectRegions(maxRegions);
+        }
+        mContext->ClearRenderTargetView(mView, clearColor);
+    }
+    return numRegions;
+}
+
+void TileCache::SetScissor(size_t region)
+{
+    auto const& r = mGrid.GetRegions()[region];
+    D3D11_RECT rect{};
+    rect.left = static_cast<LONG>(r.x);
+    rect.top = static_cast<LONG>(r.y);
+    rect.right = static_cast<LONG>(r.x + r.width);
+    rect.bottom = static_cast<LONG>(r.y + r.height);
+    mContext->RSSetScissorRects(1, &rect);
+}
+
+void TileCache::Composite(ID3D11Texture2D* target)
+{
+    auto Copy = [this, target](TileGrid::Region const& region)
+    {
+        D3D11_BOX box{};
+        box.left = region.x;
+        box.top = region.y;
+        box.front = 0;
+        box.right = region.x + region.width;
+        box.bottom = region.y + region.height;
+        box.back = 1;
+        mContext->CopySubresourceRegion(target, 0, region.x, region.y, 0,
+            mTexture, 0, &box);
+    };
+
+    for (auto const& region : mGrid.GetRegions())
+    {
+        Copy(region);
+    }
+    for (auto const& region : mDamage)
+    {
+        Copy(region);
+    }
+    mDamage.clear();
+}
+
+void TileCache::AddTargetDamage(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    if (x >= mWidth || y >= mHeight || width == 0 || height == 0)
+    {
+        return;
+    }
+
+    mDamage.push_back(TileGrid::Region{ x, y,
+        std::min(width, mWidth - x), std::min(height, mHeight - y) });
+}
+
+void TileCache::CreateTexture(uint32_t width, uint32_t height, DXGI_FORMAT format)
+{
+    D3D11_TEXTURE2D_DESC desc{};
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = format;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_RENDER_TARGET;
+    desc.CPUAccessFlags = 0;
+    desc.MiscFlags = 0;
+
+    HRESULT hr = DXM_COM_CALL(CREATE, "TileCache::CreateTexture CreateTexture2D",
+        mDevice->CreateTexture2D(&desc, nullptr, &mTexture));
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("CreateTexture2D failed for the tile cache.");
+    }
+
+    hr = DXM_COM_CALL(CREATE, "TileCache::CreateTexture CreateRenderTargetView",
+        mDevice->CreateRenderTargetView(mTexture, nullptr, &mView));
+    if (FAILED(hr))
+    {
+        ReleaseTexture();
+        throw std::runtime_error("CreateRenderTargetView failed for the tile cache.");
+    }
+
+    mWidth = width;
+    mHeight = height;
+    mFormat = format;
+}
+
+void TileCache::ReleaseTexture()
+{
+    if (mView)
+    {
+        DXM_COM_CALL(RELEASE, "TileCache Release view", mView->Release());
+        mView = nullptr;
+    }
+
+    if (mTexture)
+    {
+        DXM_COM_CALL(RELEASE, "TileCache Release texture", mTexture->Release());
+        mTexture = nullptr;
+    }
+}
@@ -0,0 +1,120 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include "TileGrid.h"
+#include <d3d11_1.h>
+#include <cstdint>
+#include <vector>
+
+// TileCache retains the rendered scene between frames so that only the
+// tiles that changed are rendered again. The cache is one texture of the
+// render target size; its tiles are the cells of a TileGrid. Each frame,
+// Begin collects the invalid tiles as regions and clears them, the scene
+// is drawn once per region with the region as the scissor rectangle, and
+// Composite copies the regions to the render target. A frame in which
+// nothing was invalidated draws and copies nothing.
+//
+// The render target keeps its contents between frames, so Composite only
+// copies what changed in the cache. Anything drawn to the render target
+// after the composite (for example, an overlay) must be reported with
+// AddTargetDamage, and the next Composite copies that rectangle from the
+// cache as well.
+//
+// Clearing a list of rectangles requires ID3D11DeviceContext1::ClearView
+// (the D3D11.1 runtime). Without it, any invalidation clears and renders
+// the entire cache, which is the cost of rendering without the cache.
+
+namespace dxm
+{
+    class TileCache
+    {
+    public:
+        // More regions than this are replaced by their bounding rectangle
+        // so that the scene is not submitted many times in a frame.
+        static size_t constexpr maxRegions = 16;
+
+        // The device and context are not reference counted by this class.
+        TileCache(ID3D11Device* device, ID3D11DeviceContext* context,
+            uint32_t tileSize = TileGrid::defaultTileSize);
+        ~TileCache();
+
+        // Disallow copying; the class owns COM interfaces.
+        TileCache(TileCache const&) = delete;
+        TileCache& operator=(TileCache const&) = delete;
+
+        // Mark the tiles that overlap a rectangle of pixels as invalid.
+        inline void Invalidate(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+        {
+            mGrid.Invalidate(x, y, width, height);
+        }
+
+        inline void InvalidateAll()
+        {
+            mGrid.InvalidateAll();
+        }
+
+        // Release the cache texture. The next Begin creates it again and
+        // renders every tile.
+        void Discard();
+
+        // Start a frame. The cache texture is created when it does not
+        // exist or its size or format differ, in which case all tiles are
+        // invalid. The regions of the invalid tiles are cleared to
+        // 'clearColor' and marked valid. The return value is the number of
+        // regions. A std::runtime_error is thrown when the texture cannot
+        // be created.
+        size_t Begin(uint32_t width, uint32_t height, DXGI_FORMAT format,
+            float const* clearColor);
+
+        inline std::vector<TileGrid::Region> const& GetRegions() const
+        {
+            return mGrid.GetRegions();
+        }
+
+        // Set the scissor rectangle to a region returned by Begin. The
+        // rasterizer states of the draws must enable the scissor test.
+        void SetScissor(size_t region);
+
+        inline ID3D11Texture2D* GetTexture() const
+        {
+            return mTexture;
+        }
+
+        inline ID3D11RenderTargetView* GetView() const
+        {
+            return mView;
+        }
+
+        // Copy the regions of the frame and the damaged rectangles to the
+        // render target, which must have the size and format of the cache.
+        void Composite(ID3D11Texture2D* target);
+
+        void AddTargetDamage(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
+        inline TileGrid const& GetGrid() const
+        {
+            return mGrid;
+        }
+
+    private:
+        void CreateTexture(uint32_t width, uint32_t height, DXGI_FORMAT format);
+        void ReleaseTexture();
+
+        ID3D11Device* mDevice;
+        ID3D11DeviceContext* mContext;
+        ID3D11DeviceContext1* mContext1;
+        ID3D11Texture2D* mTexture;
+        ID3D11RenderTargetView* mView;
+        uint32_t mWidth, mHeight;
+        DXGI_FORMAT mFormat;
+
+        TileGrid mGrid;
+        std::vector<D3D11_RECT> mRects;
+        std::vector<TileGrid::Region> mDamage;
+    };
+}
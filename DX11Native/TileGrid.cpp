@@ -0,0 +1,193 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "TileGrid.h"
+#include <algorithm>
+#include <stdexcept>
+using namespace dxm;
+
+TileGrid::TileGrid(uint32_t tileSize)
+    :
+    mTileSize(tileSize),
+    mWidth(0),
+    mHeight(0),
+    mNumColumns(0),
+    mNumRows(0),
+    mValid{},
+    mInvalid{},
+    mAllInvalid(false),
+    mOpen{},
+    mNextOpen{},
+    mRuns{},
+    mRegions{},
+    mStatistics{},
+    mNumTilesInvalidated(0)
+{
+    if (tileSize == 0)
+    {
+        throw std::invalid_argument("TileGrid requires a positive tile size.");
+    }
+}
+
+void TileGrid::Resize(uint32_t width, uint32_t height)
+{
+    if (width == mWidth && height == mHeight)
+    {
+        return;
+    }
+
+    mWidth = width;
+    mHeight = height;
+    mNumColumns = (width + mTileSize - 1) / mTileSize;
+    mNumRows = (height + mTileSize - 1) / mTileSize;
+    mValid.assign(static_cast<size_t>(mNumColumns) * mNumRows, 0);
+    mInvalid.clear();
+    mAllInvalid = true;
+    mNumTilesInvalidated += mValid.size();
+}
+
+void TileGrid::Invalidate(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    if (mAllInvalid || x >= mWidth || y >= mHeight || width == 0 || height == 0)
+    {
+        return;
+    }
+
+    uint32_t const column0 = x / mTileSize;
+    uint32_t const column1 = (x + std::min(width, mWidth - x) - 1) / mTileSize + 1;
+    uint32_t const row0 = y / mTileSize;
+    uint32_t const row1 = (y + std::min(height, mHeight - y) - 1) / mTileSize + 1;
+    size_t const numInvalid = mInvalid.size();
+    for (uint32_t row = row0; row < row1; ++row)
+    {
+        uint32_t index = row * mNumColumns + column0;
+        for (uint32_t column = column0; column < column1; ++column, ++index)
+        {
+            if (mValid[index])
+            {
+                mValid[index] = 0;
+                mInvalid.push_back(index);
+            }
+        }
+    }
+    mNumTilesInvalidated += mInvalid.size() - numInvalid;
+}
+
+void TileGrid::InvalidateAll()
+{
+    if (!mAllInvalid)
+    {
+        std::fill(mValid.begin(), mValid.end(), static_cast<uint8_t>(0));
+        mInvalid.clear();
+        mAllInvalid = true;
+        mNumTilesInvalidated += mValid.size();
+    }
+}
+
+size_t TileGrid::CollectRegions(size_t maxRegions)
+{
+    mRegions.clear();
+    mRuns.clear();
+    mStatistics.numTilesInvalidated = mNumTilesInvalidated;
+    mNumTilesInvalidated = 0;
+
+    if (mAllInvalid)
+    {
+        if (!mValid.empty())
+        {
+            mRuns.push_back(Run{ 0, mNumColumns, 0, mNumRows });
+        }
+        std::fill(mValid.begin(), mValid.end(), static_cast<uint8_t>(1));
+        mStatistics.numTilesCollected = mValid.size();
+        mAllInvalid = false;
+    }
+    else
+    {
+        // The tiles are sorted by row, then by column, so the invalid
+        // tiles of a row form runs in column order. A run extends the run
+        // of the previous row that has the same columns; the runs of the
+        // previous row that are not extended are complete. Both lists of
+        // open runs are in column order, so they are merged.
+        std::sort(mInvalid.begin(), mInvalid.end());
+        mOpen.clear();
+        size_t const numInvalid = mInvalid.size();
+        for (size_t i = 0; i < numInvalid; )
+        {
+            uint32_t const row = mInvalid[i] / mNumColumns;
+            uint32_t const rowStart = row * mNumColumns;
+            size_t open = 0;
+            mNextOpen.clear();
+            while (i < numInvalid && mInvalid[i] < rowStart + mNumColumns)
+            {
+                uint32_t const column0 = mInvalid[i++] - rowStart;
+                uint32_t column1 = column0 + 1;
+                while (column1 < mNumColumns && i < numInvalid &&
+                    mInvalid[i] == rowStart + column1)
+                {
+                    ++column1;
+                    ++i;
+                }
+
+                for (; open < mOpen.size() && mOpen[open].column0 < column0; ++open)
+                {
+                    mRuns.push_back(mOpen[open]);
+                }
+
+                Run const* previous = (open < mOpen.size() ? &mOpen[open] : nullptr);
+                if (previous && previous->column0 == column0 &&
+                    previous->column1 == column1 && previous->row1 == row)
+                {
+                    mNextOpen.push_back(Run{ column0, column1, previous->row0, row + 1 });
+                    ++open;
+                }
+                else
+                {
+                    mNextOpen.push_back(Run{ column0, column1, row, row + 1 });
+                }
+            }
+            mRuns.insert(mRuns.end(), mOpen.begin() + open, mOpen.end());
+            std::swap(mOpen, mNextOpen);
+        }
+        mRuns.insert(mRuns.end(), mOpen.begin(), mOpen.end());
+
+        for (auto index : mInvalid)
+        {
+            mValid[index] = 1;
+        }
+        mStatistics.numTilesCollected = numInvalid;
+        mInvalid.clear();
+    }
+
+    if (mRuns.size() > std::max(maxRegions, static_cast<size_t>(1)))
+    {
+        Run bound = mRuns[0];
+        for (auto const& run : mRuns)
+        {
+            bound.column0 = std::min(bound.column0, run.column0);
+            bound.column1 = std::max(bound.column1, run.column1);
+            bound.row0 = std::min(bound.row0, run.row0);
+            bound.row1 = std::max(bound.row1, run.row1);
+        }
+        mRuns.assign(1, bound);
+    }
+
+    for (auto const& run : mRuns)
+    {
+        mRegions.push_back(ToRegion(run));
+    }
+    mStatistics.numRegions = mRegions.size();
+    return mRegions.size();
+}
+
+TileGrid::Region TileGrid::ToRegion(Run const& run) const
+{
+    uint32_t const x0 = run.column0 * mTileSize;
+    uint32_t const y0 = run.row0 * mTileSize;
+    uint32_t const x1 = std::min(run.column1 * mTileSize, mWidth);
+    uint32_t const y1 = std::min(run.row1 * mTileSize, mHeight);
+    return Region{ x0, y0, x1 - x0, y1 - y0 };
+}
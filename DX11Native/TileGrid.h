@@ -0,0 +1,135 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// TileGrid is the bookkeeping of a tile-cached surface: the surface is
+// split into square tiles of 'tileSize' pixels (the tiles of the last row
+// and column are clipped to the surface), and each tile is valid or
+// invalid. Invalidate marks the tiles that a pixel rectangle overlaps, and
+// CollectRegions returns the invalid tiles as a short list of pixel
+// rectangles and marks them valid, because the caller renders them in the
+// same frame.
+//
+// The invalid tiles are kept in a list as well as in the per-tile flags,
+// so the cost of Invalidate is proportional to the number of tiles the
+// rectangle overlaps and the cost of CollectRegions to the number of
+// invalid tiles; neither visits the valid tiles. Adjacent invalid tiles of
+// a row are merged into one rectangle, and rectangles of consecutive rows
+// that span the same columns are merged. When there are more than
+// 'maxRegions' rectangles, they are replaced by their bounding rectangle,
+// which also contains valid tiles; rendering a valid tile again is
+// harmless and is cheaper than many small draws.
+//
+// The class has no dependency on Direct3D, so the invalidation can be
+// tested without a device.
+
+namespace dxm
+{
+    class TileGrid
+    {
+    public:
+        static uint32_t constexpr defaultTileSize = 64;
+
+        // A rectangle of pixels, [x,x+width)x[y,y+height).
+        struct Region
+        {
+            uint32_t x, y, width, height;
+        };
+
+        struct Statistics
+        {
+            size_t numTilesInvalidated;
+            size_t numTilesCollected;
+            size_t numRegions;
+        };
+
+        // A std::invalid_argument is thrown when the tile size is 0.
+        TileGrid(uint32_t tileSize = defaultTileSize);
+        ~TileGrid() = default;
+
+        // Set the surface size. When it changes, all tiles are invalid.
+        void Resize(uint32_t width, uint32_t height);
+
+        // Mark the tiles that overlap a rectangle of pixels as invalid. The
+        // rectangle is clipped to the surface.
+        void Invalidate(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
+        void InvalidateAll();
+
+        // Compute the regions of the invalid tiles and mark the tiles valid.
+        // The return value is the number of regions, which are available
+        // from GetRegions until the next call.
+        size_t CollectRegions(size_t maxRegions);
+
+        inline std::vector<Region> const& GetRegions() const
+        {
+            return mRegions;
+        }
+
+        inline uint32_t GetTileSize() const
+        {
+            return mTileSize;
+        }
+
+        inline uint32_t GetNumColumns() const
+        {
+            return mNumColumns;
+        }
+
+        inline uint32_t GetNumRows() const
+        {
+            return mNumRows;
+        }
+
+        inline bool IsValid(uint32_t column, uint32_t row) const
+        {
+            return mValid[static_cast<size_t>(row) * mNumColumns + column] != 0;
+        }
+
+        inline size_t GetNumInvalidTiles() const
+        {
+            return mAllInvalid ? mValid.size() : mInvalid.size();
+        }
+
+        // The statistics of the last CollectRegions call and of the
+        // invalidations before it.
+        inline Statistics const& GetStatistics() const
+        {
+            return mStatistics;
+        }
+
+    private:
+        // A run of invalid tiles [column0,column1) in rows [row0,row1).
+        struct Run
+        {
+            uint32_t column0, column1;
+            uint32_t row0, row1;
+        };
+
+        Region ToRegion(Run const& run) const;
+
+        uint32_t mTileSize;
+        uint32_t mWidth, mHeight;
+        uint32_t mNumColumns, mNumRows;
+
+        // mValid is indexed by row * mNumColumns + column. The indices of
+        // the invalid tiles are in mInvalid, except after InvalidateAll,
+        // which sets mAllInvalid instead of listing every tile.
+        std::vector<uint8_t> mValid;
+        std::vector<uint32_t> mInvalid;
+        bool mAllInvalid;
+
+        std::vector<Run> mOpen, mNextOpen, mRuns;
+        std::vector<Region> mRegions;
+        Statistics mStatistics;
+        size_t mNumTilesInvalidated;
+    };
+}
@@ -0,0 +1,344 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "Trace.h"
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+using namespace dxm;
+
+std::atomic<bool> TraceDetail::enabled(false);
+
+namespace
+{
+    struct Event
+    {
+        uint64_t nanoseconds;
+        char const* name;
+        char phase;
+    };
+
+    struct Chunk
+    {
+        std::array<Event, Trace::eventsPerChunk> events;
+        std::atomic<size_t> count{ 0 };
+        std::atomic<Chunk*> next{ nullptr };
+    };
+
+    // The owning thread appends at the tail; the writer, holding the
+    // registry mutex, reads from the head. A chunk is freed by the writer
+    // once it is full and the owning thread has moved on to the next one.
+    class ThreadBuffer
+    {
+    public:
+        ThreadBuffer(uint32_t threadId)
+            :
+            mTail(new Chunk()),
+            mTailCount(0),
+            mHead(mTail),
+            mHeadRead(0),
+            mNumChunks(1),
+            mNumDropped(0),
+            mThreadId(threadId),
+            mName{}
+        {
+        }
+
+        ~ThreadBuffer()
+        {
+            Chunk* chunk = mHead;
+            while (chunk)
+            {
+                Chunk* next = chunk->next.load(std::memory_order_relaxed);
+                delete chunk;
+                chunk = next;
+            }
+        }
+
+        void Append(char const* name, char phase, uint64_t nanoseconds)
+        {
+            size_t index = mTailCount;
+            if (index == Trace::eventsPerChunk)
+            {
+                if (mNumChunks.load(std::memory_order_relaxed) >= Trace::maxChunksPerThread)
+                {
+                    mNumDropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                Chunk* chunk = new Chunk();
+                mNumChunks.fetch_add(1, std::memory_order_relaxed);
+                mTail->next.store(chunk, std::memory_order_release);
+                mTail = chunk;
+                index = 0;
+            }
+
+            mTail->events[index] = Event{ nanoseconds, name, phase };
+            mTailCount = index + 1;
+            mTail->count.store(mTailCount, std::memory_order_release);
+        }
+
+        template <typename Visitor>
+        void Drain(Visitor const& visitor)
+        {
+            for (;;)
+            {
+                size_t const count = mHead->count.load(std::memory_order_acquire);
+                for (size_t i = mHeadRead; i < count; ++i)
+                {
+                    visitor(mHead->events[i]);
+                }
+                mHeadRead = count;
+
+                if (count < Trace::eventsPerChunk)
+                {
+                    return;
+                }
+
+                Chunk* next = mHead->next.load(std::memory_order_acquire);
+                if (next == nullptr)
+                {
+                    return;
+                }
+                delete mHead;
+                mNumChunks.fetch_sub(1, std::memory_order_relaxed);
+                mHead = next;
+                mHeadRead = 0;
+            }
+        }
+
+        bool IsDrained() const
+        {
+            return mHead->next.load(std::memory_order_acquire) == nullptr &&
+                mHead->count.load(std::memory_order_acquire) == mHeadRead;
+        }
+
+        inline uint64_t GetNumDropped() const
+        {
+            return mNumDropped.load(std::memory_order_relaxed);
+        }
+
+        inline uint32_t GetThreadId() const
+        {
+            return mThreadId;
+        }
+
+        // Accessed with the registry mutex locked.
+        std::string& Name()
+        {
+            return mName;
+        }
+
+    private:
+        // Producer.
+        Chunk* mTail;
+        size_t mTailCount;
+
+        // Consumer.
+        Chunk* mHead;
+        size_t mHeadRead;
+
+        std::atomic<size_t> mNumChunks;
+        std::atomic<uint64_t> mNumDropped;
+        uint32_t mThreadId;
+        std::string mName;
+    };
+
+    // The buffers of all threads that have recorded events. A buffer is
+    // owned jointly by its thread and the registry, so the events of a
+    // thread that has exited can still be written.
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        uint32_t nextThreadId = 1;
+        uint64_t numDroppedRetired = 0;
+        std::chrono::steady_clock::time_point const epoch =
+            std::chrono::steady_clock::now();
+    };
+
+    Registry& GetRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    // The buffer is created by the first event of the thread. A name set
+    // before that is kept until then, so naming a thread does not allocate
+    // a buffer while tracing is off.
+    struct ThreadState
+    {
+        std::shared_ptr<ThreadBuffer> buffer;
+        std::string pendingName;
+    };
+
+    ThreadState& GetThreadState()
+    {
+        thread_local ThreadState state;
+        return state;
+    }
+
+    ThreadBuffer& GetThreadBuffer()
+    {
+        ThreadState& state = GetThreadState();
+        if (!state.buffer)
+        {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            state.buffer = std::make_shared<ThreadBuffer>(registry.nextThreadId++);
+            state.buffer->Name() = std::move(state.pendingName);
+            registry.buffers.push_back(state.buffer);
+        }
+        return *state.buffer;
+    }
+
+    uint64_t GetNanoseconds()
+    {
+        auto const elapsed = std::chrono::steady_clock::now() - GetRegistry().epoch;
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    void WriteString(std::ostream& output, char const* text)
+    {
+        output << '"';
+        for (char const* c = text; *c; ++c)
+        {
+            unsigned char const u = static_cast<unsigned char>(*c);
+            if (*c == '"' || *c == '\\')
+            {
+                output << '\\' << *c;
+            }
+            else if (u < 0x20)
+            {
+                char escape[8];
+                std::snprintf(escape, sizeof(escape), "\\u%04x", u);
+                output << escape;
+            }
+            else
+            {
+                output << *c;
+            }
+        }
+        output << '"';
+    }
+}
+
+void Trace::Enable(bool enable)
+{
+    // Create the registry (and its epoch) before the first event.
+    (void)GetRegistry();
+    TraceDetail::enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool Trace::IsEnabled()
+{
+    return TraceDetail::IsEnabled();
+}
+
+void Trace::Begin(char const* name)
+{
+    GetThreadBuffer().Append(name, 'B', GetNanoseconds());
+}
+
+void Trace::End(char const* name)
+{
+    GetThreadBuffer().Append(name, 'E', GetNanoseconds());
+}
+
+void Trace::SetThreadName(char const* name)
+{
+    ThreadState& state = GetThreadState();
+    if (state.buffer)
+    {
+        std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+        state.buffer->Name() = name;
+    }
+    else
+    {
+        state.pendingName = name;
+    }
+}
+
+void Trace::Write(std::ostream& output)
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    output << "{\"traceEvents\":[";
+    bool first = true;
+    char timestamp[32];
+    for (auto const& buffer : registry.buffers)
+    {
+        uint32_t const tid = buffer->GetThreadId();
+        if (!buffer->Name().empty())
+        {
+            output << (first ? "\n" : ",\n");
+            output << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << tid << ",\"args\":{\"name\":";
+            WriteString(output, buffer->Name().c_str());
+            output << "}}";
+            first = false;
+        }
+
+        buffer->Drain([&output, &first, &timestamp, tid](Event const& event)
+            {
+                // The timestamps are in microseconds.
+                std::snprintf(timestamp, sizeof(timestamp), "%.3f",
+                    static_cast<double>(event.nanoseconds) * 1e-3);
+                output << (first ? "\n" : ",\n");
+                output << "{\"name\":";
+                WriteString(output, event.name);
+                output << ",\"ph\":\"" << event.phase << "\",\"ts\":" << timestamp
+                    << ",\"pid\":1,\"tid\":" << tid << "}";
+                first = false;
+            });
+    }
+    output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    // Release the buffers of threads that have exited once their events
+    // are written.
+    for (auto iter = registry.buffers.begin(); iter != registry.buffers.end(); )
+    {
+        if (iter->use_count() == 1 && (*iter)->IsDrained())
+        {
+            registry.numDroppedRetired += (*iter)->GetNumDropped();
+            iter = registry.buffers.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+bool Trace::Write(std::string const& filename)
+{
+    std::ofstream output(filename, std::ios::out | std::ios::trunc);
+    if (!output)
+    {
+        return false;
+    }
+    Write(output);
+    return static_cast<bool>(output);
+}
+
+uint64_t Trace::GetNumDropped()
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    uint64_t numDropped = registry.numDroppedRetired;
+    for (auto const& buffer : registry.buffers)
+    {
+        numDropped += buffer->GetNumDropped();
+    }
+    return numDropped;
+}
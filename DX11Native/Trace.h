@@ -0,0 +1,127 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#if !defined(_M_CEE)
+#include <atomic>
+#endif
+
+// Trace records begin/end events for a timeline of the frame and writes
+// them in the Chrome trace-event JSON format, which chrome://tracing and
+// https://ui.perfetto.dev load. Each thread appends events to its own
+// buffer, a list of fixed-size chunks with a single producer (the thread)
+// and a single consumer (the writer), so recording takes no lock. The
+// writer drains the events recorded so far; chunks that it has consumed
+// are freed. When a thread has maxChunksPerThread chunks pending, further
+// events of that thread are dropped and counted.
+//
+// The event names must have static storage duration (string literals),
+// because only the pointers are recorded.
+//
+// Use DXM_TRACE_SCOPE("name") to record a scope. When tracing is off, the
+// cost of a scope is one relaxed atomic load. Defining DXM_DISABLE_TRACE
+// removes the scopes at compile time. C++/CLI code cannot include <atomic>,
+// so there the check is a call to Trace::IsEnabled().
+//
+// The code uses only the C++ standard library so that it can be built and
+// tested on any platform.
+
+namespace dxm
+{
+    class Trace
+    {
+    public:
+        // The number of events in a chunk of a thread buffer.
+        static size_t constexpr eventsPerChunk = 4096;
+        static size_t constexpr maxChunksPerThread = 256;
+
+        // Recording is off initially.
+        static void Enable(bool enable);
+        static bool IsEnabled();
+
+        // Record an event for the calling thread. These do not check
+        // whether tracing is enabled; TraceScope does.
+        static void Begin(char const* name);
+        static void End(char const* name);
+
+        // The thread name shown by the trace viewers for the calling
+        // thread. The name is copied.
+        static void SetThreadName(char const* name);
+
+        // Write the events recorded since the last write as a complete
+        // JSON document and remove them from the buffers. Events of scopes
+        // that are open during the write are in the next write, so the
+        // viewers can show a begin event without its end event. The
+        // filename version returns 'false' when the file cannot be opened.
+        static void Write(std::ostream& output);
+        static bool Write(std::string const& filename);
+
+        // The number of events dropped because a thread buffer was full.
+        static uint64_t GetNumDropped();
+    };
+
+#if !defined(_M_CEE)
+    namespace TraceDetail
+    {
+        extern std::atomic<bool> enabled;
+
+        inline bool IsEnabled()
+        {
+            return enabled.load(std::memory_order_relaxed);
+        }
+    }
+#endif
+
+    // A null name records nothing; DXM_TRACE_SCOPE passes null when
+    // tracing is off.
+    class TraceScope
+    {
+    public:
+        inline TraceScope(char const* name)
+            :
+            mName(name)
+        {
+            if (mName)
+            {
+                Trace::Begin(mName);
+            }
+        }
+
+        inline ~TraceScope()
+        {
+            if (mName)
+            {
+                Trace::End(mName);
+            }
+        }
+
+        TraceScope(TraceScope const&) = delete;
+        TraceScope& operator=(TraceScope const&) = delete;
+
+    private:
+        char const* mName;
+    };
+}
+
+#define DXM_TRACE_CONCATENATE_(x, y) x##y
+#define DXM_TRACE_CONCATENATE(x, y) DXM_TRACE_CONCATENATE_(x, y)
+
+#if defined(DXM_DISABLE_TRACE)
+#define DXM_TRACE_SCOPE(name)
+#elif !defined(_M_CEE)
+#define DXM_TRACE_SCOPE(name) \
+    dxm::TraceScope DXM_TRACE_CONCATENATE(traceScope, __LINE__)( \
+        dxm::TraceDetail::IsEnabled() ? (name) : nullptr)
+#else
+#define DXM_TRACE_SCOPE(name) \
+    dxm::TraceScope DXM_TRACE_CONCATENATE(traceScope, __LINE__)( \
+        dxm::Trace::IsEnabled() ? (name) : nullptr)
+#endif
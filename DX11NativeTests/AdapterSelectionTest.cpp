@@ -0,0 +1,159 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "AdapterSelection.h"
+#include "TestCheck.h"
+#include <vector>
+using namespace dxm;
+
+namespace
+{
+    using Adapter = AdapterSelection::Adapter;
+    using D3D9Adapter = AdapterSelection::D3D9Adapter;
+    using Reason = AdapterSelection::Reason;
+
+    // The LUIDs and monitors of the fake systems.
+    uint64_t constexpr integrated = 0x0000000100000010ull;
+    uint64_t constexpr discrete = 0x0000000100000020ull;
+    uint64_t constexpr warp = 0x0000000100000030ull;
+    uintptr_t constexpr internalPanel = 0x1001;
+    uintptr_t constexpr externalMonitor = 0x1002;
+    uintptr_t constexpr thirdMonitor = 0x1003;
+
+    Adapter MakeAdapter(uint64_t luid, std::vector<uintptr_t> monitors, bool software = false)
+    {
+        return Adapter{ luid, software ? "WARP" : "GPU", software, 1ull << 30, monitors };
+    }
+
+    bool Is(AdapterSelection::Selection const& selection, Reason reason, uint64_t luid,
+        size_t adapter, uint32_t ordinal)
+    {
+        return selection.reason == reason && selection.luid == luid &&
+            selection.adapter == adapter && selection.ordinal == ordinal;
+    }
+
+    // A hybrid laptop: the integrated GPU drives the panel and the discrete
+    // GPU the external monitor. The window gets the adapter of its monitor
+    // and the D3D9 ordinal of that monitor.
+    void TestHybridLaptop()
+    {
+        std::vector<Adapter> const adapters =
+        {
+            MakeAdapter(integrated, { internalPanel }),
+            MakeAdapter(discrete, { externalMonitor }),
+            MakeAdapter(warp, {}, true)
+        };
+        std::vector<D3D9Adapter> const d3d9Adapters =
+        {
+            { 0, integrated, internalPanel },
+            { 1, discrete, externalMonitor }
+        };
+
+        DXM_CHECK(Is(AdapterSelection::Select(adapters, d3d9Adapters, internalPanel),
+            Reason::MONITOR, integrated, 0, 0));
+        DXM_CHECK(Is(AdapterSelection::Select(adapters, d3d9Adapters, externalMonitor),
+            Reason::MONITOR, discrete, 1, 1));
+
+        // A monitor that no adapter reports falls back to the primary.
+        DXM_CHECK(Is(AdapterSelection::Select(adapters, d3d9Adapters, thirdMonitor),
+            Reason::PRIMARY, integrated, 0, 0));
+    }
+
+    // DXGI does not report the outputs of an adapter (as for the discrete
+    // GPU of some laptops whose outputs are routed through the integrated
+    // GPU); D3D9 still associates the monitor with its LUID.
+    void TestUnreportedOutputs()
+    {
+        std::vector<Adapter> const adapters =
+        {
+            MakeAdapter(integrated, { internalPanel }),
+            MakeAdapter(discrete, {})
+        };
+        std::vector<D3D9Adapter> const d3d9Adapters =
+        {
+            { 0, integrated, internalPanel },
+            { 1, discrete, externalMonitor }
+        };
+        DXM_CHECK(Is(AdapterSelection::Select(adapters, d3d9Adapters, externalMonitor),
+            Reason::D3D9_MONITOR, discrete, 1, 1));
+    }
+
+    // An adapter with several outputs has a D3D9 ordinal per output; the
+    // ordinal of the window's monitor is chosen, or the first one when the
+    // monitor is not one of them.
+    void TestMultipleOutputs()
+    {
+        std::vector<Adapter> const adapters =
+        {
+            MakeAdapter(discrete, { internalPanel, externalMonitor, thirdMonitor })
+        };
+        std::vector<D3D9Adapter> const d3d9Adapters =
+        {
+            { 0, discrete, internalPanel },
+            { 1, discrete, externalMonitor },
+            { 2, discrete, thirdMonitor }
+        };
+        DXM_CHECK(Is(AdapterSelection::Select(adapters, d3d9Adapters, thirdMonitor),
+            Reason::MONITOR, discrete, 0, 2));
+        DXM_CHECK(Is(AdapterSelection::Select(adapters, d3d9Adapters, externalMonitor),
+            Reason::MONITOR, discrete, 0, 1));
+        DXM_CHECK(Is(AdapterSelection::Select(adapters, d3d9Adapters, 0x2000),
+            Reason::PRIMARY, discrete, 0, 0));
+
+        // The primary is the lowest ordinal, in any order of the list.
+        std::vector<D3D9Adapter> const reordered =
+        {
+            { 1, integrated, externalMonitor },
+            { 0, discrete, internalPanel }
+        };
+        std::vector<Adapter> const both =
+        {
+            MakeAdapter(integrated, {}),
+            MakeAdapter(discrete, {})
+        };
+        DXM_CHECK(Is(AdapterSelection::Select(both, reordered, 0x2000),
+            Reason::PRIMARY, discrete, 1, 0));
+    }
+
+    // Software adapters and adapters that D3D9 does not know are not
+    // candidates. Without a candidate the reason is NONE.
+    void TestNoCandidate()
+    {
+        std::vector<Adapter> const softwareOnly = { MakeAdapter(warp, { internalPanel }, true) };
+        std::vector<D3D9Adapter> const d3d9Warp = { { 0, warp, internalPanel } };
+        DXM_CHECK(Is(AdapterSelection::Select(softwareOnly, d3d9Warp, internalPanel),
+            Reason::NONE, 0, 0, 0));
+
+        std::vector<Adapter> const adapters =
+        {
+            MakeAdapter(integrated, { internalPanel }),
+            MakeAdapter(discrete, { externalMonitor })
+        };
+        std::vector<D3D9Adapter> const unmatched = { { 0, 0x77ull, internalPanel } };
+        DXM_CHECK(Is(AdapterSelection::Select(adapters, unmatched, internalPanel),
+            Reason::NONE, 0, 0, 0));
+        DXM_CHECK(Is(AdapterSelection::Select(adapters, {}, internalPanel),
+            Reason::NONE, 0, 0, 0));
+        DXM_CHECK(Is(AdapterSelection::Select({}, d3d9Warp, internalPanel),
+            Reason::NONE, 0, 0, 0));
+
+        // The discrete GPU drives the monitor but has no D3D9 ordinal, so
+        // the primary is used.
+        std::vector<D3D9Adapter> const integratedOnly = { { 0, integrated, internalPanel } };
+        DXM_CHECK(Is(AdapterSelection::Select(adapters, integratedOnly, externalMonitor),
+            Reason::PRIMARY, integrated, 0, 0));
+    }
+}
+
+int main()
+{
+    TestHybridLaptop();
+    TestUnreportedOutputs();
+    TestMultipleOutputs();
+    TestNoCandidate();
+    return TestCheck::Report("AdapterSelectionTest");
+}
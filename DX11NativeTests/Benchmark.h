@@ -0,0 +1,75 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// The timing of the benchmarks. Measure runs a function 'numRuns' times
+// and returns the smallest time per iteration in nanoseconds, where the
+// function performs 'numIterations' iterations. With --quick on the
+// command line, the benchmarks run one short pass so that ctest can check
+// them.
+
+namespace dxm
+{
+    class Benchmark
+    {
+    public:
+        Benchmark(int argc, char** argv)
+            :
+            mQuick(argc > 1 && std::strcmp(argv[1], "--quick") == 0)
+        {
+        }
+
+        inline bool IsQuick() const
+        {
+            return mQuick;
+        }
+
+        // The iteration count, reduced in quick mode.
+        inline size_t Iterations(size_t numIterations) const
+        {
+            return mQuick ? (numIterations + 999) / 1000 : numIterations;
+        }
+
+        template <typename Function>
+        double Measure(size_t numIterations, Function function) const
+        {
+            size_t const numRuns = (mQuick ? 1 : 7);
+            double best = 0.0;
+            for (size_t run = 0; run < numRuns; ++run)
+            {
+                auto const start = std::chrono::steady_clock::now();
+                function();
+                auto const end = std::chrono::steady_clock::now();
+                double const nanoseconds =
+                    std::chrono::duration<double, std::nano>(end - start).count() /
+                    static_cast<double>(numIterations > 0 ? numIterations : 1);
+                if (run == 0 || nanoseconds < best)
+                {
+                    best = nanoseconds;
+                }
+            }
+            return best;
+        }
+
+    private:
+        bool mQuick;
+    };
+
+    // Keep a value alive so that the compiler cannot remove the work that
+    // computed it.
+    inline char volatile benchmarkSink = 0;
+
+    template <typename T>
+    inline void DoNotOptimize(T const& value)
+    {
+        benchmarkSink = *reinterpret_cast<char const volatile*>(&value);
+    }
+}
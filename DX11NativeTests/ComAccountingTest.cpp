@@ -0,0 +1,224 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "ComAccounting.h"
+#include "PixelUploader.h"
+#include "MockD3D11.h"
+#include "TestCheck.h"
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace dxm;
+
+namespace
+{
+    using Operation = ComAccounting::Operation;
+
+    ID3D11Buffer* CreateBuffer(MockDevice& device, HRESULT* result = nullptr)
+    {
+        D3D11_BUFFER_DESC desc{};
+        desc.ByteWidth = 256;
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        ID3D11Buffer* buffer = nullptr;
+        HRESULT const hr = DXM_COM_CALL(CREATE, "Test CreateBuffer",
+            device.CreateBuffer(&desc, nullptr, &buffer));
+        if (result)
+        {
+            *result = hr;
+        }
+        return buffer;
+    }
+
+    ComAccounting::Site FindSite(char const* name, Operation operation)
+    {
+        for (auto const& site : ComAccounting::GetSites())
+        {
+            if (site.name == name && site.operation == operation)
+            {
+                return site;
+            }
+        }
+        return ComAccounting::Site{ "", operation, 0, 0.0 };
+    }
+
+    // The calls are not recorded while accounting is off, and the result
+    // of an instrumented call is the result of the call.
+    void TestSites()
+    {
+        MockDevice device;
+        ComAccounting::Reset();
+        CreateBuffer(device)->Release();
+        DXM_CHECK(ComAccounting::GetSites().empty());
+
+        ComAccounting::Enable(true);
+        ID3D11Buffer* buffer = CreateBuffer(device);
+        void* object = nullptr;
+        HRESULT const hr = DXM_COM_CALL(QUERY_INTERFACE, "Test QueryInterface",
+            buffer->QueryInterface(__uuidof(ID3D11Texture2D), &object));
+        DXM_CHECK(hr == E_NOINTERFACE && object == nullptr);
+        ULONG const references = DXM_COM_CALL(RELEASE, "Test Release", buffer->Release());
+        DXM_CHECK(references == 0);
+
+        // A failed creation is recorded with its result.
+        HRESULT result = S_OK;
+        device.failAtCreate = device.numCreates;
+        DXM_CHECK(CreateBuffer(device, &result) == nullptr && result == E_OUTOFMEMORY);
+
+        // Sites with equal names are merged, also when the strings are at
+        // different addresses.
+        std::string const name = "Test CreateBuffer";
+        (void)DXM_COM_CALL(CREATE, name.c_str(), S_OK);
+
+        DXM_CHECK(FindSite("Test CreateBuffer", Operation::CREATE).count == 3);
+        DXM_CHECK(FindSite("Test QueryInterface", Operation::QUERY_INTERFACE).count == 1);
+        DXM_CHECK(FindSite("Test Release", Operation::RELEASE).count == 1);
+        DXM_CHECK(ComAccounting::GetSites().size() == 3);
+        DXM_CHECK(FindSite("Test CreateBuffer", Operation::CREATE).milliseconds >= 0.0);
+
+        ComAccounting::Enable(false);
+        DXM_CHECK(MockCom::NumLiveObjects() == 1);
+    }
+
+    // A steady-state frame that creates an object is flagged with its first
+    // creation site; a frame that is not in steady state is not.
+    void TestFrames()
+    {
+        MockDevice device;
+        ComAccounting::Reset();
+        ComAccounting::Enable(true);
+
+        CreateBuffer(device)->Release();
+        ComAccounting::EndFrame(false);
+        DXM_CHECK(ComAccounting::GetNumFrames() == 1);
+        DXM_CHECK(ComAccounting::GetNumFlaggedFrames() == 0);
+        DXM_CHECK(ComAccounting::GetLastFrame().numCreates == 1);
+        DXM_CHECK(ComAccounting::GetLastFrame().numReleases == 0);
+
+        ComAccounting::EndFrame(true);
+        DXM_CHECK(ComAccounting::GetNumFlaggedFrames() == 0);
+        DXM_CHECK(ComAccounting::GetLastFrame().numCreates == 0);
+
+        ID3D11Buffer* buffer = CreateBuffer(device);
+        (void)DXM_COM_CALL(CREATE, "Test second", S_OK);
+        (void)DXM_COM_CALL(RELEASE, "Test Release", buffer->Release());
+        ComAccounting::EndFrame(true);
+        auto flagged = ComAccounting::GetFlaggedFrames();
+        DXM_CHECK(flagged.size() == 1 && flagged[0].frame == 2);
+        DXM_CHECK(flagged[0].numCreates == 2 && flagged[0].firstSite == "Test CreateBuffer");
+        DXM_CHECK(ComAccounting::GetLastFrame().numReleases == 1);
+
+        // The list is bounded; the count is not.
+        for (size_t i = 0; i < ComAccounting::maxFlaggedFrames + 10; ++i)
+        {
+            (void)DXM_COM_CALL(CREATE, "Test loop", S_OK);
+            ComAccounting::EndFrame(true);
+        }
+        DXM_CHECK(ComAccounting::GetNumFlaggedFrames() == ComAccounting::maxFlaggedFrames + 11);
+        DXM_CHECK(ComAccounting::GetFlaggedFrames().size() == ComAccounting::maxFlaggedFrames);
+
+        // The operations of other threads belong to the current frame.
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([]()
+            {
+                for (size_t i = 0; i < 1000; ++i)
+                {
+                    (void)DXM_COM_CALL(QUERY_INTERFACE, "Test thread", S_OK);
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        ComAccounting::EndFrame(true);
+        DXM_CHECK(ComAccounting::GetLastFrame().numQueryInterfaces == 4000);
+        DXM_CHECK(FindSite("Test thread", Operation::QUERY_INTERFACE).count == 4000);
+
+        // EndFrame is ignored while accounting is off.
+        ComAccounting::Enable(false);
+        uint64_t const numFrames = ComAccounting::GetNumFrames();
+        ComAccounting::EndFrame(true);
+        DXM_CHECK(ComAccounting::GetNumFrames() == numFrames);
+    }
+
+    // A reference that outlives the final Release is recorded and
+    // reported.
+    void TestLiveReferences()
+    {
+        MockDevice device;
+        ComAccounting::Reset();
+        ComAccounting::Enable(true);
+
+        ID3D11Buffer* buffer = CreateBuffer(device);
+        buffer->AddRef();
+        ComAccounting::RecordLiveReferences("Test buffer",
+            DXM_COM_CALL(RELEASE, "Test Release", buffer->Release()));
+        ComAccounting::RecordLiveReferences("Test released",
+            DXM_COM_CALL(RELEASE, "Test Release", buffer->Release()));
+        auto const live = ComAccounting::GetLiveReferences();
+        DXM_CHECK(live.size() == 1 && live[0].name == "Test buffer" && live[0].references == 1);
+
+        ComAccounting::EndFrame(true);
+        std::ostringstream report;
+        ComAccounting::Write(report);
+        std::string const text = report.str();
+        DXM_CHECK(text.find("Test CreateBuffer") != std::string::npos);
+        DXM_CHECK(text.find("frames: 1, steady-state frames that created objects: 1") !=
+            std::string::npos);
+        DXM_CHECK(text.find("first at Test CreateBuffer") != std::string::npos);
+        DXM_CHECK(text.find("Test buffer: 1 references") != std::string::npos);
+        DXM_CHECK(!ComAccounting::Write(std::string("/nonexistent/directory/report.txt")));
+
+        ComAccounting::Enable(false);
+        ComAccounting::Reset();
+        DXM_CHECK(ComAccounting::GetSites().empty() && ComAccounting::GetNumFrames() == 0);
+    }
+
+    // The instrumented classes record their sites against the mock device:
+    // PixelUploader creates textures while its ring grows and then reuses
+    // them, so only the first frames create objects.
+    void TestInstrumentedClass()
+    {
+        MockDevice device;
+        MockContext context;
+        std::vector<uint8_t> pixels(32 * 32 * 4);
+        ComAccounting::Reset();
+        ComAccounting::Enable(true);
+        {
+            PixelUploader uploader(&device, &context);
+            for (size_t frame = 0; frame < 10; ++frame)
+            {
+                uploader.Upload(PixelConversion::Format::BGRA8, pixels.data(), 32 * 4,
+                    0, 0, 32, 32);
+                uploader.Resolve(nullptr, 64, 64);
+                uploader.NextFrame();
+                ComAccounting::EndFrame(true);
+            }
+        }
+        auto const creates = FindSite("PixelUploader::Upload CreateTexture2D", Operation::CREATE);
+        auto const releases = FindSite("PixelUploader Release texture", Operation::RELEASE);
+        DXM_CHECK(creates.count == device.numCreates && creates.count > 0);
+        DXM_CHECK(releases.count == creates.count);
+        DXM_CHECK(ComAccounting::GetNumFlaggedFrames() == creates.count);
+        DXM_CHECK(ComAccounting::GetFlaggedFrames().back().frame < 5);
+        ComAccounting::Enable(false);
+        ComAccounting::Reset();
+    }
+}
+
+int main()
+{
+    TestSites();
+    TestFrames();
+    TestLiveReferences();
+    TestInstrumentedClass();
+    return TestCheck::Report("ComAccountingTest");
+}
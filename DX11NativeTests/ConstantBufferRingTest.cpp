@@ -0,0 +1,268 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "ConstantBufferRing.h"
+#include "MockD3D11.h"
+#include "TestCheck.h"
+#include <array>
+#include <cstring>
+#include <stdexcept>
+using namespace dxm;
+
+namespace
+{
+    // A context that records the bindings.
+    class BindingContext : public MockContext
+    {
+    public:
+        BindingContext()
+            :
+            buffer(nullptr),
+            firstConstant(0),
+            numConstants(0),
+            numOffsetBindings(0),
+            numBindings(0)
+        {
+        }
+
+        virtual void VSSetConstantBuffers(UINT, UINT, ID3D11Buffer* const* buffers) override
+        {
+            buffer = buffers[0];
+            ++numBindings;
+        }
+
+        virtual void VSSetConstantBuffers1(UINT, UINT, ID3D11Buffer* const* buffers,
+            UINT const* firstConstants, UINT const* numsConstants) override
+        {
+            buffer = buffers[0];
+            firstConstant = firstConstants[0];
+            numConstants = numsConstants[0];
+            ++numOffsetBindings;
+        }
+
+        ID3D11Buffer* buffer;
+        UINT firstConstant, numConstants;
+        size_t numOffsetBindings, numBindings;
+    };
+
+    void SupportOffsetBinding(MockDevice& device)
+    {
+        device.options.ConstantBufferOffsetting = TRUE;
+        device.options.MapNoOverwriteOnDynamicConstantBuffer = TRUE;
+    }
+
+    std::array<uint8_t, 1024> MakeData(uint8_t seed)
+    {
+        std::array<uint8_t, 1024> data{};
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            data[i] = static_cast<uint8_t>(seed + i);
+        }
+        return data;
+    }
+
+    void TestRing()
+    {
+        MockDevice device;
+        SupportOffsetBinding(device);
+        BindingContext context;
+        {
+            // The capacity is rounded up to 4 slices.
+            ConstantBufferRing ring(&device, &context, 1000);
+            DXM_CHECK(ring.UsesOffsetBinding());
+            DXM_CHECK(device.numCreates == 1);
+
+            auto data = MakeData(1);
+            auto a0 = ring.Upload(data.data(), 100);
+            auto a1 = ring.Upload(data.data(), 300);
+            DXM_CHECK(a0.buffer == a1.buffer);
+            DXM_CHECK(a0.firstConstant == 0 && a0.numConstants == 16);
+            DXM_CHECK(a1.firstConstant == 16 && a1.numConstants == 32);
+
+            // The first block of the empty ring discards; the others do not
+            // overwrite bytes the GPU may be reading.
+            DXM_CHECK(context.maps.size() == 2 && context.numUnmaps == 2);
+            DXM_CHECK(context.maps[0].type == D3D11_MAP_WRITE_DISCARD);
+            DXM_CHECK(context.maps[1].type == D3D11_MAP_WRITE_NO_OVERWRITE);
+
+            auto& bytes = static_cast<MockBuffer*>(a1.buffer)->GetData();
+            DXM_CHECK(std::memcmp(&bytes[256], data.data(), 300) == 0);
+
+            ring.BindVS(1, a1);
+            DXM_CHECK(context.numOffsetBindings == 1 && context.numBindings == 0);
+            DXM_CHECK(context.buffer == a1.buffer);
+            DXM_CHECK(context.firstConstant == 16 && context.numConstants == 32);
+
+            // Slices 0 to 2 are used, so a 2-slice block does not fit and
+            // the ring is full until the frame is retired.
+            DXM_CHECK_THROWS(std::runtime_error, ring.Upload(data.data(), 512));
+            ring.NextFrame();
+
+            // The ring is empty, so the block starts at 0 with a discard.
+            auto a2 = ring.Upload(data.data(), 512);
+            DXM_CHECK(a2.firstConstant == 0);
+            DXM_CHECK(context.maps.back().type == D3D11_MAP_WRITE_DISCARD);
+            auto a3 = ring.Upload(data.data(), 256);
+            DXM_CHECK(a3.firstConstant == 32);
+            DXM_CHECK(context.maps.back().type == D3D11_MAP_WRITE_NO_OVERWRITE);
+            ring.NextFrame();
+
+            // No buffer is created after the ring buffer.
+            DXM_CHECK(device.numCreates == 1);
+            DXM_CHECK(ring.GetPoolSizes().empty());
+
+            DXM_CHECK_THROWS(std::runtime_error, ring.Upload(data.data(), 0));
+            DXM_CHECK_THROWS(std::runtime_error,
+                ring.Upload(data.data(), ConstantBufferRing::maxBytes + 1));
+        }
+
+        // The ring released the ring buffer and its ID3D11DeviceContext1
+        // reference.
+        DXM_CHECK(context.mockReferences == 1);
+    }
+
+    void TestRingWrap()
+    {
+        MockDevice device;
+        SupportOffsetBinding(device);
+        MockContext context;
+        ConstantBufferRing ring(&device, &context, 4 * ConstantBufferRing::sliceBytes);
+        auto data0 = MakeData(2);
+        auto data1 = MakeData(7);
+
+        // Frame 0 ends in the middle of the ring.
+        ring.Upload(data0.data(), 256);
+        ring.Upload(data0.data(), 256);
+        auto a0 = ring.Upload(data0.data(), 256);
+        DXM_CHECK(a0.firstConstant == 32);
+        ring.NextFrame();
+
+        // NextFrame retires frame 0, so the ring wraps to slice 0 and the
+        // wrap discards instead of overwriting the slice frame 0 used.
+        size_t const numMaps = context.maps.size();
+        auto a1 = ring.Upload(data1.data(), 512);
+        DXM_CHECK(a1.firstConstant == 0);
+        DXM_CHECK(context.maps.size() == numMaps + 1);
+        DXM_CHECK(context.maps.back().type == D3D11_MAP_WRITE_DISCARD);
+        DXM_CHECK(std::memcmp(static_cast<MockBuffer*>(a1.buffer)->GetData().data(),
+            data1.data(), 512) == 0);
+        auto a2 = ring.Upload(data1.data(), 256);
+        DXM_CHECK(a2.firstConstant == 32);
+        DXM_CHECK(context.maps.back().type == D3D11_MAP_WRITE_NO_OVERWRITE);
+    }
+
+    void TestRingMapFailure()
+    {
+        MockDevice device;
+        SupportOffsetBinding(device);
+        MockContext context;
+        ConstantBufferRing ring(&device, &context, 1024);
+        context.mapResult = E_FAIL;
+        auto data = MakeData(3);
+        DXM_CHECK_THROWS(std::runtime_error, ring.Upload(data.data(), 16));
+    }
+
+    void TestPoolFallback()
+    {
+        // Without MapNoOverwriteOnDynamicConstantBuffer, and without
+        // ID3D11DeviceContext1, the pool is used.
+        for (size_t i = 0; i < 2; ++i)
+        {
+            MockDevice device;
+            BindingContext context;
+            if (i == 0)
+            {
+                device.options.ConstantBufferOffsetting = TRUE;
+            }
+            else
+            {
+                SupportOffsetBinding(device);
+                context.supportsContext1 = false;
+            }
+
+            ConstantBufferRing ring(&device, &context, 1024);
+            DXM_CHECK(!ring.UsesOffsetBinding());
+            DXM_CHECK(device.numCreates == 0);
+
+            auto data = MakeData(4);
+            auto a0 = ring.Upload(data.data(), 100);
+            auto a1 = ring.Upload(data.data(), 200);
+            auto a2 = ring.Upload(data.data(), 300);
+            DXM_CHECK(device.numCreates == 3);
+            DXM_CHECK(a0.buffer != a1.buffer);
+            DXM_CHECK(a0.firstConstant == 0 && a0.numConstants == 16);
+            DXM_CHECK(a2.numConstants == 32);
+
+            // Every pooled buffer is written with a discard.
+            for (auto const& map : context.maps)
+            {
+                DXM_CHECK(map.type == D3D11_MAP_WRITE_DISCARD);
+            }
+            DXM_CHECK(std::memcmp(static_cast<MockBuffer*>(a2.buffer)->GetData().data(),
+                data.data(), 300) == 0);
+
+            ring.BindVS(0, a2);
+            DXM_CHECK(context.numBindings == 1 && context.numOffsetBindings == 0);
+            DXM_CHECK(context.buffer == a2.buffer);
+
+            // The next frame reuses the buffers of the bucket in order.
+            ring.NextFrame();
+            DXM_CHECK(ring.Upload(data.data(), 50).buffer == a0.buffer);
+            DXM_CHECK(ring.Upload(data.data(), 256).buffer == a1.buffer);
+            DXM_CHECK(ring.Upload(data.data(), 512).buffer == a2.buffer);
+            DXM_CHECK(device.numCreates == 3);
+
+            auto poolSizes = ring.GetPoolSizes();
+            DXM_CHECK(poolSizes.size() == 2);
+            DXM_CHECK(poolSizes[1] == 2 && poolSizes[2] == 1);
+        }
+    }
+
+    void TestPrewarm()
+    {
+        MockDevice device;
+        MockContext context;
+        auto data = MakeData(5);
+        {
+            ConstantBufferRing ring(&device, &context, 1024);
+            ring.Prewarm({ { 1, 3 }, { 4, 1 } });
+            DXM_CHECK(device.numCreates == 4);
+
+            // The steady-state frame creates no buffer.
+            for (size_t frame = 0; frame < 3; ++frame)
+            {
+                ring.Upload(data.data(), 16);
+                ring.Upload(data.data(), 16);
+                ring.Upload(data.data(), 16);
+                ring.Upload(data.data(), 1024);
+                ring.NextFrame();
+            }
+            DXM_CHECK(device.numCreates == 4);
+
+            // A creation failure is reported.
+            device.failAtCreate = device.numCreates;
+            ring.Upload(data.data(), 16);
+            ring.Upload(data.data(), 16);
+            ring.Upload(data.data(), 16);
+            DXM_CHECK_THROWS(std::runtime_error, ring.Upload(data.data(), 16));
+        }
+
+        // The pooled buffers were released.
+        DXM_CHECK(MockCom::NumLiveObjects() == 2);
+    }
+}
+
+int main()
+{
+    TestRing();
+    TestRingWrap();
+    TestRingMapFailure();
+    TestPoolFallback();
+    TestPrewarm();
+    DXM_CHECK(MockCom::NumLiveObjects() == 0);
+    return TestCheck::Report("ConstantBufferRingTest");
+}
@@ -0,0 +1,78 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "CullingKernels.h"
+#include "Benchmark.h"
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+using namespace dxm;
+
+// TransformBounds followed by CullBoxes and Compact over all instances, as
+// Application::CullInstances runs them each frame, for each SIMD path and
+// for 1, 2, 4 and 8 threads (up to the hardware threads). The time per
+// frame and the speedup over the scalar path on one thread are reported.
+
+int main(int argc, char** argv)
+{
+    Benchmark benchmark(argc, argv);
+
+    std::vector<CullingKernels::Path> paths = { CullingKernels::Path::SCALAR, CullingKernels::Path::SSE };
+    if (CullingKernels::GetBestPath() == CullingKernels::Path::AVX2)
+    {
+        paths.push_back(CullingKernels::Path::AVX2);
+    }
+    char const* pathNames[] = { "scalar", "sse", "avx2" };
+    size_t const maxThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+    std::printf("%10s %8s %8s %12s %10s\n", "instances", "path", "threads", "us/frame", "speedup");
+    for (size_t numInstances : { 10000, 100000, 1000000 })
+    {
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> position(-3.0f, 3.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        InstanceStore store;
+        store.Reserve(numInstances);
+        for (size_t i = 0; i < numInstances; ++i)
+        {
+            float const c = std::cos(angle(random)), s = std::sin(angle(random));
+            store.Add({ 0.0f, 0.0f, 0.0f }, { 0.1f, 0.2f, 0.3f },
+                { c, -s, 0, position(random), s, c, 0, position(random), 0, 0, 1, position(random) });
+        }
+
+        Frustum const frustum;
+        std::vector<uint8_t> visible(numInstances);
+        std::vector<uint32_t> indices(numInstances);
+        size_t const numFrames = std::max<size_t>(1, benchmark.Iterations(100000000 / numInstances));
+        double scalarMicroseconds = 0.0;
+        for (auto path : paths)
+        {
+            for (size_t numThreads = 1; numThreads <= std::min<size_t>(maxThreads, 8); numThreads *= 2)
+            {
+                ThreadPool pool(numThreads);
+                double const microseconds = 1e-3 * benchmark.Measure(numFrames, [&]()
+                {
+                    for (size_t frame = 0; frame < numFrames; ++frame)
+                    {
+                        CullingKernels::TransformBounds(pool, path, store);
+                        CullingKernels::CullBoxes(pool, path, frustum, store, visible.data());
+                        DoNotOptimize(CullingKernels::Compact(visible.data(), numInstances, indices.data()));
+                    }
+                });
+                if (path == CullingKernels::Path::SCALAR && numThreads == 1)
+                {
+                    scalarMicroseconds = microseconds;
+                }
+                std::printf("%10zu %8s %8zu %12.1f %10.2f\n", numInstances,
+                    pathNames[static_cast<size_t>(path)], numThreads, microseconds,
+                    scalarMicroseconds / microseconds);
+            }
+        }
+    }
+    return 0;
+}
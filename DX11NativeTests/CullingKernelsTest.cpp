@@ -0,0 +1,259 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "CullingKernels.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+using namespace dxm;
+
+namespace
+{
+    using Path = CullingKernels::Path;
+
+    // The paths supported by the processor.
+    std::vector<Path> GetPaths()
+    {
+        std::vector<Path> paths = { Path::SCALAR, Path::SSE };
+        if (CullingKernels::GetBestPath() == Path::AVX2)
+        {
+            paths.push_back(Path::AVX2);
+        }
+        return paths;
+    }
+
+    std::array<float, 12> const identity = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0 };
+
+    // Random instances in [-range,range]^3 with rotated, scaled boxes.
+    void AddRandomInstances(InstanceStore& store, size_t numInstances, float range,
+        std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> position(-range, range);
+        std::uniform_real_distribution<float> extent(0.01f, 0.5f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+        for (size_t i = 0; i < numInstances; ++i)
+        {
+            float const a = angle(random), s = scale(random);
+            float const c = s * std::cos(a), n = s * std::sin(a);
+            std::array<float, 12> const world =
+            {
+                c, -n, 0, position(random),
+                n, c, 0, position(random),
+                0, 0, s, position(random)
+            };
+            store.Add({ position(random), position(random), position(random) },
+                { extent(random), extent(random), extent(random) }, world);
+        }
+    }
+
+    // A perspective view-projection matrix with a 90-degree field of view,
+    // looking along +z from the origin, near 0.1 and far 100.
+    Frustum MakePerspectiveFrustum()
+    {
+        float const n = 0.1f, f = 100.0f;
+        Frustum frustum;
+        frustum.FromViewProjection({ 1, 0, 0, 0, 0, 1, 0, 0,
+            0, 0, f / (f - n), -n * f / (f - n), 0, 0, 1, 0 });
+        return frustum;
+    }
+
+    // The smallest signed distance of a bound to the planes, in double
+    // precision; the bound is visible when it is nonnegative.
+    double GetMargin(Frustum const& frustum, InstanceStore const& store, size_t i, bool isBox)
+    {
+        double margin = 1e30;
+        for (size_t p = 0; p < Frustum::NUM_PLANES; ++p)
+        {
+            auto const& plane = frustum.GetPlane(p);
+            double distance = plane[3], projected = 0.0;
+            for (size_t k = 0; k < 3; ++k)
+            {
+                distance += static_cast<double>(plane[k]) * store.GetCenter(k)[i];
+                projected += std::fabs(static_cast<double>(plane[k])) * store.GetExtent(k)[i];
+            }
+            margin = std::min(margin, distance + (isBox ? projected : store.GetRadius()[i]));
+        }
+        return margin;
+    }
+
+    void TestKnownBounds()
+    {
+        InstanceStore store;
+        store.Add({ 0, 0, 0.5f }, { 0.1f, 0.1f, 0.1f }, identity);     // inside
+        store.Add({ 5, 0, 0.5f }, { 0.1f, 0.1f, 0.1f }, identity);     // right of the volume
+        store.Add({ 1.05f, 0, 0.5f }, { 0.1f, 0.1f, 0.1f }, identity); // straddles x = 1
+        store.Add({ 0, 0, -0.5f }, { 0.1f, 0.1f, 0.1f }, identity);    // in front of the near plane
+
+        // Scaled by 10 and translated by 5 in x, the box reaches x = 1.
+        std::array<float, 12> world = { 10, 0, 0, 5, 0, 10, 0, 0, 0, 0, 1, 0 };
+        store.Add({ -0.4f, 0, 0.5f }, { 0.05f, 0.05f, 0.05f }, world);
+
+        Frustum const frustum;
+        for (Path path : GetPaths())
+        {
+            CullingKernels::TransformBounds(path, store, 0, store.GetNumInstances());
+            DXM_CHECK(std::fabs(store.GetCenter(0)[4] - 1.0f) < 1e-6f);
+            DXM_CHECK(std::fabs(store.GetExtent(0)[4] - 0.5f) < 1e-6f);
+            DXM_CHECK(std::fabs(store.GetRadius()[0] - std::sqrt(0.03f)) < 1e-6f);
+
+            uint8_t visible[5] = {};
+            CullingKernels::CullBoxes(path, frustum, store, 0, 5, visible);
+            DXM_CHECK(visible[0] == 1 && visible[1] == 0 && visible[2] == 1);
+            DXM_CHECK(visible[3] == 0 && visible[4] == 1);
+
+            CullingKernels::CullSpheres(path, frustum, store, 0, 5, visible);
+            DXM_CHECK(visible[0] == 1 && visible[1] == 0 && visible[2] == 1);
+            DXM_CHECK(visible[3] == 0 && visible[4] == 1);
+        }
+    }
+
+    // Each path agrees with a double-precision transform and with the
+    // scalar culling, except for bounds within rounding of a plane.
+    void TestPathsAgree()
+    {
+        std::mt19937 random(3);
+        InstanceStore store;
+        AddRandomInstances(store, 1003, 3.0f, random);
+        size_t const numInstances = store.GetNumInstances();
+        Frustum const frustums[2] = { Frustum(), MakePerspectiveFrustum() };
+
+        for (Path path : GetPaths())
+        {
+            CullingKernels::TransformBounds(path, store, 0, numInstances);
+            size_t numBad = 0;
+            for (size_t i = 0; i < numInstances; ++i)
+            {
+                double sqrLength = 0.0;
+                for (size_t r = 0; r < 3; ++r)
+                {
+                    double center = store.GetWorld(4 * r + 3)[i], extent = 0.0;
+                    for (size_t k = 0; k < 3; ++k)
+                    {
+                        double const m = store.GetWorld(4 * r + k)[i];
+                        center += m * store.GetLocalCenter(k)[i];
+                        extent += std::fabs(m) * store.GetLocalExtent(k)[i];
+                    }
+                    numBad += (std::fabs(center - store.GetCenter(r)[i]) > 1e-5 ? 1 : 0);
+                    numBad += (std::fabs(extent - store.GetExtent(r)[i]) > 1e-5 ? 1 : 0);
+                    sqrLength += extent * extent;
+                }
+                numBad += (std::fabs(std::sqrt(sqrLength) - store.GetRadius()[i]) > 1e-5 ? 1 : 0);
+            }
+            DXM_CHECK(numBad == 0);
+
+            for (auto const& frustum : frustums)
+            {
+                for (bool isBox : { false, true })
+                {
+                    std::vector<uint8_t> visible(numInstances, 0xCD);
+                    if (isBox)
+                    {
+                        CullingKernels::CullBoxes(path, frustum, store, 0, numInstances, visible.data());
+                    }
+                    else
+                    {
+                        CullingKernels::CullSpheres(path, frustum, store, 0, numInstances, visible.data());
+                    }
+
+                    size_t numVisible = 0, numWrong = 0;
+                    for (size_t i = 0; i < numInstances; ++i)
+                    {
+                        double const margin = GetMargin(frustum, store, i, isBox);
+                        if (std::fabs(margin) > 1e-4)
+                        {
+                            numWrong += (visible[i] != (margin >= 0.0 ? 1 : 0) ? 1 : 0);
+                        }
+                        numVisible += visible[i];
+                    }
+                    DXM_CHECK(numWrong == 0);
+                    DXM_CHECK(numVisible > 0 && numVisible < numInstances);
+                }
+            }
+        }
+    }
+
+    // A range [begin,end) that is not a multiple of the vector width, with
+    // its remainder processed by the scalar kernel, writes only its bytes.
+    void TestRanges()
+    {
+        std::mt19937 random(5);
+        InstanceStore store;
+        AddRandomInstances(store, 64, 1.5f, random);
+        Frustum const frustum;
+        CullingKernels::TransformBounds(Path::SCALAR, store, 0, 64);
+        std::vector<uint8_t> expected(64);
+        CullingKernels::CullBoxes(Path::SCALAR, frustum, store, 0, 64, expected.data());
+
+        for (Path path : GetPaths())
+        {
+            for (size_t begin : { 0, 1, 3, 9 })
+            {
+                for (size_t end : { begin, begin + 1, begin + 7, begin + 8, begin + 13, size_t(64) })
+                {
+                    std::vector<uint8_t> visible(64, 0xCD);
+                    CullingKernels::CullBoxes(path, frustum, store, begin, end, visible.data());
+                    bool correct = true;
+                    for (size_t i = 0; i < 64; ++i)
+                    {
+                        uint8_t const value = (i >= begin && i < end ? expected[i] : 0xCD);
+                        correct = correct && (visible[i] == value);
+                    }
+                    DXM_CHECK(correct);
+                }
+            }
+        }
+    }
+
+    void TestParallel()
+    {
+        std::mt19937 random(9);
+        InstanceStore store;
+        AddRandomInstances(store, 20001, 3.0f, random);
+        size_t const numInstances = store.GetNumInstances();
+        Frustum const frustum = MakePerspectiveFrustum();
+
+        InstanceStore serial = store;
+        Path const path = CullingKernels::GetBestPath();
+        CullingKernels::TransformBounds(path, serial, 0, numInstances);
+        std::vector<uint8_t> expected(numInstances);
+        CullingKernels::CullBoxes(path, frustum, serial, 0, numInstances, expected.data());
+
+        ThreadPool pool(4);
+        for (size_t grainSize : { 1000, 4096, 100000 })
+        {
+            CullingKernels::TransformBounds(pool, path, store, grainSize);
+            std::vector<uint8_t> visible(numInstances, 0xCD);
+            CullingKernels::CullBoxes(pool, path, frustum, store, visible.data(), grainSize);
+            DXM_CHECK(visible == expected);
+            DXM_CHECK(std::equal(store.GetRadius(), store.GetRadius() + numInstances,
+                serial.GetRadius()));
+        }
+    }
+
+    void TestCompact()
+    {
+        uint8_t const visible[10] = { 1, 0, 0, 1, 1, 0, 1, 0, 0, 1 };
+        uint32_t indices[10] = {};
+        DXM_CHECK(CullingKernels::Compact(visible, 10, indices) == 5);
+        DXM_CHECK(indices[0] == 0 && indices[1] == 3 && indices[2] == 4);
+        DXM_CHECK(indices[3] == 6 && indices[4] == 9);
+        DXM_CHECK(CullingKernels::Compact(visible, 0, indices) == 0);
+    }
+}
+
+int main()
+{
+    TestKnownBounds();
+    TestPathsAgree();
+    TestRanges();
+    TestParallel();
+    TestCompact();
+    return TestCheck::Report("CullingKernelsTest");
+}
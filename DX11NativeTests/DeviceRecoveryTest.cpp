@@ -0,0 +1,273 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "DeviceRecovery.h"
+#include "MockD3D11.h"
+#include "TestCheck.h"
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace dxm;
+
+namespace
+{
+    // The stages of Application: the device, a constant buffer and a
+    // render target, each created on the mock device of the first stage.
+    // Faults are injected with 'failDevice', 'throwTarget' and the
+    // failAtCreate of the mock device. The creations and releases are
+    // logged in order.
+    class Stages
+    {
+    public:
+        Stages(DeviceRecovery& recovery)
+            :
+            device(nullptr),
+            buffer(nullptr),
+            target(nullptr),
+            failDevice(false),
+            throwTarget(false),
+            failAtCreate(MockDevice::never),
+            log{}
+        {
+            recovery.AddStage("device",
+                [this]()
+                {
+                    if (failDevice)
+                    {
+                        return false;
+                    }
+                    device = new MockDevice();
+                    device->failAtCreate = failAtCreate;
+                    failAtCreate = MockDevice::never;
+                    log.push_back("+device");
+                    return true;
+                },
+                [this]()
+                {
+                    if (device != nullptr)
+                    {
+                        device->Release();
+                        device = nullptr;
+                        log.push_back("-device");
+                    }
+                });
+
+            recovery.AddStage("buffer",
+                [this]()
+                {
+                    D3D11_BUFFER_DESC desc{};
+                    desc.ByteWidth = 256;
+                    desc.Usage = D3D11_USAGE_DYNAMIC;
+                    desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+                    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+                    if (FAILED(device->CreateBuffer(&desc, nullptr, &buffer)))
+                    {
+                        return false;
+                    }
+                    log.push_back("+buffer");
+                    return true;
+                },
+                [this]()
+                {
+                    if (buffer != nullptr)
+                    {
+                        buffer->Release();
+                        buffer = nullptr;
+                        log.push_back("-buffer");
+                    }
+                });
+
+            recovery.AddStage("target",
+                [this]()
+                {
+                    if (throwTarget)
+                    {
+                        throw std::runtime_error("target");
+                    }
+                    D3D11_TEXTURE2D_DESC desc{};
+                    desc.Width = 64;
+                    desc.Height = 64;
+                    desc.MipLevels = 1;
+                    desc.ArraySize = 1;
+                    desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+                    desc.SampleDesc.Count = 1;
+                    desc.BindFlags = D3D11_BIND_RENDER_TARGET;
+                    if (FAILED(device->CreateTexture2D(&desc, nullptr, &target)))
+                    {
+                        return false;
+                    }
+                    log.push_back("+target");
+                    return true;
+                },
+                [this]()
+                {
+                    if (target != nullptr)
+                    {
+                        target->Release();
+                        target = nullptr;
+                        log.push_back("-target");
+                    }
+                });
+        }
+
+        MockDevice* device;
+        ID3D11Buffer* buffer;
+        ID3D11Texture2D* target;
+        bool failDevice, throwTarget;
+        size_t failAtCreate;
+        std::vector<std::string> log;
+    };
+
+    using State = DeviceRecovery::State;
+    using Log = std::vector<std::string>;
+
+    void TestCreate()
+    {
+        DeviceRecovery recovery;
+        Stages stages(recovery);
+        DXM_CHECK(recovery.GetState() == State::UNINITIALIZED);
+
+        // The render target fails on the device; the buffer and the
+        // device are released in reverse order.
+        stages.failAtCreate = 1;
+        DXM_CHECK(!recovery.Create());
+        DXM_CHECK(recovery.GetState() == State::UNINITIALIZED);
+        DXM_CHECK(recovery.GetFailedStage() == "target");
+        DXM_CHECK((stages.log == Log{ "+device", "+buffer", "-buffer", "-device" }));
+        DXM_CHECK(MockCom::NumLiveObjects() == 0);
+
+        stages.log.clear();
+        DXM_CHECK(recovery.Create());
+        DXM_CHECK(recovery.GetState() == State::OPERATIONAL);
+        DXM_CHECK(recovery.GetFailedStage().empty());
+        DXM_CHECK((stages.log == Log{ "+device", "+buffer", "+target" }));
+
+        // Without a loss, TryRecover does nothing.
+        stages.log.clear();
+        DXM_CHECK(recovery.TryRecover());
+        DXM_CHECK(stages.log.empty());
+        DXM_CHECK(recovery.GetNumRecoveries() == 0);
+
+        recovery.Release();
+        DXM_CHECK((stages.log == Log{ "-target", "-buffer", "-device" }));
+        DXM_CHECK(MockCom::NumLiveObjects() == 0);
+    }
+
+    void TestRecovery()
+    {
+        DeviceRecovery recovery;
+        Stages stages(recovery);
+        DXM_CHECK(recovery.Create());
+
+        // A loss before creation is ignored.
+        DeviceRecovery uninitialized;
+        uninitialized.NotifyLost();
+        DXM_CHECK(uninitialized.GetState() == State::UNINITIALIZED);
+        DXM_CHECK(!uninitialized.TryRecover());
+
+        stages.log.clear();
+        recovery.NotifyLost();
+        DXM_CHECK(recovery.GetState() == State::LOST);
+        DXM_CHECK(recovery.TryRecover());
+        DXM_CHECK(recovery.GetState() == State::OPERATIONAL);
+        DXM_CHECK((stages.log == Log{ "-target", "-buffer", "-device",
+            "+device", "+buffer", "+target" }));
+        DXM_CHECK(stages.device != nullptr && stages.device->numCreates == 2);
+        DXM_CHECK(recovery.GetNumRecoveries() == 1);
+        DXM_CHECK(recovery.GetNumFailedAttempts() == 0);
+        DXM_CHECK(MockCom::NumLiveObjects() == 3);
+
+        recovery.Release();
+        DXM_CHECK(MockCom::NumLiveObjects() == 0);
+    }
+
+    // Recovery fails while the device cannot be created, when a resource
+    // of the new device fails, and when a stage throws. The state stays
+    // LOST, nothing is leaked, and the next attempt starts over.
+    void TestFailedRecovery()
+    {
+        DeviceRecovery recovery;
+        Stages stages(recovery);
+        DXM_CHECK(recovery.Create());
+        recovery.NotifyLost();
+
+        stages.failDevice = true;
+        DXM_CHECK(!recovery.TryRecover());
+        DXM_CHECK(recovery.GetState() == State::LOST);
+        DXM_CHECK(recovery.GetFailedStage() == "device");
+        DXM_CHECK(MockCom::NumLiveObjects() == 0);
+        stages.failDevice = false;
+
+        stages.failAtCreate = 0;
+        DXM_CHECK(!recovery.TryRecover());
+        DXM_CHECK(recovery.GetFailedStage() == "buffer");
+        DXM_CHECK(MockCom::NumLiveObjects() == 0);
+
+        stages.throwTarget = true;
+        DXM_CHECK(!recovery.TryRecover());
+        DXM_CHECK(recovery.GetFailedStage() == "target");
+        DXM_CHECK(MockCom::NumLiveObjects() == 0);
+        stages.throwTarget = false;
+
+        DXM_CHECK(recovery.GetNumFailedAttempts() == 3);
+        DXM_CHECK(recovery.GetNumRecoveries() == 0);
+
+        DXM_CHECK(recovery.TryRecover());
+        DXM_CHECK(recovery.GetState() == State::OPERATIONAL);
+        DXM_CHECK(recovery.GetFailedStage().empty());
+        DXM_CHECK(recovery.GetNumRecoveries() == 1);
+        DXM_CHECK(MockCom::NumLiveObjects() == 3);
+
+        recovery.Release();
+        DXM_CHECK(MockCom::NumLiveObjects() == 0);
+    }
+
+    // The time to a recovered frame runs from the first NotifyLost to the
+    // first NotifyFrameCompleted after the recovery, and includes the
+    // failed attempts.
+    void TestRecoveryTime()
+    {
+        DeviceRecovery recovery;
+        Stages stages(recovery);
+        DXM_CHECK(recovery.Create());
+        recovery.NotifyFrameCompleted();
+        DXM_CHECK(recovery.GetLastRecoveryMilliseconds() == 0.0);
+
+        recovery.NotifyLost();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        recovery.NotifyLost();
+        stages.failDevice = true;
+        DXM_CHECK(!recovery.TryRecover());
+        stages.failDevice = false;
+        DXM_CHECK(recovery.TryRecover());
+
+        // Until a frame completes, the recovery time is not known.
+        DXM_CHECK(recovery.GetLastRecoveryMilliseconds() == 0.0);
+        recovery.NotifyFrameCompleted();
+        double const milliseconds = recovery.GetLastRecoveryMilliseconds();
+        DXM_CHECK(milliseconds >= 20.0);
+        DXM_CHECK(recovery.GetLastRebuildMilliseconds() <= milliseconds);
+
+        // Later frames do not change it.
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        recovery.NotifyFrameCompleted();
+        DXM_CHECK(recovery.GetLastRecoveryMilliseconds() == milliseconds);
+
+        recovery.Release();
+        DXM_CHECK(MockCom::NumLiveObjects() == 0);
+    }
+}
+
+int main()
+{
+    TestCreate();
+    TestRecovery();
+    TestFailedRecovery();
+    TestRecoveryTime();
+    return TestCheck::Report("DeviceRecoveryTest");
+}
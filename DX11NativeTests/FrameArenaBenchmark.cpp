@@ -0,0 +1,103 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "FrameArena.h"
+#include "Benchmark.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+using namespace dxm;
+
+// The transient allocations of a frame: 'numAllocations' arrays of
+// 'numElements' 16-byte elements, as a draw list or constant data would
+// use. Each strategy allocates and fills the arrays of a frame and then
+// releases them, and the time per frame is reported.
+
+namespace
+{
+    struct Element
+    {
+        float values[4];
+    };
+
+    void Fill(Element* elements, size_t numElements)
+    {
+        for (size_t i = 0; i < numElements; ++i)
+        {
+            elements[i].values[0] = static_cast<float>(i);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Benchmark benchmark(argc, argv);
+    size_t const numFrames = benchmark.Iterations(20000);
+
+    std::printf("%12s %12s %14s %14s %14s\n", "allocations", "elements",
+        "arena ns", "new[] ns", "vector ns");
+    for (size_t numAllocations : { 16, 256 })
+    {
+        for (size_t numElements : { 4, 64 })
+        {
+            FrameArena arena(numAllocations * (numElements * sizeof(Element) + 16), 2);
+            double const arenaNs = benchmark.Measure(numFrames, [&]()
+            {
+                for (size_t frame = 0; frame < numFrames; ++frame)
+                {
+                    arena.NextFrame();
+                    for (size_t i = 0; i < numAllocations; ++i)
+                    {
+                        Element* elements = arena.Allocate<Element>(numElements);
+                        Fill(elements, numElements);
+                        DoNotOptimize(elements);
+                    }
+                }
+            });
+
+            std::vector<std::unique_ptr<Element[]>> arrays(numAllocations);
+            double const newNs = benchmark.Measure(numFrames, [&]()
+            {
+                for (size_t frame = 0; frame < numFrames; ++frame)
+                {
+                    for (size_t i = 0; i < numAllocations; ++i)
+                    {
+                        arrays[i].reset(new Element[numElements]);
+                        Fill(arrays[i].get(), numElements);
+                        DoNotOptimize(arrays[i]);
+                    }
+                    for (auto& array : arrays)
+                    {
+                        array.reset();
+                    }
+                }
+            });
+
+            std::vector<std::vector<Element>> vectors(numAllocations);
+            double const vectorNs = benchmark.Measure(numFrames, [&]()
+            {
+                for (size_t frame = 0; frame < numFrames; ++frame)
+                {
+                    for (size_t i = 0; i < numAllocations; ++i)
+                    {
+                        std::vector<Element> elements(numElements);
+                        Fill(elements.data(), numElements);
+                        vectors[i] = std::move(elements);
+                    }
+                    for (auto& elements : vectors)
+                    {
+                        elements = std::vector<Element>{};
+                    }
+                }
+            });
+
+            std::printf("%12zu %12zu %14.1f %14.1f %14.1f\n", numAllocations,
+                numElements, arenaNs, newNs, vectorNs);
+        }
+    }
+    return 0;
+}
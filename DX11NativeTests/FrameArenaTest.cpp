@@ -0,0 +1,169 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "FrameArena.h"
+#include "TestCheck.h"
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+using namespace dxm;
+
+namespace
+{
+    bool IsAligned(void const* pointer, size_t alignment)
+    {
+        return reinterpret_cast<uintptr_t>(pointer) % alignment == 0;
+    }
+
+    void TestConstruction()
+    {
+        DXM_CHECK_THROWS(std::invalid_argument, FrameArena(0, 2));
+        DXM_CHECK_THROWS(std::invalid_argument, FrameArena(1024, 0));
+
+        FrameArena arena(1024, 3);
+        DXM_CHECK(arena.GetBytesPerFrame() == 1024);
+        DXM_CHECK(arena.GetNumFramesInFlight() == 3);
+        DXM_CHECK(arena.GetCurrentFrame() == 0);
+        DXM_CHECK(arena.GetBytesUsed() == 0);
+    }
+
+    void TestAlignment()
+    {
+        FrameArena arena(4096, 2);
+        void* p0 = arena.Allocate(1);
+        DXM_CHECK(IsAligned(p0, FrameArena::defaultAlignment));
+        void* p1 = arena.Allocate(3, 4);
+        DXM_CHECK(IsAligned(p1, 4));
+        void* p2 = arena.Allocate(8, 256);
+        DXM_CHECK(IsAligned(p2, 256));
+        DXM_CHECK(static_cast<uint8_t*>(p1) > static_cast<uint8_t*>(p0));
+        DXM_CHECK(static_cast<uint8_t*>(p2) > static_cast<uint8_t*>(p1));
+
+        DXM_CHECK_THROWS(std::invalid_argument, arena.Allocate(8, 0));
+        DXM_CHECK_THROWS(std::invalid_argument, arena.Allocate(8, 24));
+
+        struct alignas(64) Wide
+        {
+            float values[16];
+        };
+        DXM_CHECK(IsAligned(arena.Allocate<Wide>(2), 64));
+    }
+
+    void TestOverflow()
+    {
+        FrameArena arena(256, 2);
+        DXM_CHECK(arena.Allocate(256, 1) != nullptr);
+        DXM_CHECK(arena.GetBytesUsed() == 256);
+        DXM_CHECK_THROWS(std::runtime_error, arena.Allocate(1, 1));
+
+        arena.NextFrame();
+        DXM_CHECK_THROWS(std::runtime_error, arena.Allocate(257, 1));
+        DXM_CHECK(arena.GetBytesUsed() == 0);
+
+        // The byte count of the typed allocation overflows size_t; without
+        // the check it would wrap to a small allocation.
+        DXM_CHECK_THROWS(std::runtime_error, arena.Allocate<uint64_t>(SIZE_MAX / 4));
+        DXM_CHECK_THROWS(std::runtime_error, arena.Allocate<uint32_t>(SIZE_MAX / 2 + 1));
+        DXM_CHECK_THROWS(std::runtime_error, arena.Allocate(SIZE_MAX, 16));
+        DXM_CHECK(arena.GetBytesUsed() == 0);
+    }
+
+    void TestFrames()
+    {
+        FrameArena arena(1024, 2);
+        uint8_t* frame0 = static_cast<uint8_t*>(arena.Allocate(100));
+        DXM_CHECK(arena.GetBytesUsed() == 100);
+
+        arena.NextFrame();
+        DXM_CHECK(arena.GetCurrentFrame() == 1);
+        DXM_CHECK(arena.GetBytesUsed() == 0);
+        uint8_t* frame1 = static_cast<uint8_t*>(arena.Allocate(300));
+        DXM_CHECK(frame1 != frame0);
+
+        // The third frame reuses the region of the first.
+        arena.NextFrame();
+        DXM_CHECK(arena.GetCurrentFrame() == 0);
+        DXM_CHECK(static_cast<uint8_t*>(arena.Allocate(1)) == frame0);
+        DXM_CHECK(arena.GetHighWaterMark() == 300);
+
+        arena.Reset();
+        DXM_CHECK(arena.GetCurrentFrame() == 0);
+        DXM_CHECK(arena.GetBytesUsed() == 0);
+    }
+
+    void TestReserve()
+    {
+        FrameArena arena(128, 2);
+        arena.NextFrame();
+        arena.Allocate(64);
+
+        // Not growing keeps the current allocations.
+        arena.Reserve(64);
+        DXM_CHECK(arena.GetBytesPerFrame() == 128);
+        DXM_CHECK(arena.GetBytesUsed() == 64);
+        DXM_CHECK(arena.GetCurrentFrame() == 1);
+
+        arena.Reserve(1000);
+        DXM_CHECK(arena.GetBytesPerFrame() == 1000);
+        DXM_CHECK(arena.GetBytesUsed() == 0);
+        DXM_CHECK(arena.GetCurrentFrame() == 0);
+        uint8_t* bytes = arena.Allocate<uint8_t>(1000);
+        bytes[0] = 1;
+        bytes[999] = 2;
+        arena.NextFrame();
+        DXM_CHECK(arena.Allocate<uint8_t>(1000) != bytes);
+        arena.NextFrame();
+    }
+
+    void TestAllocatorAdapter()
+    {
+        FrameArena arena(64 * 1024, 2);
+        std::vector<uint64_t, FrameArenaAllocator<uint64_t>> keys(
+            (FrameArenaAllocator<uint64_t>(arena)));
+        for (uint64_t i = 0; i < 1000; ++i)
+        {
+            keys.push_back(i * i);
+        }
+
+        bool correct = true;
+        for (uint64_t i = 0; i < 1000; ++i)
+        {
+            correct = correct && (keys[i] == i * i);
+        }
+        DXM_CHECK(correct);
+        DXM_CHECK(arena.GetBytesUsed() >= 1000 * sizeof(uint64_t));
+
+        FrameArena other(1024, 1);
+        DXM_CHECK(FrameArenaAllocator<int>(arena) == FrameArenaAllocator<float>(arena));
+        DXM_CHECK(FrameArenaAllocator<int>(arena) != FrameArenaAllocator<int>(other));
+    }
+
+#if defined(_DEBUG)
+    void TestGuard()
+    {
+        FrameArena arena(64, 2);
+        uint8_t* bytes = arena.Allocate<uint8_t>(64);
+        bytes[64] = 0;  // Deliberately write past the end of the region.
+        arena.NextFrame();
+        DXM_CHECK_THROWS(std::runtime_error, arena.NextFrame());
+    }
+#endif
+}
+
+int main()
+{
+    TestConstruction();
+    TestAlignment();
+    TestOverflow();
+    TestFrames();
+    TestReserve();
+    TestAllocatorAdapter();
+#if defined(_DEBUG)
+    TestGuard();
+#endif
+    return TestCheck::Report("FrameArenaTest");
+}
@@ -0,0 +1,229 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "Application.h"
+#include "MockD3D11.h"
+#include "Benchmark.h"
+#include <d3dcompiler.h>
+#include <cstdlib>
+#include <string>
+using namespace dxm;
+
+// The CPU cost of Application::RenderFrame per frame loop preset, on a
+// software device: the mock device and context, whose calls do no GPU work
+// and whose queries complete at once, so the times are those of the loop
+// itself. PER_FRAME_QUERY is STANDARD with the event query created in
+// each frame, the sync that RenderFrame had before the presets.
+// The frames draw no scene into a 1920x1080 shared surface. The columns
+// are the nanoseconds per frame with the optional features off, with the
+// overlay, the ToneMap pass and tile caching on (a preset ignores those
+// that its policies disable; one 96x96 region is invalidated per frame),
+// and with the features off and COM accounting on. 'created' is the
+// number of COM objects created per frame in the accounting run, from the
+// sites and frames that ComAccounting records for every preset.
+
+// The shaders compile to empty blobs.
+HRESULT D3DCompile(void const*, SIZE_T, char const*, void const*, void*, char const*,
+    char const*, UINT, UINT, ID3DBlob** code, ID3DBlob** errors)
+{
+    *code = new ID3DBlob();
+    *errors = nullptr;
+    return S_OK;
+}
+
+// The device is created on the default adapter.
+HRESULT CreateDXGIFactory1(REFIID, void** factory)
+{
+    *factory = nullptr;
+    return E_FAIL;
+}
+
+namespace
+{
+    UINT constexpr width = 1920, height = 1080;
+
+    // The D3D11 side of the shared surface. OpenSharedResource returns it
+    // as an ID3D11Resource, which is queried for ID3D11Texture2D.
+    class SharedTexture : public MockTexture2D
+    {
+    public:
+        SharedTexture(D3D11_TEXTURE2D_DESC const& desc)
+            :
+            MockTexture2D(desc, nullptr)
+        {
+        }
+
+        virtual HRESULT QueryInterface(REFIID riid, void** object) override
+        {
+            if (riid == __uuidof(ID3D11Texture2D))
+            {
+                AddRef();
+                *object = static_cast<ID3D11Texture2D*>(this);
+                return S_OK;
+            }
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+    };
+
+    class SoftwareDevice : public MockDevice
+    {
+    public:
+        virtual HRESULT OpenSharedResource(HANDLE, REFIID, void** resource) override
+        {
+            D3D11_TEXTURE2D_DESC desc{};
+            desc.Width = width;
+            desc.Height = height;
+            desc.MipLevels = 1;
+            desc.ArraySize = 1;
+            desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+            desc.Usage = D3D11_USAGE_DEFAULT;
+            desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+            *resource = static_cast<ID3D11Resource*>(new SharedTexture(desc));
+            return S_OK;
+        }
+    };
+
+    // MockContext without the records of the calls, which would grow with
+    // the number of frames.
+    class SoftwareContext : public MockContext
+    {
+    public:
+        virtual HRESULT Map(ID3D11Resource* resource, UINT subresource, D3D11_MAP type,
+            UINT flags, D3D11_MAPPED_SUBRESOURCE* mapped) override
+        {
+            HRESULT const hr = MockContext::Map(resource, subresource, type, flags, mapped);
+            maps.clear();
+            return hr;
+        }
+
+        virtual void UpdateSubresource(ID3D11Resource*, UINT, D3D11_BOX const*,
+            void const*, UINT, UINT) override
+        {
+        }
+
+        virtual void CopySubresourceRegion(ID3D11Resource*, UINT, UINT, UINT, UINT,
+            ID3D11Resource*, UINT, D3D11_BOX const*) override
+        {
+        }
+    };
+
+    // The WPF side of the shared surface (the back buffer of the D3DImage).
+    class SharedSurface : public IDXGIResource
+    {
+    public:
+        virtual HRESULT QueryInterface(REFIID riid, void** object) override
+        {
+            if (riid == __uuidof(IDXGIResource))
+            {
+                AddRef();
+                *object = static_cast<IDXGIResource*>(this);
+                return S_OK;
+            }
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        virtual HRESULT GetSharedHandle(HANDLE* handle) override
+        {
+            *handle = this;
+            return S_OK;
+        }
+    };
+
+    void Check(std::string const& exceptionMessage)
+    {
+        if (exceptionMessage != "")
+        {
+            std::printf("%s\n", exceptionMessage.c_str());
+            std::exit(1);
+        }
+    }
+}
+
+HRESULT D3D11CreateDevice(IDXGIAdapter*, D3D_DRIVER_TYPE, HMODULE, UINT,
+    D3D_FEATURE_LEVEL const* featureLevels, UINT, UINT, ID3D11Device** device,
+    D3D_FEATURE_LEVEL* featureLevel, ID3D11DeviceContext** context)
+{
+    *device = new SoftwareDevice();
+    *featureLevel = featureLevels[0];
+    *context = new SoftwareContext();
+    return S_OK;
+}
+
+int main(int argc, char** argv)
+{
+    Benchmark benchmark(argc, argv);
+    size_t const numFrames = benchmark.Iterations(20000) + 1;
+    SharedSurface surface;
+
+    std::string exceptionMessage;
+    Application* application = Application::Create(exceptionMessage);
+    Check(exceptionMessage);
+
+    std::printf("%10s %12s %12s %12s %8s\n", "preset", "off ns", "features ns",
+        "accounting ns", "created");
+    struct Preset
+    {
+        char const* name;
+        FrameLoopPreset preset;
+    };
+    Preset const presets[] =
+    {
+        { "standard", FrameLoopPreset::STANDARD },
+        { "fast", FrameLoopPreset::FAST },
+        { "composed", FrameLoopPreset::COMPOSED },
+        { "per-frame", FrameLoopPreset::PER_FRAME_QUERY }
+    };
+    for (auto const& preset : presets)
+    {
+        Check(Application::SetFrameLoopPreset(application, preset.preset));
+        Check(Application::RenderFrame(application, &surface, true));
+
+        auto run = [&](bool features)
+        {
+            Check(Application::SetOverlayVisible(application, features));
+            Check(Application::SetPostProcessPass(application, "ToneMap", features, nullptr));
+            Check(Application::SetTileCacheEnabled(application, features));
+            return benchmark.Measure(numFrames, [&]()
+            {
+                for (size_t frame = 0; frame < numFrames; ++frame)
+                {
+                    if (features)
+                    {
+                        uint32_t const x = static_cast<uint32_t>(frame % (width - 96));
+                        Check(Application::InvalidateRegion(application, x, 500, 96, 96));
+                    }
+                    Check(Application::RenderFrame(application, &surface, false));
+                }
+            });
+        };
+        double const off = run(false);
+
+        ComAccounting::Reset();
+        ComAccounting::Enable(true);
+        double const accounting = run(false);
+        ComAccounting::Enable(false);
+        size_t numCreated = 0;
+        for (auto const& site : ComAccounting::GetSites())
+        {
+            if (site.operation == ComAccounting::Operation::CREATE)
+            {
+                numCreated += site.count;
+            }
+        }
+        double const created = static_cast<double>(numCreated) /
+            static_cast<double>(ComAccounting::GetNumFrames());
+        double const features = run(true);
+
+        std::printf("%10s %12.0f %12.0f %12.0f %8.2f\n", preset.name, off, features,
+            accounting, created);
+    }
+
+    Check(Application::Destroy(application));
+    return 0;
+}
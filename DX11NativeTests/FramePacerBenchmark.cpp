@@ -0,0 +1,51 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "FramePacer.h"
+#include "Benchmark.h"
+using namespace dxm;
+
+// The accuracy of FramePacer::Wait at 30, 60 and 144 frames per second,
+// with the default final spin and with no spin (the sleep alone, which
+// shows the accuracy of the timer). Each row paces two seconds of frames.
+// 'mean ms' is the mean interval between wake-ups, 'jitter us' the
+// root-mean-square deviation of the intervals from the target, 'max us'
+// the largest deviation and 'missed' the deadlines skipped. The frames do
+// no work, so the intervals are those of the wait itself.
+
+int main(int argc, char** argv)
+{
+    Benchmark benchmark(argc, argv);
+    double const seconds = (benchmark.IsQuick() ? 0.05 : 2.0);
+    double const rates[] = { 30.0, 60.0, 144.0 };
+
+    // The default spin depends on the resolution of the timer.
+    FramePacer pacer;
+    double const spins[] = { pacer.GetSpinSeconds(), 0.0 };
+    std::printf("%6s %10s %10s %10s %10s %8s\n", "rate", "spin us", "mean ms",
+        "jitter us", "max us", "missed");
+    for (auto rate : rates)
+    {
+        for (auto spinSeconds : spins)
+        {
+            FramePacer run(rate);
+            run.SetSpinSeconds(spinSeconds);
+            size_t const numFrames = static_cast<size_t>(seconds * rate) + 2;
+            for (size_t frame = 0; frame < numFrames; ++frame)
+            {
+                DoNotOptimize(run.Wait());
+            }
+
+            auto const& statistics = run.GetStatistics();
+            std::printf("%6.0f %10.0f %10.3f %10.1f %10.1f %8llu\n", rate,
+                1e6 * spinSeconds, 1e3 * statistics.GetMeanInterval(),
+                1e6 * statistics.GetJitter(), 1e6 * statistics.GetMaxDeviation(),
+                static_cast<unsigned long long>(run.GetNumMissed()));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "FramePacer.h"
+#include "TestCheck.h"
+#include <chrono>
+#include <cmath>
+#include <thread>
+using namespace dxm;
+
+namespace
+{
+    bool Near(double value, double expected, double tolerance = 1e-12)
+    {
+        return std::fabs(value - expected) <= tolerance;
+    }
+
+    void Sleep(double seconds)
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    }
+
+    void TestIntervalStatistics()
+    {
+        FrameIntervalStatistics statistics(0.1);
+        DXM_CHECK(statistics.GetNumIntervals() == 0);
+        DXM_CHECK(statistics.GetMeanInterval() == 0.0 && statistics.GetJitter() == 0.0);
+
+        // The first event starts the first interval.
+        statistics.Record(1.0);
+        DXM_CHECK(statistics.GetNumIntervals() == 0);
+        statistics.Record(1.1);
+        statistics.Record(1.3);
+        statistics.Record(1.35);
+        DXM_CHECK(statistics.GetNumIntervals() == 3);
+        DXM_CHECK(Near(statistics.GetLastInterval(), 0.05));
+        DXM_CHECK(Near(statistics.GetMeanInterval(), 0.35 / 3.0));
+
+        // The deviations from the target are 0, 0.1 and -0.05.
+        DXM_CHECK(Near(statistics.GetJitter(), std::sqrt((0.01 + 0.0025) / 3.0)));
+        DXM_CHECK(Near(statistics.GetMaxDeviation(), 0.1));
+
+        statistics.Reset(0.05);
+        DXM_CHECK(statistics.GetTargetInterval() == 0.05);
+        DXM_CHECK(statistics.GetNumIntervals() == 0 && statistics.GetMaxDeviation() == 0.0);
+        statistics.Record(2.0);
+        statistics.Record(2.05);
+        DXM_CHECK(statistics.GetNumIntervals() == 1 && Near(statistics.GetJitter(), 0.0, 1e-9));
+    }
+
+    // The deadlines are first + n * interval. A wake-up is at or after its
+    // deadline and, on an unloaded machine, well within a quarter interval
+    // of it.
+    class Schedule
+    {
+    public:
+        Schedule(double first, double interval)
+            :
+            mFirst(first),
+            mInterval(interval)
+        {
+        }
+
+        uint64_t GetFrame(double seconds) const
+        {
+            return static_cast<uint64_t>(std::floor((seconds - mFirst) / mInterval + 1e-9));
+        }
+
+        bool OnDeadline(double seconds) const
+        {
+            double const phase = seconds - mFirst -
+                static_cast<double>(GetFrame(seconds)) * mInterval;
+            return phase > -1e-9 && phase < 0.25 * mInterval;
+        }
+
+    private:
+        double mFirst, mInterval;
+    };
+
+    void TestRate()
+    {
+        // A rate of 0 does not wait.
+        FramePacer pacer;
+        DXM_CHECK(pacer.GetRate() == 0.0);
+        double const start = FramePacer::GetSeconds();
+        for (int i = 0; i < 10; ++i)
+        {
+            (void)pacer.Wait();
+        }
+        DXM_CHECK(FramePacer::GetSeconds() - start < 0.01);
+        DXM_CHECK(pacer.GetStatistics().GetNumIntervals() == 0);
+
+        // The first Wait after SetRate returns at once and the next ones
+        // are on the deadlines.
+        double const interval = 0.02;
+        pacer.SetRate(1.0 / interval);
+        DXM_CHECK(pacer.GetStatistics().GetTargetInterval() == interval);
+        double const first = pacer.Wait();
+        DXM_CHECK(first - start < 0.01);
+        Schedule const schedule(first, interval);
+        for (uint64_t frame = 1; frame <= 5; ++frame)
+        {
+            double const now = pacer.Wait();
+            DXM_CHECK(schedule.OnDeadline(now) && schedule.GetFrame(now) == frame);
+        }
+        DXM_CHECK(pacer.GetNumMissed() == 0);
+        DXM_CHECK(pacer.GetStatistics().GetNumIntervals() == 5);
+        DXM_CHECK(Near(pacer.GetStatistics().GetMeanInterval(), interval, 0.25 * interval));
+
+        // Negative spins are clamped.
+        pacer.SetSpinSeconds(-1.0);
+        DXM_CHECK(pacer.GetSpinSeconds() == 0.0);
+    }
+
+    // A Wait that is late by a full interval or more skips the missed
+    // deadlines and wakes on the next deadline of the original schedule,
+    // so the lateness does not shift the later frames. A Wait that is late
+    // by less than an interval returns at once and the schedule continues.
+    void TestMissedDeadlines()
+    {
+        double const interval = 0.02;
+        FramePacer pacer(1.0 / interval);
+        double const first = pacer.Wait();
+        Schedule const schedule(first, interval);
+
+        // Frame 1 is due at 'interval'; the call comes after 3.5.
+        Sleep(3.5 * interval);
+        double now = pacer.Wait();
+        uint64_t const frame = schedule.GetFrame(now);
+        DXM_CHECK(schedule.OnDeadline(now));
+        DXM_CHECK(frame >= 4 && pacer.GetNumMissed() == frame - 1);
+
+        for (uint64_t i = 1; i <= 3; ++i)
+        {
+            now = pacer.Wait();
+            DXM_CHECK(schedule.OnDeadline(now) && schedule.GetFrame(now) == frame + i);
+        }
+
+        // Late by half an interval: nothing is skipped, and the next frame
+        // is on the schedule again.
+        uint64_t const numMissed = pacer.GetNumMissed();
+        Sleep(1.5 * interval);
+        now = pacer.Wait();
+        DXM_CHECK(pacer.GetNumMissed() == numMissed);
+        now = pacer.Wait();
+        DXM_CHECK(schedule.OnDeadline(now) && schedule.GetFrame(now) == frame + 5);
+
+        // SetRate restarts the schedule and the counts.
+        pacer.SetRate(1.0 / interval);
+        DXM_CHECK(pacer.GetNumMissed() == 0 && pacer.GetStatistics().GetNumIntervals() == 0);
+    }
+}
+
+int main()
+{
+    TestIntervalStatistics();
+    TestRate();
+    TestMissedDeadlines();
+    return TestCheck::Report("FramePacerTest");
+}
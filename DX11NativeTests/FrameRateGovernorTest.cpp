@@ -0,0 +1,309 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "FrameRateGovernor.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <random>
+#include <stdexcept>
+using namespace dxm;
+
+namespace
+{
+    using WindowState = FrameRateGovernor::WindowState;
+
+    WindowState const active = { true, false, false, false, 0.0 };
+
+    // A simulated clock that issues render requests at the display rate,
+    // optionally with jitter, as the WPF Rendering event does.
+    class Simulation
+    {
+    public:
+        Simulation(FrameRateGovernor& governor, double requestRate = 60.0)
+            :
+            mGovernor(governor),
+            mInterval(1.0 / requestRate),
+            mJitter(0.0),
+            mRandom(7),
+            mTime(0.0)
+        {
+        }
+
+        // The requests are spaced by the interval plus or minus 'jitter'
+        // seconds.
+        void SetJitter(double jitter)
+        {
+            mJitter = jitter;
+        }
+
+        // Issue requests for 'seconds' and return the number rendered.
+        // The idle time of the state advances with the clock from its
+        // initial value, as when there is no input.
+        size_t Run(WindowState state, double seconds)
+        {
+            size_t numRendered = 0;
+            double const end = mTime + seconds;
+            std::uniform_real_distribution<double> jitter(-mJitter, mJitter);
+            double const idleStart = mTime - state.idleSeconds;
+            while (mTime < end)
+            {
+                state.idleSeconds = mTime - idleStart;
+                numRendered += (mGovernor.OnRequest(state, mTime + jitter(mRandom)) ? 1 : 0);
+                mTime += mInterval;
+            }
+            return numRendered;
+        }
+
+        // One request at the current time.
+        bool Step(WindowState const& state)
+        {
+            bool const rendered = mGovernor.OnRequest(state, mTime);
+            mTime += mInterval;
+            return rendered;
+        }
+
+        void Skip(double seconds)
+        {
+            mTime += seconds;
+        }
+
+    private:
+        FrameRateGovernor& mGovernor;
+        double mInterval, mJitter;
+        std::mt19937 mRandom;
+        double mTime;
+    };
+
+    WindowState With(bool focused, bool occluded, bool minimized, bool onBattery,
+        double idleSeconds)
+    {
+        return WindowState{ focused, occluded, minimized, onBattery, idleSeconds };
+    }
+
+    void TestTargetRate()
+    {
+        FrameRateGovernor governor;
+        DXM_CHECK(governor.GetTargetRate(active) == 60.0);
+        DXM_CHECK(governor.GetTargetRate(With(false, false, false, false, 0.0)) == 30.0);
+        DXM_CHECK(governor.GetTargetRate(With(true, false, false, true, 0.0)) == 30.0);
+        DXM_CHECK(governor.GetTargetRate(With(true, false, false, false, 30.0)) == 10.0);
+        DXM_CHECK(governor.GetTargetRate(With(true, false, false, false, 29.9)) == 60.0);
+        DXM_CHECK(governor.GetTargetRate(With(true, true, false, false, 0.0)) == 1.0);
+        DXM_CHECK(governor.GetTargetRate(With(false, true, true, true, 100.0)) == 0.0);
+
+        // The smallest cap applies.
+        FrameRateGovernor::Policy policy = FrameRateGovernor::DefaultPolicy();
+        policy.batteryRate = 20.0;
+        policy.unfocusedRate = 40.0;
+        governor.SetPolicy(policy);
+        DXM_CHECK(governor.GetTargetRate(With(false, false, false, true, 0.0)) == 20.0);
+        DXM_CHECK(governor.GetTargetRate(With(false, false, false, true, 60.0)) == 10.0);
+    }
+
+    // After the ramp has settled, each state renders at its target rate.
+    void TestSteadyRates()
+    {
+        struct Case
+        {
+            WindowState state;
+            size_t expected;
+        };
+        Case const cases[] =
+        {
+            { active, 600 },
+            { With(false, false, false, false, 0.0), 300 },
+            { With(true, false, false, true, 0.0), 300 },
+            { With(true, true, false, false, 0.0), 10 },
+            { With(true, false, true, false, 0.0), 0 }
+        };
+
+        for (auto const& c : cases)
+        {
+            FrameRateGovernor governor;
+            Simulation simulation(governor);
+            (void)simulation.Run(active, 1.0);
+            (void)simulation.Run(c.state, 5.0);
+            size_t const numRendered = simulation.Run(c.state, 10.0);
+            DXM_CHECK(numRendered + 1 >= c.expected && numRendered <= c.expected + 1);
+        }
+
+        // The idle time grows with the clock; after 30 seconds without
+        // input the rate drops to the idle rate.
+        FrameRateGovernor governor;
+        Simulation simulation(governor);
+        DXM_CHECK(simulation.Run(active, 20.0) == 1200);
+        (void)simulation.Run(With(true, false, false, false, 20.0), 15.0);
+        size_t const numIdle = simulation.Run(With(true, false, false, false, 35.0), 10.0);
+        DXM_CHECK(numIdle >= 99 && numIdle <= 101);
+    }
+
+    // A rate that does not divide the request rate is met on average, also
+    // when the requests jitter by a fraction of the interval.
+    void TestNonDivisorRates()
+    {
+        for (double rate : { 24.0, 25.0, 45.0 })
+        {
+            for (double jitter : { 0.0, 0.002 })
+            {
+                FrameRateGovernor::Policy policy = FrameRateGovernor::DefaultPolicy();
+                policy.unfocusedRate = rate;
+                FrameRateGovernor governor(policy);
+                Simulation simulation(governor);
+                simulation.SetJitter(jitter);
+                (void)simulation.Run(With(false, false, false, false, 0.0), 5.0);
+                double const achieved = static_cast<double>(
+                    simulation.Run(With(false, false, false, false, 0.0), 20.0)) / 20.0;
+                DXM_CHECK(std::fabs(achieved - rate) <= 0.1);
+            }
+        }
+    }
+
+    // A lower target is approached with the ramp time constant; a higher
+    // target applies at once and the next request renders.
+    void TestRampAndWake()
+    {
+        FrameRateGovernor governor;
+        Simulation simulation(governor);
+        (void)simulation.Run(active, 1.0);
+
+        WindowState const unfocused = With(false, false, false, false, 0.0);
+        double previous = governor.GetCurrentRate();
+        bool decreasing = true;
+        for (size_t i = 0; i < 30; ++i)
+        {
+            (void)simulation.Step(unfocused);
+            decreasing = decreasing && governor.GetCurrentRate() <= previous;
+            previous = governor.GetCurrentRate();
+        }
+        DXM_CHECK(decreasing);
+
+        // After 0.5 seconds (one time constant), the rate is about
+        // 30 + 30/e.
+        DXM_CHECK(std::fabs(governor.GetCurrentRate() - (30.0 + 30.0 / std::exp(1.0))) < 1.0);
+
+        // The rate snaps to the target once it is within half a frame per
+        // second, after 0.5 * ln(60) seconds.
+        (void)simulation.Run(unfocused, 1.6);
+        DXM_CHECK(governor.GetCurrentRate() == 30.0);
+
+        // Regaining focus renders the next request.
+        (void)simulation.Step(unfocused);
+        DXM_CHECK(simulation.Step(active));
+        DXM_CHECK(governor.GetCurrentRate() == 60.0);
+
+        // Input (a decreasing idle time) renders the next request even when
+        // the target does not change.
+        (void)simulation.Run(unfocused, 3.0);
+        size_t numWoken = 0;
+        for (size_t i = 0; i < 10; ++i)
+        {
+            // Two requests between frames at 30 fps.
+            (void)simulation.Step(With(false, false, false, false, 5.0));
+            numWoken += (simulation.Step(With(false, false, false, false, 1.0)) ? 1 : 0);
+            (void)simulation.Step(With(false, false, false, false, 5.0));
+        }
+        DXM_CHECK(numWoken == 10);
+
+        // Without a ramp, the rate drops at once.
+        FrameRateGovernor::Policy policy = FrameRateGovernor::DefaultPolicy();
+        policy.rampSeconds = 0.0;
+        FrameRateGovernor immediate(policy);
+        Simulation direct(immediate);
+        (void)direct.Run(active, 1.0);
+        (void)direct.Step(unfocused);
+        DXM_CHECK(immediate.GetCurrentRate() == 30.0);
+    }
+
+    // A stall longer than the frame interval is not caught up by a burst.
+    void TestStall()
+    {
+        FrameRateGovernor governor;
+        Simulation simulation(governor);
+        WindowState const unfocused = With(false, false, false, false, 0.0);
+        (void)simulation.Run(active, 1.0);
+        (void)simulation.Run(unfocused, 5.0);
+
+        simulation.Skip(1.0);
+        size_t numRendered = 0, numFirst = 0;
+        for (size_t i = 0; i < 6; ++i)
+        {
+            bool const rendered = simulation.Step(unfocused);
+            numRendered += (rendered ? 1 : 0);
+            numFirst += (i < 2 && rendered ? 1 : 0);
+        }
+        DXM_CHECK(numFirst == 1);
+        DXM_CHECK(numRendered == 3);
+    }
+
+    void TestStatistics()
+    {
+        FrameRateGovernor governor;
+        Simulation simulation(governor);
+        size_t const numRendered = simulation.Run(active, 1.0) +
+            simulation.Run(With(true, true, false, false, 0.0), 9.0);
+        auto const& statistics = governor.GetStatistics();
+        DXM_CHECK(statistics.numRequests == 600);
+        DXM_CHECK(statistics.numRendered == numRendered);
+        DXM_CHECK(governor.GetNumSaved() == 600 - numRendered);
+
+        // A new policy renders the next request.
+        governor.ResetStatistics();
+        DXM_CHECK(governor.GetStatistics().numRequests == 0);
+        (void)simulation.Step(With(true, true, false, false, 0.0));
+        governor.SetPolicy(governor.GetPolicy());
+        DXM_CHECK(simulation.Step(With(true, true, false, false, 0.0)));
+        DXM_CHECK(governor.GetStatistics().numRequests == 2);
+    }
+
+    // A policy whose display rate is not positive, or whose other rates or
+    // times are negative or NaN, is rejected and the previous policy stays.
+    // A state rate of 0 renders nothing in that state.
+    void TestInvalidPolicy()
+    {
+        FrameRateGovernor::Policy const defaults = FrameRateGovernor::DefaultPolicy();
+        FrameRateGovernor governor;
+        auto reject = [&](double FrameRateGovernor::Policy::* member, double value)
+        {
+            FrameRateGovernor::Policy policy = defaults;
+            policy.*member = value;
+            DXM_CHECK_THROWS(std::invalid_argument, governor.SetPolicy(policy));
+            DXM_CHECK_THROWS(std::invalid_argument, FrameRateGovernor{ policy });
+            DXM_CHECK(governor.GetPolicy().*member == defaults.*member);
+        };
+        reject(&FrameRateGovernor::Policy::displayRate, 0.0);
+        reject(&FrameRateGovernor::Policy::displayRate, -60.0);
+        reject(&FrameRateGovernor::Policy::displayRate, std::nan(""));
+        for (auto member : { &FrameRateGovernor::Policy::unfocusedRate,
+            &FrameRateGovernor::Policy::batteryRate, &FrameRateGovernor::Policy::idleRate,
+            &FrameRateGovernor::Policy::occludedRate, &FrameRateGovernor::Policy::idleSeconds,
+            &FrameRateGovernor::Policy::rampSeconds })
+        {
+            reject(member, -1.0);
+            reject(member, std::nan(""));
+        }
+
+        FrameRateGovernor::Policy policy = defaults;
+        policy.occludedRate = 0.0;
+        policy.rampSeconds = 0.0;
+        governor.SetPolicy(policy);
+        Simulation simulation(governor);
+        DXM_CHECK(simulation.Run(With(true, true, false, false, 0.0), 1.0) == 0);
+        DXM_CHECK(simulation.Step(active) && governor.GetCurrentRate() == 60.0);
+    }
+}
+
+int main()
+{
+    TestTargetRate();
+    TestSteadyRates();
+    TestNonDivisorRates();
+    TestRampAndWake();
+    TestStall();
+    TestStatistics();
+    TestInvalidPolicy();
+    return TestCheck::Report("FrameRateGovernorTest");
+}
@@ -0,0 +1,673 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// A stand-in for the Windows SDK header with the subset of D3D11 and DXGI
+// that the DX11Native classes use, so that they can be compiled and tested
+// with mock devices on any platform. The CMake targets that use it put the
+// Mock directory first in the include path.
+//
+// The interfaces are classes with virtual member functions. By default the
+// functions that set state do nothing, and those that create objects or
+// map resources fail. IUnknown counts references and deletes the object on
+// the final Release. The mock devices and contexts of MockD3D11.h override
+// the functions a test observes. __uuidof(T) is the address of a variable
+// per interface. D3D11CreateDevice is declared and not defined; a test that
+// links code calling it defines it.
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef uint32_t DWORD;
+typedef float FLOAT;
+typedef int INT;
+typedef long LONG;
+typedef int64_t LONGLONG;
+typedef unsigned int UINT;
+typedef uint64_t UINT64;
+typedef unsigned long ULONG;
+typedef size_t SIZE_T;
+typedef wchar_t WCHAR;
+typedef int32_t HRESULT;
+typedef void* HANDLE;
+typedef void* HMODULE;
+typedef void* HMONITOR;
+typedef void* HWND;
+
+struct LUID
+{
+    DWORD LowPart;
+    LONG HighPart;
+};
+
+struct RECT
+{
+    LONG left, top, right, bottom;
+};
+
+#define TRUE 1
+#define FALSE 0
+#define SUCCEEDED(hr) (static_cast<HRESULT>(hr) >= 0)
+#define FAILED(hr) (static_cast<HRESULT>(hr) < 0)
+#define S_OK (static_cast<HRESULT>(0))
+#define S_FALSE (static_cast<HRESULT>(1))
+#define E_NOTIMPL (static_cast<HRESULT>(0x80004001u))
+#define E_NOINTERFACE (static_cast<HRESULT>(0x80004002u))
+#define E_FAIL (static_cast<HRESULT>(0x80004005u))
+#define E_OUTOFMEMORY (static_cast<HRESULT>(0x8007000Eu))
+#define E_INVALIDARG (static_cast<HRESULT>(0x80070057u))
+#define DXGI_ERROR_NOT_FOUND (static_cast<HRESULT>(0x887A0002u))
+#define DXGI_ERROR_DEVICE_REMOVED (static_cast<HRESULT>(0x887A0005u))
+#define DXGI_ERROR_DEVICE_HUNG (static_cast<HRESULT>(0x887A0006u))
+#define DXGI_ERROR_DEVICE_RESET (static_cast<HRESULT>(0x887A0007u))
+
+typedef void const* IID;
+typedef IID REFIID;
+
+namespace MockCom
+{
+    template <typename Interface>
+    struct Uuid
+    {
+        static char const id;
+    };
+
+    template <typename Interface>
+    char const Uuid<Interface>::id = 0;
+
+    // The number of mock objects not yet deleted by their final Release.
+    inline long& NumLiveObjects()
+    {
+        static long numLiveObjects = 0;
+        return numLiveObjects;
+    }
+}
+
+#define __uuidof(Interface) static_cast<IID>(&MockCom::Uuid<Interface>::id)
+
+struct IUnknown
+{
+    IUnknown()
+        :
+        mockReferences(1)
+    {
+        ++MockCom::NumLiveObjects();
+    }
+
+    virtual ~IUnknown()
+    {
+        --MockCom::NumLiveObjects();
+    }
+
+    IUnknown(IUnknown const&) = delete;
+    IUnknown& operator=(IUnknown const&) = delete;
+
+    virtual ULONG AddRef()
+    {
+        return ++mockReferences;
+    }
+
+    virtual ULONG Release()
+    {
+        ULONG const references = --mockReferences;
+        if (references == 0)
+        {
+            delete this;
+        }
+        return references;
+    }
+
+    virtual HRESULT QueryInterface(REFIID, void** object)
+    {
+        *object = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG mockReferences;
+};
+
+enum DXGI_FORMAT
+{
+    DXGI_FORMAT_UNKNOWN = 0,
+    DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+    DXGI_FORMAT_R32G32B32_FLOAT = 6,
+    DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+    DXGI_FORMAT_R32G32_FLOAT = 16,
+    DXGI_FORMAT_R10G10B10A2_UNORM = 24,
+    DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+    DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+    DXGI_FORMAT_R32_UINT = 42,
+    DXGI_FORMAT_R16_UINT = 57,
+    DXGI_FORMAT_R8_UNORM = 61,
+    DXGI_FORMAT_B8G8R8A8_UNORM = 87
+};
+
+enum D3D11_PRIMITIVE_TOPOLOGY
+{
+    D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+    D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4,
+    D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = 5
+};
+
+enum D3D_FEATURE_LEVEL
+{
+    D3D_FEATURE_LEVEL_1_0_CORE = 0x1000,
+    D3D_FEATURE_LEVEL_10_0 = 0xa000,
+    D3D_FEATURE_LEVEL_10_1 = 0xa100,
+    D3D_FEATURE_LEVEL_11_0 = 0xb000,
+    D3D_FEATURE_LEVEL_11_1 = 0xb100
+};
+
+enum D3D_DRIVER_TYPE
+{
+    D3D_DRIVER_TYPE_UNKNOWN = 0,
+    D3D_DRIVER_TYPE_HARDWARE = 1,
+    D3D_DRIVER_TYPE_WARP = 5
+};
+
+#define D3D11_CREATE_DEVICE_BGRA_SUPPORT 0x20
+#define D3D11_SDK_VERSION 7
+#define D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT 4096
+#define D3D11_FLOAT32_MAX 3.402823466e+38f
+#define D3D11_APPEND_ALIGNED_ELEMENT 0xffffffff
+
+enum D3D11_USAGE
+{
+    D3D11_USAGE_DEFAULT,
+    D3D11_USAGE_IMMUTABLE,
+    D3D11_USAGE_DYNAMIC,
+    D3D11_USAGE_STAGING
+};
+
+enum D3D11_BIND_FLAG
+{
+    D3D11_BIND_VERTEX_BUFFER = 0x1,
+    D3D11_BIND_INDEX_BUFFER = 0x2,
+    D3D11_BIND_CONSTANT_BUFFER = 0x4,
+    D3D11_BIND_SHADER_RESOURCE = 0x8,
+    D3D11_BIND_RENDER_TARGET = 0x20,
+    D3D11_BIND_UNORDERED_ACCESS = 0x80
+};
+
+enum D3D11_CPU_ACCESS_FLAG
+{
+    D3D11_CPU_ACCESS_WRITE = 0x10000,
+    D3D11_CPU_ACCESS_READ = 0x20000
+};
+
+enum D3D11_RESOURCE_MISC_FLAG
+{
+    D3D11_RESOURCE_MISC_SHARED = 0x2
+};
+
+enum D3D11_MAP
+{
+    D3D11_MAP_READ = 1,
+    D3D11_MAP_WRITE = 2,
+    D3D11_MAP_READ_WRITE = 3,
+    D3D11_MAP_WRITE_DISCARD = 4,
+    D3D11_MAP_WRITE_NO_OVERWRITE = 5
+};
+
+enum D3D11_QUERY
+{
+    D3D11_QUERY_EVENT = 0,
+    D3D11_QUERY_TIMESTAMP = 2,
+    D3D11_QUERY_TIMESTAMP_DISJOINT = 3
+};
+
+enum D3D11_FEATURE
+{
+    D3D11_FEATURE_D3D11_OPTIONS = 7
+};
+
+enum D3D11_RTV_DIMENSION
+{
+    D3D11_RTV_DIMENSION_TEXTURE2D = 4
+};
+
+enum D3D11_SRV_DIMENSION
+{
+    D3D11_SRV_DIMENSION_TEXTURE2D = 4
+};
+
+enum D3D11_FILTER
+{
+    D3D11_FILTER_MIN_MAG_MIP_POINT = 0,
+    D3D11_FILTER_MIN_MAG_MIP_LINEAR = 0x15
+};
+
+enum D3D11_TEXTURE_ADDRESS_MODE
+{
+    D3D11_TEXTURE_ADDRESS_CLAMP = 3
+};
+
+enum D3D11_COMPARISON_FUNC
+{
+    D3D11_COMPARISON_NEVER = 1
+};
+
+enum D3D11_BLEND
+{
+    D3D11_BLEND_ZERO = 1,
+    D3D11_BLEND_ONE = 2,
+    D3D11_BLEND_SRC_ALPHA = 5,
+    D3D11_BLEND_INV_SRC_ALPHA = 6
+};
+
+enum D3D11_BLEND_OP
+{
+    D3D11_BLEND_OP_ADD = 1
+};
+
+enum D3D11_COLOR_WRITE_ENABLE
+{
+    D3D11_COLOR_WRITE_ENABLE_ALL = 15
+};
+
+enum D3D11_INPUT_CLASSIFICATION
+{
+    D3D11_INPUT_PER_VERTEX_DATA = 0,
+    D3D11_INPUT_PER_INSTANCE_DATA = 1
+};
+
+struct D3D11_FEATURE_DATA_D3D11_OPTIONS
+{
+    BOOL OutputMergerLogicOp;
+    BOOL UAVOnlyRenderingForcedSampleCount;
+    BOOL DiscardAPIsSeenByDriver;
+    BOOL FlagsForUpdateAndCopySeenByDriver;
+    BOOL ClearView;
+    BOOL CopyWithOverlap;
+    BOOL ConstantBufferPartialUpdate;
+    BOOL ConstantBufferOffsetting;
+    BOOL MapNoOverwriteOnDynamicConstantBuffer;
+    BOOL MapNoOverwriteOnDynamicBufferSRV;
+    BOOL MultisampleRTVWithForcedSampleCountOne;
+    BOOL SAD4ShaderInstructions;
+    BOOL ExtendedDoublesShaderInstructions;
+    BOOL ExtendedResourceSharing;
+};
+
+struct D3D11_BUFFER_DESC
+{
+    UINT ByteWidth;
+    D3D11_USAGE Usage;
+    UINT BindFlags;
+    UINT CPUAccessFlags;
+    UINT MiscFlags;
+    UINT StructureByteStride;
+};
+
+struct DXGI_SAMPLE_DESC
+{
+    UINT Count;
+    UINT Quality;
+};
+
+struct D3D11_TEXTURE2D_DESC
+{
+    UINT Width;
+    UINT Height;
+    UINT MipLevels;
+    UINT ArraySize;
+    DXGI_FORMAT Format;
+    DXGI_SAMPLE_DESC SampleDesc;
+    D3D11_USAGE Usage;
+    UINT BindFlags;
+    UINT CPUAccessFlags;
+    UINT MiscFlags;
+};
+
+struct D3D11_QUERY_DESC
+{
+    D3D11_QUERY Query;
+    UINT MiscFlags;
+};
+
+struct D3D11_TEX2D_RTV
+{
+    UINT MipSlice;
+};
+
+struct D3D11_RENDER_TARGET_VIEW_DESC
+{
+    DXGI_FORMAT Format;
+    D3D11_RTV_DIMENSION ViewDimension;
+    D3D11_TEX2D_RTV Texture2D;
+};
+
+struct D3D11_TEX2D_SRV
+{
+    UINT MostDetailedMip;
+    UINT MipLevels;
+};
+
+struct D3D11_SHADER_RESOURCE_VIEW_DESC
+{
+    DXGI_FORMAT Format;
+    D3D11_SRV_DIMENSION ViewDimension;
+    D3D11_TEX2D_SRV Texture2D;
+};
+
+struct D3D11_VIEWPORT
+{
+    FLOAT TopLeftX, TopLeftY, Width, Height, MinDepth, MaxDepth;
+};
+
+struct D3D11_MAPPED_SUBRESOURCE
+{
+    void* pData;
+    UINT RowPitch;
+    UINT DepthPitch;
+};
+
+struct D3D11_BOX
+{
+    UINT left, top, front, right, bottom, back;
+};
+
+struct D3D11_SUBRESOURCE_DATA
+{
+    void const* pSysMem;
+    UINT SysMemPitch;
+    UINT SysMemSlicePitch;
+};
+
+struct D3D11_QUERY_DATA_TIMESTAMP_DISJOINT
+{
+    UINT64 Frequency;
+    BOOL Disjoint;
+};
+
+typedef RECT D3D11_RECT;
+
+struct D3D11_SAMPLER_DESC
+{
+    D3D11_FILTER Filter;
+    D3D11_TEXTURE_ADDRESS_MODE AddressU;
+    D3D11_TEXTURE_ADDRESS_MODE AddressV;
+    D3D11_TEXTURE_ADDRESS_MODE AddressW;
+    FLOAT MipLODBias;
+    UINT MaxAnisotropy;
+    D3D11_COMPARISON_FUNC ComparisonFunc;
+    FLOAT BorderColor[4];
+    FLOAT MinLOD;
+    FLOAT MaxLOD;
+};
+
+struct D3D11_INPUT_ELEMENT_DESC
+{
+    char const* SemanticName;
+    UINT SemanticIndex;
+    DXGI_FORMAT Format;
+    UINT InputSlot;
+    UINT AlignedByteOffset;
+    D3D11_INPUT_CLASSIFICATION InputSlotClass;
+    UINT InstanceDataStepRate;
+};
+
+struct D3D11_RENDER_TARGET_BLEND_DESC
+{
+    BOOL BlendEnable;
+    D3D11_BLEND SrcBlend;
+    D3D11_BLEND DestBlend;
+    D3D11_BLEND_OP BlendOp;
+    D3D11_BLEND SrcBlendAlpha;
+    D3D11_BLEND DestBlendAlpha;
+    D3D11_BLEND_OP BlendOpAlpha;
+    BYTE RenderTargetWriteMask;
+};
+
+struct D3D11_BLEND_DESC
+{
+    BOOL AlphaToCoverageEnable;
+    BOOL IndependentBlendEnable;
+    D3D11_RENDER_TARGET_BLEND_DESC RenderTarget[8];
+};
+
+struct ID3D11ClassInstance;
+struct ID3D11ClassLinkage;
+struct ID3D11Device;
+
+struct ID3D11DeviceChild : IUnknown
+{
+};
+
+struct ID3D11Resource : ID3D11DeviceChild
+{
+};
+
+struct ID3D11Buffer : ID3D11Resource
+{
+    virtual void GetDesc(D3D11_BUFFER_DESC* desc)
+    {
+        *desc = D3D11_BUFFER_DESC{};
+    }
+};
+
+struct ID3D11Texture2D : ID3D11Resource
+{
+    virtual void GetDesc(D3D11_TEXTURE2D_DESC* desc)
+    {
+        *desc = D3D11_TEXTURE2D_DESC{};
+    }
+};
+
+struct ID3D11View : ID3D11DeviceChild
+{
+    virtual void GetResource(ID3D11Resource** resource)
+    {
+        *resource = nullptr;
+    }
+};
+
+struct ID3D11RenderTargetView : ID3D11View
+{
+};
+
+struct ID3D11DepthStencilView : ID3D11View
+{
+};
+
+struct ID3D11ShaderResourceView : ID3D11View
+{
+};
+
+struct ID3D11UnorderedAccessView : ID3D11View
+{
+};
+
+struct ID3D11InputLayout : ID3D11DeviceChild
+{
+};
+
+struct ID3D11VertexShader : ID3D11DeviceChild
+{
+};
+
+struct ID3D11PixelShader : ID3D11DeviceChild
+{
+};
+
+struct ID3D11ComputeShader : ID3D11DeviceChild
+{
+};
+
+struct ID3D11SamplerState : ID3D11DeviceChild
+{
+};
+
+struct ID3D11RasterizerState : ID3D11DeviceChild
+{
+};
+
+struct ID3D11BlendState : ID3D11DeviceChild
+{
+};
+
+struct ID3D11DepthStencilState : ID3D11DeviceChild
+{
+};
+
+struct ID3D11Asynchronous : ID3D11DeviceChild
+{
+};
+
+struct ID3D11Query : ID3D11Asynchronous
+{
+};
+
+struct ID3D11DeviceContext : ID3D11DeviceChild
+{
+    virtual void IASetInputLayout(ID3D11InputLayout*) {}
+    virtual void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY) {}
+    virtual void IASetVertexBuffers(UINT, UINT, ID3D11Buffer* const*, UINT const*, UINT const*) {}
+    virtual void IASetIndexBuffer(ID3D11Buffer*, DXGI_FORMAT, UINT) {}
+    virtual void VSSetShader(ID3D11VertexShader*, ID3D11ClassInstance* const*, UINT) {}
+    virtual void VSSetConstantBuffers(UINT, UINT, ID3D11Buffer* const*) {}
+    virtual void PSSetShader(ID3D11PixelShader*, ID3D11ClassInstance* const*, UINT) {}
+    virtual void PSSetConstantBuffers(UINT, UINT, ID3D11Buffer* const*) {}
+    virtual void PSSetShaderResources(UINT, UINT, ID3D11ShaderResourceView* const*) {}
+    virtual void PSSetSamplers(UINT, UINT, ID3D11SamplerState* const*) {}
+    virtual void RSSetState(ID3D11RasterizerState*) {}
+    virtual void RSSetViewports(UINT, D3D11_VIEWPORT const*) {}
+    virtual void RSSetScissorRects(UINT, D3D11_RECT const*) {}
+    virtual void OMSetBlendState(ID3D11BlendState*, FLOAT const*, UINT) {}
+    virtual void OMSetDepthStencilState(ID3D11DepthStencilState*, UINT) {}
+    virtual void OMSetRenderTargets(UINT, ID3D11RenderTargetView* const*, ID3D11DepthStencilView*) {}
+    virtual void ClearRenderTargetView(ID3D11RenderTargetView*, FLOAT const*) {}
+    virtual void Draw(UINT, UINT) {}
+    virtual void DrawIndexed(UINT, UINT, INT) {}
+    virtual void DrawInstanced(UINT, UINT, UINT, UINT) {}
+    virtual void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT) {}
+    virtual void Begin(ID3D11Asynchronous*) {}
+    virtual void End(ID3D11Asynchronous*) {}
+    virtual void Flush() {}
+
+    virtual HRESULT GetData(ID3D11Asynchronous*, void*, UINT, UINT)
+    {
+        return S_OK;
+    }
+
+    virtual HRESULT Map(ID3D11Resource*, UINT, D3D11_MAP, UINT, D3D11_MAPPED_SUBRESOURCE* mapped)
+    {
+        *mapped = D3D11_MAPPED_SUBRESOURCE{};
+        return E_FAIL;
+    }
+
+    virtual void Unmap(ID3D11Resource*, UINT) {}
+    virtual void CopyResource(ID3D11Resource*, ID3D11Resource*) {}
+    virtual void CopySubresourceRegion(ID3D11Resource*, UINT, UINT, UINT, UINT,
+        ID3D11Resource*, UINT, D3D11_BOX const*) {}
+    virtual void UpdateSubresource(ID3D11Resource*, UINT, D3D11_BOX const*,
+        void const*, UINT, UINT) {}
+};
+
+struct ID3D11Device : IUnknown
+{
+    virtual HRESULT CreateBuffer(D3D11_BUFFER_DESC const*, D3D11_SUBRESOURCE_DATA const*,
+        ID3D11Buffer** buffer)
+    {
+        *buffer = nullptr;
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT CreateTexture2D(D3D11_TEXTURE2D_DESC const*, D3D11_SUBRESOURCE_DATA const*,
+        ID3D11Texture2D** texture)
+    {
+        *texture = nullptr;
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT CreateRenderTargetView(ID3D11Resource*, D3D11_RENDER_TARGET_VIEW_DESC const*,
+        ID3D11RenderTargetView** view)
+    {
+        *view = nullptr;
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT CreateShaderResourceView(ID3D11Resource*, D3D11_SHADER_RESOURCE_VIEW_DESC const*,
+        ID3D11ShaderResourceView** view)
+    {
+        *view = nullptr;
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT CreateVertexShader(void const*, SIZE_T, ID3D11ClassLinkage*,
+        ID3D11VertexShader** shader)
+    {
+        *shader = nullptr;
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT CreatePixelShader(void const*, SIZE_T, ID3D11ClassLinkage*,
+        ID3D11PixelShader** shader)
+    {
+        *shader = nullptr;
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT CreateInputLayout(D3D11_INPUT_ELEMENT_DESC const*, UINT, void const*, SIZE_T,
+        ID3D11InputLayout** layout)
+    {
+        *layout = nullptr;
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT CreateSamplerState(D3D11_SAMPLER_DESC const*, ID3D11SamplerState** state)
+    {
+        *state = nullptr;
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT CreateBlendState(D3D11_BLEND_DESC const*, ID3D11BlendState** state)
+    {
+        *state = nullptr;
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT CreateQuery(D3D11_QUERY_DESC const*, ID3D11Query** query)
+    {
+        *query = nullptr;
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT OpenSharedResource(HANDLE, REFIID, void** resource)
+    {
+        *resource = nullptr;
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT CheckFeatureSupport(D3D11_FEATURE, void*, UINT)
+    {
+        return E_INVALIDARG;
+    }
+
+    virtual HRESULT GetDeviceRemovedReason()
+    {
+        return S_OK;
+    }
+
+    virtual D3D_FEATURE_LEVEL GetFeatureLevel()
+    {
+        return D3D_FEATURE_LEVEL_11_0;
+    }
+
+    virtual void GetImmediateContext(ID3D11DeviceContext** context)
+    {
+        *context = nullptr;
+    }
+};
+
+#include "dxgi.h"
+
+HRESULT D3D11CreateDevice(IDXGIAdapter* adapter, D3D_DRIVER_TYPE driverType, HMODULE software,
+    UINT flags, D3D_FEATURE_LEVEL const* featureLevels, UINT numFeatureLevels, UINT sdkVersion,
+    ID3D11Device** device, D3D_FEATURE_LEVEL* featureLevel, ID3D11DeviceContext** context);
@@ -0,0 +1,19 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+// The D3D11.1 part of the stand-in for the Windows SDK headers; see
+// d3d11.h.
+
+#include "d3d11.h"
+
+struct ID3D11DeviceContext1 : ID3D11DeviceContext
+{
+    virtual void VSSetConstantBuffers1(UINT, UINT, ID3D11Buffer* const*, UINT const*, UINT const*) {}
+    virtual void PSSetConstantBuffers1(UINT, UINT, ID3D11Buffer* const*, UINT const*, UINT const*) {}
+    virtual void ClearView(ID3D11View*, FLOAT const*, D3D11_RECT const*, UINT) {}
+};
@@ -0,0 +1,30 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+// The D3D9Ex part of the stand-in for the Windows SDK headers; see d3d11.h.
+
+#include "d3d11.h"
+
+struct IDirect3D9Ex : IUnknown
+{
+    virtual UINT GetAdapterCount()
+    {
+        return 0;
+    }
+
+    virtual HRESULT GetAdapterLUID(UINT, LUID* luid)
+    {
+        *luid = LUID{};
+        return E_FAIL;
+    }
+
+    virtual HMONITOR GetAdapterMonitor(UINT)
+    {
+        return nullptr;
+    }
+};
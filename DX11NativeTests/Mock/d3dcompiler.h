@@ -0,0 +1,32 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+// The shader compiler part of the stand-in for the Windows SDK headers; see
+// d3d11.h. D3DCompile is declared and not defined; a test that links code
+// calling it defines it.
+
+#include "d3d11.h"
+
+#define D3DCOMPILE_OPTIMIZATION_LEVEL3 (1 << 15)
+
+struct ID3DBlob : IUnknown
+{
+    virtual void* GetBufferPointer()
+    {
+        return nullptr;
+    }
+
+    virtual SIZE_T GetBufferSize()
+    {
+        return 0;
+    }
+};
+
+HRESULT D3DCompile(void const* source, SIZE_T sourceSize, char const* sourceName,
+    void const* defines, void* include, char const* entryPoint, char const* target,
+    UINT flags1, UINT flags2, ID3DBlob** code, ID3DBlob** errors);
@@ -0,0 +1,122 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+// The DXGI part of the stand-in for the Windows SDK headers; see d3d11.h.
+// The factory, adapter and output functions report no objects unless a
+// test overrides them. CreateDXGIFactory1 is declared and not defined; a
+// test that links code calling it defines it.
+
+#include "d3d11.h"
+
+struct DXGI_ADAPTER_DESC
+{
+    WCHAR Description[128];
+    UINT VendorId;
+    UINT DeviceId;
+    UINT SubSysId;
+    UINT Revision;
+    SIZE_T DedicatedVideoMemory;
+    SIZE_T DedicatedSystemMemory;
+    SIZE_T SharedSystemMemory;
+    LUID AdapterLuid;
+};
+
+struct DXGI_ADAPTER_DESC1 : DXGI_ADAPTER_DESC
+{
+    UINT Flags;
+};
+
+enum DXGI_ADAPTER_FLAG
+{
+    DXGI_ADAPTER_FLAG_NONE = 0,
+    DXGI_ADAPTER_FLAG_SOFTWARE = 2
+};
+
+struct DXGI_OUTPUT_DESC
+{
+    WCHAR DeviceName[32];
+    RECT DesktopCoordinates;
+    BOOL AttachedToDesktop;
+    int Rotation;
+    HMONITOR Monitor;
+};
+
+struct IDXGIObject : IUnknown
+{
+};
+
+struct IDXGIOutput : IDXGIObject
+{
+    virtual HRESULT GetDesc(DXGI_OUTPUT_DESC* desc)
+    {
+        *desc = DXGI_OUTPUT_DESC{};
+        return S_OK;
+    }
+};
+
+struct IDXGIAdapter : IDXGIObject
+{
+    virtual HRESULT GetDesc(DXGI_ADAPTER_DESC* desc)
+    {
+        *desc = DXGI_ADAPTER_DESC{};
+        return S_OK;
+    }
+
+    virtual HRESULT EnumOutputs(UINT, IDXGIOutput** output)
+    {
+        *output = nullptr;
+        return DXGI_ERROR_NOT_FOUND;
+    }
+};
+
+struct IDXGIAdapter1 : IDXGIAdapter
+{
+    virtual HRESULT GetDesc1(DXGI_ADAPTER_DESC1* desc)
+    {
+        *desc = DXGI_ADAPTER_DESC1{};
+        return S_OK;
+    }
+};
+
+struct IDXGIFactory1 : IDXGIObject
+{
+    virtual HRESULT EnumAdapters1(UINT, IDXGIAdapter1** adapter)
+    {
+        *adapter = nullptr;
+        return DXGI_ERROR_NOT_FOUND;
+    }
+};
+
+struct IDXGIDevice : IDXGIObject
+{
+    virtual HRESULT GetAdapter(IDXGIAdapter** adapter)
+    {
+        *adapter = nullptr;
+        return E_FAIL;
+    }
+};
+
+struct IDXGIDeviceSubObject : IDXGIObject
+{
+    virtual HRESULT GetDevice(REFIID, void** device)
+    {
+        *device = nullptr;
+        return E_NOINTERFACE;
+    }
+};
+
+struct IDXGIResource : IDXGIDeviceSubObject
+{
+    virtual HRESULT GetSharedHandle(HANDLE* handle)
+    {
+        *handle = nullptr;
+        return E_FAIL;
+    }
+};
+
+HRESULT CreateDXGIFactory1(REFIID riid, void** factory);
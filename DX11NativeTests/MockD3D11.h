@@ -0,0 +1,333 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <d3d11_1.h>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+// A mock device and immediate context for the tests of the D3D11 classes,
+// built on the interfaces of Mock/d3d11.h. The device creates objects that
+// live in CPU memory and can be made to fail a creation. The
+// context maps buffers and textures to their CPU memory and records the
+// maps, updates and copies. The state-setting functions of the context
+// are the no-ops of the interface; a test that observes them derives from
+// MockContext.
+
+namespace dxm
+{
+    template <typename Interface>
+    class MockObject : public Interface
+    {
+    };
+
+    class MockBuffer : public ID3D11Buffer
+    {
+    public:
+        MockBuffer(D3D11_BUFFER_DESC const& desc, D3D11_SUBRESOURCE_DATA const* initialData)
+            :
+            mDesc(desc),
+            mData(desc.ByteWidth)
+        {
+            if (initialData)
+            {
+                std::memcpy(mData.data(), initialData->pSysMem, mData.size());
+            }
+        }
+
+        virtual void GetDesc(D3D11_BUFFER_DESC* desc) override
+        {
+            *desc = mDesc;
+        }
+
+        inline std::vector<uint8_t>& GetData()
+        {
+            return mData;
+        }
+
+    private:
+        D3D11_BUFFER_DESC mDesc;
+        std::vector<uint8_t> mData;
+    };
+
+    // The texels have 4 bytes, or 1 for DXGI_FORMAT_R8_UNORM, 8 for
+    // DXGI_FORMAT_R16G16B16A16_FLOAT and 16 for
+    // DXGI_FORMAT_R32G32B32A32_FLOAT.
+    class MockTexture2D : public ID3D11Texture2D
+    {
+    public:
+        MockTexture2D(D3D11_TEXTURE2D_DESC const& desc, D3D11_SUBRESOURCE_DATA const* initialData)
+            :
+            mDesc(desc),
+            mRowPitch(desc.Width * GetTexelBytes(desc.Format)),
+            mData(static_cast<size_t>(mRowPitch) * desc.Height)
+        {
+            if (initialData)
+            {
+                for (UINT y = 0; y < desc.Height; ++y)
+                {
+                    std::memcpy(&mData[static_cast<size_t>(y) * mRowPitch],
+                        static_cast<uint8_t const*>(initialData->pSysMem) +
+                        static_cast<size_t>(y) * initialData->SysMemPitch, mRowPitch);
+                }
+            }
+        }
+
+        virtual void GetDesc(D3D11_TEXTURE2D_DESC* desc) override
+        {
+            *desc = mDesc;
+        }
+
+        inline UINT GetRowPitch() const
+        {
+            return mRowPitch;
+        }
+
+        inline std::vector<uint8_t>& GetData()
+        {
+            return mData;
+        }
+
+        static UINT GetTexelBytes(DXGI_FORMAT format)
+        {
+            switch (format)
+            {
+            case DXGI_FORMAT_R32G32B32A32_FLOAT:
+                return 16;
+            case DXGI_FORMAT_R16G16B16A16_FLOAT:
+                return 8;
+            case DXGI_FORMAT_R8_UNORM:
+                return 1;
+            default:
+                return 4;
+            }
+        }
+
+    private:
+        D3D11_TEXTURE2D_DESC mDesc;
+        UINT mRowPitch;
+        std::vector<uint8_t> mData;
+    };
+
+    class MockDevice : public ID3D11Device
+    {
+    public:
+        static size_t constexpr never = std::numeric_limits<size_t>::max();
+
+        MockDevice()
+            :
+            options{},
+            numCreates(0),
+            failAtCreate(never)
+        {
+        }
+
+        // The result of CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS).
+        D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+
+        // The number of successful creations. When it is failAtCreate, the
+        // next creation fails with E_OUTOFMEMORY and failAtCreate is reset
+        // to 'never'.
+        size_t numCreates;
+        size_t failAtCreate;
+
+        virtual HRESULT CheckFeatureSupport(D3D11_FEATURE feature, void* data, UINT size) override
+        {
+            if (feature != D3D11_FEATURE_D3D11_OPTIONS || size != sizeof(options))
+            {
+                return E_INVALIDARG;
+            }
+            std::memcpy(data, &options, sizeof(options));
+            return S_OK;
+        }
+
+        virtual HRESULT CreateBuffer(D3D11_BUFFER_DESC const* desc,
+            D3D11_SUBRESOURCE_DATA const* initialData, ID3D11Buffer** buffer) override
+        {
+            return Create(buffer, [&]() { return new MockBuffer(*desc, initialData); });
+        }
+
+        virtual HRESULT CreateTexture2D(D3D11_TEXTURE2D_DESC const* desc,
+            D3D11_SUBRESOURCE_DATA const* initialData, ID3D11Texture2D** texture) override
+        {
+            return Create(texture, [&]() { return new MockTexture2D(*desc, initialData); });
+        }
+
+        virtual HRESULT CreateRenderTargetView(ID3D11Resource*,
+            D3D11_RENDER_TARGET_VIEW_DESC const*, ID3D11RenderTargetView** view) override
+        {
+            return Create(view);
+        }
+
+        virtual HRESULT CreateShaderResourceView(ID3D11Resource*,
+            D3D11_SHADER_RESOURCE_VIEW_DESC const*, ID3D11ShaderResourceView** view) override
+        {
+            return Create(view);
+        }
+
+        virtual HRESULT CreateVertexShader(void const*, SIZE_T, ID3D11ClassLinkage*,
+            ID3D11VertexShader** shader) override
+        {
+            return Create(shader);
+        }
+
+        virtual HRESULT CreatePixelShader(void const*, SIZE_T, ID3D11ClassLinkage*,
+            ID3D11PixelShader** shader) override
+        {
+            return Create(shader);
+        }
+
+        virtual HRESULT CreateInputLayout(D3D11_INPUT_ELEMENT_DESC const*, UINT, void const*,
+            SIZE_T, ID3D11InputLayout** layout) override
+        {
+            return Create(layout);
+        }
+
+        virtual HRESULT CreateSamplerState(D3D11_SAMPLER_DESC const*,
+            ID3D11SamplerState** state) override
+        {
+            return Create(state);
+        }
+
+        virtual HRESULT CreateBlendState(D3D11_BLEND_DESC const*,
+            ID3D11BlendState** state) override
+        {
+            return Create(state);
+        }
+
+        virtual HRESULT CreateQuery(D3D11_QUERY_DESC const*, ID3D11Query** query) override
+        {
+            return Create(query);
+        }
+
+    private:
+        template <typename Interface, typename Factory>
+        HRESULT Create(Interface** object, Factory factory)
+        {
+            *object = nullptr;
+            if (numCreates == failAtCreate)
+            {
+                failAtCreate = never;
+                return E_OUTOFMEMORY;
+            }
+            ++numCreates;
+            *object = factory();
+            return S_OK;
+        }
+
+        template <typename Interface>
+        HRESULT Create(Interface** object)
+        {
+            return Create(object, []() { return new MockObject<Interface>(); });
+        }
+    };
+
+    class MockContext : public ID3D11DeviceContext1
+    {
+    public:
+        struct MapCall
+        {
+            ID3D11Resource* resource;
+            D3D11_MAP type;
+        };
+
+        struct UpdateCall
+        {
+            ID3D11Resource* resource;
+            bool hasBox;
+            D3D11_BOX box;
+        };
+
+        struct CopyCall
+        {
+            ID3D11Resource* destination;
+            UINT x, y;
+            ID3D11Resource* source;
+            bool hasBox;
+            D3D11_BOX box;
+        };
+
+        MockContext()
+            :
+            supportsContext1(true),
+            mapResult(S_OK),
+            numUnmaps(0)
+        {
+        }
+
+        // Whether QueryInterface returns the ID3D11DeviceContext1 interface.
+        bool supportsContext1;
+
+        // Map fails with a failed mapResult.
+        HRESULT mapResult;
+
+        std::vector<MapCall> maps;
+        size_t numUnmaps;
+        std::vector<UpdateCall> updates;
+        std::vector<CopyCall> copies;
+
+        virtual HRESULT QueryInterface(REFIID riid, void** object) override
+        {
+            if (supportsContext1 && riid == __uuidof(ID3D11DeviceContext1))
+            {
+                AddRef();
+                *object = static_cast<ID3D11DeviceContext1*>(this);
+                return S_OK;
+            }
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        virtual HRESULT Map(ID3D11Resource* resource, UINT, D3D11_MAP type, UINT,
+            D3D11_MAPPED_SUBRESOURCE* mapped) override
+        {
+            *mapped = D3D11_MAPPED_SUBRESOURCE{};
+            if (FAILED(mapResult))
+            {
+                return mapResult;
+            }
+
+            maps.push_back(MapCall{ resource, type });
+            if (auto buffer = dynamic_cast<MockBuffer*>(resource))
+            {
+                mapped->pData = buffer->GetData().data();
+                mapped->RowPitch = static_cast<UINT>(buffer->GetData().size());
+            }
+            else if (auto texture = dynamic_cast<MockTexture2D*>(resource))
+            {
+                mapped->pData = texture->GetData().data();
+                mapped->RowPitch = texture->GetRowPitch();
+            }
+            else
+            {
+                return E_INVALIDARG;
+            }
+            mapped->DepthPitch = mapped->RowPitch;
+            return S_OK;
+        }
+
+        virtual void Unmap(ID3D11Resource*, UINT) override
+        {
+            ++numUnmaps;
+        }
+
+        virtual void UpdateSubresource(ID3D11Resource* resource, UINT, D3D11_BOX const* box,
+            void const*, UINT, UINT) override
+        {
+            updates.push_back(UpdateCall{ resource, box != nullptr, box ? *box : D3D11_BOX{} });
+        }
+
+        virtual void CopySubresourceRegion(ID3D11Resource* destination, UINT, UINT x, UINT y,
+            UINT, ID3D11Resource* source, UINT, D3D11_BOX const* box) override
+        {
+            copies.push_back(CopyCall{ destination, x, y, source, box != nullptr,
+                box ? *box : D3D11_BOX{} });
+        }
+    };
+}
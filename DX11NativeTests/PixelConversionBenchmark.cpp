@@ -0,0 +1,86 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "PixelConversion.h"
+#include "Benchmark.h"
+#include <cstring>
+#include <vector>
+using namespace dxm;
+
+// The conversion of a 1920x1080 frame into a row-padded target, as
+// PixelUploader writes it to a mapped texture, for each format and path.
+// The 'two-pass' column converts into a staging buffer and then copies it
+// to the target, which is the upload without the direct conversion.
+
+int main(int argc, char** argv)
+{
+    Benchmark benchmark(argc, argv);
+    size_t const numFrames = benchmark.Iterations(200);
+    uint32_t const width = 1920, height = 1080;
+    size_t const targetPitch = 4 * static_cast<size_t>(width) + 256;
+
+    PixelConversion::Format const formats[] =
+    {
+        PixelConversion::Format::BGRA8,
+        PixelConversion::Format::RGBA8,
+        PixelConversion::Format::RGB8,
+        PixelConversion::Format::GRAY16,
+        PixelConversion::Format::RGBA16
+    };
+    char const* formatNames[] = { "BGRA8", "RGBA8", "RGB8", "GRAY16", "RGBA16" };
+    bool const hasSSSE3 = (PixelConversion::GetBestPath() == PixelConversion::Path::SSSE3);
+
+    std::vector<uint8_t> target(targetPitch * height);
+    std::vector<uint8_t> staging(4 * static_cast<size_t>(width) * height);
+    std::printf("%8s %12s %12s %12s %12s\n", "format", "scalar us", "ssse3 us",
+        "two-pass us", "ssse3 GB/s");
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i)
+    {
+        size_t const sourcePitch = PixelConversion::GetBytesPerPixel(formats[i]) * width;
+        std::vector<uint8_t> source(sourcePitch * height);
+        for (size_t j = 0; j < source.size(); ++j)
+        {
+            source[j] = static_cast<uint8_t>(j * 7);
+        }
+
+        auto convert = [&](PixelConversion::Path path)
+        {
+            return 1e-3 * benchmark.Measure(numFrames, [&]()
+            {
+                for (size_t frame = 0; frame < numFrames; ++frame)
+                {
+                    PixelConversion::ConvertToBGRA8(path, formats[i], source.data(),
+                        sourcePitch, target.data(), targetPitch, width, height);
+                    DoNotOptimize(target[frame % target.size()]);
+                }
+            });
+        };
+
+        double const scalar = convert(PixelConversion::Path::SCALAR);
+        double const ssse3 = (hasSSSE3 ? convert(PixelConversion::Path::SSSE3) : 0.0);
+        double const twoPass = 1e-3 * benchmark.Measure(numFrames, [&]()
+        {
+            for (size_t frame = 0; frame < numFrames; ++frame)
+            {
+                PixelConversion::ConvertToBGRA8(PixelConversion::GetBestPath(), formats[i],
+                    source.data(), sourcePitch, staging.data(), 4 * static_cast<size_t>(width),
+                    width, height);
+                for (uint32_t y = 0; y < height; ++y)
+                {
+                    std::memcpy(&target[y * targetPitch], &staging[4 * static_cast<size_t>(y) * width],
+                        4 * static_cast<size_t>(width));
+                }
+                DoNotOptimize(target[frame % target.size()]);
+            }
+        });
+
+        double const bytes = static_cast<double>(source.size() + 4 * static_cast<size_t>(width) * height);
+        std::printf("%8s %12.0f %12.0f %12.0f %12.2f\n", formatNames[i], scalar, ssse3,
+            twoPass, ssse3 > 0.0 ? bytes / (ssse3 * 1e3) : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "PixelUploader.h"
+#include "MockD3D11.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+using namespace dxm;
+
+namespace
+{
+    using Format = PixelConversion::Format;
+
+    std::vector<uint8_t> MakePixels(size_t numBytes, unsigned int seed)
+    {
+        std::mt19937 random(seed);
+        std::vector<uint8_t> pixels(numBytes);
+        for (auto& value : pixels)
+        {
+            value = static_cast<uint8_t>(random());
+        }
+        return pixels;
+    }
+
+    // The SSSE3 path matches the scalar path for every format, for widths
+    // that do not fill the vectors and for padded rows.
+    void TestConversion()
+    {
+        if (PixelConversion::GetBestPath() != PixelConversion::Path::SSSE3)
+        {
+            return;
+        }
+
+        for (Format format : { Format::BGRA8, Format::RGBA8, Format::RGB8,
+            Format::GRAY16, Format::RGBA16 })
+        {
+            for (uint32_t width : { 1u, 3u, 4u, 15u, 16u, 17u, 67u })
+            {
+                uint32_t const height = 5;
+                size_t const sourcePitch = width * PixelConversion::GetBytesPerPixel(format) + 3;
+                size_t const targetPitch = width * 4 + 8;
+                auto const source = MakePixels(sourcePitch * height, width);
+                std::vector<uint8_t> expected(targetPitch * height, 0xCD);
+                std::vector<uint8_t> target(targetPitch * height, 0xCD);
+                PixelConversion::ConvertToBGRA8(PixelConversion::Path::SCALAR, format,
+                    source.data(), sourcePitch, expected.data(), targetPitch, width, height);
+                PixelConversion::ConvertToBGRA8(PixelConversion::Path::SSSE3, format,
+                    source.data(), sourcePitch, target.data(), targetPitch, width, height);
+                DXM_CHECK(target == expected);
+            }
+        }
+
+        // Known values: RGBA8 swaps red and blue, GRAY16 keeps the high byte.
+        uint8_t const rgba[4] = { 1, 2, 3, 4 };
+        uint16_t const gray[1] = { 0xAB12 };
+        uint8_t bgra[4] = {};
+        PixelConversion::ConvertToBGRA8(PixelConversion::Path::SCALAR, Format::RGBA8,
+            rgba, 4, bgra, 4, 1, 1);
+        DXM_CHECK(bgra[0] == 3 && bgra[1] == 2 && bgra[2] == 1 && bgra[3] == 4);
+        PixelConversion::ConvertToBGRA8(PixelConversion::Path::SCALAR, Format::GRAY16,
+            gray, 2, bgra, 4, 1, 1);
+        DXM_CHECK(bgra[0] == 0xAB && bgra[1] == 0xAB && bgra[2] == 0xAB && bgra[3] == 255);
+    }
+
+    void TestUpload()
+    {
+        MockDevice device;
+        MockContext context;
+        auto const pixels = MakePixels(64 * 32 * 4, 1);
+        {
+            PixelUploader uploader(&device, &context);
+            uploader.Upload(Format::BGRA8, pixels.data(), 64 * 4, 10, 20, 64, 32);
+            uploader.Upload(Format::BGRA8, pixels.data(), 64 * 4, 0, 0, 16, 16);
+            DXM_CHECK(device.numCreates == 2);
+            DXM_CHECK(context.maps.size() == 2 && context.numUnmaps == 2);
+            DXM_CHECK(context.maps[0].type == D3D11_MAP_WRITE_DISCARD);
+
+            // The pixels are written to the mapped texture.
+            auto* texture = static_cast<MockTexture2D*>(context.maps[0].resource);
+            DXM_CHECK(std::equal(pixels.begin(), pixels.end(), texture->GetData().begin()));
+
+            // The copies are clipped to the target.
+            uploader.Resolve(nullptr, 50, 100);
+            DXM_CHECK(!uploader.HasPending());
+            DXM_CHECK(context.copies.size() == 2);
+            DXM_CHECK(context.copies[0].x == 10 && context.copies[0].y == 20);
+            DXM_CHECK(context.copies[0].box.right == 40 && context.copies[0].box.bottom == 32);
+            DXM_CHECK(context.copies[1].box.right == 16 && context.copies[1].box.bottom == 16);
+
+            // The next frame reuses the textures, which only grow, and a
+            // third upload adds a texture to the ring.
+            uploader.NextFrame();
+            uploader.Upload(Format::BGRA8, pixels.data(), 64 * 4, 0, 0, 8, 8);
+            uploader.Upload(Format::BGRA8, pixels.data(), 64 * 4, 0, 0, 16, 8);
+            DXM_CHECK(device.numCreates == 2);
+            uploader.Upload(Format::BGRA8, pixels.data(), 64 * 4, 0, 0, 16, 16);
+            DXM_CHECK(device.numCreates == 3);
+            uploader.Resolve(nullptr, 64, 64);
+            uploader.NextFrame();
+            uploader.Upload(Format::BGRA8, pixels.data(), 64 * 4, 0, 0, 8, 8);
+            uploader.Upload(Format::BGRA8, pixels.data(), 64 * 4, 0, 0, 32, 16);
+            DXM_CHECK(device.numCreates == 4);
+            DXM_CHECK(MockCom::NumLiveObjects() == 5);
+        }
+        DXM_CHECK(MockCom::NumLiveObjects() == 2);
+    }
+
+    // A failed creation for a new slot leaves the slot without a texture.
+    // The slot is reused by the next upload, and the destructor skips it
+    // if it is never filled.
+    void TestCreateFailure()
+    {
+        MockDevice device;
+        MockContext context;
+        auto const pixels = MakePixels(16 * 16 * 4, 2);
+        {
+            PixelUploader uploader(&device, &context);
+            device.failAtCreate = 0;
+            DXM_CHECK_THROWS(std::runtime_error,
+                uploader.Upload(Format::BGRA8, pixels.data(), 16 * 4, 0, 0, 16, 16));
+            DXM_CHECK(!uploader.HasPending());
+        }
+        DXM_CHECK(MockCom::NumLiveObjects() == 2);
+
+        {
+            PixelUploader uploader(&device, &context);
+            device.failAtCreate = device.numCreates;
+            DXM_CHECK_THROWS(std::runtime_error,
+                uploader.Upload(Format::BGRA8, pixels.data(), 16 * 4, 0, 0, 16, 16));
+            uploader.Upload(Format::BGRA8, pixels.data(), 16 * 4, 0, 0, 16, 16);
+            DXM_CHECK(uploader.HasPending());
+            DXM_CHECK(MockCom::NumLiveObjects() == 3);
+
+            // A failed map does not record the upload.
+            context.mapResult = E_FAIL;
+            DXM_CHECK_THROWS(std::runtime_error,
+                uploader.Upload(Format::BGRA8, pixels.data(), 16 * 4, 0, 0, 16, 16));
+            context.mapResult = S_OK;
+            context.copies.clear();
+            uploader.Resolve(nullptr, 64, 64);
+            DXM_CHECK(context.copies.size() == 1);
+        }
+        DXM_CHECK(MockCom::NumLiveObjects() == 2);
+    }
+}
+
+int main()
+{
+    TestConversion();
+    TestUpload();
+    TestCreateFailure();
+    return TestCheck::Report("PixelUploaderTest");
+}
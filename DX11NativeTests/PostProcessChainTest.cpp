@@ -0,0 +1,242 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "PostProcessChain.h"
+#include "MockD3D11.h"
+#include "TestCheck.h"
+#include <d3dcompiler.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace dxm;
+
+namespace
+{
+    // The entry points of the compiled shaders, in order.
+    std::vector<std::string> compiled;
+}
+
+// The shaders compile to empty blobs.
+HRESULT D3DCompile(void const*, SIZE_T, char const*, void const*, void*, char const* entryPoint,
+    char const*, UINT, UINT, ID3DBlob** code, ID3DBlob** errors)
+{
+    compiled.push_back(entryPoint);
+    *code = new ID3DBlob();
+    *errors = nullptr;
+    return S_OK;
+}
+
+namespace
+{
+    using Kind = PostProcessChain::Kind;
+    using Pass = PostProcessChain::Pass;
+    using Plan = std::vector<std::vector<size_t>>;
+
+    Pass MakePass(std::string const& name, Kind kind, bool enabled = true)
+    {
+        Pass pass{};
+        pass.name = name;
+        pass.kind = kind;
+        pass.enabled = enabled;
+        return pass;
+    }
+
+    Plan GetPlan(std::vector<Pass> const& passes)
+    {
+        Plan plan;
+        for (auto const& segment : PostProcessChain::Plan(passes))
+        {
+            plan.push_back(segment.passes);
+        }
+        return plan;
+    }
+
+    size_t NumPixelShaders()
+    {
+        size_t count = 0;
+        for (auto const& entryPoint : compiled)
+        {
+            count += (entryPoint == "PSMain" ? 1 : 0);
+        }
+        return count;
+    }
+
+    // A segment is a NEIGHBORHOOD pass or the first enabled pass followed
+    // by POINTWISE passes.
+    void TestPlan()
+    {
+        Pass const p = MakePass("P", Kind::POINTWISE);
+        Pass const n = MakePass("N", Kind::NEIGHBORHOOD);
+        Pass const off = MakePass("Off", Kind::NEIGHBORHOOD, false);
+
+        DXM_CHECK(GetPlan({}).empty());
+        DXM_CHECK(GetPlan({ off }).empty());
+        DXM_CHECK((GetPlan({ p, p, p }) == Plan{ { 0, 1, 2 } }));
+        DXM_CHECK((GetPlan({ n, p, p }) == Plan{ { 0, 1, 2 } }));
+
+        // A NEIGHBORHOOD pass after a POINTWISE pass reads the results of
+        // the POINTWISE pass at other pixels, so it starts a segment.
+        DXM_CHECK((GetPlan({ p, n, p }) == Plan{ { 0 }, { 1, 2 } }));
+        DXM_CHECK((GetPlan({ n, n }) == Plan{ { 0 }, { 1 } }));
+        DXM_CHECK((GetPlan({ p, p, n, p, n }) == Plan{ { 0, 1 }, { 2, 3 }, { 4 } }));
+
+        // Disabled passes do not split or start segments.
+        DXM_CHECK((GetPlan({ p, off, p }) == Plan{ { 0, 2 } }));
+        DXM_CHECK((GetPlan({ off, p, n }) == Plan{ { 1 }, { 2 } }));
+
+        // The built-in passes in the order of Application.
+        DXM_CHECK(PostProcessChain::ToneMap().kind == Kind::POINTWISE);
+        DXM_CHECK(PostProcessChain::ColorGrade().kind == Kind::POINTWISE);
+        DXM_CHECK(PostProcessChain::Sharpen().kind == Kind::NEIGHBORHOOD);
+        std::vector<Pass> passes = { PostProcessChain::ToneMap(),
+            PostProcessChain::ColorGrade(), PostProcessChain::Sharpen() };
+        for (auto& pass : passes)
+        {
+            pass.enabled = true;
+        }
+        DXM_CHECK((GetPlan(passes) == Plan{ { 0, 1 }, { 2 } }));
+    }
+
+    // A pixel shader is compiled once per segment key (the pass names of
+    // the segment), when the segment is first used.
+    void TestShaderCache()
+    {
+        MockDevice device;
+        MockContext context;
+        {
+            ConstantBufferRing constants(&device, &context, 4096);
+            RenderTargetPool pool(&device);
+            PostProcessChain chain;
+            chain.AddPass(PostProcessChain::ToneMap());
+            chain.AddPass(PostProcessChain::ColorGrade());
+            chain.AddPass(PostProcessChain::Sharpen());
+            DXM_CHECK_THROWS(std::runtime_error, chain.AddPass(PostProcessChain::Sharpen()));
+            DXM_CHECK_THROWS(std::runtime_error, chain.SetPass("Blur", true, nullptr));
+            DXM_CHECK(!chain.IsActive());
+
+            // The shaders of the current plan are compiled with the vertex
+            // shader.
+            compiled.clear();
+            chain.SetPass("ToneMap", true, nullptr);
+            chain.SetPass("ColorGrade", true, nullptr);
+            chain.CreateShaders(&device);
+            DXM_CHECK(compiled.size() == 2 && compiled[0] == "VSMain");
+            DXM_CHECK(NumPixelShaders() == 1);
+
+            auto execute = [&]()
+            {
+                chain.Execute(&context, constants, pool,
+                    pool.Acquire(64, 64, PostProcessChain::intermediateFormat), nullptr);
+            };
+            execute();
+            DXM_CHECK(NumPixelShaders() == 1 && chain.GetNumDraws() == 1);
+
+            // "ToneMap;" and "Sharpen;" are new segments; returning to an
+            // earlier plan uses the cached shaders.
+            chain.SetPass("ColorGrade", false, nullptr);
+            execute();
+            DXM_CHECK(NumPixelShaders() == 2);
+            chain.SetPass("Sharpen", true, nullptr);
+            execute();
+            DXM_CHECK(NumPixelShaders() == 3 && chain.GetNumDraws() == 2);
+            chain.SetPass("ColorGrade", true, nullptr);
+            execute();
+            DXM_CHECK(NumPixelShaders() == 3 && chain.GetNumDraws() == 2);
+            chain.SetPass("Sharpen", false, nullptr);
+            chain.SetPass("ColorGrade", false, nullptr);
+            execute();
+            DXM_CHECK(NumPixelShaders() == 3 && chain.GetNumDraws() == 1);
+
+            // Parameters do not change the key.
+            float const parameters[PostProcessChain::numParameters] = { 2.0f };
+            chain.SetPass("ToneMap", true, parameters);
+            execute();
+            DXM_CHECK(NumPixelShaders() == 3);
+            DXM_CHECK(chain.GetPasses()[0].parameters[0] == 2.0f);
+
+            // The shaders are compiled again for a new device.
+            chain.ReleaseShaders();
+            compiled.clear();
+            chain.CreateShaders(&device);
+            DXM_CHECK(compiled.size() == 2);
+        }
+        DXM_CHECK(MockCom::NumLiveObjects() == 2);
+    }
+
+    // The segments ping-pong between two pool targets, the source being one
+    // of them, and every acquired target is released.
+    void TestExecute()
+    {
+        MockDevice device;
+        MockContext context;
+        {
+            ConstantBufferRing constants(&device, &context, 4096);
+            RenderTargetPool pool(&device);
+            PostProcessChain chain;
+            chain.AddPass(PostProcessChain::Sharpen());
+            chain.AddPass(PostProcessChain::ToneMap());
+            Pass blur = MakePass("Blur", Kind::NEIGHBORHOOD);
+            blur.function = "float4 Blur(Texture2D<float4> source, int2 pixel, float4 p0, "
+                "float4 p1) { return source.Load(int3(pixel, 0)); }";
+            chain.AddPass(blur);
+            chain.AddPass(PostProcessChain::ColorGrade());
+            chain.AddPass(MakePass("Edge", Kind::NEIGHBORHOOD));
+            for (auto name : { "Sharpen", "ToneMap", "ColorGrade" })
+            {
+                chain.SetPass(name, true, nullptr);
+            }
+            chain.CreateShaders(&device);
+
+            // Three segments: two intermediate targets are written, and the
+            // last segment writes the output.
+            for (size_t frame = 0; frame < 3; ++frame)
+            {
+                chain.Execute(&context, constants, pool,
+                    pool.Acquire(64, 64, PostProcessChain::intermediateFormat), nullptr);
+                DXM_CHECK(chain.GetNumDraws() == 3);
+                DXM_CHECK(pool.GetNumAcquired() == 0);
+                DXM_CHECK(pool.GetNumTargets() == 2);
+                pool.NextFrame();
+            }
+            auto const& statistics = pool.GetStatistics();
+            DXM_CHECK(statistics.numCreated == 2);
+            DXM_CHECK(statistics.numCreated + statistics.numReused == 3 * 3);
+
+            // Without enabled passes the source is released and nothing is
+            // drawn.
+            for (auto name : { "Sharpen", "ToneMap", "Blur", "ColorGrade", "Edge" })
+            {
+                chain.SetPass(name, false, nullptr);
+            }
+            chain.Execute(&context, constants, pool,
+                pool.Acquire(64, 64, PostProcessChain::intermediateFormat), nullptr);
+            DXM_CHECK(chain.GetNumDraws() == 0 && pool.GetNumAcquired() == 0);
+
+            // A shader that cannot be created throws, and the targets are
+            // released.
+            chain.SetPass("Sharpen", true, nullptr);
+            chain.SetPass("Edge", true, nullptr);
+            auto const* source = pool.Acquire(64, 64, PostProcessChain::intermediateFormat);
+            device.failAtCreate = device.numCreates;
+            DXM_CHECK_THROWS(std::runtime_error, chain.Execute(&context, constants, pool,
+                source, nullptr));
+            DXM_CHECK(pool.GetNumAcquired() == 0);
+            chain.Execute(&context, constants, pool,
+                pool.Acquire(64, 64, PostProcessChain::intermediateFormat), nullptr);
+            DXM_CHECK(chain.GetNumDraws() == 2 && pool.GetNumAcquired() == 0);
+        }
+        DXM_CHECK(MockCom::NumLiveObjects() == 2);
+    }
+}
+
+int main()
+{
+    TestPlan();
+    TestShaderCache();
+    TestExecute();
+    return TestCheck::Report("PostProcessChainTest");
+}
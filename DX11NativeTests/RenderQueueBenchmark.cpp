@@ -0,0 +1,160 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "RenderQueue.h"
+#include "Benchmark.h"
+#include "MockD3D11.h"
+#include <random>
+#include <vector>
+using namespace dxm;
+
+// A frame of draws in random order over 'numShaders' shaders with
+// 'numTextures' textures each, submitted to the mock context, whose calls
+// are virtual no-ops. The queue is timed with and without Sort, and
+// against a loop that sets every state of every draw. The state calls per
+// frame are those that reach the context; each costs much more with a
+// real driver than with the mock.
+
+namespace
+{
+    class NullBinder
+    {
+    public:
+        void BindVS(UINT, ConstantBufferRing::Allocation const&)
+        {
+        }
+
+        void BindPS(UINT, ConstantBufferRing::Allocation const&)
+        {
+        }
+    };
+
+    template <typename T>
+    T* Handle(uintptr_t value)
+    {
+        return reinterpret_cast<T*>(value * 16);
+    }
+
+    // Every state is set for every draw, as without the queue.
+    void SubmitAll(ID3D11DeviceContext* context, std::vector<RenderQueue::DrawItem> const& items)
+    {
+        for (auto const& item : items)
+        {
+            RenderQueue::DrawState const& state = *item.state;
+            context->IASetInputLayout(state.inputLayout);
+            context->IASetPrimitiveTopology(state.topology);
+            context->IASetVertexBuffers(0, 1, &state.vertexBuffer, &state.vertexStride, &state.vertexOffset);
+            context->IASetIndexBuffer(state.indexBuffer, state.indexFormat, state.indexOffset);
+            context->VSSetShader(state.vertexShader, nullptr, 0);
+            context->PSSetShader(state.pixelShader, nullptr, 0);
+            context->PSSetShaderResources(0, 1, &state.psResource);
+            context->PSSetSamplers(0, 1, &state.psSampler);
+            context->RSSetState(state.rasterizerState);
+            context->OMSetBlendState(state.blendState, nullptr, 0xFFFFFFFFu);
+            context->OMSetDepthStencilState(state.depthStencilState, state.stencilReference);
+            context->DrawIndexed(item.count, item.first, item.baseVertex);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Benchmark benchmark(argc, argv);
+    size_t const numFrames = benchmark.Iterations(2000);
+    size_t constexpr numStatesPerDraw = 11;
+
+    std::printf("%8s %8s %8s %12s %12s %12s %12s %12s %12s\n", "draws", "shaders",
+        "textures", "sorted ns", "unsorted ns", "all ns", "sorted calls",
+        "unsort calls", "all calls");
+    for (size_t numDraws : { 1000, 10000 })
+    {
+        for (size_t numShaders : { 4, 32 })
+        {
+            size_t const numTextures = 16;
+            std::vector<RenderQueue::DrawState> states(numShaders * numTextures);
+            for (size_t shader = 0; shader < numShaders; ++shader)
+            {
+                for (size_t texture = 0; texture < numTextures; ++texture)
+                {
+                    RenderQueue::DrawState& state = states[shader * numTextures + texture];
+                    state = RenderQueue::DrawState{};
+                    state.inputLayout = Handle<ID3D11InputLayout>(1);
+                    state.topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+                    state.vertexBuffer = Handle<ID3D11Buffer>(2);
+                    state.vertexStride = 32;
+                    state.indexBuffer = Handle<ID3D11Buffer>(3);
+                    state.indexFormat = DXGI_FORMAT_R16_UINT;
+                    state.vertexShader = Handle<ID3D11VertexShader>(100 + shader);
+                    state.pixelShader = Handle<ID3D11PixelShader>(200 + shader);
+                    state.psResource = Handle<ID3D11ShaderResourceView>(300 + texture);
+                    state.psSampler = Handle<ID3D11SamplerState>(4);
+                    state.rasterizerState = Handle<ID3D11RasterizerState>(5);
+                    state.blendState = Handle<ID3D11BlendState>(6);
+                    state.depthStencilState = Handle<ID3D11DepthStencilState>(7);
+                }
+            }
+
+            std::mt19937 random(1);
+            std::vector<RenderQueue::DrawItem> items(numDraws);
+            std::vector<uint64_t> keys(numDraws);
+            for (size_t i = 0; i < numDraws; ++i)
+            {
+                size_t const shader = random() % numShaders;
+                size_t const texture = random() % numTextures;
+                float const depth = static_cast<float>(random() % 1000) / 1000.0f;
+                items[i] = RenderQueue::DrawItem{};
+                items[i].state = &states[shader * numTextures + texture];
+                items[i].count = 36;
+                keys[i] = RenderQueue::MakeKey(0, static_cast<uint32_t>(shader),
+                    static_cast<uint32_t>(texture), depth);
+            }
+
+            // The context is read through a volatile pointer so that the
+            // compiler cannot resolve and remove the virtual calls.
+            MockContext mockContext;
+            ID3D11DeviceContext* volatile opaqueContext = &mockContext;
+            ID3D11DeviceContext* context = opaqueContext;
+            NullBinder binder;
+            RenderQueue queue;
+            size_t numCalls[2] = { 0, 0 };
+            double nanoseconds[2] = { 0.0, 0.0 };
+            for (size_t sorted = 0; sorted < 2; ++sorted)
+            {
+                nanoseconds[sorted] = benchmark.Measure(numFrames, [&]()
+                {
+                    for (size_t frame = 0; frame < numFrames; ++frame)
+                    {
+                        queue.Clear();
+                        for (size_t i = 0; i < numDraws; ++i)
+                        {
+                            queue.Add(keys[i], items[i]);
+                        }
+                        if (sorted == 1)
+                        {
+                            queue.Sort();
+                        }
+                        queue.Submit(context, binder);
+                    }
+                });
+                numCalls[sorted] = queue.GetStatistics().numStateCalls;
+            }
+
+            double const allNanoseconds = benchmark.Measure(numFrames, [&]()
+            {
+                for (size_t frame = 0; frame < numFrames; ++frame)
+                {
+                    SubmitAll(context, items);
+                }
+            });
+
+            std::printf("%8zu %8zu %8zu %12.0f %12.0f %12.0f %12zu %12zu %12zu\n",
+                numDraws, numShaders, numTextures, nanoseconds[1], nanoseconds[0],
+                allNanoseconds, numCalls[1], numCalls[0], numDraws * numStatesPerDraw);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,325 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "RenderQueue.h"
+#include "MockD3D11.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+using namespace dxm;
+
+namespace
+{
+    // A context and constant binder that record the calls of Submit by
+    // name in one list. Submit is a template, so they need not be D3D11
+    // interfaces.
+    class RecordingContext
+    {
+    public:
+        void IASetInputLayout(ID3D11InputLayout*) { calls.push_back("IASetInputLayout"); }
+        void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY) { calls.push_back("IASetPrimitiveTopology"); }
+        void IASetVertexBuffers(UINT, UINT, ID3D11Buffer* const*, UINT const*, UINT const*) { calls.push_back("IASetVertexBuffers"); }
+        void IASetIndexBuffer(ID3D11Buffer*, DXGI_FORMAT, UINT) { calls.push_back("IASetIndexBuffer"); }
+        void VSSetShader(ID3D11VertexShader*, ID3D11ClassInstance* const*, UINT) { calls.push_back("VSSetShader"); }
+        void PSSetShader(ID3D11PixelShader*, ID3D11ClassInstance* const*, UINT) { calls.push_back("PSSetShader"); }
+        void PSSetShaderResources(UINT, UINT, ID3D11ShaderResourceView* const*) { calls.push_back("PSSetShaderResources"); }
+        void PSSetSamplers(UINT, UINT, ID3D11SamplerState* const*) { calls.push_back("PSSetSamplers"); }
+        void RSSetState(ID3D11RasterizerState*) { calls.push_back("RSSetState"); }
+        void OMSetBlendState(ID3D11BlendState*, FLOAT const*, UINT) { calls.push_back("OMSetBlendState"); }
+        void OMSetDepthStencilState(ID3D11DepthStencilState*, UINT) { calls.push_back("OMSetDepthStencilState"); }
+
+        void Draw(UINT count, UINT)
+        {
+            calls.push_back("Draw");
+            counts.push_back(count);
+        }
+
+        void DrawIndexed(UINT count, UINT, INT)
+        {
+            calls.push_back("DrawIndexed");
+            counts.push_back(count);
+        }
+
+        // The state calls between a draw and the previous one.
+        size_t NumStateCallsBeforeDraw(size_t draw) const
+        {
+            size_t numDraws = 0, numCalls = 0;
+            for (auto const& call : calls)
+            {
+                if (call == "Draw" || call == "DrawIndexed")
+                {
+                    if (numDraws++ == draw)
+                    {
+                        return numCalls;
+                    }
+                    numCalls = 0;
+                }
+                else
+                {
+                    ++numCalls;
+                }
+            }
+            return numCalls;
+        }
+
+        std::vector<std::string> calls;
+        std::vector<UINT> counts;
+    };
+
+    class RecordingBinder
+    {
+    public:
+        RecordingBinder(RecordingContext& context)
+            :
+            mContext(context)
+        {
+        }
+
+        void BindVS(UINT, ConstantBufferRing::Allocation const&)
+        {
+            mContext.calls.push_back("BindVS");
+        }
+
+        void BindPS(UINT, ConstantBufferRing::Allocation const&)
+        {
+            mContext.calls.push_back("BindPS");
+        }
+
+    private:
+        RecordingContext& mContext;
+    };
+
+    // Distinct, never dereferenced addresses for the state objects.
+    template <typename T>
+    T* Handle(uintptr_t value)
+    {
+        return reinterpret_cast<T*>(value * 16);
+    }
+
+    RenderQueue::DrawState MakeState(uintptr_t shader, uintptr_t texture, bool indexed)
+    {
+        RenderQueue::DrawState state{};
+        state.inputLayout = Handle<ID3D11InputLayout>(1);
+        state.topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        state.vertexBuffer = Handle<ID3D11Buffer>(2);
+        state.vertexStride = 32;
+        state.vertexOffset = 0;
+        state.indexBuffer = (indexed ? Handle<ID3D11Buffer>(3) : nullptr);
+        state.indexFormat = DXGI_FORMAT_R16_UINT;
+        state.indexOffset = 0;
+        state.vertexShader = Handle<ID3D11VertexShader>(10 + shader);
+        state.pixelShader = Handle<ID3D11PixelShader>(20 + shader);
+        state.psResource = Handle<ID3D11ShaderResourceView>(30 + texture);
+        state.psSampler = Handle<ID3D11SamplerState>(4);
+        state.rasterizerState = Handle<ID3D11RasterizerState>(5);
+        state.blendState = Handle<ID3D11BlendState>(6);
+        state.depthStencilState = Handle<ID3D11DepthStencilState>(7);
+        state.stencilReference = 0;
+        return state;
+    }
+
+    RenderQueue::DrawItem MakeItem(RenderQueue::DrawState const& state, UINT count,
+        UINT vsConstant, UINT psConstant)
+    {
+        RenderQueue::DrawItem item{};
+        item.state = &state;
+        if (vsConstant != 0)
+        {
+            item.vsConstants = { Handle<ID3D11Buffer>(8), vsConstant, 16 };
+        }
+        if (psConstant != 0)
+        {
+            item.psConstants = { Handle<ID3D11Buffer>(8), psConstant, 16 };
+        }
+        item.count = count;
+        item.first = 0;
+        item.baseVertex = 0;
+        return item;
+    }
+
+    void TestMakeKey()
+    {
+        uint64_t const key = RenderQueue::MakeKey(0x12, 0x345, 0x6789A, 1.0f);
+        DXM_CHECK((key >> 56) == 0x12);
+        DXM_CHECK(((key >> 44) & 0xFFF) == 0x345);
+        DXM_CHECK(((key >> 24) & 0xFFFFF) == 0x6789A);
+        DXM_CHECK((key & 0xFFFFFF) == 0xFFFFFF);
+
+        // The fields are masked to their widths.
+        DXM_CHECK(RenderQueue::MakeKey(0x1FF, 0, 0, 0.0f) == (uint64_t(0xFF) << 56));
+        DXM_CHECK(RenderQueue::MakeKey(0, 0x1FFF, 0, 0.0f) == (uint64_t(0xFFF) << 44));
+        DXM_CHECK(RenderQueue::MakeKey(0, 0, 0x1FFFFF, 0.0f) == (uint64_t(0xFFFFF) << 24));
+
+        // The depth is clamped and quantized.
+        DXM_CHECK(RenderQueue::MakeKey(0, 0, 0, -1.0f) == 0);
+        DXM_CHECK(RenderQueue::MakeKey(0, 0, 0, 2.0f) == 0xFFFFFF);
+        DXM_CHECK(RenderQueue::MakeKey(0, 0, 0, 0.25f) < RenderQueue::MakeKey(0, 0, 0, 0.5f));
+
+        // The pass dominates the shader, which dominates the material,
+        // which dominates the depth.
+        DXM_CHECK(RenderQueue::MakeKey(0, 0xFFF, 0xFFFFF, 1.0f) < RenderQueue::MakeKey(1, 0, 0, 0.0f));
+        DXM_CHECK(RenderQueue::MakeKey(1, 0, 0xFFFFF, 1.0f) < RenderQueue::MakeKey(1, 1, 0, 0.0f));
+        DXM_CHECK(RenderQueue::MakeKey(1, 1, 0, 1.0f) < RenderQueue::MakeKey(1, 1, 1, 0.0f));
+    }
+
+    // The order of the draws after Sort is given by the counts, which are
+    // the submission indices.
+    std::vector<UINT> SortAndSubmit(RenderQueue& queue)
+    {
+        queue.Sort();
+        RecordingContext context;
+        RecordingBinder binder(context);
+        queue.Submit(&context, binder);
+        return context.counts;
+    }
+
+    void TestSort()
+    {
+        RenderQueue::DrawState const state = MakeState(0, 0, false);
+        std::mt19937 random(7);
+        for (size_t numItems : { 0, 1, 2, 100, 5000 })
+        {
+            for (size_t keyRange : { 1, 8, 1 << 20 })
+            {
+                RenderQueue queue;
+                std::vector<std::pair<uint64_t, UINT>> expected;
+                for (size_t i = 0; i < numItems; ++i)
+                {
+                    // The keys share the pass and, for small key ranges,
+                    // most of their bytes, so that digits are skipped.
+                    uint64_t const key = RenderQueue::MakeKey(3, 0,
+                        static_cast<uint32_t>(random() % keyRange), 0.5f);
+                    queue.Add(key, MakeItem(state, static_cast<UINT>(i), 0, 0));
+                    expected.push_back(std::make_pair(key, static_cast<UINT>(i)));
+                }
+                DXM_CHECK(queue.GetNumItems() == numItems);
+
+                std::stable_sort(expected.begin(), expected.end(),
+                    [](std::pair<uint64_t, UINT> const& e0, std::pair<uint64_t, UINT> const& e1)
+                    {
+                        return e0.first < e1.first;
+                    });
+                std::vector<UINT> order = SortAndSubmit(queue);
+                DXM_CHECK(order.size() == numItems);
+                bool same = (order.size() == numItems);
+                for (size_t i = 0; same && i < numItems; ++i)
+                {
+                    same = (order[i] == expected[i].second);
+                }
+                DXM_CHECK(same);
+            }
+        }
+
+        // Keys that differ in every byte.
+        RenderQueue queue;
+        uint64_t const keys[] = { 0xFFEEDDCCBBAA9988ull, 0x0011223344556677ull,
+            0x8000000000000000ull, 0x00000000000000FFull, 0x0011223344556677ull };
+        for (size_t i = 0; i < 5; ++i)
+        {
+            queue.Add(keys[i], MakeItem(state, static_cast<UINT>(i), 0, 0));
+        }
+        std::vector<UINT> const order = SortAndSubmit(queue);
+        DXM_CHECK((order == std::vector<UINT>{ 3, 1, 4, 2, 0 }));
+
+        // Clear keeps nothing of the previous frame.
+        queue.Clear();
+        DXM_CHECK(queue.GetNumItems() == 0);
+        DXM_CHECK(SortAndSubmit(queue).empty());
+    }
+
+    void TestRedundantStateFiltering()
+    {
+        // Two shaders with two textures each, added interleaved. After
+        // sorting, the draws of a shader are adjacent.
+        RenderQueue::DrawState const states[4] =
+        {
+            MakeState(0, 0, true), MakeState(0, 1, true),
+            MakeState(1, 0, false), MakeState(1, 1, false)
+        };
+
+        RenderQueue queue;
+        for (UINT i = 0; i < 8; ++i)
+        {
+            uint32_t const shader = (i % 2), texture = (i / 2) % 2;
+            uint64_t const key = RenderQueue::MakeKey(0, shader, texture, 0.0f);
+            // The first two draws of each state share their constants.
+            queue.Add(key, MakeItem(states[2 * shader + texture], 100 + i, 16 * (1 + i / 4), 0));
+        }
+        queue.Sort();
+
+        RecordingContext context;
+        RecordingBinder binder(context);
+        queue.Submit(&context, binder);
+
+        // Submission order: shader 0 texture 0 (items 0, 4), shader 0
+        // texture 1 (2, 6), shader 1 texture 0 (1, 5), shader 1 texture 1
+        // (3, 7).
+        DXM_CHECK((context.counts == std::vector<UINT>{ 100, 104, 102, 106, 101, 105, 103, 107 }));
+
+        // The first draw sets all 11 states and the vertex constants; the
+        // pixel constants have no buffer and are never bound.
+        DXM_CHECK(context.NumStateCallsBeforeDraw(0) == 12);
+        DXM_CHECK(std::count(context.calls.begin(), context.calls.end(), "BindPS") == 0);
+
+        // The second draw changes only the vertex constants, the third only
+        // the texture and the constants, and the fourth only the constants.
+        DXM_CHECK(context.NumStateCallsBeforeDraw(1) == 1);
+        DXM_CHECK(context.NumStateCallsBeforeDraw(2) == 2);
+        DXM_CHECK(context.NumStateCallsBeforeDraw(3) == 1);
+
+        // The shader change also changes the index buffer (none) and the
+        // texture; the draws are not indexed.
+        DXM_CHECK(context.NumStateCallsBeforeDraw(4) == 5);
+        DXM_CHECK(context.NumStateCallsBeforeDraw(5) == 1);
+        DXM_CHECK(context.NumStateCallsBeforeDraw(6) == 2);
+        DXM_CHECK(context.NumStateCallsBeforeDraw(7) == 1);
+        DXM_CHECK(context.calls[context.calls.size() - 1] == "Draw");
+        DXM_CHECK(std::count(context.calls.begin(), context.calls.end(), "DrawIndexed") == 4);
+        DXM_CHECK(std::count(context.calls.begin(), context.calls.end(), "VSSetShader") == 2);
+        DXM_CHECK(std::count(context.calls.begin(), context.calls.end(), "IASetInputLayout") == 1);
+
+        RenderQueue::Statistics const& statistics = queue.GetStatistics();
+        DXM_CHECK(statistics.numDraws == 8);
+        DXM_CHECK(statistics.numStateCalls == 25);
+        DXM_CHECK(statistics.numStateCalls == context.calls.size() - 8);
+        DXM_CHECK(statistics.numStateCalls + statistics.numSkippedStateCalls == 8 * 12);
+
+        // A second Submit sets all the state of its first draw again, since
+        // the context may have been changed in between.
+        RecordingContext context2;
+        RecordingBinder binder2(context2);
+        queue.Submit(&context2, binder2);
+        DXM_CHECK(context2.NumStateCallsBeforeDraw(0) == 12);
+        DXM_CHECK(queue.GetStatistics().numStateCalls == statistics.numStateCalls);
+    }
+
+    void TestInterfaceContext()
+    {
+        // Submit compiles and runs with the D3D11 context interface.
+        RenderQueue::DrawState const state = MakeState(0, 0, true);
+        RenderQueue queue;
+        queue.Add(0, MakeItem(state, 3, 0, 0));
+        MockContext context;
+        RecordingContext recording;
+        RecordingBinder binder(recording);
+        ID3D11DeviceContext* interfaceContext = &context;
+        queue.Submit(interfaceContext, binder);
+        DXM_CHECK(queue.GetStatistics().numDraws == 1);
+        DXM_CHECK(queue.GetStatistics().numStateCalls == 11);
+    }
+}
+
+int main()
+{
+    TestMakeKey();
+    TestSort();
+    TestRedundantStateFiltering();
+    TestInterfaceContext();
+    return TestCheck::Report("RenderQueueTest");
+}
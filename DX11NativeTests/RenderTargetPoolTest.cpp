@@ -0,0 +1,161 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "RenderTargetPool.h"
+#include "MockD3D11.h"
+#include "TestCheck.h"
+#include <stdexcept>
+using namespace dxm;
+
+namespace
+{
+    DXGI_FORMAT constexpr format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+    // A released target is reused for the same width, height and format
+    // and for nothing else.
+    void TestReuse()
+    {
+        MockDevice device;
+        {
+            RenderTargetPool pool(&device);
+            auto const* target = pool.Acquire(64, 32, format);
+            DXM_CHECK(target->texture && target->rtv && target->srv);
+            DXM_CHECK(target->width == 64 && target->height == 32 && target->format == format);
+            DXM_CHECK(device.numCreates == 3 && pool.GetNumAcquired() == 1);
+
+            // An acquired target is not shared.
+            auto const* other = pool.Acquire(64, 32, format);
+            DXM_CHECK(other != target && pool.GetNumTargets() == 2);
+
+            pool.Release(target);
+            DXM_CHECK(pool.Acquire(64, 32, format) == target);
+            DXM_CHECK(pool.GetStatistics().numReused == 1);
+
+            // Another key creates a target.
+            pool.Release(target);
+            auto const* wide = pool.Acquire(32, 64, format);
+            auto const* bytes = pool.Acquire(64, 32, DXGI_FORMAT_B8G8R8A8_UNORM);
+            DXM_CHECK(wide != target && bytes != target && pool.GetNumTargets() == 4);
+            DXM_CHECK(pool.GetStatistics().numCreated == 4);
+
+            // Releasing twice or releasing null does nothing.
+            pool.Release(wide);
+            pool.Release(wide);
+            pool.Release(nullptr);
+            DXM_CHECK(pool.GetNumAcquired() == 2);
+            DXM_CHECK(pool.Acquire(32, 64, format) == wide);
+            DXM_CHECK(pool.Acquire(32, 64, format) != wide);
+        }
+        DXM_CHECK(MockCom::NumLiveObjects() == 1);
+    }
+
+    // A free target is destroyed after maxIdleFrames frames without use; an
+    // acquired target is never destroyed.
+    void TestEviction()
+    {
+        MockDevice device;
+        {
+            RenderTargetPool pool(&device);
+            auto const* idle = pool.Acquire(64, 64, format);
+            auto const* held = pool.Acquire(64, 64, format);
+            pool.Release(idle);
+            for (uint32_t frame = 0; frame < RenderTargetPool::maxIdleFrames; ++frame)
+            {
+                pool.NextFrame();
+            }
+            DXM_CHECK(pool.GetNumTargets() == 2);
+            pool.NextFrame();
+            DXM_CHECK(pool.GetNumTargets() == 1 && pool.GetStatistics().numDestroyed == 1);
+            DXM_CHECK(MockCom::NumLiveObjects() == 1 + 3);
+
+            // A use restarts the count.
+            for (uint32_t frame = 0; frame < 3 * RenderTargetPool::maxIdleFrames; ++frame)
+            {
+                pool.NextFrame();
+            }
+            pool.Release(held);
+            for (uint32_t frame = 0; frame < RenderTargetPool::maxIdleFrames; ++frame)
+            {
+                pool.NextFrame();
+                DXM_CHECK(pool.GetNumTargets() == 1);
+            }
+            DXM_CHECK(pool.Acquire(64, 64, format) == held);
+            pool.Release(held);
+            for (uint32_t frame = 0; frame <= RenderTargetPool::maxIdleFrames; ++frame)
+            {
+                pool.NextFrame();
+            }
+            DXM_CHECK(pool.GetNumTargets() == 0 && pool.GetStatistics().numDestroyed == 2);
+        }
+        DXM_CHECK(MockCom::NumLiveObjects() == 1);
+    }
+
+    // A failed creation throws and releases the objects already created.
+    void TestCreationFailure()
+    {
+        MockDevice device;
+        {
+            RenderTargetPool pool(&device);
+            device.failAtCreate = 1;
+            DXM_CHECK_THROWS(std::runtime_error, pool.Acquire(64, 64, format));
+            DXM_CHECK(pool.GetNumTargets() == 0 && pool.GetNumAcquired() == 0);
+            DXM_CHECK(MockCom::NumLiveObjects() == 1);
+        }
+    }
+
+    void TestScopedTarget()
+    {
+        MockDevice device;
+        {
+            RenderTargetPool pool(&device);
+            RenderTargetPool::Target const* target = nullptr;
+            {
+                ScopedTarget scoped(pool, pool.Acquire(64, 64, format));
+                target = scoped.Get();
+                DXM_CHECK(pool.GetNumAcquired() == 1);
+            }
+            DXM_CHECK(pool.GetNumAcquired() == 0);
+
+            // An exception releases the target.
+            try
+            {
+                ScopedTarget scoped(pool);
+                scoped.Reset(pool.Acquire(64, 64, format));
+                DXM_CHECK(scoped.Get() == target);
+                throw std::runtime_error("test");
+            }
+            catch (std::runtime_error const&)
+            {
+            }
+            DXM_CHECK(pool.GetNumAcquired() == 0);
+
+            // Reset releases the previous target; Detach keeps the target
+            // acquired.
+            RenderTargetPool::Target const* detached = nullptr;
+            {
+                ScopedTarget scoped(pool, pool.Acquire(64, 64, format));
+                scoped.Reset(pool.Acquire(32, 32, format));
+                DXM_CHECK(pool.GetNumAcquired() == 1);
+                detached = scoped.Detach();
+                DXM_CHECK(scoped.Get() == nullptr);
+            }
+            DXM_CHECK(pool.GetNumAcquired() == 1 && detached->width == 32);
+            pool.Release(detached);
+            DXM_CHECK(pool.GetNumAcquired() == 0);
+        }
+        DXM_CHECK(MockCom::NumLiveObjects() == 1);
+    }
+}
+
+int main()
+{
+    TestReuse();
+    TestEviction();
+    TestCreationFailure();
+    TestScopedTarget();
+    return TestCheck::Report("RenderTargetPoolTest");
+}
@@ -0,0 +1,168 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "RingAllocator.h"
+#include "TestCheck.h"
+#include <stdexcept>
+using namespace dxm;
+
+namespace
+{
+    void TestConstruction()
+    {
+        DXM_CHECK_THROWS(std::invalid_argument, RingAllocator(1024, 0));
+        DXM_CHECK_THROWS(std::invalid_argument, RingAllocator(1024, 24));
+        DXM_CHECK_THROWS(std::invalid_argument, RingAllocator(0, 256));
+        DXM_CHECK_THROWS(std::invalid_argument, RingAllocator(1000, 256));
+
+        RingAllocator ring(1024, 256);
+        DXM_CHECK(ring.GetCapacity() == 1024);
+        DXM_CHECK(ring.GetAlignment() == 256);
+        DXM_CHECK(ring.GetUsed() == 0);
+        DXM_CHECK(ring.GetNumFramesInFlight() == 0);
+    }
+
+    void TestAllocate()
+    {
+        RingAllocator ring(1024, 256);
+        bool wrapped = false;
+
+        // The first block of an empty ring starts at 0, which the caller
+        // treats as a wrap.
+        DXM_CHECK(ring.Allocate(1, wrapped) == 0);
+        DXM_CHECK(wrapped);
+        DXM_CHECK(ring.GetUsed() == 256);
+
+        DXM_CHECK(ring.Allocate(300, wrapped) == 256);
+        DXM_CHECK(!wrapped);
+        DXM_CHECK(ring.GetUsed() == 768);
+
+        DXM_CHECK(ring.Allocate(256, wrapped) == 768);
+        DXM_CHECK(!wrapped);
+        DXM_CHECK(ring.GetUsed() == 1024);
+
+        // The ring is full.
+        DXM_CHECK(ring.Allocate(1, wrapped) == RingAllocator::invalidOffset);
+        DXM_CHECK(!wrapped);
+
+        DXM_CHECK(ring.Allocate(0, wrapped) == RingAllocator::invalidOffset);
+        DXM_CHECK(ring.Allocate(1025, wrapped) == RingAllocator::invalidOffset);
+        DXM_CHECK(ring.GetUsed() == 1024);
+    }
+
+    void TestWrap()
+    {
+        RingAllocator ring(1024, 256);
+        bool wrapped = false;
+
+        // Frame 0 uses [0,512) and frame 1 uses [512,768).
+        ring.Allocate(512, wrapped);
+        ring.EndFrame();
+        DXM_CHECK(ring.Allocate(256, wrapped) == 512);
+        ring.EndFrame();
+        DXM_CHECK(ring.GetNumFramesInFlight() == 2);
+
+        // [768,1024) is free, but a 512-byte block does not fit there and
+        // frame 0 still holds the start of the ring.
+        DXM_CHECK(ring.Allocate(512, wrapped) == RingAllocator::invalidOffset);
+
+        // After frame 0 retires, the block wraps to 0 and the tail bytes
+        // [768,1024) are skipped.
+        DXM_CHECK(ring.RetireFrame());
+        DXM_CHECK(ring.GetUsed() == 256);
+        DXM_CHECK(ring.Allocate(512, wrapped) == 0);
+        DXM_CHECK(wrapped);
+        DXM_CHECK(ring.GetUsed() == 256 + 256 + 512);
+        ring.EndFrame();
+
+        // The ring is full until frame 1 retires, after which [512,768)
+        // is free again.
+        DXM_CHECK(ring.Allocate(256, wrapped) == RingAllocator::invalidOffset);
+        DXM_CHECK(ring.RetireFrame());
+        DXM_CHECK(ring.GetUsed() == 768);
+        DXM_CHECK(ring.Allocate(256, wrapped) == 512);
+        DXM_CHECK(!wrapped);
+        ring.EndFrame();
+
+        // Retiring the frame of the wrapped block releases the skipped tail
+        // bytes with it.
+        DXM_CHECK(ring.RetireFrame());
+        DXM_CHECK(ring.GetUsed() == 256);
+        DXM_CHECK(ring.RetireFrame());
+        DXM_CHECK(ring.GetUsed() == 0);
+        DXM_CHECK(!ring.RetireFrame());
+    }
+
+    void TestExactFitAtEnd()
+    {
+        // A block that ends exactly at the capacity moves the head to 0
+        // without skipping bytes.
+        RingAllocator ring(1024, 256);
+        bool wrapped = false;
+        ring.Allocate(256, wrapped);
+        ring.EndFrame();
+        DXM_CHECK(ring.Allocate(768, wrapped) == 256);
+        ring.EndFrame();
+        DXM_CHECK(ring.RetireFrame());
+        DXM_CHECK(ring.Allocate(256, wrapped) == 0);
+        DXM_CHECK(wrapped);
+        DXM_CHECK(ring.GetUsed() == 1024);
+    }
+
+    void TestReset()
+    {
+        RingAllocator ring(1024, 256);
+        bool wrapped = false;
+        ring.Allocate(512, wrapped);
+        ring.EndFrame();
+        ring.Allocate(256, wrapped);
+        ring.Reset();
+        DXM_CHECK(ring.GetUsed() == 0);
+        DXM_CHECK(ring.GetNumFramesInFlight() == 0);
+        DXM_CHECK(!ring.RetireFrame());
+        DXM_CHECK(ring.Allocate(1024, wrapped) == 0);
+        DXM_CHECK(wrapped);
+    }
+
+    void TestSteadyState()
+    {
+        // Frames of varying sizes, each retired two frames later as with
+        // two frames in flight, never fail and never exceed the capacity.
+        RingAllocator ring(64 * 256, 256);
+        bool wrapped = false;
+        size_t numWraps = 0;
+        for (size_t frame = 0; frame < 1000; ++frame)
+        {
+            size_t const numBlocks = 1 + frame % 7;
+            for (size_t block = 0; block < numBlocks; ++block)
+            {
+                size_t const offset = ring.Allocate(1 + (frame + block) % 600, wrapped);
+                DXM_CHECK(offset != RingAllocator::invalidOffset);
+                DXM_CHECK(offset % 256 == 0);
+                numWraps += (wrapped ? 1 : 0);
+            }
+            ring.EndFrame();
+            DXM_CHECK(ring.GetUsed() <= ring.GetCapacity());
+            if (ring.GetNumFramesInFlight() > 2)
+            {
+                ring.RetireFrame();
+            }
+        }
+        DXM_CHECK(numWraps > 1);
+    }
+}
+
+int main()
+{
+    TestConstruction();
+    TestAllocate();
+    TestWrap();
+    TestExactFitAtEnd();
+    TestReset();
+    TestSteadyState();
+    return TestCheck::Report("RingAllocatorTest");
+}
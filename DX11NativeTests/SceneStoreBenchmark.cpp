@@ -0,0 +1,213 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "SceneStore.h"
+#include "ThreadPool.h"
+#include "Benchmark.h"
+#include <memory>
+#include <random>
+#include <vector>
+using namespace dxm;
+
+// The transform propagation of SceneStore on 100k-node scenes, compared
+// with an object graph whose nodes have a virtual Update that recomputes
+// the node and recurses into its children. The 'wide' scene has a
+// branching factor of 8, the 'deep' scene is 100 chains of 1000 nodes,
+// and the 'random' scene attaches each node to a random earlier node. The
+// edits are a full update (every local transform changed), 1% of the
+// nodes at random, one subtree of about 1% of the nodes, one leaf and no
+// change. The columns are the times per Update in microseconds with one
+// thread and with the hardware threads, and the number of nodes
+// recomputed.
+
+namespace
+{
+    using Matrix = std::array<float, 12>;
+
+    Matrix const identity = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f };
+
+    Matrix Translation(float x)
+    {
+        Matrix result = identity;
+        result[3] = x;
+        return result;
+    }
+
+    class GraphNode
+    {
+    public:
+        GraphNode(Matrix const& local)
+            :
+            local(local),
+            world(identity)
+        {
+        }
+
+        virtual ~GraphNode() = default;
+
+        virtual void Update(Matrix const& parentWorld)
+        {
+            for (size_t r = 0; r < 3; ++r)
+            {
+                for (size_t c = 0; c < 4; ++c)
+                {
+                    world[4 * r + c] = parentWorld[4 * r] * local[c] +
+                        parentWorld[4 * r + 1] * local[4 + c] +
+                        parentWorld[4 * r + 2] * local[8 + c];
+                }
+                world[4 * r + 3] += parentWorld[4 * r + 3];
+            }
+            for (auto& child : children)
+            {
+                child->Update(world);
+            }
+        }
+
+        Matrix local, world;
+        std::vector<std::unique_ptr<GraphNode>> children;
+    };
+
+    // The parent of each node, which precedes it; invalidNode for a root.
+    std::vector<uint32_t> MakeShape(char const* shape, size_t numNodes, std::mt19937& random)
+    {
+        std::vector<uint32_t> parents(numNodes);
+        for (size_t i = 0; i < numNodes; ++i)
+        {
+            if (shape[0] == 'w')
+            {
+                parents[i] = (i == 0 ? SceneStore::invalidNode : static_cast<uint32_t>((i - 1) / 8));
+            }
+            else if (shape[0] == 'd')
+            {
+                parents[i] = (i % 1000 == 0 ? SceneStore::invalidNode : static_cast<uint32_t>(i - 1));
+            }
+            else
+            {
+                parents[i] = (i < 10 ? SceneStore::invalidNode :
+                    static_cast<uint32_t>(random() % i));
+            }
+        }
+        return parents;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Benchmark benchmark(argc, argv);
+    size_t const numNodes = 100000;
+    size_t const numUpdates = benchmark.Iterations(200) + 1;
+    ThreadPool serial(1), parallel;
+
+    std::printf("%8s %8s %12s %12s %12s %10s\n", "scene", "edit", "graph us",
+        "1 thread us", "pool us", "recomputed");
+    for (char const* shape : { "wide", "deep", "random" })
+    {
+        std::mt19937 random(23);
+        auto const parents = MakeShape(shape, numNodes, random);
+
+        SceneStore scene;
+        scene.Reserve(numNodes);
+        std::vector<std::unique_ptr<GraphNode>> roots;
+        std::vector<GraphNode*> graphNodes(numNodes);
+        for (size_t i = 0; i < numNodes; ++i)
+        {
+            Matrix const local = Translation(static_cast<float>(i % 7));
+            (void)scene.AddNode(parents[i], local);
+            auto node = std::make_unique<GraphNode>(local);
+            graphNodes[i] = node.get();
+            if (parents[i] == SceneStore::invalidNode)
+            {
+                roots.push_back(std::move(node));
+            }
+            else
+            {
+                graphNodes[parents[i]]->children.push_back(std::move(node));
+            }
+        }
+        (void)scene.Update(serial);
+
+        // A subtree of about 1% of the nodes: the deepest ancestor of a
+        // random node with at least that many descendants.
+        std::vector<size_t> subtreeSize(numNodes, 1);
+        for (size_t i = numNodes; i-- > 1; )
+        {
+            if (parents[i] != SceneStore::invalidNode)
+            {
+                subtreeSize[parents[i]] += subtreeSize[i];
+            }
+        }
+        uint32_t subtree = static_cast<uint32_t>(numNodes - 1);
+        while (subtreeSize[subtree] < numNodes / 100 && parents[subtree] != SceneStore::invalidNode)
+        {
+            subtree = parents[subtree];
+        }
+
+        std::vector<uint32_t> sample(numNodes / 100);
+        for (auto& node : sample)
+        {
+            node = static_cast<uint32_t>(random() % numNodes);
+        }
+
+        struct Edit
+        {
+            char const* name;
+            std::vector<uint32_t> nodes;
+        };
+        std::vector<Edit> edits(5);
+        edits[0].name = "full";
+        for (uint32_t i = 0; i < numNodes; ++i)
+        {
+            edits[0].nodes.push_back(i);
+        }
+        edits[1] = Edit{ "1%", sample };
+        edits[2] = Edit{ "subtree", { subtree } };
+        edits[3] = Edit{ "leaf", { static_cast<uint32_t>(numNodes - 1) } };
+        edits[4] = Edit{ "none", {} };
+
+        double const graph = 1e-3 * benchmark.Measure(numUpdates, [&]()
+        {
+            for (size_t update = 0; update < numUpdates; ++update)
+            {
+                for (auto& root : roots)
+                {
+                    root->Update(identity);
+                }
+            }
+            DoNotOptimize(graphNodes.back()->world[3]);
+        });
+
+        for (auto const& edit : edits)
+        {
+            size_t recomputed = 0;
+            auto run = [&](ThreadPool& pool)
+            {
+                return 1e-3 * benchmark.Measure(numUpdates, [&]()
+                {
+                    for (size_t update = 0; update < numUpdates; ++update)
+                    {
+                        for (uint32_t node : edit.nodes)
+                        {
+                            scene.SetLocal(node, Translation(static_cast<float>(update % 5)));
+                        }
+                        recomputed = scene.Update(pool);
+                    }
+                    DoNotOptimize(recomputed);
+                });
+            };
+            double const one = run(serial);
+            double const many = run(parallel);
+
+            // The object graph has no dirty tracking and always updates
+            // every node.
+            std::printf("%8s %8s %12.1f %12.1f %12.1f %10zu\n", shape, edit.name, graph,
+                one, many, recomputed);
+        }
+    }
+    std::printf("pool threads: %zu\n", parallel.GetNumThreads());
+    return 0;
+}
@@ -0,0 +1,244 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "SceneStore.h"
+#include "ThreadPool.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+using namespace dxm;
+
+namespace
+{
+    using Matrix = std::array<float, 12>;
+
+    Matrix Translation(float x, float y, float z)
+    {
+        return Matrix{ 1.0f, 0.0f, 0.0f, x, 0.0f, 1.0f, 0.0f, y, 0.0f, 0.0f, 1.0f, z };
+    }
+
+    // A rotation about z with a uniform scale and a translation.
+    Matrix RandomTransform(std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        float const angle = unit(random);
+        float const s = 1.0f + 0.1f * unit(random);
+        float const c = s * std::cos(angle), n = s * std::sin(angle);
+        return Matrix{ c, -n, 0.0f, unit(random), n, c, 0.0f, unit(random),
+            0.0f, 0.0f, s, unit(random) };
+    }
+
+    Matrix Multiply(Matrix const& P, Matrix const& L)
+    {
+        Matrix W;
+        for (size_t r = 0; r < 3; ++r)
+        {
+            for (size_t c = 0; c < 4; ++c)
+            {
+                W[4 * r + c] = P[4 * r] * L[c] + P[4 * r + 1] * L[4 + c] +
+                    P[4 * r + 2] * L[8 + c];
+            }
+            W[4 * r + 3] += P[4 * r + 3];
+        }
+        return W;
+    }
+
+    // The world transform by walking the parents.
+    Matrix ReferenceWorld(SceneStore const& scene, uint32_t node)
+    {
+        uint32_t const parent = scene.GetParent(node);
+        Matrix const local = scene.GetLocal(node);
+        return parent == SceneStore::invalidNode ? local :
+            Multiply(ReferenceWorld(scene, parent), local);
+    }
+
+    bool IsClose(Matrix const& a, Matrix const& b)
+    {
+        for (size_t i = 0; i < 12; ++i)
+        {
+            if (std::fabs(a[i] - b[i]) > 1e-4f * (1.0f + std::fabs(b[i])))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TestBasic()
+    {
+        ThreadPool pool(1);
+        SceneStore scene;
+        uint32_t const root = scene.AddNode(SceneStore::invalidNode, Translation(1, 0, 0));
+        uint32_t const a = scene.AddNode(root, Translation(0, 2, 0));
+        uint32_t const b = scene.AddNode(a, Translation(0, 0, 3));
+        uint32_t const c = scene.AddNode(root, Translation(4, 0, 0));
+        DXM_CHECK(scene.Update(pool) == 4);
+        DXM_CHECK(scene.GetNumLevels() == 3 && scene.GetNumNodes() == 4);
+        DXM_CHECK(scene.GetWorld(b) == Translation(1, 2, 3));
+        DXM_CHECK(scene.GetWorld(c) == Translation(5, 0, 0));
+
+        // Only the changed subtrees are recomputed.
+        DXM_CHECK(scene.Update(pool) == 0);
+        scene.SetLocal(b, Translation(0, 0, 5));
+        DXM_CHECK(scene.Update(pool) == 1);
+        DXM_CHECK(scene.GetWorld(b) == Translation(1, 2, 5));
+        scene.SetLocal(a, Translation(0, 1, 0));
+        DXM_CHECK(scene.Update(pool) == 2);
+        scene.SetLocal(root, Translation(0, 0, 0));
+        DXM_CHECK(scene.Update(pool) == 4);
+        DXM_CHECK(scene.GetWorld(b) == Translation(0, 1, 5));
+
+        // Reparenting moves the subtree.
+        scene.SetParent(a, c);
+        DXM_CHECK(scene.Update(pool) == 2);
+        DXM_CHECK(scene.GetWorld(b) == Translation(4, 1, 5));
+        DXM_CHECK(scene.GetNumLevels() == 4);
+
+        DXM_CHECK_THROWS(std::invalid_argument, scene.SetParent(c, b));
+        DXM_CHECK_THROWS(std::invalid_argument, scene.SetParent(a, a));
+        DXM_CHECK_THROWS(std::invalid_argument, scene.RemoveNode(a));
+        DXM_CHECK_THROWS(std::invalid_argument, scene.AddNode(100, Translation(0, 0, 0)));
+        scene.RemoveNode(b);
+        DXM_CHECK_THROWS(std::invalid_argument, scene.RemoveNode(b));
+        DXM_CHECK(scene.Update(pool) == 0);
+        DXM_CHECK(scene.GetNumNodes() == 3);
+
+        // The handle of the removed node is reused.
+        DXM_CHECK(scene.AddNode(a, Translation(0, 0, 1)) == b);
+        DXM_CHECK(scene.Update(pool) == 1);
+        DXM_CHECK(scene.GetWorld(b) == Translation(4, 1, 1));
+    }
+
+    // Random edits, checked against the transforms computed by walking
+    // the parents and against the number of nodes in the edited subtrees.
+    // The small grain size splits the levels among the threads.
+    void TestRandomEdits()
+    {
+        ThreadPool pool(4);
+        std::mt19937 random(17);
+        SceneStore scene;
+        std::vector<uint32_t> nodes;
+        std::vector<uint8_t> edited;
+        auto add = [&](uint32_t parent)
+        {
+            uint32_t const node = scene.AddNode(parent, RandomTransform(random));
+            nodes.push_back(node);
+            edited.resize(std::max<size_t>(edited.size(), node + 1));
+            edited[node] = 1;
+        };
+
+        for (size_t i = 0; i < 3000; ++i)
+        {
+            add(nodes.empty() || random() % 50 == 0 ? SceneStore::invalidNode :
+                nodes[random() % nodes.size()]);
+        }
+
+        bool correct = true, counted = true;
+        for (size_t round = 0; round < 20; ++round)
+        {
+            // The number of live nodes with an edited ancestor or self.
+            size_t expected = 0;
+            for (uint32_t node : nodes)
+            {
+                uint32_t ancestor = node;
+                while (ancestor != SceneStore::invalidNode && !edited[ancestor])
+                {
+                    ancestor = scene.GetParent(ancestor);
+                }
+                expected += (ancestor != SceneStore::invalidNode ? 1 : 0);
+            }
+
+            counted = counted && scene.Update(pool, 16) == expected;
+            for (uint32_t node : nodes)
+            {
+                correct = correct && IsClose(scene.GetWorld(node), ReferenceWorld(scene, node));
+            }
+            std::fill(edited.begin(), edited.end(), 0);
+
+            for (size_t i = 0; i < 1 + round * round; ++i)
+            {
+                uint32_t const node = nodes[random() % nodes.size()];
+                scene.SetLocal(node, RandomTransform(random));
+                edited[node] = 1;
+            }
+            if (round % 3 == 1)
+            {
+                uint32_t const node = nodes[random() % nodes.size()];
+                uint32_t const parent = nodes[random() % nodes.size()];
+                try
+                {
+                    scene.SetParent(node, parent);
+                    edited[node] = 1;
+                }
+                catch (std::invalid_argument const&)
+                {
+                }
+            }
+            if (round % 4 == 2)
+            {
+                for (size_t i = 0; i < 10; ++i)
+                {
+                    size_t const j = random() % nodes.size();
+                    try
+                    {
+                        scene.RemoveNode(nodes[j]);
+                        edited[nodes[j]] = 0;
+                        nodes[j] = nodes.back();
+                        nodes.pop_back();
+                    }
+                    catch (std::invalid_argument const&)
+                    {
+                    }
+                }
+                add(nodes[random() % nodes.size()]);
+            }
+        }
+        DXM_CHECK(correct);
+        DXM_CHECK(counted);
+        DXM_CHECK(scene.GetNumNodes() == nodes.size());
+    }
+
+    // WriteInstances copies the transforms that the last Update recomputed.
+    void TestWriteInstances()
+    {
+        ThreadPool pool(1);
+        InstanceStore instances;
+        std::array<float, 3> const center{}, extent{ 1.0f, 1.0f, 1.0f };
+        uint32_t const i0 = instances.Add(center, extent, Translation(0, 0, 0));
+        uint32_t const i1 = instances.Add(center, extent, Translation(0, 0, 0));
+
+        SceneStore scene;
+        uint32_t const root = scene.AddNode(SceneStore::invalidNode, Translation(1, 0, 0), i0);
+        uint32_t const left = scene.AddNode(root, Translation(0, 1, 0));
+        uint32_t const right = scene.AddNode(root, Translation(0, 2, 0), i1);
+        (void)scene.Update(pool);
+        scene.WriteInstances(instances);
+        DXM_CHECK(instances.GetWorld(3)[i0] == 1.0f && instances.GetWorld(7)[i1] == 2.0f);
+
+        instances.SetWorld(i0, Translation(9, 9, 9));
+        instances.SetWorld(i1, Translation(9, 9, 9));
+        scene.SetLocal(left, Translation(0, 3, 0));
+        (void)scene.Update(pool);
+        scene.WriteInstances(instances);
+        DXM_CHECK(instances.GetWorld(3)[i0] == 9.0f && instances.GetWorld(7)[i1] == 9.0f);
+
+        scene.SetLocal(right, Translation(0, 4, 0));
+        (void)scene.Update(pool);
+        scene.WriteInstances(instances);
+        DXM_CHECK(instances.GetWorld(3)[i0] == 9.0f && instances.GetWorld(7)[i1] == 4.0f);
+    }
+}
+
+int main()
+{
+    TestBasic();
+    TestRandomEdits();
+    TestWriteInstances();
+    return TestCheck::Report("SceneStoreTest");
+}
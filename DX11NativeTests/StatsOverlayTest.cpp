@@ -0,0 +1,101 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "StatsOverlay.h"
+#include "MockD3D11.h"
+#include "TestCheck.h"
+#include <d3dcompiler.h>
+#include <vector>
+using namespace dxm;
+
+// The shaders of the overlay compile to empty blobs.
+HRESULT D3DCompile(void const*, SIZE_T, char const*, void const*, void*, char const*,
+    char const*, UINT, UINT, ID3DBlob** code, ID3DBlob** errors)
+{
+    *code = new ID3DBlob();
+    *errors = nullptr;
+    return S_OK;
+}
+
+namespace
+{
+    size_t constexpr instanceBytes = 36;
+    size_t constexpr firstFieldInstance = 2 + StatsOverlay::graphSamples;
+
+    using Ranges = std::vector<std::pair<size_t, size_t>>;
+
+    // The instance ranges of the UpdateSubresource calls made by a Draw.
+    Ranges Draw(StatsOverlay& overlay, MockContext& context, ConstantBufferRing& constants)
+    {
+        size_t const first = context.updates.size();
+        overlay.Draw(&context, constants, 640, 480);
+        Ranges ranges;
+        for (size_t i = first; i < context.updates.size(); ++i)
+        {
+            D3D11_BOX const& box = context.updates[i].box;
+            ranges.emplace_back(box.left / instanceBytes, box.right / instanceBytes);
+        }
+        return ranges;
+    }
+
+    void TestDirtyRanges()
+    {
+        MockDevice device;
+        MockContext context;
+        {
+            ConstantBufferRing constants(&device, &context, 1024);
+            StatsOverlay overlay;
+            size_t const fps = overlay.AddField(0, 0, 8);
+            size_t const frame = overlay.AddField(0, 1, 8);
+            overlay.SetField(fps, "FPS 60");
+            overlay.SetField(frame, "MS 16.6");
+            overlay.CreateResources(&device);
+
+            // The first draw uploads everything, the graph and the fields
+            // separately.
+            size_t const end = firstFieldInstance + 16;
+            DXM_CHECK((Draw(overlay, context, constants) ==
+                Ranges{ { 0, firstFieldInstance }, { firstFieldInstance, end } }));
+
+            // Unchanged text uploads nothing.
+            overlay.SetField(fps, "FPS 60");
+            DXM_CHECK(Draw(overlay, context, constants).empty());
+
+            // A bar and two digits upload their own instances, not the bars
+            // between them.
+            overlay.AddGraphSample(16.0f);
+            overlay.SetField(fps, "FPS 59");
+            DXM_CHECK((Draw(overlay, context, constants) ==
+                Ranges{ { 2, 3 }, { firstFieldInstance + 4, firstFieldInstance + 6 } }));
+
+            overlay.SetField(frame, "MS 16.9");
+            DXM_CHECK((Draw(overlay, context, constants) ==
+                Ranges{ { firstFieldInstance + 14, firstFieldInstance + 15 } }));
+
+            overlay.AddGraphSample(20.0f);
+            overlay.AddGraphSample(40.0f);
+            DXM_CHECK((Draw(overlay, context, constants) == Ranges{ { 3, 5 } }));
+
+            auto const& statistics = overlay.GetStatistics();
+            DXM_CHECK(statistics.numUploads == 6);
+            DXM_CHECK(statistics.numInstancesUploaded == end + 3 + 1 + 2);
+
+            // A field added after creation grows the buffer, which is
+            // uploaded in full.
+            (void)overlay.AddField(0, 2, 4);
+            DXM_CHECK((Draw(overlay, context, constants) ==
+                Ranges{ { 0, firstFieldInstance }, { firstFieldInstance, end + 4 } }));
+        }
+        DXM_CHECK(MockCom::NumLiveObjects() == 2);
+    }
+}
+
+int main()
+{
+    TestDirtyRanges();
+    return TestCheck::Report("StatsOverlayTest");
+}
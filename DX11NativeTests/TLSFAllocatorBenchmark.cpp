@@ -0,0 +1,92 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "TLSFAllocator.h"
+#include "Benchmark.h"
+#include <random>
+#include <vector>
+using namespace dxm;
+
+// The speed of Allocate and Free with a number of live allocations, and
+// the fragmentation after a churn of random allocations and frees, as
+// GeometryHeap sees when meshes are streamed in and out. The sizes are
+// uniform in [1, maxSize] units of a 16M-unit range. 'failed' is the
+// fraction of the allocations that failed during the churn, and 'compact'
+// is the number of units Compact moves to remove the fragmentation.
+
+int main(int argc, char** argv)
+{
+    Benchmark benchmark(argc, argv);
+    size_t const capacity = static_cast<size_t>(1) << 24;
+    size_t const numOperations = benchmark.Iterations(1000000);
+
+    std::printf("%10s %8s %14s %14s %10s %10s %12s\n", "maxSize", "live",
+        "alloc+free ns", "fragmentation", "used", "failed", "compact");
+    for (size_t maxSize : { 64, 4096, 65536 })
+    {
+        for (size_t numLive : { 100, 10000 })
+        {
+            std::mt19937 random(11);
+            std::uniform_int_distribution<size_t> sizes(1, maxSize);
+            std::vector<size_t> sizeTable(4096);
+            for (auto& size : sizeTable)
+            {
+                size = sizes(random);
+            }
+
+            // Fill to the live count, or until the range is full, then
+            // replace an allocation per operation. When the new allocation
+            // fails, the old one is kept.
+            TLSFAllocator allocator(capacity);
+            std::vector<uint32_t> live;
+            for (size_t i = 0; i < numLive; ++i)
+            {
+                auto const allocation = allocator.Allocate(sizeTable[i % sizeTable.size()]);
+                if (allocation.block != TLSFAllocator::invalidBlock)
+                {
+                    live.push_back(allocation.block);
+                }
+            }
+
+            size_t numFailed = 0, numAttempts = 0, step = 0;
+            double const nanoseconds = benchmark.Measure(numOperations, [&]()
+            {
+                for (size_t i = 0; i < numOperations; ++i, ++step)
+                {
+                    size_t const j = (step * 2654435761u) % live.size();
+                    auto const allocation = allocator.Allocate(sizeTable[step % sizeTable.size()]);
+                    ++numAttempts;
+                    if (allocation.block != TLSFAllocator::invalidBlock)
+                    {
+                        allocator.Free(live[j]);
+                        live[j] = allocation.block;
+                    }
+                    else
+                    {
+                        ++numFailed;
+                    }
+                }
+            });
+            DoNotOptimize(live[0]);
+
+            double const fragmentation = allocator.GetFragmentation();
+            double const used = static_cast<double>(allocator.GetUsed()) /
+                static_cast<double>(capacity);
+            size_t moved = 0;
+            TLSFAllocator::Move move{};
+            while (allocator.Compact(move))
+            {
+                moved += move.size;
+            }
+
+            std::printf("%10zu %8zu %14.1f %14.3f %10.3f %10.4f %12zu\n", maxSize, numLive,
+                nanoseconds, fragmentation, used,
+                static_cast<double>(numFailed) / static_cast<double>(numAttempts), moved);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,247 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "TLSFAllocator.h"
+#include "GeometryHeap.h"
+#include "MockD3D11.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <vector>
+using namespace dxm;
+
+namespace
+{
+    // The allocations do not overlap, lie in the range and add up to the
+    // used count.
+    bool IsConsistent(TLSFAllocator const& allocator, std::vector<uint32_t> const& blocks)
+    {
+        std::vector<std::pair<size_t, size_t>> ranges;
+        size_t used = 0;
+        for (uint32_t block : blocks)
+        {
+            ranges.emplace_back(allocator.GetOffset(block), allocator.GetSize(block));
+            used += allocator.GetSize(block);
+        }
+        std::sort(ranges.begin(), ranges.end());
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            size_t const end = ranges[i].first + ranges[i].second;
+            if (end > allocator.GetCapacity() ||
+                (i + 1 < ranges.size() && end > ranges[i + 1].first))
+            {
+                return false;
+            }
+        }
+        return used == allocator.GetUsed() && blocks.size() == allocator.GetNumAllocations();
+    }
+
+    // A block of exactly the requested size is found although its class
+    // also holds smaller blocks.
+    void TestExactFit()
+    {
+        for (size_t capacity : { 1, 15, 16, 17, 1000, 3000, 65536, 65537 })
+        {
+            TLSFAllocator allocator(capacity);
+            auto const whole = allocator.Allocate(capacity);
+            DXM_CHECK(whole.block != TLSFAllocator::invalidBlock);
+            DXM_CHECK(whole.offset == 0 && whole.size == capacity);
+            DXM_CHECK(allocator.Allocate(1).block == TLSFAllocator::invalidBlock);
+            allocator.Free(whole.block);
+            DXM_CHECK(allocator.GetLargestFree() == capacity);
+        }
+
+        // A gap of exactly the size, between two allocations.
+        TLSFAllocator allocator(3000);
+        auto const a = allocator.Allocate(1000);
+        auto const b = allocator.Allocate(1000);
+        auto const c = allocator.Allocate(1000);
+        DXM_CHECK(c.block != TLSFAllocator::invalidBlock && c.offset == 2000);
+        allocator.Free(b.block);
+        DXM_CHECK(allocator.Allocate(1001).block == TLSFAllocator::invalidBlock);
+        auto const d = allocator.Allocate(1000);
+        DXM_CHECK(d.block != TLSFAllocator::invalidBlock && d.offset == 1000);
+        DXM_CHECK(allocator.GetUsed() == 3000 && allocator.GetNumAllocations() == 3);
+        (void)a;
+
+        DXM_CHECK(allocator.Allocate(0).block == TLSFAllocator::invalidBlock);
+        DXM_CHECK_THROWS(std::invalid_argument, TLSFAllocator(0));
+    }
+
+    // Freeing a block that is free, that was merged into a neighbor or
+    // that does not exist throws and leaves the counts unchanged.
+    void TestInvalidFree()
+    {
+        TLSFAllocator allocator(100);
+        auto const a = allocator.Allocate(10);
+        auto const b = allocator.Allocate(10);
+        allocator.Free(b.block);
+        DXM_CHECK_THROWS(std::invalid_argument, allocator.Free(b.block));
+
+        // 'a' absorbs the free block that follows it, which was 'b'.
+        allocator.Free(a.block);
+        DXM_CHECK(allocator.GetNumAllocations() == 0 && allocator.GetUsed() == 0);
+        DXM_CHECK_THROWS(std::invalid_argument, allocator.Free(b.block));
+        DXM_CHECK_THROWS(std::invalid_argument, allocator.Free(a.block));
+        DXM_CHECK_THROWS(std::invalid_argument, allocator.Free(1000));
+        DXM_CHECK(allocator.GetNumAllocations() == 0 && allocator.GetUsed() == 0);
+        DXM_CHECK(allocator.GetLargestFree() == 100);
+    }
+
+    void TestRandom()
+    {
+        std::mt19937 random(3);
+        std::uniform_int_distribution<size_t> sizes(1, 3000);
+        TLSFAllocator allocator(1 << 20);
+        std::vector<uint32_t> blocks;
+        bool consistent = true;
+        for (size_t i = 0; i < 20000; ++i)
+        {
+            if (blocks.empty() || random() % 3 != 0)
+            {
+                size_t const size = sizes(random);
+                auto const allocation = allocator.Allocate(size);
+                if (allocation.block != TLSFAllocator::invalidBlock)
+                {
+                    consistent = consistent && allocation.size == size;
+                    blocks.push_back(allocation.block);
+                }
+                else
+                {
+                    // A failure means that no free block is large enough
+                    // or the free block that is (in the class of the size)
+                    // is not found by the search, which does not happen.
+                    consistent = consistent && allocator.GetLargestFree() < size;
+                }
+            }
+            else
+            {
+                size_t const j = random() % blocks.size();
+                allocator.Free(blocks[j]);
+                blocks[j] = blocks.back();
+                blocks.pop_back();
+            }
+
+            if (i % 100 == 0)
+            {
+                consistent = consistent && IsConsistent(allocator, blocks);
+            }
+        }
+        DXM_CHECK(consistent);
+
+        for (uint32_t block : blocks)
+        {
+            allocator.Free(block);
+        }
+        DXM_CHECK(allocator.GetUsed() == 0 && allocator.GetNumAllocations() == 0);
+        DXM_CHECK(allocator.GetLargestFree() == allocator.GetCapacity());
+        DXM_CHECK(allocator.GetFragmentation() == 0.0);
+    }
+
+    // Compact moves every allocation to the front, the moves preserve the
+    // tags, and the free space ends as one block.
+    void TestCompact()
+    {
+        std::mt19937 random(5);
+        TLSFAllocator allocator(100000);
+        std::vector<uint32_t> blocks;
+        std::map<uint32_t, size_t> offsets;
+        for (uint32_t tag = 0; tag < 200; ++tag)
+        {
+            auto const allocation = allocator.Allocate(1 + random() % 400, tag);
+            blocks.push_back(allocation.block);
+        }
+        for (size_t i = 0; i < blocks.size(); i += 2)
+        {
+            allocator.Free(blocks[i]);
+        }
+        std::vector<uint32_t> kept;
+        for (size_t i = 1; i < blocks.size(); i += 2)
+        {
+            kept.push_back(blocks[i]);
+            offsets[blocks[i]] = allocator.GetOffset(blocks[i]);
+        }
+        DXM_CHECK(allocator.GetFragmentation() > 0.0);
+
+        TLSFAllocator::Move move{};
+        bool ordered = true;
+        size_t numMoves = 0;
+        while (allocator.Compact(move))
+        {
+            ordered = ordered && move.newOffset < move.oldOffset &&
+                offsets[move.block] == move.oldOffset && move.tag % 2 == 1;
+            offsets[move.block] = move.newOffset;
+            ++numMoves;
+        }
+        DXM_CHECK(ordered && numMoves == kept.size());
+        DXM_CHECK(IsConsistent(allocator, kept));
+        DXM_CHECK(allocator.GetFragmentation() == 0.0);
+        DXM_CHECK(allocator.GetLargestFree() == allocator.GetCapacity() - allocator.GetUsed());
+
+        size_t end = 0;
+        for (uint32_t block : kept)
+        {
+            DXM_CHECK(allocator.GetOffset(block) == offsets[block]);
+            end = std::max(end, allocator.GetOffset(block) + allocator.GetSize(block));
+        }
+        DXM_CHECK(end == allocator.GetUsed());
+        DXM_CHECK(!allocator.Compact(move));
+
+        allocator.Reset();
+        DXM_CHECK(allocator.GetNumAllocations() == 0);
+        DXM_CHECK(allocator.Allocate(100000).block != TLSFAllocator::invalidBlock);
+    }
+
+    // A mesh that fills a page, and a mesh larger than a page, are stored at
+    // the start of a new page. A page that cannot be created does not leave
+    // a mesh behind.
+    void TestGeometryHeap()
+    {
+        MockDevice device;
+        MockContext context;
+        std::vector<float> vertices(3 * 2000);
+        std::vector<uint16_t> indices(6000);
+        {
+            GeometryHeap heap(&device, &context, 12, DXGI_FORMAT_R16_UINT, 1000, 3000);
+            uint32_t const small = heap.AddMesh(vertices.data(), 10, indices.data(), 30);
+            uint32_t const full = heap.AddMesh(vertices.data(), 1000, indices.data(), 3000);
+            uint32_t const large = heap.AddMesh(vertices.data(), 2000, indices.data(), 6000);
+            DXM_CHECK(heap.GetNumPages() == 3 && heap.GetNumMeshes() == 3);
+
+            auto const draw = heap.GetDraw(full);
+            DXM_CHECK(draw.page == 1 && draw.baseVertex == 0 && draw.firstIndex == 0);
+            DXM_CHECK(draw.indexCount == 3000);
+            DXM_CHECK(heap.GetDraw(large).page == 2 && heap.GetDraw(large).indexCount == 6000);
+            DXM_CHECK(heap.GetDraw(small).page == 0);
+            DXM_CHECK(context.updates.size() == 6);
+            DXM_CHECK(context.updates[3].box.left == 0 && context.updates[3].box.right == 6000);
+
+            device.failAtCreate = device.numCreates;
+            DXM_CHECK_THROWS(std::runtime_error,
+                heap.AddMesh(vertices.data(), 1500, indices.data(), 30));
+            DXM_CHECK(heap.GetNumMeshes() == 3 && heap.GetNumPages() == 3);
+
+            heap.RemoveMesh(full);
+            DXM_CHECK_THROWS(std::invalid_argument, heap.RemoveMesh(full));
+            DXM_CHECK(heap.AddMesh(vertices.data(), 1000, indices.data(), 3000) == full);
+            DXM_CHECK(heap.GetDraw(full).page == 1);
+        }
+        DXM_CHECK(MockCom::NumLiveObjects() == 2);
+    }
+}
+
+int main()
+{
+    TestExactFit();
+    TestInvalidFree();
+    TestRandom();
+    TestCompact();
+    TestGeometryHeap();
+    return TestCheck::Report("TLSFAllocatorTest");
+}
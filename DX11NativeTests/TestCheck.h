@@ -0,0 +1,67 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+#pragma once
+
+#include <cstdio>
+
+// The checks of the tests. A failed check is reported with its location
+// and the test continues; main returns TestCheck::Report(), which is
+// nonzero when a check failed.
+
+namespace dxm
+{
+    class TestCheck
+    {
+    public:
+        static void Fail(char const* file, int line, char const* expression)
+        {
+            std::fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+            ++GetNumFailures();
+        }
+
+        static int Report(char const* name)
+        {
+            int const numFailures = GetNumFailures();
+            if (numFailures == 0)
+            {
+                std::printf("%s: all checks passed\n", name);
+                return 0;
+            }
+            std::printf("%s: %d checks failed\n", name, numFailures);
+            return 1;
+        }
+
+    private:
+        static int& GetNumFailures()
+        {
+            static int numFailures = 0;
+            return numFailures;
+        }
+    };
+}
+
+#define DXM_CHECK(expression) \
+    ((expression) ? (void)0 : dxm::TestCheck::Fail(__FILE__, __LINE__, #expression))
+
+// Check that the statement throws an exception of the type.
+#define DXM_CHECK_THROWS(Exception, statement) \
+    do \
+    { \
+        bool thrown = false; \
+        try \
+        { \
+            statement; \
+        } \
+        catch (Exception const&) \
+        { \
+            thrown = true; \
+        } \
+        if (!thrown) \
+        { \
+            dxm::TestCheck::Fail(__FILE__, __LINE__, #statement " throws " #Exception); \
+        } \
+    } while (false)
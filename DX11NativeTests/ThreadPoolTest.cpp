@@ -0,0 +1,116 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "ThreadPool.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+using namespace dxm;
+
+namespace
+{
+    void TestCoverage()
+    {
+        for (size_t numThreads : { 1, 2, 4, 7 })
+        {
+            ThreadPool pool(numThreads);
+            DXM_CHECK(pool.GetNumThreads() == numThreads);
+            for (size_t numItems : { 0, 1, 5, 1000, 4097 })
+            {
+                for (size_t grainSize : { 0, 1, 3, 64, 5000 })
+                {
+                    // Every item is processed exactly once.
+                    std::vector<std::atomic<int>> counts(numItems);
+                    pool.ParallelFor(numItems, grainSize, [&](size_t begin, size_t end)
+                    {
+                        for (size_t i = begin; i < end; ++i)
+                        {
+                            counts[i].fetch_add(1, std::memory_order_relaxed);
+                        }
+                    });
+
+                    bool once = true;
+                    for (auto const& count : counts)
+                    {
+                        once = once && (count.load() == 1);
+                    }
+                    DXM_CHECK(once);
+                }
+            }
+        }
+    }
+
+    void TestDefaultThreads()
+    {
+        ThreadPool pool;
+        DXM_CHECK(pool.GetNumThreads() >= 1);
+        DXM_CHECK(pool.GetNumThreads() == std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    void TestExceptions()
+    {
+        ThreadPool pool(4);
+        for (size_t iteration = 0; iteration < 200; ++iteration)
+        {
+            // The chunk that throws runs on a worker or the calling thread.
+            size_t const throwingChunk = iteration % 16;
+            std::atomic<size_t> numChunks(0);
+            DXM_CHECK_THROWS(std::runtime_error, pool.ParallelFor(1600, 100,
+                [&](size_t begin, size_t)
+                {
+                    numChunks.fetch_add(1, std::memory_order_relaxed);
+                    if (begin == throwingChunk * 100)
+                    {
+                        throw std::runtime_error("task failed");
+                    }
+                }));
+            DXM_CHECK(numChunks.load() >= 1 && numChunks.load() <= 16);
+
+            // The pool runs the next loop normally.
+            std::atomic<size_t> numItems(0);
+            pool.ParallelFor(1600, 100, [&](size_t begin, size_t end)
+            {
+                numItems.fetch_add(end - begin, std::memory_order_relaxed);
+            });
+            DXM_CHECK(numItems.load() == 1600);
+        }
+
+        // When every chunk throws, the first exception is rethrown, once.
+        size_t numCaught = 0;
+        try
+        {
+            pool.ParallelFor(64, 1, [](size_t, size_t)
+            {
+                throw std::logic_error("every chunk");
+            });
+        }
+        catch (std::logic_error const&)
+        {
+            ++numCaught;
+        }
+        DXM_CHECK(numCaught == 1);
+
+        // A single chunk, or a pool without workers, runs the task on the
+        // calling thread, and its exception propagates directly.
+        DXM_CHECK_THROWS(std::runtime_error, pool.ParallelFor(10, 100,
+            [](size_t, size_t) { throw std::runtime_error("single chunk"); }));
+        ThreadPool serial(1);
+        DXM_CHECK_THROWS(std::runtime_error, serial.ParallelFor(1000, 10,
+            [](size_t, size_t) { throw std::runtime_error("no workers"); }));
+    }
+}
+
+int main()
+{
+    TestCoverage();
+    TestDefaultThreads();
+    TestExceptions();
+    return TestCheck::Report("ThreadPoolTest");
+}
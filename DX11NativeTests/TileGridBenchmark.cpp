@@ -0,0 +1,138 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "TileGrid.h"
+#include "Benchmark.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+using namespace dxm;
+
+// The cost of a frame of a 3840x2160 surface with 64-pixel tiles when 'k'
+// objects of 96x96 pixels move, each invalidating its old and new
+// rectangles. 'grid us' is Invalidate and CollectRegions, and 'render us'
+// is a CPU stand-in for the GPU work: the regions are filled in a cache
+// and copied to the target, as TileCache clears, draws and composites
+// them. The regions are exact (no bound on their number) or bounded by
+// TileCache::maxRegions = 16, above which their bounding rectangle is
+// rendered. The area is the mean fraction of the surface that the regions
+// of a frame cover. The last row is a full redraw, which is the frame
+// without the cache. With exact regions both costs follow the changed area
+// rather than the surface size.
+
+namespace
+{
+    uint32_t constexpr width = 3840, height = 2160;
+
+    void Fill(std::vector<uint32_t>& cache, std::vector<uint32_t>& target,
+        TileGrid::Region const& region, uint32_t value)
+    {
+        for (uint32_t y = region.y; y < region.y + region.height; ++y)
+        {
+            uint32_t* row = &cache[static_cast<size_t>(y) * width + region.x];
+            std::fill(row, row + region.width, value);
+            std::memcpy(&target[static_cast<size_t>(y) * width + region.x], row,
+                region.width * sizeof(uint32_t));
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Benchmark benchmark(argc, argv);
+    size_t const numFrames = benchmark.Iterations(500) + 1;
+    std::vector<uint32_t> cache(static_cast<size_t>(width) * height);
+    std::vector<uint32_t> target(cache.size());
+
+    std::printf("%8s %8s %8s %10s %10s %10s %10s\n", "objects", "area %", "regions",
+        "grid us", "render us", "16: area %", "render us");
+    size_t const objectCounts[] = { 0, 1, 4, 16, 64, 256 };
+    size_t const numTests = sizeof(objectCounts) / sizeof(objectCounts[0]);
+    for (size_t test = 0; test <= numTests; ++test)
+    {
+        bool const full = (test == numTests);
+        size_t const numObjects = (full ? 0 : objectCounts[test]);
+        TileGrid grid(64);
+        grid.Resize(width, height);
+        (void)grid.CollectRegions(16);
+
+        // The objects move by a few pixels per frame and wrap around.
+        std::mt19937 random(31);
+        std::vector<std::array<uint32_t, 2>> positions(numObjects);
+        for (auto& position : positions)
+        {
+            position = { static_cast<uint32_t>(random() % (width - 96)),
+                static_cast<uint32_t>(random() % (height - 96)) };
+        }
+
+        size_t frame = 0;
+        auto invalidate = [&]()
+        {
+            if (full)
+            {
+                grid.InvalidateAll();
+                return;
+            }
+            for (auto& position : positions)
+            {
+                grid.Invalidate(position[0], position[1], 96, 96);
+                position[0] = (position[0] + 5) % (width - 96);
+                position[1] = (position[1] + 3) % (height - 96);
+                grid.Invalidate(position[0], position[1], 96, 96);
+            }
+        };
+
+        size_t numPixels = 0, numRegions = 0;
+        auto render = [&](size_t maxRegions)
+        {
+            return 1e-3 * benchmark.Measure(numFrames, [&]()
+            {
+                numPixels = 0;
+                for (size_t i = 0; i < numFrames; ++i, ++frame)
+                {
+                    invalidate();
+                    numRegions = grid.CollectRegions(maxRegions);
+                    for (auto const& region : grid.GetRegions())
+                    {
+                        Fill(cache, target, region, static_cast<uint32_t>(frame));
+                        numPixels += static_cast<size_t>(region.width) * region.height;
+                    }
+                }
+                DoNotOptimize(target[frame % target.size()]);
+            });
+        };
+        // The mean area of the regions of a frame.
+        auto percent = [&]()
+        {
+            return 100.0 * static_cast<double>(numPixels) /
+                (static_cast<double>(width) * height * static_cast<double>(numFrames));
+        };
+
+        size_t const unbounded = static_cast<size_t>(-1);
+        double const gridTime = 1e-3 * benchmark.Measure(numFrames, [&]()
+        {
+            for (size_t i = 0; i < numFrames; ++i)
+            {
+                invalidate();
+                numRegions = grid.CollectRegions(unbounded);
+            }
+            DoNotOptimize(numRegions);
+        });
+        double const exactTime = render(unbounded);
+        double const exactPercent = percent();
+        size_t const exactRegions = numRegions;
+        double const boundedTime = render(16);
+
+        std::printf("%8s %8.2f %8zu %10.2f %10.1f %10.2f %10.1f\n",
+            full ? "full" : std::to_string(numObjects).c_str(), exactPercent, exactRegions,
+            gridTime, exactTime, percent(), boundedTime);
+    }
+    return 0;
+}
@@ -0,0 +1,212 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "TileGrid.h"
+#include "TestCheck.h"
+#include <random>
+#include <stdexcept>
+#include <vector>
+using namespace dxm;
+
+namespace
+{
+    using Region = TileGrid::Region;
+
+    bool operator==(Region const& r0, Region const& r1)
+    {
+        return r0.x == r1.x && r0.y == r1.y && r0.width == r1.width && r0.height == r1.height;
+    }
+
+    bool HasRegions(TileGrid const& grid, std::vector<Region> const& expected)
+    {
+        auto const& regions = grid.GetRegions();
+        if (regions.size() != expected.size())
+        {
+            return false;
+        }
+        for (auto const& region : expected)
+        {
+            bool found = false;
+            for (auto const& actual : regions)
+            {
+                found = found || actual == region;
+            }
+            if (!found)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TestResize()
+    {
+        DXM_CHECK_THROWS(std::invalid_argument, TileGrid(0));
+
+        // 200x130 pixels are 4x3 tiles; the last column and row are
+        // clipped.
+        TileGrid grid(64);
+        grid.Resize(200, 130);
+        DXM_CHECK(grid.GetNumColumns() == 4 && grid.GetNumRows() == 3);
+        DXM_CHECK(grid.GetNumInvalidTiles() == 12 && !grid.IsValid(3, 2));
+        DXM_CHECK(grid.CollectRegions(16) == 1);
+        DXM_CHECK(HasRegions(grid, { { 0, 0, 200, 130 } }));
+        DXM_CHECK(grid.GetNumInvalidTiles() == 0 && grid.IsValid(3, 2));
+        DXM_CHECK(grid.GetStatistics().numTilesInvalidated == 12);
+        DXM_CHECK(grid.GetStatistics().numTilesCollected == 12);
+
+        // Nothing is invalid until something changes.
+        DXM_CHECK(grid.CollectRegions(16) == 0);
+        grid.Resize(200, 130);
+        DXM_CHECK(grid.CollectRegions(16) == 0);
+        grid.Resize(64, 64);
+        DXM_CHECK(grid.CollectRegions(16) == 1 && HasRegions(grid, { { 0, 0, 64, 64 } }));
+
+        // An empty surface has no tiles.
+        grid.Resize(0, 0);
+        DXM_CHECK(grid.CollectRegions(16) == 0);
+        grid.Invalidate(0, 0, 10, 10);
+        DXM_CHECK(grid.GetNumInvalidTiles() == 0);
+    }
+
+    void TestInvalidate()
+    {
+        TileGrid grid(64);
+        grid.Resize(200, 130);
+        (void)grid.CollectRegions(16);
+
+        // A pixel invalidates its tile; the clipped tiles are clipped.
+        grid.Invalidate(199, 129, 1, 1);
+        DXM_CHECK(grid.GetNumInvalidTiles() == 1 && !grid.IsValid(3, 2));
+        DXM_CHECK(grid.CollectRegions(16) == 1);
+        DXM_CHECK(HasRegions(grid, { { 192, 128, 8, 2 } }));
+
+        // A rectangle on tile boundaries does not touch the next tiles,
+        // and rectangles are clipped to the surface.
+        grid.Invalidate(64, 0, 64, 64);
+        grid.Invalidate(150, 100, 1000, 1000);
+        grid.Invalidate(500, 0, 10, 10);
+        grid.Invalidate(0, 0, 0, 100);
+        DXM_CHECK(grid.GetNumInvalidTiles() == 5);
+        DXM_CHECK(grid.CollectRegions(16) == 2);
+        DXM_CHECK(HasRegions(grid, { { 64, 0, 64, 64 }, { 128, 64, 72, 66 } }));
+
+        // Invalidating a tile twice counts it once.
+        grid.Invalidate(0, 0, 10, 10);
+        grid.Invalidate(5, 5, 10, 10);
+        DXM_CHECK(grid.GetNumInvalidTiles() == 1);
+        (void)grid.CollectRegions(16);
+        DXM_CHECK(grid.GetStatistics().numTilesInvalidated == 1);
+        DXM_CHECK(grid.GetStatistics().numRegions == 1);
+
+        // InvalidateAll makes later invalidations no-ops until collected.
+        grid.InvalidateAll();
+        grid.Invalidate(0, 0, 10, 10);
+        DXM_CHECK(grid.GetNumInvalidTiles() == 12);
+        DXM_CHECK(grid.CollectRegions(16) == 1 && HasRegions(grid, { { 0, 0, 200, 130 } }));
+    }
+
+    // The runs of a row merge with the runs of the previous row when they
+    // span the same columns.
+    void TestMerging()
+    {
+        TileGrid grid(10);
+        grid.Resize(100, 100);
+        (void)grid.CollectRegions(16);
+
+        // A 3x2 block, a column below its left tile, and a separate tile
+        // in the first row.
+        grid.Invalidate(10, 10, 30, 20);
+        grid.Invalidate(10, 30, 10, 20);
+        grid.Invalidate(80, 10, 10, 10);
+        DXM_CHECK(grid.CollectRegions(16) == 3);
+        DXM_CHECK(HasRegions(grid, { { 10, 10, 30, 20 }, { 10, 30, 10, 20 },
+            { 80, 10, 10, 10 } }));
+
+        // A checkerboard has a region per tile, more than the maximum, and
+        // is replaced by its bounding rectangle.
+        for (uint32_t row = 2; row < 6; ++row)
+        {
+            for (uint32_t column = row % 2; column < 8; column += 2)
+            {
+                grid.Invalidate(column * 10, row * 10, 10, 10);
+            }
+        }
+        DXM_CHECK(grid.GetNumInvalidTiles() == 16);
+        DXM_CHECK(grid.CollectRegions(15) == 1);
+        DXM_CHECK(HasRegions(grid, { { 0, 20, 80, 40 } }));
+        DXM_CHECK(grid.GetStatistics().numTilesCollected == 16);
+
+        grid.Invalidate(0, 0, 10, 10);
+        grid.Invalidate(20, 0, 10, 10);
+        DXM_CHECK(grid.CollectRegions(0) == 1 && HasRegions(grid, { { 0, 0, 30, 10 } }));
+    }
+
+    // Without the bound, the regions cover exactly the invalid tiles and do
+    // not overlap.
+    void TestRandom()
+    {
+        std::mt19937 random(29);
+        TileGrid grid(16);
+        grid.Resize(1000, 700);
+        (void)grid.CollectRegions(16);
+        uint32_t const numColumns = grid.GetNumColumns(), numRows = grid.GetNumRows();
+
+        bool exact = true;
+        for (size_t frame = 0; frame < 200; ++frame)
+        {
+            std::vector<int> expected(static_cast<size_t>(numColumns) * numRows, 0);
+            size_t const numRectangles = random() % 8;
+            for (size_t i = 0; i < numRectangles; ++i)
+            {
+                uint32_t const x = random() % 1100, y = random() % 800;
+                uint32_t const width = 1 + random() % 200, height = 1 + random() % 200;
+                grid.Invalidate(x, y, width, height);
+                if (x >= 1000 || y >= 700)
+                {
+                    continue;
+                }
+                for (uint32_t row = 0; row < numRows; ++row)
+                {
+                    for (uint32_t column = 0; column < numColumns; ++column)
+                    {
+                        if (x < (column + 1) * 16 && column * 16 < x + width &&
+                            y < (row + 1) * 16 && row * 16 < y + height)
+                        {
+                            expected[row * numColumns + column] = 1;
+                        }
+                    }
+                }
+            }
+
+            (void)grid.CollectRegions(1000000);
+            std::vector<int> covered(expected.size(), 0);
+            for (auto const& region : grid.GetRegions())
+            {
+                for (uint32_t row = region.y / 16; row * 16 < region.y + region.height; ++row)
+                {
+                    for (uint32_t column = region.x / 16;
+                        column * 16 < region.x + region.width; ++column)
+                    {
+                        ++covered[row * numColumns + column];
+                    }
+                }
+            }
+            exact = exact && covered == expected && grid.GetNumInvalidTiles() == 0;
+        }
+        DXM_CHECK(exact);
+    }
+}
+
+int main()
+{
+    TestResize();
+    TestInvalidate();
+    TestMerging();
+    TestRandom();
+    return TestCheck::Report("TileGridTest");
+}
@@ -0,0 +1,458 @@
+// David Eberly, Geometric Tools, Redmond WA 98052
+// Copyright (c) 1998-2022
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+// https://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+// Version: 1.0.2022.07.01
+
+#include "Trace.h"
+#include "TestCheck.h"
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace dxm;
+
+namespace
+{
+    // A minimal JSON parser, enough to check that the output of
+    // Trace::Write is a valid document and to read its events.
+    struct Value
+    {
+        enum class Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+        Type type = Type::NUL;
+        double number = 0.0;
+        std::string text;
+        std::vector<Value> elements;
+        std::map<std::string, Value> members;
+
+        Value const& operator[](std::string const& key) const
+        {
+            static Value const none;
+            auto iter = members.find(key);
+            return (iter != members.end() ? iter->second : none);
+        }
+    };
+
+    class Parser
+    {
+    public:
+        Parser(std::string const& text)
+            :
+            mText(text),
+            mPosition(0)
+        {
+        }
+
+        // Returns 'false' when the text is not a single JSON value.
+        bool Parse(Value& value)
+        {
+            if (!ParseValue(value))
+            {
+                return false;
+            }
+            SkipSpace();
+            return mPosition == mText.size();
+        }
+
+    private:
+        void SkipSpace()
+        {
+            while (mPosition < mText.size() && std::isspace(static_cast<unsigned char>(mText[mPosition])))
+            {
+                ++mPosition;
+            }
+        }
+
+        bool Consume(char c)
+        {
+            SkipSpace();
+            if (mPosition < mText.size() && mText[mPosition] == c)
+            {
+                ++mPosition;
+                return true;
+            }
+            return false;
+        }
+
+        bool ParseString(std::string& text)
+        {
+            if (!Consume('"'))
+            {
+                return false;
+            }
+            while (mPosition < mText.size())
+            {
+                char c = mText[mPosition++];
+                if (c == '"')
+                {
+                    return true;
+                }
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    return false;
+                }
+                if (c == '\\')
+                {
+                    if (mPosition >= mText.size())
+                    {
+                        return false;
+                    }
+                    c = mText[mPosition++];
+                    if (c == 'u')
+                    {
+                        if (mPosition + 4 > mText.size())
+                        {
+                            return false;
+                        }
+                        c = static_cast<char>(std::strtol(mText.substr(mPosition, 4).c_str(), nullptr, 16));
+                        mPosition += 4;
+                    }
+                    else if (c == 'n')
+                    {
+                        c = '\n';
+                    }
+                    else if (c != '"' && c != '\\' && c != '/')
+                    {
+                        return false;
+                    }
+                }
+                text += c;
+            }
+            return false;
+        }
+
+        bool ParseValue(Value& value)
+        {
+            SkipSpace();
+            if (mPosition >= mText.size())
+            {
+                return false;
+            }
+
+            char const c = mText[mPosition];
+            if (c == '{')
+            {
+                value.type = Value::Type::OBJECT;
+                ++mPosition;
+                if (Consume('}'))
+                {
+                    return true;
+                }
+                do
+                {
+                    std::string key;
+                    if (!ParseString(key) || !Consume(':') || !ParseValue(value.members[key]))
+                    {
+                        return false;
+                    }
+                } while (Consume(','));
+                return Consume('}');
+            }
+            if (c == '[')
+            {
+                value.type = Value::Type::ARRAY;
+                ++mPosition;
+                if (Consume(']'))
+                {
+                    return true;
+                }
+                do
+                {
+                    value.elements.emplace_back();
+                    if (!ParseValue(value.elements.back()))
+                    {
+                        return false;
+                    }
+                } while (Consume(','));
+                return Consume(']');
+            }
+            if (c == '"')
+            {
+                value.type = Value::Type::STRING;
+                return ParseString(value.text);
+            }
+            if (c == '-' || std::isdigit(static_cast<unsigned char>(c)))
+            {
+                char* end = nullptr;
+                value.type = Value::Type::NUMBER;
+                value.number = std::strtod(mText.c_str() + mPosition, &end);
+                mPosition = static_cast<size_t>(end - mText.c_str());
+                return true;
+            }
+            for (char const* literal : { "true", "false", "null" })
+            {
+                if (mText.compare(mPosition, std::strlen(literal), literal) == 0)
+                {
+                    value.type = (literal[0] == 'n' ? Value::Type::NUL : Value::Type::BOOLEAN);
+                    mPosition += std::strlen(literal);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::string const& mText;
+        size_t mPosition;
+    };
+
+    // Write the trace and return its events; 'valid' reports whether the
+    // document parsed and had the expected top-level members.
+    std::vector<Value> WriteEvents(bool& valid)
+    {
+        std::ostringstream output;
+        Trace::Write(output);
+        std::string const text = output.str();
+        Value document;
+        valid = Parser(text).Parse(document) &&
+            document.type == Value::Type::OBJECT &&
+            document["traceEvents"].type == Value::Type::ARRAY &&
+            document["displayTimeUnit"].text == "ms";
+        return document["traceEvents"].elements;
+    }
+
+    std::vector<Value> WriteEvents()
+    {
+        bool valid = false;
+        auto events = WriteEvents(valid);
+        DXM_CHECK(valid);
+        return events;
+    }
+
+    // A stream that counts the begin events written to it, for traces
+    // too large to keep in memory comfortably.
+    class CountingBuffer : public std::streambuf
+    {
+    public:
+        size_t numBegins = 0;
+
+    protected:
+        virtual int_type overflow(int_type c) override
+        {
+            if (c != traits_type::eof())
+            {
+                // The last three characters are "B".
+                mLast = (mLast << 8) | static_cast<uint32_t>(c & 0xFF);
+                numBegins += ((mLast & 0xFFFFFFu) == 0x224222u ? 1 : 0);
+            }
+            return c;
+        }
+
+    private:
+        uint32_t mLast = 0;
+    };
+
+    void TestDisabled()
+    {
+        Trace::Enable(false);
+        (void)WriteEvents();
+        {
+            DXM_TRACE_SCOPE("disabled");
+        }
+        DXM_CHECK(!Trace::IsEnabled());
+        DXM_CHECK(WriteEvents().empty());
+    }
+
+    void TestEvents()
+    {
+        Trace::Enable(true);
+        Trace::SetThreadName("main \"quoted\" \\ tab\t");
+        {
+            DXM_TRACE_SCOPE("outer");
+            {
+                DXM_TRACE_SCOPE("inner");
+            }
+        }
+
+        auto events = WriteEvents();
+        DXM_CHECK(events.size() == 5);
+        if (events.size() == 5)
+        {
+            DXM_CHECK(events[0]["ph"].text == "M" && events[0]["name"].text == "thread_name");
+            DXM_CHECK(events[0]["args"]["name"].text == "main \"quoted\" \\ tab\t");
+            char const* names[4] = { "outer", "inner", "inner", "outer" };
+            char const* phases[4] = { "B", "B", "E", "E" };
+            for (size_t i = 0; i < 4; ++i)
+            {
+                Value const& event = events[i + 1];
+                DXM_CHECK(event["name"].text == names[i] && event["ph"].text == phases[i]);
+                DXM_CHECK(event["pid"].number == 1.0);
+                DXM_CHECK(event["tid"].number == events[0]["tid"].number);
+                DXM_CHECK(event["ts"].type == Value::Type::NUMBER);
+                DXM_CHECK(i == 0 || event["ts"].number >= events[i]["ts"].number);
+            }
+        }
+
+        // The events were drained, so the next write has only the name.
+        events = WriteEvents();
+        DXM_CHECK(events.size() == 1 && events[0]["ph"].text == "M");
+    }
+
+    // A scope open during a write has its begin in that write and its end
+    // in the next.
+    void TestOpenScope()
+    {
+        Trace::Enable(true);
+        (void)WriteEvents();
+        std::vector<Value> first, second;
+        {
+            DXM_TRACE_SCOPE("open");
+            first = WriteEvents();
+        }
+        second = WriteEvents();
+        DXM_CHECK(first.size() == 2 && first[1]["ph"].text == "B");
+        DXM_CHECK(second.size() == 2 && second[1]["ph"].text == "E");
+        DXM_CHECK(second[1]["name"].text == "open");
+    }
+
+    // Events across several chunks are written once each, in order, and
+    // the drained chunks are freed, so the thread can record the limit
+    // again after a write.
+    void TestChunks()
+    {
+        Trace::Enable(true);
+        (void)WriteEvents();
+        uint64_t const numDropped = Trace::GetNumDropped();
+
+        size_t const numScopes = 3 * Trace::eventsPerChunk / 2 + 7;
+        for (size_t i = 0; i < numScopes; ++i)
+        {
+            DXM_TRACE_SCOPE("chunked");
+        }
+        auto events = WriteEvents();
+        DXM_CHECK(events.size() == 2 * numScopes + 1);
+        bool ordered = true;
+        for (size_t i = 1; i + 1 < events.size(); i += 2)
+        {
+            ordered = ordered && events[i]["ph"].text == "B" && events[i + 1]["ph"].text == "E";
+        }
+        DXM_CHECK(ordered);
+
+        for (size_t pass = 0; pass < 2; ++pass)
+        {
+            size_t const numEvents = Trace::maxChunksPerThread * Trace::eventsPerChunk - Trace::eventsPerChunk;
+            for (size_t i = 0; i < numEvents / 2; ++i)
+            {
+                DXM_TRACE_SCOPE("filler");
+            }
+            CountingBuffer counter;
+            std::ostream output(&counter);
+            Trace::Write(output);
+            DXM_CHECK(counter.numBegins == numEvents / 2);
+        }
+        DXM_CHECK(Trace::GetNumDropped() == numDropped);
+    }
+
+    // A full buffer drops events and counts them. The buffer of a thread
+    // that has exited is written and then retired, and its drops remain
+    // counted.
+    void TestDropsAndRetire()
+    {
+        Trace::Enable(true);
+        (void)WriteEvents();
+        uint64_t const numDropped = Trace::GetNumDropped();
+        size_t const capacity = Trace::maxChunksPerThread * Trace::eventsPerChunk;
+
+        std::thread worker([capacity]()
+        {
+            Trace::SetThreadName("worker");
+            for (size_t i = 0; i < capacity / 2 + 100; ++i)
+            {
+                DXM_TRACE_SCOPE("worker scope");
+            }
+        });
+        worker.join();
+        DXM_CHECK(Trace::GetNumDropped() == numDropped + 200);
+
+        CountingBuffer counter;
+        std::ostream output(&counter);
+        Trace::Write(output);
+        DXM_CHECK(counter.numBegins == capacity / 2);
+
+        // The retired buffer no longer contributes its name.
+        auto events = WriteEvents();
+        bool hasWorker = false;
+        for (auto const& event : events)
+        {
+            hasWorker = hasWorker || event["args"]["name"].text == "worker";
+        }
+        DXM_CHECK(!hasWorker);
+        DXM_CHECK(Trace::GetNumDropped() == numDropped + 200);
+    }
+
+    // Threads record while the main thread writes. Every event is written
+    // exactly once, and each thread's scopes are balanced.
+    void TestConcurrentWrites()
+    {
+        Trace::Enable(true);
+        (void)WriteEvents();
+        size_t constexpr numThreads = 4, numScopes = 20000;
+        std::atomic<size_t> numFinished(0);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < numThreads; ++t)
+        {
+            threads.emplace_back([&numFinished]()
+            {
+                for (size_t i = 0; i < numScopes; ++i)
+                {
+                    DXM_TRACE_SCOPE("concurrent");
+                }
+                numFinished.fetch_add(1);
+            });
+        }
+
+        // The begin and end counts of each thread.
+        std::map<double, std::pair<size_t, size_t>> counts;
+        auto countEvents = [&counts](std::vector<Value> const& events)
+        {
+            for (auto const& event : events)
+            {
+                auto& count = counts[event["tid"].number];
+                count.first += (event["ph"].text == "B" ? 1 : 0);
+                count.second += (event["ph"].text == "E" ? 1 : 0);
+            }
+        };
+
+        bool valid = true, done = false;
+        while (!done)
+        {
+            done = (numFinished.load() == numThreads);
+            bool writeValid = false;
+            countEvents(WriteEvents(writeValid));
+            valid = valid && writeValid;
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        countEvents(WriteEvents());
+
+        DXM_CHECK(valid);
+        size_t numBalanced = 0;
+        for (auto const& count : counts)
+        {
+            numBalanced += (count.second.first == numScopes && count.second.second == numScopes ? 1 : 0);
+        }
+        DXM_CHECK(numBalanced == numThreads);
+        Trace::Enable(false);
+    }
+}
+
+int main()
+{
+    TestDisabled();
+    TestEvents();
+    TestOpenScope();
+    TestChunks();
+    TestDropsAndRetire();
+    TestConcurrentWrites();
+    return TestCheck::Report("TraceTest");
+}
@@ -38,7 +38,25 @@ namespace WPFDX11Sample
         private readonly DX11Managed dx11Manager;
         private readonly RenderFrameTimer timer;
         private TimeSpan lastRender;
+        private TimeSpan lastStatus;
+        private bool overlayVisible = true;
         private bool lastVisible;
+        private string statusText = "";
+        private bool tracing;
+        private bool accounting;
+        private bool tileCache;
+        private FrameLoopPreset frameLoop = FrameLoopPreset.Standard;
+
+        // When 'true', the frames are rendered by calling the native
+        // Application code directly from DXManager. When 'false', they go
+        // through the OnRender delegate, DoRender and DX11Managed.
+        private const bool useNativeRender = true;
+
+        // The frame rate and timings are drawn by the native overlay. The
+        // text box shows the managed statistics and is updated at this
+        // interval rather than every frame, because the string formatting
+        // and WPF text layout cost more than rendering a frame.
+        private static readonly TimeSpan statusInterval = TimeSpan.FromSeconds(0.5);
         public MainWindow()
         {
             // After the construction call, an exception occurred when
@@ -55,6 +73,13 @@ namespace WPFDX11Sample
         {
             this.d3d11Image!.WindowOwner = (new System.Windows.Interop.WindowInteropHelper(this)).Handle;
             this.d3d11Image.OnRender = this.DoRender;
+            this.d3d11Image.GovernorEnabled = true;
+            _ = dx11Manager.SetOverlayVisible(overlayVisible);
+            if (useNativeRender)
+            {
+                this.d3d11Image.SetNativeRender(dx11Manager.NativeRenderFunction,
+                    dx11Manager.NativeRenderContext);
+            }
             this.d3d11Image.RequestRender();
 
             timer.Reset();
@@ -67,27 +92,88 @@ namespace WPFDX11Sample
             if (this.d3d11Image!.IsFrontBufferAvailable &&
                 this.lastRender != args.RenderingTime)
             {
-                this.d3d11Image.RequestRender();
+                timer.Measure();
+                bool rendered = this.d3d11Image.RequestRender();
                 this.lastRender = args.RenderingTime;
+                if (rendered)
+                {
+                    timer.UpdateFrameCount();
+                }
+
+                if (args.RenderingTime - this.lastStatus >= statusInterval)
+                {
+                    this.lastStatus = args.RenderingTime;
+                    UpdateStatus();
+                }
             }
         }
-        private void DoRender(IntPtr wpfBackBuffer, bool recreateRenderTarget)
+
+        private void UpdateStatus()
         {
-            timer.Measure();
+            // With a frame-rate cap, the image renders itself and
+            // RequestRender returns 'false', so the achieved rate and
+            // jitter are those measured by the image.
+            string rateText;
+            if (this.d3d11Image!.FrameRateCap > 0.0)
+            {
+                double interval = this.d3d11Image.FrameIntervalMilliseconds;
+                rateText = "cap = " + this.d3d11Image.FrameRateCap.ToString("F0") +
+                    " fps, achieved = " + (interval > 0.0 ? 1000.0 / interval : 0.0).ToString("F2") +
+                    " fps, jitter = " + this.d3d11Image.FrameJitterMilliseconds.ToString("F3") +
+                    " ms, dropped = " + this.d3d11Image.FramesDropped + ", ";
+            }
+            else if (!overlayVisible)
+            {
+                rateText = "fps = " + timer.GetFramesPerSecond().ToString("F1") + ", ";
+            }
+            else
+            {
+                rateText = "";
+            }
 
+            string text = rateText +
+                "lock = " + this.d3d11Image.AverageLockMicroseconds.ToString("F0") + " us" +
+                ", governor = " + this.d3d11Image.GovernorRate.ToString("F0") +
+                " fps, saved " + this.d3d11Image.FramesSaved + " of " +
+                (this.d3d11Image.FramesSaved + this.d3d11Image.FramesRendered) + " frames" +
+                statusText;
+            // Assigning the same text still invalidates the layout.
+            if (text != this.textbox.Text)
+            {
+                this.textbox.Text = text;
+            }
+        }
+        private void DoRender(IntPtr wpfBackBuffer, bool recreateRenderTarget)
+        {
             // If the RenderFrame call returns 'false', an exception occurred.
-            // The message is described by dx11Manager.exceptionMessage.
+            // The message is described by dx11Manager.exceptionMessage. With
+            // the native render path, the message is described by
+            // dx11Manager.NativeRenderExceptionMessage.
             _ = dx11Manager.RenderFrame(wpfBackBuffer, recreateRenderTarget);
-
-            double rate = timer.GetFramesPerSecond();
-            this.textbox.Text = "fps = " + rate.ToString("F1");
-            timer.UpdateFrameCount();
+        }
+        private void DoMeasure(IntPtr wpfBackBuffer, bool recreateRenderTarget)
+        {
+            // DoRender without the frame; see the B key.
+            _ = RenderCallDiagnostics.ManagedProbe(wpfBackBuffer, recreateRenderTarget);
         }
         private void OnClosing(object sender, System.ComponentModel.CancelEventArgs e)
         {
             CompositionTarget.Rendering -= this.OnComposition;
-            this.dx11Manager?.Dispose();
+
+            // The image holds the native Application pointer of dx11Manager,
+            // so it is detached and disposed first. Otherwise a queued frame
+            // or a front buffer event could call into the deleted native
+            // object.
+            this.d3d11Image?.SetNativeRender(IntPtr.Zero, IntPtr.Zero);
             this.d3d11Image?.Dispose();
+            this.dx11Manager?.Dispose();
+
+            // The devices are released by the Dispose calls, so the report
+            // includes those that were still referenced.
+            if (accounting)
+            {
+                _ = DX11Managed.WriteComAccounting(Path.Combine(Environment.CurrentDirectory, "com_accounting.txt"));
+            }
         }
         private void OnSizeChanged(object sender, SizeChangedEventArgs e)
         {
@@ -129,6 +215,92 @@ namespace WPFDX11Sample
             {
                 timer.Reset();
             }
+            else if (e.Key == System.Windows.Input.Key.L)
+            {
+                // Toggle rendering outside the D3DImage lock to compare the
+                // lock hold times of the two modes. The mode copies each
+                // frame to a second surface and is off by default.
+                this.d3d11Image!.RenderOutsideLock = !this.d3d11Image.RenderOutsideLock;
+            }
+            else if (e.Key == System.Windows.Input.Key.O)
+            {
+                // Toggle the native statistics overlay. While it is hidden,
+                // the text box shows the frame rate.
+                overlayVisible = !overlayVisible;
+                _ = dx11Manager.SetOverlayVisible(overlayVisible);
+            }
+            else if (e.Key == System.Windows.Input.Key.C)
+            {
+                // Cycle the frame-rate cap through off, 30 and 45 fps.
+                double cap = this.d3d11Image!.FrameRateCap;
+                this.d3d11Image.FrameRateCap = (cap == 0.0 ? 30.0 : (cap == 30.0 ? 45.0 : 0.0));
+                timer.Reset();
+            }
+            else if (e.Key == System.Windows.Input.Key.T)
+            {
+                // Start a timeline trace; the next press writes it to
+                // trace.json, which chrome://tracing and ui.perfetto.dev load.
+                tracing = !tracing;
+                DX11Managed.EnableTrace(tracing);
+                if (tracing)
+                {
+                    statusText = ", tracing";
+                }
+                else
+                {
+                    string filename = Path.Combine(Environment.CurrentDirectory, "trace.json");
+                    statusText = DX11Managed.WriteTrace(filename) ?
+                        ", trace written to " + filename : ", trace not written";
+                }
+            }
+            else if (e.Key == System.Windows.Input.Key.A)
+            {
+                // Start COM object accounting; the next press writes the
+                // report to com_accounting.txt. If accounting is on when
+                // the window closes, the report is written at shutdown.
+                accounting = !accounting;
+                DX11Managed.EnableComAccounting(accounting);
+                if (accounting)
+                {
+                    statusText = ", COM accounting";
+                }
+                else
+                {
+                    string filename = Path.Combine(Environment.CurrentDirectory, "com_accounting.txt");
+                    statusText = DX11Managed.WriteComAccounting(filename) ?
+                        ", COM report written to " + filename : ", COM report not written";
+                }
+            }
+            else if (e.Key == System.Windows.Input.Key.R)
+            {
+                // Toggle the native tile cache. The sample scene is static,
+                // so while the cache is enabled the frames only wait for
+                // the GPU, except for the overlay.
+                tileCache = !tileCache;
+                _ = dx11Manager.SetTileCacheEnabled(tileCache);
+                statusText = tileCache ? ", tile cache" : "";
+            }
+            else if (e.Key == System.Windows.Input.Key.F)
+            {
+                // Cycle the native frame loop presets. The overlay is drawn
+                // only by the Standard and PerFrameQuery loops.
+                frameLoop = (FrameLoopPreset)(((int)frameLoop + 1) % 4);
+                _ = dx11Manager.SetFrameLoopPreset(frameLoop);
+                statusText = ", frame loop " + frameLoop.ToString();
+            }
+            else if (e.Key == System.Windows.Input.Key.B)
+            {
+                // Compare the per-frame call overhead of the two render
+                // paths. The probes take the same route into the native
+                // code as the render entry points but do not render, so
+                // only the transitions are measured.
+                const uint numCalls = 100000;
+                double managedNs = RenderCallDiagnostics.Measure(this.DoMeasure, numCalls);
+                double nativeNs = RenderCallDiagnostics.Measure(RenderCallDiagnostics.NativeProbe,
+                    IntPtr.Zero, numCalls);
+                statusText = ", render call: delegate = " + managedNs.ToString("F0") +
+                    " ns, native = " + nativeNs.ToString("F0") + " ns";
+            }
         }
     }
 }